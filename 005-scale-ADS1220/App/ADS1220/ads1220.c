@@ -29,38 +29,179 @@ ADS1220_Status_t ADS1220_SendCommand(ADS1220_Handle_t *hads, uint8_t cmd)
 
 ADS1220_Status_t ADS1220_Reset(ADS1220_Handle_t *hads)
 {
-    return ADS1220_SendCommand(hads, ADS1220_CMD_RESET);
+    if (ADS1220_SendCommand(hads, ADS1220_CMD_RESET) != ADS1220_OK) return ADS1220_ERROR;
+
+    /* all configuration registers are 00h after reset */
+    memset(hads->regs, 0, sizeof(hads->regs));
+    hads->regs_valid = 1;
+    return ADS1220_OK;
 }
 
 ADS1220_Status_t ADS1220_WriteRegister(ADS1220_Handle_t *hads, uint8_t reg, uint8_t value)
 {
-    if (!hads || !hads->csLow || !hads->csHigh || !hads->spiTxRx) return ADS1220_ERROR;
+    return ADS1220_WriteRegisters(hads, reg, &value, 1);
+}
+
+ADS1220_Status_t ADS1220_ReadRegister(ADS1220_Handle_t *hads, uint8_t reg, uint8_t *value)
+{
+    return ADS1220_ReadRegisters(hads, reg, value, 1);
+}
+
+/* WREG/RREG with nn = count-1: registers reg .. reg+count-1 in one transaction.
+   Both keep the register shadow up to date. */
+ADS1220_Status_t ADS1220_WriteRegisters(ADS1220_Handle_t *hads, uint8_t reg, const uint8_t *values, uint8_t count)
+{
+    if (!hads || !hads->csLow || !hads->csHigh || !hads->spiTxRx || !values) return ADS1220_ERROR;
+    if (count == 0 || reg + count > 4) return ADS1220_ERROR;
 
-    uint8_t cmd[2];
-    cmd[0] = ADS1220_CMD_WREG | ((reg & 0x03) << 2); /* write starting at reg, nn=0 => write 1 byte */
-    cmd[1] = value;
+    uint8_t cmd[5];
+    cmd[0] = ADS1220_CMD_WREG | ((reg & 0x03) << 2) | ((count - 1) & 0x03);
+    memcpy(&cmd[1], values, count);
 
     hads->csLow();
-    int r = ads_spi_xfer(hads, cmd, NULL, 2);
+    int r = ads_spi_xfer(hads, cmd, NULL, (uint16_t)(count + 1));
     hads->csHigh();
 
-    return (r == 0) ? ADS1220_OK : ADS1220_ERROR;
+    if (r != 0) {
+        hads->regs_valid = 0; /* device state unknown */
+        return ADS1220_ERROR;
+    }
+    memcpy(&hads->regs[reg], values, count);
+    return ADS1220_OK;
 }
 
-ADS1220_Status_t ADS1220_ReadRegister(ADS1220_Handle_t *hads, uint8_t reg, uint8_t *value)
+ADS1220_Status_t ADS1220_ReadRegisters(ADS1220_Handle_t *hads, uint8_t reg, uint8_t *values, uint8_t count)
 {
-    if (!hads || !hads->csLow || !hads->csHigh || !hads->spiTxRx || !value) return ADS1220_ERROR;
+    if (!hads || !hads->csLow || !hads->csHigh || !hads->spiTxRx || !values) return ADS1220_ERROR;
+    if (count == 0 || reg + count > 4) return ADS1220_ERROR;
 
-    uint8_t cmd = ADS1220_CMD_RREG | ((reg & 0x03) << 2);
+    uint8_t cmd = ADS1220_CMD_RREG | ((reg & 0x03) << 2) | ((count - 1) & 0x03);
 
     hads->csLow();
     int r = ads_spi_xfer(hads, &cmd, NULL, 1);
     if (r == 0) {
-        r = ads_spi_xfer(hads, NULL, value, 1); /* read one byte */
+        r = ads_spi_xfer(hads, NULL, values, count);
     }
     hads->csHigh();
 
-    return (r == 0) ? ADS1220_OK : ADS1220_ERROR;
+    if (r != 0) return ADS1220_ERROR;
+    memcpy(&hads->regs[reg], values, count);
+    if (reg == 0 && count == 4) hads->regs_valid = 1;
+    return ADS1220_OK;
+}
+
+ADS1220_Status_t ADS1220_SyncRegisters(ADS1220_Handle_t *hads)
+{
+    uint8_t regs[4];
+    return ADS1220_ReadRegisters(hads, ADS1220_REG_CONFIG0, regs, 4);
+}
+
+/* Write only the registers that differ from the shadow, as one WREG over
+   the first..last changed register; optionally read that range back */
+ADS1220_Status_t ADS1220_ApplyRegisters(ADS1220_Handle_t *h, const uint8_t regs[4], uint8_t verify)
+{
+    uint8_t first = 0, last = 3;
+    uint8_t back[4];
+
+    if (!h || !regs) return ADS1220_ERROR;
+    if (h->regs_valid) {
+        while (first < 4 && regs[first] == h->regs[first]) first++;
+        if (first == 4) return ADS1220_OK;              /* nothing changed */
+        while (regs[last] == h->regs[last]) last--;
+    }
+
+    uint8_t count = (uint8_t)(last - first + 1);
+    if (ADS1220_WriteRegisters(h, first, &regs[first], count) != ADS1220_OK) return ADS1220_ERROR;
+    if (!verify) return ADS1220_OK;
+
+    if (ADS1220_ReadRegisters(h, first, back, count) != ADS1220_OK) {
+        h->regs_valid = 0;  /* written, but not confirmed */
+        return ADS1220_ERROR;
+    }
+    if (memcmp(&regs[first], back, count) != 0) {
+        h->regs_valid = 0;
+        return ADS1220_VERIFY_FAIL;
+    }
+    return ADS1220_OK;
+}
+
+/* read-modify-write of a field through the shadow; SPI only on a change */
+static ADS1220_Status_t ads_set_field(ADS1220_Handle_t *h, uint8_t reg, uint8_t mask, uint8_t value)
+{
+    uint8_t regs[4];
+
+    if (!h) return ADS1220_ERROR;
+    if (!h->regs_valid && ADS1220_SyncRegisters(h) != ADS1220_OK) return ADS1220_ERROR;
+
+    memcpy(regs, h->regs, 4);
+    regs[reg] = (uint8_t)((regs[reg] & ~mask) | (value & mask));
+    return ADS1220_ApplyRegisters(h, regs, 0);
+}
+
+static int8_t ads_gain_code(uint8_t gain)
+{
+    for (int8_t code = 0; code < 8; code++)
+        if ((1u << code) == gain) return code;
+    return -1;
+}
+
+ADS1220_Status_t ADS1220_SetInput(ADS1220_Handle_t *hads, ADS1220_Input_t input)
+{
+    if ((unsigned)input > ADS1220_IN_SHORTED) return ADS1220_ERROR;
+    return ads_set_field(hads, ADS1220_REG_CONFIG0, 0xF0, (uint8_t)((unsigned)input << 4));
+}
+
+ADS1220_Status_t ADS1220_SetGain(ADS1220_Handle_t *hads, uint8_t gain)
+{
+    int8_t code = ads_gain_code(gain);
+    if (code < 0) return ADS1220_ERROR;
+
+    /* the bypass bit is dropped above gain 4, where it is not allowed */
+    uint8_t mask = (gain > 4) ? 0x0F : 0x0E;
+    if (ads_set_field(hads, ADS1220_REG_CONFIG0, mask, (uint8_t)(code << 1)) != ADS1220_OK) return ADS1220_ERROR;
+    hads->gain = gain;
+    return ADS1220_OK;
+}
+
+ADS1220_Status_t ADS1220_SetInputGain(ADS1220_Handle_t *hads, ADS1220_Input_t input, uint8_t gain)
+{
+    int8_t code = ads_gain_code(gain);
+    if (code < 0 || (unsigned)input > ADS1220_IN_SHORTED) return ADS1220_ERROR;
+
+    uint8_t mask = (gain > 4) ? 0xFF : 0xFE;
+    if (ads_set_field(hads, ADS1220_REG_CONFIG0, mask,
+                      (uint8_t)(((unsigned)input << 4) | (code << 1))) != ADS1220_OK) return ADS1220_ERROR;
+    hads->gain = gain;
+    return ADS1220_OK;
+}
+
+ADS1220_Status_t ADS1220_SetDataRate(ADS1220_Handle_t *hads, ADS1220_OpMode_t mode, uint8_t dr)
+{
+    if ((unsigned)mode > ADS1220_OPMODE_TURBO || dr >= ADS1220_DR_COUNT) return ADS1220_ERROR;
+    if (!hads) return ADS1220_ERROR;
+    if (!hads->regs_valid && ADS1220_SyncRegisters(hads) != ADS1220_OK) return ADS1220_ERROR;
+
+    /* 50/60 Hz rejection must be off first if the new rate does not allow it */
+    if ((hads->regs[2] & 0x30) && !(dr == 0 && mode != ADS1220_OPMODE_TURBO)) return ADS1220_ERROR;
+
+    return ads_set_field(hads, ADS1220_REG_CONFIG1, 0xF8, (uint8_t)((dr << 5) | ((unsigned)mode << 3)));
+}
+
+ADS1220_Status_t ADS1220_SetIdac(ADS1220_Handle_t *hads, ADS1220_Idac_t idac,
+                                 ADS1220_IdacMux_t idac1, ADS1220_IdacMux_t idac2)
+{
+    uint8_t regs[4];
+
+    if (!hads) return ADS1220_ERROR;
+    if ((unsigned)idac > ADS1220_IDAC_1500UA ||
+        (unsigned)idac1 > ADS1220_IDAC_TO_REFN0 || (unsigned)idac2 > ADS1220_IDAC_TO_REFN0) return ADS1220_ERROR;
+    if (!hads->regs_valid && ADS1220_SyncRegisters(hads) != ADS1220_OK) return ADS1220_ERROR;
+
+    /* CONFIG2 and CONFIG3 together: one WREG if both change */
+    memcpy(regs, hads->regs, 4);
+    regs[2] = (uint8_t)((regs[2] & ~0x07) | (unsigned)idac);
+    regs[3] = (uint8_t)((regs[3] & 0x03) | ((unsigned)idac1 << 5) | ((unsigned)idac2 << 2));
+    return ADS1220_ApplyRegisters(hads, regs, 0);
 }
 
 uint8_t ADS1220_DataReady(ADS1220_Handle_t *hads)
@@ -94,8 +235,94 @@ ADS1220_Status_t ADS1220_ReadData(ADS1220_Handle_t *hads, int32_t *data)
     return ADS1220_OK;
 }
 
+/* Output data rates, mSPS, per mode and DR index (datasheet table 14) */
+static const uint32_t ads_rate_msps[3][ADS1220_DR_COUNT] = {
+    {  20000,  45000,  90000, 175000, 330000,  600000, 1000000 },   /* normal */
+    {   5000,  11250,  22500,  44000,  82500,  150000,  250000 },   /* duty   */
+    {  40000,  90000, 180000, 350000, 660000, 1200000, 2000000 },   /* turbo  */
+};
+
+uint32_t ADS1220_DataRate_mSPS(ADS1220_OpMode_t mode, uint8_t dr)
+{
+    if ((unsigned)mode > ADS1220_OPMODE_TURBO || dr >= ADS1220_DR_COUNT) return 0;
+    return ads_rate_msps[mode][dr];
+}
+
+void ADS1220_DefaultConfig(ADS1220_Config_t *cfg)
+{
+    if (!cfg) return;
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->input      = ADS1220_IN_AIN1_AIN0;
+    cfg->gain       = 128;
+    cfg->mode       = ADS1220_OPMODE_NORMAL;
+    cfg->dr         = 0;                        /* 20 SPS */
+    cfg->continuous = 1;
+    cfg->ref        = ADS1220_REF_INTERNAL;
+    cfg->reject     = ADS1220_REJECT_OFF;
+    cfg->idac       = ADS1220_IDAC_0UA;
+    cfg->idac1      = ADS1220_IDAC_TO_NONE;
+    cfg->idac2      = ADS1220_IDAC_TO_NONE;
+}
+
+ADS1220_Status_t ADS1220_ConfigToRegs(const ADS1220_Config_t *cfg, uint8_t regs[4])
+{
+    uint8_t gain_code = 0;
+
+    if (!cfg || !regs) return ADS1220_ERROR;
+
+    /* gain must be a power of two 1..128 */
+    while (gain_code < 8 && (1u << gain_code) != cfg->gain) gain_code++;
+    if (gain_code == 8) return ADS1220_ERROR;
+
+    if ((unsigned)cfg->input > ADS1220_IN_SHORTED)     return ADS1220_ERROR;
+    if ((unsigned)cfg->mode  > ADS1220_OPMODE_TURBO)   return ADS1220_ERROR;
+    if (cfg->dr >= ADS1220_DR_COUNT)                   return ADS1220_ERROR;
+    if ((unsigned)cfg->ref   > ADS1220_REF_AVDD)       return ADS1220_ERROR;
+    if ((unsigned)cfg->reject > ADS1220_REJECT_60)     return ADS1220_ERROR;
+    if ((unsigned)cfg->idac  > ADS1220_IDAC_1500UA)    return ADS1220_ERROR;
+    if ((unsigned)cfg->idac1 > ADS1220_IDAC_TO_REFN0)  return ADS1220_ERROR;
+    if ((unsigned)cfg->idac2 > ADS1220_IDAC_TO_REFN0)  return ADS1220_ERROR;
+
+    /* the PGA can only be bypassed at gain 1, 2 and 4 */
+    if (cfg->pga_bypass && cfg->gain > 4)              return ADS1220_ERROR;
+    /* the 50/60 Hz FIR only runs at 20 SPS normal (5 SPS duty-cycle) */
+    if (cfg->reject != ADS1220_REJECT_OFF &&
+        !(cfg->dr == 0 && cfg->mode != ADS1220_OPMODE_TURBO)) return ADS1220_ERROR;
+
+    regs[0] = (uint8_t)(((unsigned)cfg->input << 4) | (gain_code << 1) | (cfg->pga_bypass ? 1u : 0u));
+    regs[1] = (uint8_t)((cfg->dr << 5) | ((unsigned)cfg->mode << 3) |
+                        (cfg->continuous  ? 0x04u : 0u) |
+                        (cfg->temp_sensor ? 0x02u : 0u) |
+                        (cfg->burnout     ? 0x01u : 0u));
+    regs[2] = (uint8_t)(((unsigned)cfg->ref << 6) | ((unsigned)cfg->reject << 4) |
+                        (cfg->low_side_switch ? 0x08u : 0u) | (unsigned)cfg->idac);
+    regs[3] = (uint8_t)(((unsigned)cfg->idac1 << 5) | ((unsigned)cfg->idac2 << 2) |
+                        (cfg->drdy_on_dout ? 0x02u : 0u));
+    return ADS1220_OK;
+}
+
+ADS1220_Status_t ADS1220_Configure(ADS1220_Handle_t *hads, const ADS1220_Config_t *cfg)
+{
+    uint8_t regs[4];
+
+    if (!hads) return ADS1220_ERROR;
+    if (ADS1220_ConfigToRegs(cfg, regs) != ADS1220_OK) return ADS1220_ERROR;
+
+    /* one WREG over the registers that differ from the shadow (all four
+       if the shadow is not known), read back; in continuous mode the
+       write restarts the conversion with the new setting */
+    ADS1220_Status_t st = ADS1220_ApplyRegisters(hads, regs, 1);
+    if (st != ADS1220_OK) return st;
+
+    hads->gain = cfg->gain;
+    if (cfg->ref == ADS1220_REF_INTERNAL) hads->vref = 2.048f;
+    return ADS1220_OK;
+}
+
 ADS1220_Status_t ADS1220_Init(ADS1220_Handle_t *hads)
 {
+    ADS1220_Config_t cfg;
+
     if (!hads) return ADS1220_ERROR;
 
     /* Minimal checks: callbacks must be set by application */
@@ -108,25 +335,11 @@ ADS1220_Status_t ADS1220_Init(ADS1220_Handle_t *hads)
 
     /* Small delay: caller must provide hardware delay before calling Init if needed */
 
-    /* Configure register0: MUX AIN1/AIN0, GAIN=128, PGA enabled */
-    if (ADS1220_WriteRegister(hads, ADS1220_REG_CONFIG0, (uint8_t)(ADS1220_MUX_AIN1_AIN0 | ADS1220_GAIN_128)) != ADS1220_OK) {
-        return ADS1220_ERROR;
-    }
-
-    /* Configure register1: 20SPS, Normal mode, Continuous conversion */
-    if (ADS1220_WriteRegister(hads, ADS1220_REG_CONFIG1, (uint8_t)(ADS1220_DR_20SPS | ADS1220_MODE_NORMAL | ADS1220_CM_CONTINUOUS)) != ADS1220_OK) {
-        return ADS1220_ERROR;
-    }
-
-    /* Configure register2: internal ref, no 50/60 rejection */
-    if (ADS1220_WriteRegister(hads, ADS1220_REG_CONFIG2, (uint8_t)(ADS1220_VREF_INTERNAL | ADS1220_50HZ_60HZ_OFF)) != ADS1220_OK) {
-        return ADS1220_ERROR;
-    }
-
-    /* Configure register3: idac off */
-    if (ADS1220_WriteRegister(hads, ADS1220_REG_CONFIG3, (uint8_t)ADS1220_IDAC_OFF) != ADS1220_OK) {
-        return ADS1220_ERROR;
-    }
+    /* Default setting: AIN1/AIN0, gain 128, 20 SPS normal, continuous,
+       internal ref, no 50/60 rejection, IDACs off; written and verified
+       in one go. The app may call ADS1220_Configure afterwards. */
+    ADS1220_DefaultConfig(&cfg);
+    if (ADS1220_Configure(hads, &cfg) != ADS1220_OK) return ADS1220_ERROR;
 
     /* store defaults if not set */
     if (hads->gain == 0) hads->gain = 128;
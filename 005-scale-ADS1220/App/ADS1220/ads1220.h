@@ -7,7 +7,8 @@
 typedef enum {
     ADS1220_OK = 0,
     ADS1220_ERROR = -1,
-    ADS1220_TIMEOUT = -2
+    ADS1220_TIMEOUT = -2,
+    ADS1220_VERIFY_FAIL = -3    /* register readback differs from what was written */
 } ADS1220_Status_t;
 
 /* Commands */
@@ -37,6 +38,77 @@ typedef enum {
 #define ADS1220_50HZ_60HZ_OFF   (0x00)
 #define ADS1220_IDAC_OFF        (0x00)
 
+/* ---- Typed configuration (field values, not shifted) ---- */
+
+/* CONFIG0 MUX[7:4]: input multiplexer, AINP_AINN */
+typedef enum {
+    ADS1220_IN_AIN0_AIN1 = 0, ADS1220_IN_AIN0_AIN2, ADS1220_IN_AIN0_AIN3,
+    ADS1220_IN_AIN1_AIN2,     ADS1220_IN_AIN1_AIN3, ADS1220_IN_AIN2_AIN3,
+    ADS1220_IN_AIN1_AIN0,     ADS1220_IN_AIN3_AIN2,
+    ADS1220_IN_AIN0_AVSS,     ADS1220_IN_AIN1_AVSS, ADS1220_IN_AIN2_AVSS,
+    ADS1220_IN_AIN3_AVSS,
+    ADS1220_IN_REF_DIV4,      /* (REFP - REFN) / 4 monitor, PGA bypassed */
+    ADS1220_IN_AVDD_DIV4,     /* (AVDD - AVSS) / 4 monitor, PGA bypassed */
+    ADS1220_IN_SHORTED        /* AINP and AINN shorted to (AVDD + AVSS) / 2 */
+} ADS1220_Input_t;
+
+/* CONFIG1 MODE[4:3] */
+typedef enum {
+    ADS1220_OPMODE_NORMAL = 0,  /* 256 kHz modulator: 20 .. 1000 SPS      */
+    ADS1220_OPMODE_DUTY   = 1,  /* duty-cycle, low power: 5 .. 250 SPS    */
+    ADS1220_OPMODE_TURBO  = 2   /* 512 kHz modulator: 40 .. 2000 SPS      */
+} ADS1220_OpMode_t;
+
+/* CONFIG1 DR[7:5]: rate index, the SPS depends on the mode */
+#define ADS1220_DR_COUNT        7u
+
+/* CONFIG2 VREF[7:6] */
+typedef enum {
+    ADS1220_REF_INTERNAL = 0,   /* 2.048 V                                */
+    ADS1220_REF_REFP0    = 1,   /* REFP0 - REFN0                          */
+    ADS1220_REF_REFP1    = 2,   /* AIN0/REFP1 - AIN3/REFN1                */
+    ADS1220_REF_AVDD     = 3    /* AVDD - AVSS                            */
+} ADS1220_Ref_t;
+
+/* CONFIG2 50/60[5:4]: FIR rejection, only at 20 SPS normal / 5 SPS duty */
+typedef enum {
+    ADS1220_REJECT_OFF   = 0,
+    ADS1220_REJECT_50_60 = 1,
+    ADS1220_REJECT_50    = 2,
+    ADS1220_REJECT_60    = 3
+} ADS1220_Reject_t;
+
+/* CONFIG2 IDAC[2:0] */
+typedef enum {
+    ADS1220_IDAC_0UA = 0, ADS1220_IDAC_10UA, ADS1220_IDAC_50UA, ADS1220_IDAC_100UA,
+    ADS1220_IDAC_250UA,   ADS1220_IDAC_500UA, ADS1220_IDAC_1000UA, ADS1220_IDAC_1500UA
+} ADS1220_Idac_t;
+
+/* CONFIG3 I1MUX[7:5] / I2MUX[4:2] */
+typedef enum {
+    ADS1220_IDAC_TO_NONE = 0, ADS1220_IDAC_TO_AIN0, ADS1220_IDAC_TO_AIN1,
+    ADS1220_IDAC_TO_AIN2,     ADS1220_IDAC_TO_AIN3, ADS1220_IDAC_TO_REFP0,
+    ADS1220_IDAC_TO_REFN0
+} ADS1220_IdacMux_t;
+
+typedef struct {
+    ADS1220_Input_t   input;
+    uint8_t           gain;           /* 1, 2, 4 .. 128                     */
+    uint8_t           pga_bypass;     /* only for gain 1, 2, 4              */
+    ADS1220_OpMode_t  mode;
+    uint8_t           dr;             /* 0 .. ADS1220_DR_COUNT-1            */
+    uint8_t           continuous;     /* 1 = continuous, 0 = single-shot    */
+    uint8_t           temp_sensor;    /* 1 = internal temperature sensor    */
+    uint8_t           burnout;        /* 1 = 10 uA burn-out current sources */
+    ADS1220_Ref_t     ref;
+    ADS1220_Reject_t  reject;
+    uint8_t           low_side_switch;/* 1 = PSW closes with START          */
+    ADS1220_Idac_t    idac;
+    ADS1220_IdacMux_t idac1;
+    ADS1220_IdacMux_t idac2;
+    uint8_t           drdy_on_dout;   /* 1 = DOUT/DRDY also signals DRDY    */
+} ADS1220_Config_t;
+
 /* Handle with callbacks - HAL-free core driver */
 typedef struct {
     /* Low level callbacks - must be provided by application/main.c */
@@ -49,9 +121,14 @@ typedef struct {
     int      (*spiTxRx)(const uint8_t *tx, uint8_t *rx, uint16_t len);
     uint8_t  (*drdyRead)(void); /* return 1 if DRDY (data ready), 0 otherwise */
 
-    /* Optional configuration state filled by init */
+    /* Optional configuration state filled by init / ADS1220_Configure */
     uint16_t gain;    /* 1,2,4,...128 */
-    float    vref;    /* volts, e.g. 2.048f */
+    float    vref;    /* volts, e.g. 2.048f; set by the app for external references */
+
+    /* Register shadow of CONFIG0..3, kept by the driver: valid after a
+       reset or a full read, updated by every register write */
+    uint8_t  regs[4];
+    uint8_t  regs_valid;
 } ADS1220_Handle_t;
 
 /* API */
@@ -60,6 +137,35 @@ ADS1220_Status_t ADS1220_Reset(ADS1220_Handle_t *hads);
 ADS1220_Status_t ADS1220_SendCommand(ADS1220_Handle_t *hads, uint8_t cmd);
 ADS1220_Status_t ADS1220_WriteRegister(ADS1220_Handle_t *hads, uint8_t reg, uint8_t value);
 ADS1220_Status_t ADS1220_ReadRegister(ADS1220_Handle_t *hads, uint8_t reg, uint8_t *value);
+ADS1220_Status_t ADS1220_WriteRegisters(ADS1220_Handle_t *hads, uint8_t reg, const uint8_t *values, uint8_t count);
+ADS1220_Status_t ADS1220_ReadRegisters(ADS1220_Handle_t *hads, uint8_t reg, uint8_t *values, uint8_t count);
+
+/* Read CONFIG0..3 into the shadow in one RREG */
+ADS1220_Status_t ADS1220_SyncRegisters(ADS1220_Handle_t *hads);
+
+/* Write the registers in regs[] that differ from the shadow, one WREG over
+   the changed range, nothing if equal; verify = read the range back */
+ADS1220_Status_t ADS1220_ApplyRegisters(ADS1220_Handle_t *hads, const uint8_t regs[4], uint8_t verify);
+
+/* Field setters: change one field in the shadow and write the register
+   only if its value changed (no SPI read). Conversions restart on a write. */
+ADS1220_Status_t ADS1220_SetInput(ADS1220_Handle_t *hads, ADS1220_Input_t input);
+ADS1220_Status_t ADS1220_SetGain(ADS1220_Handle_t *hads, uint8_t gain);
+ADS1220_Status_t ADS1220_SetInputGain(ADS1220_Handle_t *hads, ADS1220_Input_t input, uint8_t gain);
+ADS1220_Status_t ADS1220_SetDataRate(ADS1220_Handle_t *hads, ADS1220_OpMode_t mode, uint8_t dr);
+ADS1220_Status_t ADS1220_SetIdac(ADS1220_Handle_t *hads, ADS1220_Idac_t idac,
+                                 ADS1220_IdacMux_t idac1, ADS1220_IdacMux_t idac2);
+
+/* Typed configuration: defaults are the scale setting (AIN1-AIN0, gain 128,
+   20 SPS normal, continuous, internal reference, everything else off) */
+void             ADS1220_DefaultConfig(ADS1220_Config_t *cfg);
+/* Pack into CONFIG0..3; ADS1220_ERROR on an invalid combination */
+ADS1220_Status_t ADS1220_ConfigToRegs(const ADS1220_Config_t *cfg, uint8_t regs[4]);
+/* Write the registers that differ from the shadow in one WREG, read them
+   back and compare; no SPI traffic if nothing changed */
+ADS1220_Status_t ADS1220_Configure(ADS1220_Handle_t *hads, const ADS1220_Config_t *cfg);
+/* Output data rate in mSPS (11.25 SPS = 11250), 0 if invalid */
+uint32_t         ADS1220_DataRate_mSPS(ADS1220_OpMode_t mode, uint8_t dr);
 uint8_t          ADS1220_DataReady(ADS1220_Handle_t *hads);
 ADS1220_Status_t ADS1220_ReadData(ADS1220_Handle_t *hads, int32_t *data);
 float            ADS1220_CodeToVoltage(ADS1220_Handle_t *hads, int32_t code);
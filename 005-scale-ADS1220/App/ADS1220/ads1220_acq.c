@@ -0,0 +1,131 @@
+/**
+  ******************************************************************************
+  * @file    ads1220_acq.c
+  * @brief   ADS1220 DRDY/DMA acquisition into a sample ring (HAL-free core,
+  *          uses callbacks provided by app)
+  ******************************************************************************
+  */
+
+#include "ads1220_acq.h"
+
+#define RING_MASK   (ADS1220_ACQ_RING - 1u)
+
+ADS1220_Status_t ADS1220_AcqInit(ADS1220_Acq_t *acq)
+{
+    if (!acq || !acq->hads || !acq->readStart) return ADS1220_ERROR;
+    if (!acq->hads->csLow || !acq->hads->csHigh) return ADS1220_ERROR;
+
+    acq->running  = 0;
+    acq->busy     = 0;
+    acq->head     = 0;
+    acq->tail     = 0;
+    acq->count    = 0;
+    acq->dropped  = 0;
+    acq->overruns = 0;
+    acq->errors   = 0;
+    return ADS1220_OK;
+}
+
+void ADS1220_AcqStart(ADS1220_Acq_t *acq)
+{
+    acq->running = 1;
+}
+
+void ADS1220_AcqStop(ADS1220_Acq_t *acq)
+{
+    acq->running = 0;
+    while (acq->busy) { }
+}
+
+void ADS1220_AcqOnDrdy(ADS1220_Acq_t *acq)
+{
+    if (!acq->running) return;
+
+    /* the previous result is still being read: this one is lost */
+    if (acq->busy) {
+        acq->overruns++;
+        return;
+    }
+
+    acq->t_drdy = acq->timestamp ? acq->timestamp() : 0u;
+    acq->busy   = 1;
+    acq->hads->csLow();
+    if (acq->readStart(acq->rx, 3) != 0) {
+        acq->hads->csHigh();
+        acq->busy = 0;
+        acq->errors++;
+    }
+}
+
+void ADS1220_AcqOnReadDone(ADS1220_Acq_t *acq, int status)
+{
+    acq->hads->csHigh();
+
+    if (status != 0) {
+        acq->errors++;
+    } else {
+        uint16_t head = acq->head;
+        int      ch   = 0;
+
+        int32_t raw = ((int32_t)acq->rx[0] << 16) | ((int32_t)acq->rx[1] << 8) | (int32_t)acq->rx[2];
+        if (raw & 0x800000) raw |= (int32_t)0xFF000000; /* sign extend */
+
+        if (acq->scan) ch = ADS1220_ScanOnConversion(acq->scan, raw, acq->t_drdy);
+
+        if (ch < 0) {
+            /* settling conversion after a MUX switch */
+        } else if ((uint16_t)(head - acq->tail) >= ADS1220_ACQ_RING) {
+            acq->dropped++;
+        } else {
+            acq->ring[head & RING_MASK].code    = raw;
+            acq->ring[head & RING_MASK].time    = acq->t_drdy;
+            acq->ring[head & RING_MASK].channel = (uint8_t)ch;
+            ADS1220_ACQ_BARRIER();
+            acq->head = (uint16_t)(head + 1u);
+            acq->count++;
+        }
+    }
+    acq->busy = 0;
+}
+
+uint16_t ADS1220_AcqRead(ADS1220_Acq_t *acq, ADS1220_Sample_t *out, uint16_t max)
+{
+    uint16_t tail = acq->tail;
+    uint16_t head = acq->head;
+    uint16_t n    = 0;
+
+    ADS1220_ACQ_BARRIER();
+    while (tail != head && n < max) {
+        out[n++] = acq->ring[tail & RING_MASK];
+        tail++;
+    }
+    ADS1220_ACQ_BARRIER();
+    acq->tail = tail;
+    return n;
+}
+
+uint16_t ADS1220_AcqPeek(ADS1220_Acq_t *acq, const ADS1220_Sample_t **out, uint16_t max)
+{
+    uint16_t tail = acq->tail;
+    uint16_t head = acq->head;
+    uint16_t n    = (uint16_t)(head - tail);
+    uint16_t wrap = (uint16_t)(ADS1220_ACQ_RING - (tail & RING_MASK));
+
+    ADS1220_ACQ_BARRIER();
+    if (n > wrap) n = wrap;
+    if (n > max)  n = max;
+    *out = &acq->ring[tail & RING_MASK];
+    return n;
+}
+
+void ADS1220_AcqCommit(ADS1220_Acq_t *acq, uint16_t n)
+{
+    /* the samples are read before their slots are handed back */
+    ADS1220_ACQ_BARRIER();
+    acq->tail = (uint16_t)(acq->tail + n);
+}
+
+uint16_t ADS1220_AcqPending(const ADS1220_Acq_t *acq)
+{
+    return (uint16_t)(acq->head - acq->tail);
+}
@@ -0,0 +1,98 @@
+#ifndef __ADS1220_ACQ_H__
+#define __ADS1220_ACQ_H__
+
+#include <stdint.h>
+#include "ads1220.h"
+#include "ads1220_scan.h"
+
+/* interrupt driven acquisition for the ADS1220 in continuous mode
+ * (HAL-free core, uses callbacks provided by app).
+ *
+ *   DRDY falling edge (EXTI) -> ADS1220_AcqOnDrdy():
+ *       note the time, CS low, start a 3-byte read (DMA)
+ *   read complete (DMA ISR)  -> ADS1220_AcqOnReadDone():
+ *       CS high, push { code, time } into the ring
+ *   main loop                -> ADS1220_AcqRead():
+ *       take a batch of samples out of the ring
+ *   or                       -> ADS1220_AcqPeek() / ADS1220_AcqCommit():
+ *       use a batch in place, then hand its slots back
+ *
+ * the ring has one producer (the read-complete ISR) and one consumer
+ * (the main loop), so head and tail are each written by one side only
+ * and no lock is needed. a blocking main loop (display flush) costs
+ * nothing as long as it drains the ring within ADS1220_ACQ_RING samples.
+ *
+ * with a scan list attached (scan != NULL) every conversion goes through
+ * ADS1220_ScanOnConversion first: the sample is tagged with its entry,
+ * settling conversions are not pushed, and the MUX switch is written from
+ * the read-complete interrupt through the blocking spiTxRx callback. */
+
+#define ADS1220_ACQ_RING    128u    /* samples, power of two: 64 ms at 2000 SPS */
+
+/* compiler barrier between the sample data and the index that
+ * publishes it (single core, no reordering by the CPU) */
+#ifndef ADS1220_ACQ_BARRIER
+#define ADS1220_ACQ_BARRIER()   __asm volatile ("" ::: "memory")
+#endif
+
+typedef struct {
+    int32_t  code;      /* 24-bit result, sign extended       */
+    uint32_t time;      /* timestamp() at the DRDY edge       */
+    uint8_t  channel;   /* scan entry, 0 without a scan list  */
+} ADS1220_Sample_t;
+
+typedef struct {
+    ADS1220_Handle_t *hads;     /* csLow/csHigh are used from the ISRs */
+
+    /* start a read of len bytes into rx with 0x00 on DIN (DMA), return
+     * 0 if started; its completion must call ADS1220_AcqOnReadDone */
+    int      (*readStart)(uint8_t *rx, uint16_t len);
+    /* free running time base (e.g. DWT cycle counter), may be NULL */
+    uint32_t (*timestamp)(void);
+    /* optional MUX scan list, set up with ADS1220_ScanInit */
+    ADS1220_Scan_t *scan;
+
+    /* state */
+    volatile uint8_t  running;
+    volatile uint8_t  busy;         /* read in progress           */
+    uint8_t           rx[3];
+    uint32_t          t_drdy;       /* time of the pending read   */
+
+    ADS1220_Sample_t  ring[ADS1220_ACQ_RING];
+    volatile uint16_t head;         /* written by the ISR only    */
+    volatile uint16_t tail;         /* written by AcqRead only    */
+
+    /* statistics */
+    volatile uint32_t count;        /* samples pushed             */
+    volatile uint32_t dropped;      /* ring full                  */
+    volatile uint32_t overruns;     /* DRDY while still reading   */
+    volatile uint32_t errors;       /* failed reads               */
+} ADS1220_Acq_t;
+
+/* clear ring and statistics, keep the callbacks */
+ADS1220_Status_t ADS1220_AcqInit(ADS1220_Acq_t *acq);
+
+/* accept DRDY edges from now on (device must be converting) */
+void             ADS1220_AcqStart(ADS1220_Acq_t *acq);
+
+/* ignore DRDY and wait for a running read to end, e.g. before register
+ * access through the blocking driver calls */
+void             ADS1220_AcqStop(ADS1220_Acq_t *acq);
+
+/* ISR hooks */
+void             ADS1220_AcqOnDrdy(ADS1220_Acq_t *acq);
+void             ADS1220_AcqOnReadDone(ADS1220_Acq_t *acq, int status);
+
+/* copy up to max samples, oldest first; returns the number copied */
+uint16_t         ADS1220_AcqRead(ADS1220_Acq_t *acq, ADS1220_Sample_t *out, uint16_t max);
+
+/* point *out at the oldest samples in the ring, without copying; returns
+ * up to max, contiguous (a batch stops at the end of the ring). the ISR
+ * does not reuse the slots until ADS1220_AcqCommit(acq, n) frees them */
+uint16_t         ADS1220_AcqPeek(ADS1220_Acq_t *acq, const ADS1220_Sample_t **out, uint16_t max);
+void             ADS1220_AcqCommit(ADS1220_Acq_t *acq, uint16_t n);
+
+/* samples waiting in the ring */
+uint16_t         ADS1220_AcqPending(const ADS1220_Acq_t *acq);
+
+#endif /* __ADS1220_ACQ_H__ */
@@ -0,0 +1,209 @@
+/**
+  ******************************************************************************
+  * @file    ads1220_bus.c
+  * @brief   Several ADS1220 on one SPI bus: DRDY queue, DMA reads and
+  *          frames of all devices (HAL-free core, uses callbacks provided
+  *          by app)
+  ******************************************************************************
+  */
+
+#include "ads1220_bus.h"
+
+#define RING_MASK   (ADS1220_BUS_RING - 1u)
+#define BUS_IDLE    0xFFu
+
+static uint32_t bus_time(const ADS1220_Bus_t *bus)
+{
+    return bus->timestamp ? bus->timestamp() : 0u;
+}
+
+/* start the read of dev, then of the queued devices until one starts */
+static void bus_start(ADS1220_Bus_t *bus, uint8_t dev)
+{
+    for (;;) {
+        uint32_t wait = bus_time(bus) - bus->t_drdy[dev];
+        if (wait > bus->max_wait) bus->max_wait = wait;
+
+        bus->active = dev;
+        bus->hads[dev]->csLow();
+        if (bus->readStart(bus->rx, 3) == 0) return;
+
+        bus->hads[dev]->csHigh();
+        bus->errors++;
+        bus->active = BUS_IDLE;
+        if (bus->q_len == 0) return;
+
+        dev = bus->queue[bus->q_head];
+        bus->q_head = (uint8_t)((bus->q_head + 1u) % ADS1220_BUS_MAX);
+        bus->q_len--;
+        bus->queued &= (uint8_t)~(1u << dev);
+    }
+}
+
+static void bus_frame(ADS1220_Bus_t *bus)
+{
+    uint16_t head = bus->head;
+    uint32_t t0   = bus->t_frame[0];
+    uint32_t t1   = bus->t_frame[0];
+
+    for (uint8_t i = 1; i < bus->count; i++) {
+        /* compare as differences, the time base wraps */
+        if ((int32_t)(bus->t_frame[i] - t0) < 0) t0 = bus->t_frame[i];
+        if ((int32_t)(bus->t_frame[i] - t1) > 0) t1 = bus->t_frame[i];
+    }
+    bus->next.time = t1;
+    bus->next.skew = t1 - t0;
+    bus->fresh     = 0;
+
+    if ((uint16_t)(head - bus->tail) >= ADS1220_BUS_RING) {
+        bus->dropped++;
+        return;
+    }
+    bus->ring[head & RING_MASK] = bus->next;
+    ADS1220_BUS_BARRIER();
+    bus->head = (uint16_t)(head + 1u);
+    bus->frames++;
+}
+
+ADS1220_Status_t ADS1220_BusInit(ADS1220_Bus_t *bus)
+{
+    if (!bus || !bus->readStart) return ADS1220_ERROR;
+    if (bus->count == 0 || bus->count > ADS1220_BUS_MAX) return ADS1220_ERROR;
+    for (uint8_t i = 0; i < bus->count; i++) {
+        if (!bus->hads[i] || !bus->hads[i]->csLow || !bus->hads[i]->csHigh) return ADS1220_ERROR;
+    }
+
+    bus->running  = 0;
+    bus->active   = BUS_IDLE;
+    bus->queued   = 0;
+    bus->q_head   = 0;
+    bus->q_len    = 0;
+    bus->fresh    = 0;
+    bus->head     = 0;
+    bus->tail     = 0;
+    bus->reads    = 0;
+    bus->frames   = 0;
+    bus->dropped  = 0;
+    bus->overruns = 0;
+    bus->replaced = 0;
+    bus->errors   = 0;
+    bus->max_wait = 0;
+    return ADS1220_OK;
+}
+
+void ADS1220_BusStart(ADS1220_Bus_t *bus)
+{
+    bus->fresh   = 0;
+    bus->running = 1;
+}
+
+void ADS1220_BusStop(ADS1220_Bus_t *bus)
+{
+    bus->running = 0;
+    bus->q_len   = 0;       /* the running read doesn't chain on */
+    bus->queued  = 0;
+    while (bus->active != BUS_IDLE) { }
+}
+
+void ADS1220_BusOnDrdy(ADS1220_Bus_t *bus, uint8_t dev)
+{
+    uint8_t bit = (uint8_t)(1u << dev);
+
+    if (!bus->running || dev >= bus->count) return;
+
+    /* still being read: the new result is lost */
+    if (bus->active == dev) {
+        bus->overruns++;
+        return;
+    }
+    /* still queued: the read will fetch the newer result */
+    if (bus->queued & bit) {
+        bus->overruns++;
+        bus->t_drdy[dev] = bus_time(bus);
+        return;
+    }
+
+    bus->t_drdy[dev] = bus_time(bus);
+    if (bus->active == BUS_IDLE) {
+        bus_start(bus, dev);
+    } else {
+        bus->queue[(bus->q_head + bus->q_len) % ADS1220_BUS_MAX] = dev;
+        bus->q_len++;
+        bus->queued |= bit;
+    }
+}
+
+void ADS1220_BusOnReadDone(ADS1220_Bus_t *bus, int status)
+{
+    uint8_t dev = bus->active;
+
+    if (dev == BUS_IDLE) return;
+    bus->hads[dev]->csHigh();
+
+    if (status != 0) {
+        bus->errors++;
+    } else {
+        uint8_t bit = (uint8_t)(1u << dev);
+        int32_t raw = ((int32_t)bus->rx[0] << 16) | ((int32_t)bus->rx[1] << 8) | (int32_t)bus->rx[2];
+        if (raw & 0x800000) raw |= (int32_t)0xFF000000; /* sign extend */
+
+        if (bus->fresh & bit) bus->replaced++;
+        bus->next.code[dev] = raw;
+        bus->t_frame[dev]   = bus->t_drdy[dev];
+        bus->fresh         |= bit;
+        bus->reads++;
+
+        if (bus->fresh == (uint8_t)((1u << bus->count) - 1u)) bus_frame(bus);
+    }
+
+    bus->active = BUS_IDLE;
+    if (bus->q_len != 0) {
+        dev = bus->queue[bus->q_head];
+        bus->q_head = (uint8_t)((bus->q_head + 1u) % ADS1220_BUS_MAX);
+        bus->q_len--;
+        bus->queued &= (uint8_t)~(1u << dev);
+        bus_start(bus, dev);
+    }
+}
+
+uint16_t ADS1220_BusRead(ADS1220_Bus_t *bus, ADS1220_BusFrame_t *out, uint16_t max)
+{
+    uint16_t tail = bus->tail;
+    uint16_t head = bus->head;
+    uint16_t n    = 0;
+
+    ADS1220_BUS_BARRIER();
+    while (tail != head && n < max) {
+        out[n++] = bus->ring[tail & RING_MASK];
+        tail++;
+    }
+    ADS1220_BUS_BARRIER();
+    bus->tail = tail;
+    return n;
+}
+
+static int16_t clamp16(int64_t v)
+{
+    if (v >  32767) return  32767;
+    if (v < -32767) return -32767;
+    return (int16_t)v;
+}
+
+int32_t ADS1220_BusCorners(const int32_t w[4], int16_t *x, int16_t *y)
+{
+    /* front-left, front-right, rear-left, rear-right */
+    int64_t total = (int64_t)w[0] + w[1] + w[2] + w[3];
+    int64_t right = (int64_t)w[1] + w[3] - w[0] - w[2];
+    int64_t rear  = (int64_t)w[2] + w[3] - w[0] - w[1];
+
+    if (total <= 0) {
+        if (x) *x = 0;
+        if (y) *y = 0;
+    } else {
+        if (x) *x = clamp16(right * 1000 / total);
+        if (y) *y = clamp16(rear  * 1000 / total);
+    }
+    if (total >  INT32_MAX) return INT32_MAX;
+    if (total < -INT32_MAX) return -INT32_MAX;
+    return (int32_t)total;
+}
@@ -0,0 +1,106 @@
+#ifndef __ADS1220_BUS_H__
+#define __ADS1220_BUS_H__
+
+#include <stdint.h>
+#include "ads1220.h"
+
+/* several ADS1220 on one SPI bus, each with its own CS and DRDY line
+ * (HAL-free core, uses callbacks provided by app).
+ *
+ *   DRDY i falls (EXTI)   -> ADS1220_BusOnDrdy(bus, i):
+ *       bus idle: CS i low, start the 3-byte DMA read at once
+ *       bus busy: queue device i (first come, first served)
+ *   read complete (DMA)   -> ADS1220_BusOnReadDone():
+ *       CS high, keep the result, start the next queued read
+ *   main loop             -> ADS1220_BusRead():
+ *       take complete frames, one fresh result of every device each
+ *
+ * no device waits for another one by polling: a read queued behind the
+ * others starts from the completion interrupt of the one before. with
+ * N devices the longest wait is N-1 reads (about 63 us each at 390 kHz),
+ * far below one conversion period, so nothing is lost as long as
+ * N * 63 us stays below it.
+ *
+ * the DRDY and DMA interrupts must have the same NVIC priority (they
+ * don't preempt each other), the queue is not locked otherwise.
+ *
+ * the devices run on their own oscillators, so their conversions drift
+ * against each other. a frame is closed as soon as every device has
+ * delivered a result since the last frame; a device that delivers twice
+ * in between overwrites its older result (counted in replaced). */
+
+#define ADS1220_BUS_MAX     4u
+#define ADS1220_BUS_RING    32u     /* frames, power of two */
+
+#ifndef ADS1220_BUS_BARRIER
+#define ADS1220_BUS_BARRIER()   __asm volatile ("" ::: "memory")
+#endif
+
+typedef struct {
+    int32_t  code[ADS1220_BUS_MAX]; /* latest result of every device     */
+    uint32_t time;                  /* DRDY time of the newest one       */
+    uint32_t skew;                  /* newest - oldest DRDY time         */
+} ADS1220_BusFrame_t;
+
+typedef struct {
+    /* one handle per device: csLow/csHigh select it, spiTxRx and the
+     * register functions are used for setup with the bus stopped */
+    ADS1220_Handle_t *hads[ADS1220_BUS_MAX];
+    uint8_t           count;
+
+    /* start a read of len bytes into rx with 0x00 on DIN (DMA), return
+     * 0 if started; its completion must call ADS1220_BusOnReadDone */
+    int      (*readStart)(uint8_t *rx, uint16_t len);
+    /* free running time base (e.g. DWT cycle counter), may be NULL */
+    uint32_t (*timestamp)(void);
+
+    /* state */
+    volatile uint8_t  running;
+    volatile uint8_t  active;       /* device being read, 0xFF = idle   */
+    uint8_t           queued;       /* bit per device waiting           */
+    uint8_t           queue[ADS1220_BUS_MAX];
+    uint8_t           q_head, q_len;
+    uint8_t           rx[3];
+    uint32_t          t_drdy[ADS1220_BUS_MAX];
+    uint8_t           fresh;        /* bit per device since last frame  */
+    uint32_t          t_frame[ADS1220_BUS_MAX];
+    ADS1220_BusFrame_t next;        /* frame being filled               */
+
+    ADS1220_BusFrame_t ring[ADS1220_BUS_RING];
+    volatile uint16_t head;         /* written by the ISR only          */
+    volatile uint16_t tail;         /* written by BusRead only          */
+
+    /* statistics */
+    volatile uint32_t reads;        /* results read from all devices    */
+    volatile uint32_t frames;       /* frames pushed                    */
+    volatile uint32_t dropped;      /* ring full                        */
+    volatile uint32_t overruns;     /* DRDY while its read was pending  */
+    volatile uint32_t replaced;     /* result overwritten in a frame    */
+    volatile uint32_t errors;       /* failed reads                     */
+    volatile uint32_t max_wait;     /* longest DRDY -> read start       */
+} ADS1220_Bus_t;
+
+/* clear queue, ring and statistics, keep the handles and callbacks */
+ADS1220_Status_t ADS1220_BusInit(ADS1220_Bus_t *bus);
+
+/* accept DRDY edges from now on (all devices converting) */
+void             ADS1220_BusStart(ADS1220_Bus_t *bus);
+
+/* ignore DRDY, drop the queue and wait for a running read to end */
+void             ADS1220_BusStop(ADS1220_Bus_t *bus);
+
+/* ISR hooks */
+void             ADS1220_BusOnDrdy(ADS1220_Bus_t *bus, uint8_t dev);
+void             ADS1220_BusOnReadDone(ADS1220_Bus_t *bus, int status);
+
+/* copy up to max frames, oldest first; returns the number copied */
+uint16_t         ADS1220_BusRead(ADS1220_Bus_t *bus, ADS1220_BusFrame_t *out, uint16_t max);
+
+/* four load cells at the corners of a platform, in the order
+ * front-left, front-right, rear-left, rear-right, already zeroed and
+ * scaled to a common unit. returns the total; x (left -> right) and y
+ * (front -> rear) get the center of gravity in 1/1000 of the half
+ * distance between the cells, 0 = center. both are 0 for total <= 0. */
+int32_t          ADS1220_BusCorners(const int32_t w[4], int16_t *x, int16_t *y);
+
+#endif /* __ADS1220_BUS_H__ */
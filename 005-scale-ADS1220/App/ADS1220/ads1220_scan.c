@@ -0,0 +1,90 @@
+/**
+  ******************************************************************************
+  * @file    ads1220_scan.c
+  * @brief   ADS1220 MUX scan list (HAL-free core, register writes go through
+  *          the driver callbacks)
+  ******************************************************************************
+  */
+
+#include "ads1220_scan.h"
+#include <string.h>
+
+ADS1220_Status_t ADS1220_ScanInit(ADS1220_Scan_t *scan)
+{
+    if (!scan || !scan->hads || !scan->list) return ADS1220_ERROR;
+    if (scan->count == 0 || scan->count > ADS1220_SCAN_MAX) return ADS1220_ERROR;
+
+    for (uint8_t i = 0; i < scan->count; i++) {
+        if (scan->list[i].samples == 0 || !scan->list[i].cfg.continuous) return ADS1220_ERROR;
+        if (ADS1220_ConfigToRegs(&scan->list[i].cfg, scan->regs[i]) != ADS1220_OK) return ADS1220_ERROR;
+    }
+
+    memset((void *)scan->result, 0, sizeof(scan->result));
+    scan->pos       = 0;
+    scan->cycle     = 0;
+    scan->taken     = 0;
+    scan->skip      = scan->list[0].discard;
+    scan->failed    = 0;
+    scan->switches  = 0;
+    scan->discarded = 0;
+    scan->stale     = 0;
+    scan->errors    = 0;
+
+    return ADS1220_Configure(scan->hads, &scan->list[0].cfg);
+}
+
+/* write the current entry's registers; the write restarts the conversion */
+static void scan_write(ADS1220_Scan_t *scan)
+{
+    if (ADS1220_ApplyRegisters(scan->hads, scan->regs[scan->pos], 0) != ADS1220_OK) {
+        scan->errors++;
+        scan->failed = 1;
+        return;
+    }
+    scan->failed = 0;
+    scan->skip   = scan->list[scan->pos].discard;
+    if (scan->drdyClear && scan->drdyClear()) scan->stale++;
+}
+
+int ADS1220_ScanOnConversion(ADS1220_Scan_t *scan, int32_t code, uint32_t time)
+{
+    int ch = -1;
+
+    /* the last write failed: the device runs the old entry, or a mix of
+     * both, so nothing is published until a write goes through */
+    if (scan->failed) {
+        scan->discarded++;
+        scan_write(scan);
+        return -1;
+    }
+
+    if (scan->skip) {
+        scan->skip--;
+        scan->discarded++;
+    } else {
+        scan->result[scan->pos].code = code;
+        scan->result[scan->pos].time = time;
+        scan->result[scan->pos].count++;
+        scan->taken++;
+        ch = scan->pos;
+    }
+
+    if (scan->count > 1 && scan->skip == 0 && scan->taken >= scan->list[scan->pos].samples) {
+        uint8_t next = scan->pos;
+
+        /* next entry due in this cycle (entry 0 always is) */
+        do {
+            next = (uint8_t)((next + 1u) % scan->count);
+            if (next == 0) scan->cycle++;
+        } while (next != 0 && scan->list[next].every > 1u &&
+                 (scan->cycle % scan->list[next].every) != 0u);
+
+        scan->taken = 0;
+        if (next != scan->pos) {
+            scan->pos = next;
+            scan->switches++;
+            scan_write(scan);
+        }
+    }
+    return ch;
+}
@@ -0,0 +1,82 @@
+#ifndef __ADS1220_SCAN_H__
+#define __ADS1220_SCAN_H__
+
+#include <stdint.h>
+#include "ads1220.h"
+
+/* MUX scan list for the ADS1220 in continuous mode (HAL-free core).
+ *
+ * the entries are converted in turn. each visit publishes `samples`
+ * conversions of its entry, then the next entry's registers are written
+ * (only the bytes that differ, see ADS1220_ApplyRegisters) right from the
+ * read-complete interrupt. the write restarts the conversion, and the
+ * ADS1220 filter settles in a single cycle, so the next conversion already
+ * belongs to the new entry: the switch costs one restarted conversion and
+ * no extra conversions. `discard` drops conversions after the switch for
+ * settling outside the ADC (RC filters, IDAC, bridge excitation).
+ * `every` leaves slow channels (offset, temperature) out of most cycles
+ * so the main channel keeps more of the conversions.
+ *
+ * a conversion that completes before the new setting was written still
+ * belongs to the old entry, so the switch is made right after a read, at
+ * the start of a conversion period. when the read-complete interrupt is
+ * held off for most of a period, one can still complete while the WREG
+ * is on the bus: its DRDY edge is latched and would be read as the new
+ * entry. drdyClear drops that edge right after the write; no conversion
+ * of the new entry can be ready before a full period has passed.
+ *
+ * a failed switch write leaves the device on the old entry or on a mix
+ * of both. the scan stays on the new entry, drops every conversion and
+ * retries the whole write at each one until it goes through (counted in
+ * errors and discarded); `discard` then starts from the good write. */
+
+#define ADS1220_SCAN_MAX    8u
+
+typedef struct {
+    ADS1220_Config_t cfg;       /* continuous must be set                 */
+    uint8_t          samples;   /* conversions published per visit, >= 1  */
+    uint8_t          discard;   /* conversions dropped after the switch   */
+    uint8_t          every;     /* visit every n-th cycle, 0/1 = always;
+                                   entry 0 is visited every cycle         */
+} ADS1220_ScanEntry_t;
+
+typedef struct {
+    int32_t  code;              /* latest result                          */
+    uint32_t time;              /* its DRDY timestamp                     */
+    uint32_t count;             /* results published                      */
+} ADS1220_ScanResult_t;
+
+typedef struct {
+    ADS1220_Handle_t          *hads;
+    const ADS1220_ScanEntry_t *list;
+    uint8_t                    count;
+    /* optional: clear a latched DRDY edge (EXTI pending bit), return 1
+       if one was pending */
+    uint8_t                  (*drdyClear)(void);
+
+    /* state */
+    uint8_t  pos;               /* entry being converted                  */
+    uint16_t cycle;             /* passes through the list                */
+    uint8_t  taken;             /* results of this visit                  */
+    uint8_t  skip;              /* conversions still to discard           */
+    uint8_t  failed;            /* switch write failed, retried per DRDY  */
+    uint8_t  regs[ADS1220_SCAN_MAX][4];     /* entries packed at init    */
+    volatile ADS1220_ScanResult_t result[ADS1220_SCAN_MAX];
+
+    /* statistics */
+    volatile uint32_t switches;
+    volatile uint32_t discarded;
+    volatile uint32_t stale;    /* old entry edges dropped at a switch    */
+    volatile uint32_t errors;   /* failed register writes                 */
+} ADS1220_Scan_t;
+
+/* pack and check all entries, configure (and verify) the first one.
+   blocking SPI: call with the acquisition engine stopped */
+ADS1220_Status_t ADS1220_ScanInit(ADS1220_Scan_t *scan);
+
+/* one conversion of the current entry, from the read-complete interrupt.
+   returns the entry index to publish the result under, or -1 to drop it.
+   switches to the next entry when the visit is complete. */
+int              ADS1220_ScanOnConversion(ADS1220_Scan_t *scan, int32_t code, uint32_t time);
+
+#endif /* __ADS1220_SCAN_H__ */
@@ -0,0 +1,171 @@
+/**
+  ******************************************************************************
+  * @file    calib.c
+  * @brief   Multi-point piecewise-linear load cell calibration with
+  *          temperature compensation (HAL-free, fixed point)
+  ******************************************************************************
+  */
+
+#include "calib.h"
+
+#define SPAN_ONE        ((int32_t)1 << 30)
+#define TEMP_MIN_STEP   64          /* 2 degC in 1/32 degC */
+/* 1/32 degC * Q8 ppm -> relative change: 32 * 256 * 1e6, here / 1000 */
+#define SPAN_DEN        8192000LL
+
+void Calib_Clear(Calib_t *c)
+{
+    c->tab.count    = 0;
+    c->tab.reserved = 0;
+    c->valid        = 0;
+    Calib_SetTemperature(c, c->temp);
+}
+
+Calib_Status_t Calib_AddPoint(Calib_t *c, int32_t code, int32_t weight)
+{
+    uint8_t i, n = c->tab.count;
+
+    /* same mass again: take it out first */
+    for (i = 0; i < n; i++) {
+        if (c->tab.pt[i].weight == weight) {
+            for (; i + 1u < n; i++) c->tab.pt[i] = c->tab.pt[i + 1u];
+            n--;
+            break;
+        }
+    }
+    if (n >= CALIB_POINTS_MAX) return CALIB_ERROR;
+
+    /* insert sorted by code */
+    for (i = n; i > 0 && c->tab.pt[i - 1u].code > code; i--) c->tab.pt[i] = c->tab.pt[i - 1u];
+    c->tab.pt[i].code   = code;
+    c->tab.pt[i].weight = weight;
+    c->tab.count        = (uint8_t)(n + 1u);
+    c->tab.temp0        = c->temp;      /* the temperature at calibration */
+    c->valid            = 0;
+    return CALIB_OK;
+}
+
+Calib_Status_t Calib_Fit(Calib_t *c)
+{
+    const Calib_Point_t *p = c->tab.pt;
+    uint8_t n = c->tab.count;
+    int     dir = 0;
+
+    c->valid = 0;
+    if (n < 2 || n > CALIB_POINTS_MAX) return CALIB_ERROR;
+
+    /* masses must rise (or fall, cell mounted the other way) with the code */
+    for (uint8_t i = 0; i + 1u < n; i++) {
+        int32_t dc = p[i + 1u].code - p[i].code;
+        int32_t dw = p[i + 1u].weight - p[i].weight;
+        int     d  = (dw > 0) ? 1 : -1;
+        if (dc <= 0 || dw == 0 || (dir != 0 && d != dir)) return CALIB_NOT_MONOTONIC;
+        dir = d;
+    }
+
+    for (uint8_t i = 0; i + 1u < n; i++) {
+        int64_t dw = (int64_t)(p[i + 1u].weight - p[i].weight) * ((int64_t)1 << CALIB_SHIFT);
+        int64_t dc = p[i + 1u].code - p[i].code;
+        int64_t s  = (dw >= 0 ? dw + dc / 2 : dw - dc / 2) / dc;
+        if (s > INT32_MAX || s < -INT32_MAX) return CALIB_ERROR;
+        c->slope[i] = (int32_t)s;
+    }
+
+    c->valid = 1;
+    Calib_SetTemperature(c, c->temp);
+    return CALIB_OK;
+}
+
+static int32_t calib_curve(const Calib_t *c, int32_t code)
+{
+    const Calib_Point_t *p = c->tab.pt;
+    uint8_t last = (uint8_t)(c->tab.count - 2u);
+    uint8_t i    = 0;
+
+    /* segment: the last one starting at or below the code */
+    while (i < last && code >= p[i + 1u].code) i++;
+
+    return p[i].weight +
+           (int32_t)(((int64_t)(code - p[i].code) * c->slope[i] +
+                      ((int64_t)1 << (CALIB_SHIFT - 1u))) >> CALIB_SHIFT);
+}
+
+int32_t Calib_Weight(const Calib_t *c, int32_t code)
+{
+    int32_t w;
+
+    if (!c->valid) return 0;
+    w = calib_curve(c, code - c->zero_corr);
+    if (c->span_q30 != SPAN_ONE) {
+        w = (int32_t)(((int64_t)w * c->span_q30 + (SPAN_ONE >> 1)) >> 30);
+    }
+    return w;
+}
+
+int32_t Calib_CodesPerGram(const Calib_t *c)
+{
+    const Calib_Point_t *p = c->tab.pt;
+    int32_t dw, cpg;
+
+    if (!c->valid) return 0;
+    dw  = p[c->tab.count - 1u].weight - p[0].weight;
+    if (dw < 0) dw = -dw;
+    cpg = (int32_t)(((int64_t)(p[c->tab.count - 1u].code - p[0].code) * 10) / dw);
+    return cpg > 0 ? cpg : 1;
+}
+
+void Calib_SetTemperature(Calib_t *c, int16_t temp)
+{
+    int32_t dt = (int32_t)temp - c->tab.temp0;
+    int64_t den;
+
+    c->temp      = temp;
+    /* Q8 codes/degC * 1/32 degC */
+    c->zero_corr = (int32_t)(((int64_t)c->tab.tc_zero * dt + (1 << 12)) >> 13);
+
+    den = SPAN_DEN + ((int64_t)c->tab.tc_span * dt) / 1000;
+    if (den <= SPAN_DEN / 2) den = SPAN_DEN / 2;    /* nonsense coefficient */
+    c->span_q30 = (c->tab.tc_span == 0) ? SPAN_ONE
+                                        : (int32_t)(((int64_t)SPAN_ONE * SPAN_DEN) / den);
+}
+
+Calib_Status_t Calib_LearnZeroTc(Calib_t *c, int32_t code_empty)
+{
+    const Calib_Point_t *p = c->tab.pt;
+    int32_t dt = (int32_t)c->temp - c->tab.temp0;
+    int64_t code0;
+    uint8_t i = 0;
+
+    if (!c->valid) return CALIB_ERROR;
+    if (dt < TEMP_MIN_STEP && dt > -TEMP_MIN_STEP) return CALIB_TOO_CLOSE;
+
+    /* code of 0 g at calibration: inverse of the segment holding 0 g
+       (or the end segment nearest to it) */
+    if ((p[0].weight > 0) != (p[1].weight > p[0].weight)) {
+        while (i + 2u < c->tab.count &&
+               !((p[i].weight <= 0 && p[i + 1u].weight >= 0) ||
+                 (p[i].weight >= 0 && p[i + 1u].weight <= 0))) i++;
+    }
+    code0 = p[i].code + ((int64_t)(0 - p[i].weight) * (p[i + 1u].code - p[i].code)) /
+                        (p[i + 1u].weight - p[i].weight);
+
+    /* Q8 codes per degC from a step of dt/32 degC */
+    c->tab.tc_zero = (int32_t)((((int64_t)code_empty - code0) * 8192) / dt);
+    Calib_SetTemperature(c, c->temp);
+    return CALIB_OK;
+}
+
+Calib_Status_t Calib_LearnSpanTc(Calib_t *c, int32_t code, int32_t weight)
+{
+    int32_t dt = (int32_t)c->temp - c->tab.temp0;
+    int32_t w;
+
+    if (!c->valid || weight == 0) return CALIB_ERROR;
+    if (dt < TEMP_MIN_STEP && dt > -TEMP_MIN_STEP) return CALIB_TOO_CLOSE;
+
+    /* zero corrected, span not: relative error (w - weight) / weight */
+    w = calib_curve(c, code - c->zero_corr);
+    c->tab.tc_span = (int32_t)((((int64_t)w - weight) * SPAN_DEN * 1000) / ((int64_t)weight * dt));
+    Calib_SetTemperature(c, c->temp);
+    return CALIB_OK;
+}
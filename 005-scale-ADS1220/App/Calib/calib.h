@@ -0,0 +1,90 @@
+#ifndef __CALIB_H__
+#define __CALIB_H__
+
+#include <stdint.h>
+
+/* multi-point load cell calibration with temperature compensation
+ * (HAL-free, fixed point, no division per sample).
+ *
+ * up to CALIB_POINTS_MAX reference points (ADC code, known mass) are
+ * captured, normally the empty platform first. the curve through them is
+ * piecewise linear; Calib_Fit turns every segment into a slope in
+ * Q(CALIB_SHIFT) so that a reading costs a short segment search, one
+ * 32x32->64 multiply and a shift:
+ *
+ *   w = pt[i].weight + ((code - pt[i].code) * slope[i]) >> CALIB_SHIFT
+ *
+ * below the first and above the last point the end segments continue.
+ *
+ * temperature (1/32 degC, the ADS1220 sensor code >> 10) corrects
+ *   zero: tc_zero codes/degC (Q8) are taken off the code,
+ *   span: the weight is scaled by 1 / (1 + tc_span ppm/degC (Q8) * dT)
+ * against temp0, the temperature at calibration. both factors are
+ * worked out in Calib_SetTemperature, not per sample. the coefficients
+ * are learned by weighing at a second temperature (Calib_LearnZeroTc,
+ * Calib_LearnSpanTc). */
+
+#define CALIB_POINTS_MAX    6u
+#define CALIB_SHIFT         24u
+
+typedef struct {
+    int32_t code;               /* raw ADC code                          */
+    int32_t weight;             /* reference mass, grams * 10            */
+} Calib_Point_t;
+
+/* the persistent part, stored in flash as is */
+typedef struct {
+    uint8_t        count;       /* points, < 2 = not calibrated          */
+    uint8_t        reserved;
+    int16_t        temp0;       /* at calibration, 1/32 degC             */
+    int32_t        tc_zero;     /* codes per degC, Q8                    */
+    int32_t        tc_span;     /* ppm per degC, Q8                      */
+    Calib_Point_t  pt[CALIB_POINTS_MAX];    /* ascending code            */
+} Calib_Table_t;
+
+typedef struct {
+    Calib_Table_t tab;
+
+    /* worked out by Calib_Fit / Calib_SetTemperature */
+    int32_t slope[CALIB_POINTS_MAX - 1u];   /* weight per code, Q24     */
+    int32_t zero_corr;          /* codes taken off at this temperature   */
+    int32_t span_q30;           /* weight factor, 1.0 = 1 << 30          */
+    int16_t temp;               /* last temperature                      */
+    uint8_t valid;
+} Calib_t;
+
+typedef enum {
+    CALIB_OK      = 0,
+    CALIB_ERROR   = -1,         /* bad argument, table full              */
+    CALIB_NOT_MONOTONIC = -2,   /* codes and masses don't rise together  */
+    CALIB_TOO_CLOSE = -3        /* temperature step too small to learn   */
+} Calib_Status_t;
+
+/* drop all points, keep the temperature coefficients */
+void           Calib_Clear(Calib_t *c);
+
+/* add a point, or replace the one with the same mass; keeps the table
+ * sorted by code and takes the current temperature as temp0. call
+ * Calib_Fit afterwards */
+Calib_Status_t Calib_AddPoint(Calib_t *c, int32_t code, int32_t weight);
+
+/* check the points and work out the segment slopes */
+Calib_Status_t Calib_Fit(Calib_t *c);
+
+/* code -> grams * 10 (0 while not valid) */
+int32_t        Calib_Weight(const Calib_t *c, int32_t code);
+
+/* codes per gram over the whole table (for thresholds in codes) */
+int32_t        Calib_CodesPerGram(const Calib_t *c);
+
+/* temperature for the compensation, 1/32 degC */
+void           Calib_SetTemperature(Calib_t *c, int16_t temp);
+
+/* zero drift from the empty platform at the current temperature */
+Calib_Status_t Calib_LearnZeroTc(Calib_t *c, int32_t code_empty);
+
+/* span drift from a known mass at the current temperature (learn the
+ * zero drift first) */
+Calib_Status_t Calib_LearnSpanTc(Calib_t *c, int32_t code, int32_t weight);
+
+#endif /* __CALIB_H__ */
@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file    ztrack.c
+  * @brief   Automatic zero tracking and ADC offset compensation (HAL-free,
+  *          fixed point)
+  ******************************************************************************
+  */
+
+#include "ztrack.h"
+
+#define Q8(x)   ((int64_t)(x) * 256)
+
+static int32_t q8_round(int64_t v)
+{
+    return (int32_t)((v + 128) >> 8);
+}
+
+void ZTrack_Set(ZTrack_t *z, int32_t x)
+{
+    z->zero_q8  = Q8(x);
+    z->zero_ref = x;
+    z->zero     = x;
+    z->since_ms = z->last_ms;
+    z->step_rem = 0;
+    z->active   = 1;
+    z->loaded   = 0;
+    z->tracking = 0;
+    z->at_limit = 0;
+}
+
+void ZTrack_Stop(ZTrack_t *z)
+{
+    z->active   = 0;
+    z->tracking = 0;
+}
+
+int32_t ZTrack_Update(ZTrack_t *z, int32_t x, uint8_t stable, uint32_t now_ms)
+{
+    uint32_t dt = now_ms - z->last_ms;
+    int32_t  wide = (z->recapture > z->band) ? z->recapture : z->band;
+    int64_t  e, win, step, lo, hi;
+
+    z->last_ms  = now_ms;
+    z->tracking = 0;
+    if (!z->active) return z->zero;
+
+    /* empty platform: stable and close to the zero, for hold_ms. after a
+     * load the window is widened to recapture until back in the band */
+    e = Q8(x) - z->zero_q8;
+    if (e > Q8(wide) || e < -Q8(wide)) z->loaded = 1;
+    win = Q8(z->loaded ? wide : z->band);
+    if (!stable || e > win || e < -win) {
+        z->since_ms = now_ms;
+        z->step_rem = 0;
+        return z->zero;
+    }
+    if ((now_ms - z->since_ms) < z->hold_ms) return z->zero;
+    if (e <= Q8(z->band) && e >= -Q8(z->band)) z->loaded = 0;
+
+    /* towards the reading, at most rate * dt; a long gap counts as 1 s.
+     * what is left below 1/256 code is carried, unless the step is cut
+     * short by the reading itself */
+    if (dt > 1000u) dt = 1000u;
+    step = (int64_t)z->rate * 256 * dt + z->step_rem;
+    z->step_rem = (uint32_t)(step % 1000);
+    step /= 1000;
+    if (e > step)       e = step;
+    else if (e < -step) e = -step;
+    else                z->step_rem = 0;
+    if (e == 0) return z->zero;
+
+    lo = Q8(z->zero_ref - z->limit);
+    hi = Q8(z->zero_ref + z->limit);
+    z->at_limit = 0;
+    z->zero_q8 += e;
+    if (z->zero_q8 < lo) { z->zero_q8 = lo; z->at_limit = 1; }
+    if (z->zero_q8 > hi) { z->zero_q8 = hi; z->at_limit = 1; }
+
+    z->zero     = q8_round(z->zero_q8);
+    z->tracking = 1;
+    z->corrections++;
+    return z->zero;
+}
+
+int32_t ZTrack_OffsetSample(ZTrack_t *z, int32_t code)
+{
+    if (!z->offset_valid) {
+        z->offset_q8    = Q8(code);
+        z->offset_valid = 1;
+    } else {
+        z->offset_q8 += (Q8(code) - z->offset_q8) / ((int64_t)1 << z->offset_shift);
+    }
+    z->offset = q8_round(z->offset_q8);
+    z->offset_samples++;
+    return z->offset;
+}
@@ -0,0 +1,78 @@
+#ifndef __ZTRACK_H__
+#define __ZTRACK_H__
+
+#include <stdint.h>
+
+/* automatic zero tracking and ADC offset compensation (HAL-free, fixed
+ * point, all values in ADC codes).
+ *
+ * zero tracking: after ZTrack_Set (the manual tare) the zero follows the
+ * reading while the platform is empty, i.e. the reading is stable and
+ * within `band` of the zero for at least hold_ms. the zero moves towards
+ * the reading by at most `rate` codes per second, kept as Q8 so slow
+ * rates still move, and never further than `limit` from the tared zero.
+ * a load put on slowly, or left on, is therefore not tared away: it is
+ * either outside the band or stops the tracking at the limit.
+ * the part of a step below 1/256 code is carried to the next update, so
+ * the rate holds however often ZTrack_Update is called (main.c calls it
+ * on every loop pass, about once per ms).
+ *
+ * recapture: drift while the platform is loaded (creep recovery, the
+ * temperature) can leave the empty reading outside the band. after a
+ * reading further than `recapture` from the zero (a load), the next
+ * stable reading within `recapture` is tracked as well, until it is back
+ * in the band. a load smaller than `recapture` put on right after an
+ * unload is tracked away at `rate`. typical settings: rate 0.5 division
+ * per second (OIML R76), band 0.5 to a few divisions, recapture a few
+ * divisions, limit a few percent of the capacity.
+ *
+ * offset: conversions of the shorted ADC input (ADS1220_IN_SHORTED,
+ * same gain) measure the offset of the PGA and the modulator, which
+ * drifts with temperature and shifts every reading, loaded or not.
+ * ZTrack_OffsetSample averages them (first order, 1 / 2^offset_shift
+ * per sample, the first one is taken as is); the bridge codes are
+ * corrected with z->offset before any further use. */
+
+typedef struct {
+    /* settings, may be changed at any time */
+    int32_t  band;          /* |reading - zero| tracked, codes          */
+    int32_t  recapture;     /* |reading - zero| tracked after a load    */
+    int32_t  rate;          /* largest correction, codes per second     */
+    int32_t  limit;         /* largest |zero - tared zero|, codes       */
+    uint16_t hold_ms;       /* stable and in band this long first       */
+    uint8_t  offset_shift;  /* offset average, 1 / 2^n per sample       */
+
+    /* state */
+    int64_t  zero_q8;       /* zero, Q8 (over 32 bits for 24-bit codes) */
+    int32_t  zero_ref;      /* zero at the last ZTrack_Set              */
+    uint32_t last_ms;
+    uint32_t step_rem;      /* rate * 256 * ms not yet moved, / 1000    */
+    uint32_t since_ms;      /* start of the current stable, in band run */
+    uint8_t  active;        /* set by ZTrack_Set                        */
+    uint8_t  loaded;        /* beyond recapture since last in the band  */
+    int64_t  offset_q8;
+    uint8_t  offset_valid;
+
+    /* output */
+    int32_t  zero;          /* tracked zero, codes                      */
+    int32_t  offset;        /* ADC offset to subtract, codes            */
+    uint8_t  tracking;      /* zero moved in the last update            */
+    uint8_t  at_limit;      /* held at zero_ref +- limit                */
+    uint32_t corrections;   /* updates that moved the zero              */
+    uint32_t offset_samples;
+} ZTrack_t;
+
+/* manual zero / tare at code x, starts the tracking */
+void    ZTrack_Set(ZTrack_t *z, int32_t x);
+
+/* stop tracking (the zero keeps its value), keep the offset */
+void    ZTrack_Stop(ZTrack_t *z);
+
+/* one filtered reading x (offset corrected) with its stable flag;
+ * returns the zero (also in z->zero) */
+int32_t ZTrack_Update(ZTrack_t *z, int32_t x, uint8_t stable, uint32_t now_ms);
+
+/* one conversion of the shorted input; returns the offset estimate */
+int32_t ZTrack_OffsetSample(ZTrack_t *z, int32_t code);
+
+#endif /* __ZTRACK_H__ */
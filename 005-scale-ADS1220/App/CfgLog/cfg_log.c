@@ -0,0 +1,181 @@
+/**
+  ******************************************************************************
+  * @file    cfg_log.c
+  * @brief   Append-only settings log in flash (HAL-free core, uses callbacks
+  *          provided by app)
+  ******************************************************************************
+  */
+
+#include "cfg_log.h"
+#include <string.h>
+
+#define ERASED_WORD  0xFFFFFFFFUL
+
+/* nibble table, polynomial 0xEDB88320 */
+static const uint32_t crc_nibble[16] = {
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+    0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+    0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+uint32_t CfgLog_Crc32(uint32_t crc, const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ crc_nibble[crc & 0x0Fu];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0x0Fu];
+    }
+    return ~crc;
+}
+
+static uint32_t pad4(uint32_t n) { return (n + 3u) & ~3u; }
+
+static uint32_t word_at(const CfgLog_Handle_t *h, uint8_t a, uint32_t off)
+{
+    return h->area[a][off / 4u];
+}
+
+static uint8_t area_formatted(const CfgLog_Handle_t *h, uint8_t a)
+{
+    return word_at(h, a, 0u) == CFGLOG_AREA_MAGIC &&
+           word_at(h, a, 4u) == h->slot_size;
+}
+
+static uint8_t slot_erased(const CfgLog_Handle_t *h, uint8_t a, uint32_t off)
+{
+    for (uint32_t i = 0u; i < h->slot_size; i += 4u)
+        if (word_at(h, a, off + i) != ERASED_WORD) return 0u;
+    return 1u;
+}
+
+/* CRC of a slot's header and data, read word by word from flash */
+static uint8_t record_valid(const CfgLog_Handle_t *h, uint8_t a, uint32_t off)
+{
+    uint32_t hdr = word_at(h, a, off + 4u);
+    uint32_t len = hdr >> 16;
+    uint32_t end = CFGLOG_REC_HDR + pad4(len);
+    uint32_t crc = 0u;
+
+    if (word_at(h, a, off) == ERASED_WORD) return 0u;
+    if (end + 4u > h->slot_size)           return 0u;
+
+    for (uint32_t i = 0u; i < end; i += 4u) {
+        uint32_t w = word_at(h, a, off + i);
+        crc = CfgLog_Crc32(crc, &w, 4u);
+    }
+    return word_at(h, a, off + end) == crc;
+}
+
+CfgLog_Status_t CfgLog_Init(CfgLog_Handle_t *h)
+{
+    uint32_t next[2] = { 0u, 0u };
+    uint8_t  found   = 0u;
+
+    if (!h || !h->area[0] || !h->area[1] || !h->program || !h->erase) return CFGLOG_ERROR;
+    if (h->slot_size < CFGLOG_REC_EXTRA + 4u || h->slot_size > CFGLOG_SLOT_MAX ||
+        (h->slot_size & 3u) || h->area_size < CFGLOG_AREA_HDR + h->slot_size)
+        return CFGLOG_ERROR;
+
+    h->active      = 0u;
+    h->newest_area = 0u;
+    h->newest      = 0u;
+    h->seq         = 0u;
+    h->erases      = 0u;
+
+    for (uint8_t a = 0u; a < 2u; a++) {
+        if (!area_formatted(h, a)) continue;
+
+        /* slots are filled in order: the first erased one ends the log */
+        uint32_t off = CFGLOG_AREA_HDR;
+        for (; off + h->slot_size <= h->area_size; off += h->slot_size) {
+            if (slot_erased(h, a, off)) break;
+            if (!record_valid(h, a, off)) continue;     /* torn write */
+
+            uint32_t seq = word_at(h, a, off);
+            if (!found || seq > h->seq) {
+                found          = 1u;
+                h->seq         = seq;
+                h->newest      = off;
+                h->newest_area = a;
+                h->active      = a;
+            }
+        }
+        next[a] = (off + h->slot_size <= h->area_size) ? off : h->area_size;
+        /* a formatted area without records can still take the next one */
+        if (!found && a == 1u && next[0] == 0u) h->active = 1u;
+    }
+
+    h->next = next[h->active];
+    return found ? CFGLOG_OK : CFGLOG_EMPTY;
+}
+
+CfgLog_Status_t CfgLog_Load(const CfgLog_Handle_t *h, uint16_t version, void *data, uint16_t len)
+{
+    uint32_t words[CFGLOG_SLOT_MAX / 4u];
+    uint32_t hdr;
+
+    if (!h || !data) return CFGLOG_ERROR;
+    if (h->newest == 0u) return CFGLOG_EMPTY;
+
+    hdr = word_at(h, h->newest_area, h->newest + 4u);
+    if ((hdr & 0xFFFFu) != version || (hdr >> 16) != len) return CFGLOG_EMPTY;
+
+    for (uint32_t i = 0u; i < pad4(len); i += 4u)
+        words[i / 4u] = word_at(h, h->newest_area, h->newest + CFGLOG_REC_HDR + i);
+    memcpy(data, words, len);
+    return CFGLOG_OK;
+}
+
+/* erase an area and write its header; the log continues there */
+static CfgLog_Status_t area_start(CfgLog_Handle_t *h, uint8_t a)
+{
+    uint32_t hdr[2] = { CFGLOG_AREA_MAGIC, h->slot_size };
+
+    h->erases++;
+    if (h->erase(a) != 0) return CFGLOG_ERROR;
+    if (h->program(a, 0u, hdr, 2u) != 0) return CFGLOG_ERROR;
+    h->active = a;
+    h->next   = CFGLOG_AREA_HDR;
+    return CFGLOG_OK;
+}
+
+CfgLog_Status_t CfgLog_Save(CfgLog_Handle_t *h, uint16_t version, const void *data, uint16_t len)
+{
+    uint32_t words[CFGLOG_SLOT_MAX / 4u];
+    uint32_t n   = (CFGLOG_REC_HDR + pad4(len)) / 4u;
+    uint32_t crc = 0u;
+
+    if (!h || !data) return CFGLOG_ERROR;
+    if (CFGLOG_REC_EXTRA + pad4(len) > h->slot_size) return CFGLOG_ERROR;
+
+    /* first save ever, or the active area is full: the other one is
+     * erased; the newest record stays where it is (newest_area) until a
+     * record in the new area has been written and checked */
+    if (h->next == 0u) {
+        if (area_start(h, h->active) != CFGLOG_OK) return CFGLOG_ERROR;
+    } else if (h->next + h->slot_size > h->area_size) {
+        if (area_start(h, (uint8_t)(h->active ^ 1u)) != CFGLOG_OK) return CFGLOG_ERROR;
+    }
+
+    memset(words, 0, sizeof(words));
+    words[0] = h->seq + 1u;
+    words[1] = (uint32_t)version | ((uint32_t)len << 16);
+    memcpy(&words[2], data, len);
+    for (uint32_t i = 0u; i < n; i++) crc = CfgLog_Crc32(crc, &words[i], 4u);
+    words[n] = crc;
+
+    /* the slot is used even if programming fails part way */
+    uint32_t off = h->next;
+    h->next += h->slot_size;
+    if (h->program(h->active, off, words, n + 1u) != 0) return CFGLOG_ERROR;
+    if (!record_valid(h, h->active, off))              return CFGLOG_ERROR;
+
+    h->seq         = words[0];
+    h->newest      = off;
+    h->newest_area = h->active;
+    return CFGLOG_OK;
+}
@@ -0,0 +1,241 @@
+/**
+  ******************************************************************************
+  * @file    checkw.c
+  * @brief   Checkweigher: item detection, plateau estimate and batch
+  *          statistics for dynamic weighing (HAL-free, fixed point)
+  ******************************************************************************
+  */
+
+#include "checkw.h"
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0, bit = (uint64_t)1 << 62;
+
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) { v -= r + bit; r = (r >> 1) + bit; }
+        else              { r >>= 1; }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+/* window of length w with the least variance over d = (x - ref) >> sh;
+ * returns w * sum(d^2) - sum(d)^2 (= variance * w^2) and its start in
+ * *pos */
+static int64_t flattest(const int32_t *buf, uint16_t n, uint16_t w, int32_t ref, uint8_t sh, uint16_t *pos)
+{
+    int64_t s1 = 0, s2 = 0, best;
+
+    for (uint16_t i = 0; i < w; i++) {
+        int32_t d = (buf[i] - ref) >> sh;
+        s1 += d;
+        s2 += (int64_t)d * d;
+    }
+    best = (int64_t)w * s2 - s1 * s1;
+    *pos = 0;
+    for (uint16_t i = w; i < n; i++) {
+        int32_t a = (buf[i] - ref) >> sh, b = (buf[i - w] - ref) >> sh;
+        int64_t v;
+        s1 += a - b;
+        s2 += (int64_t)a * a - (int64_t)b * b;
+        v   = (int64_t)w * s2 - s1 * s1;
+        if (v < best) { best = v; *pos = (uint16_t)(i - w + 1u); }
+    }
+    return best;
+}
+
+/* the loaded samples -> c->item */
+static void estimate(CheckW_t *c, uint32_t time)
+{
+    CheckW_Item_t *it  = &c->item;
+    uint16_t       n   = c->n, lo, hi, w, pos = 0;
+    int32_t        ref = c->buf[n / 2u], span = 0, noise;
+    int64_t        lim, var, sum = 0;
+    uint8_t        sh  = 0;
+
+    it->samples = n;
+    it->time    = time;
+    it->flags  &= CHECKW_F_LONG;
+
+    /* scale the deviations down until the sums fit 64 bits */
+    for (uint16_t i = 0; i < n; i++) {
+        int32_t d = c->buf[i] - ref;
+        if (d < 0) d = -d;
+        if (d > span) span = d;
+    }
+    while ((span >> sh) > CHECKW_DEV_MAX) sh++;
+    noise = c->noise >> sh;
+
+    /* longest window within noise: halving over lo..hi */
+    lo = c->plateau_min ? c->plateau_min : 1u;
+    if (lo >= n) {
+        it->flags |= CHECKW_F_SHORT;
+        lo = n;
+    }
+    hi = n;
+    w  = lo;
+    while (lo <= hi) {
+        uint16_t mid = (uint16_t)((lo + hi) / 2u);
+        uint16_t p;
+        lim = (int64_t)noise * noise * mid * mid;
+        if (flattest(c->buf, n, mid, ref, sh, &p) <= lim) { w = mid; lo = (uint16_t)(mid + 1u); }
+        else                                          { hi = (uint16_t)(mid - 1u); }
+    }
+    /* its flattest 3/4: the ends of the longest one still ring */
+    if (w - w / 4u >= c->plateau_min) w = (uint16_t)(w - w / 4u);
+    var = flattest(c->buf, n, w, ref, sh, &pos);
+    if (var > (int64_t)noise * noise * w * w) it->flags |= CHECKW_F_UNSTABLE;
+    it->window = w;
+    it->spread = (int32_t)((isqrt64((uint64_t)(var < 0 ? 0 : var)) / w) << sh);
+
+    /* interquartile mean: sort the window in place, average the middle half */
+    {
+        int32_t *v = &c->buf[pos];
+        uint16_t q = (uint16_t)(w / 4u);
+
+        for (uint16_t i = 1; i < w; i++) {
+            int32_t  t = v[i];
+            uint16_t j = i;
+            while (j > 0 && v[j - 1u] > t) { v[j] = v[j - 1u]; j--; }
+            v[j] = t;
+        }
+        for (uint16_t i = q; i < w - q; i++) sum += v[i];
+        it->plateau = (int32_t)(sum / (w - 2u * q)) - c->zero;
+    }
+}
+
+void CheckW_Reset(CheckW_t *c)
+{
+    c->started  = 0;
+    c->loaded   = 0;
+    c->run      = 0;
+    c->zero     = 0;
+    c->zero_acc = 0;
+    c->n        = 0;
+    c->items    = 0;
+}
+
+uint8_t CheckW_Process(CheckW_t *c, int32_t x, uint32_t time)
+{
+    int32_t d;
+
+    if (!c->started) {
+        c->zero     = x;
+        c->zero_acc = (int64_t)x * ((int64_t)1 << c->zero_shift);
+        c->started  = 1;
+    }
+    d = x - c->zero;
+
+    if (!c->loaded) {
+        if (d > c->on_level) {
+            if (++c->run >= c->confirm) {
+                c->loaded     = 1;
+                c->run        = 0;
+                c->n          = 0;
+                c->item.peak  = d;
+                c->item.flags = 0;
+            }
+        } else {
+            c->run = 0;
+            /* empty: follow the platform level, not the edges of a load */
+            if (d <= c->zero_band && d >= -c->zero_band) {
+                c->zero_acc += x - c->zero;
+                c->zero      = (int32_t)(c->zero_acc >> c->zero_shift);
+            }
+        }
+        return 0;
+    }
+
+    if (c->n < CHECKW_BUF) c->buf[c->n++] = x;
+    else                   c->item.flags |= CHECKW_F_LONG;
+    if (d > c->item.peak) c->item.peak = d;
+
+    if (d >= c->off_level) {
+        c->run = 0;
+        return 0;
+    }
+    if (++c->run < c->confirm) return 0;
+
+    /* departure */
+    c->loaded = 0;
+    c->run    = 0;
+    estimate(c, time);
+    c->items++;
+    return 1;
+}
+
+void CheckW_BatchReset(CheckW_Batch_t *b)
+{
+    for (uint8_t i = 0; i < 4u; i++) b->count[i] = 0;
+    b->total    = 0;
+    b->sum2     = 0;
+    b->min      = 0;
+    b->max      = 0;
+    b->first_ms = 0;
+    b->last_ms  = 0;
+}
+
+CheckW_Class_t CheckW_BatchAdd(CheckW_Batch_t *b, int32_t weight, uint8_t flags, uint32_t now_ms)
+{
+    CheckW_Class_t cls;
+    uint32_t       valid = b->count[CHECKW_OK] + b->count[CHECKW_UNDER] + b->count[CHECKW_OVER];
+
+    if (valid + b->count[CHECKW_INVALID] == 0) b->first_ms = now_ms;
+    b->last_ms = now_ms;
+
+    if (flags) {
+        b->count[CHECKW_INVALID]++;
+        return CHECKW_INVALID;
+    }
+    if (weight < b->nominal - b->under)     cls = CHECKW_UNDER;
+    else if (weight > b->nominal + b->over) cls = CHECKW_OVER;
+    else                                    cls = CHECKW_OK;
+    b->count[cls]++;
+
+    if (valid == 0 || weight < b->min) b->min = weight;
+    if (valid == 0 || weight > b->max) b->max = weight;
+    b->total += weight;
+    b->sum2  += (int64_t)(weight - b->nominal) * (weight - b->nominal);
+    return cls;
+}
+
+/* items per minute * 10 over the batch time, counting `items` of the n
+ * that came past (n - 1 intervals between the first and the last) */
+static uint32_t batch_rate(const CheckW_Batch_t *b, uint32_t items)
+{
+    uint32_t n = b->count[0] + b->count[1] + b->count[2] + b->count[3];
+    uint32_t t = b->last_ms - b->first_ms;
+
+    if (n < 2u || t == 0) return 0;
+    return (uint32_t)(((uint64_t)(n - 1u) * items * 600000u) / ((uint64_t)n * t));
+}
+
+uint32_t CheckW_BatchRate(const CheckW_Batch_t *b)
+{
+    return batch_rate(b, b->count[CHECKW_OK] + b->count[CHECKW_UNDER] + b->count[CHECKW_OVER]);
+}
+
+uint32_t CheckW_BatchRateAll(const CheckW_Batch_t *b)
+{
+    return batch_rate(b, b->count[0] + b->count[1] + b->count[2] + b->count[3]);
+}
+
+int32_t CheckW_BatchMean(const CheckW_Batch_t *b)
+{
+    uint32_t n = b->count[CHECKW_OK] + b->count[CHECKW_UNDER] + b->count[CHECKW_OVER];
+    return n ? (int32_t)(b->total / n) : 0;
+}
+
+int32_t CheckW_BatchDeviation(const CheckW_Batch_t *b)
+{
+    uint32_t n = b->count[CHECKW_OK] + b->count[CHECKW_UNDER] + b->count[CHECKW_OVER];
+    int64_t  m, v;
+
+    if (n < 2u) return 0;
+    /* around the nominal, then moved to the mean */
+    m = b->total - (int64_t)b->nominal * n;
+    v = (b->sum2 * n - m * m) / ((int64_t)n * (n - 1u));
+    return v > 0 ? (int32_t)isqrt64((uint64_t)v) : 0;
+}
@@ -0,0 +1,125 @@
+#ifndef __CHECKW_H__
+#define __CHECKW_H__
+
+#include <stdint.h>
+
+/* dynamic weighing of items moving across the platform (checkweigher),
+ * HAL-free, fixed point.
+ *
+ * CheckW_Process takes a fast net weight stream (the 200 Hz output of
+ * the decimation chain in main.c; any unit, the thresholds are in the
+ * same one) and finds the items in it:
+ *
+ *   empty:  the platform level is followed as the dynamic zero (first
+ *           order, 1 / 2^zero_shift per sample) while it stays within
+ *           zero_band, so the foot of a ramp doesn't lift it.
+ *   arrival: `confirm` samples in a row above zero + on_level.
+ *   loaded: every sample is kept (up to CHECKW_BUF), with the peak.
+ *   departure: `confirm` samples in a row below zero + off_level.
+ *
+ * on departure the plateau, the part where the item was fully on the
+ * platform, is picked out of the loaded samples: the longest window
+ * whose standard deviation is within `noise` (a window of plateau_min
+ * at least, found by halving over the window length, running sums per
+ * length). the flattest 3/4 of that length is kept, as the ends of the
+ * longest window still catch the platform ringing out, and its
+ * interquartile mean (the mean of the middle half when sorted) is the
+ * item weight. ramps on and off the platform, bounces and single spikes
+ * fall outside it.
+ *
+ * the item record tells how good the reading is (CHECKW_F_*). items are
+ * then graded against the batch limits with CheckW_BatchAdd, in grams
+ * * 10 after calibration, which also keeps the batch totals.
+ *
+ * the window search works on x - (middle sample), shifted right until
+ * it is within CHECKW_DEV_MAX so the sums fit 64 bits; the noise limit
+ * is shifted with it. */
+
+#define CHECKW_BUF          256u    /* loaded samples kept per item */
+#define CHECKW_DEV_MAX      ((int32_t)1 << 22)     /* see above */
+
+/* item flags */
+#define CHECKW_F_SHORT      0x01u   /* fewer than plateau_min samples    */
+#define CHECKW_F_UNSTABLE   0x02u   /* no window within noise            */
+#define CHECKW_F_LONG       0x04u   /* buffer full: items touching?      */
+
+typedef struct {
+    int32_t  plateau;           /* item weight, net of the dynamic zero */
+    int32_t  peak;              /* largest sample, net                  */
+    int32_t  spread;            /* std deviation of the window          */
+    uint16_t samples;           /* loaded samples                       */
+    uint16_t window;            /* samples in the plateau window        */
+    uint32_t time;              /* departure, caller's time unit        */
+    uint8_t  flags;
+} CheckW_Item_t;
+
+typedef struct {
+    /* settings */
+    int32_t  on_level;          /* arrival above zero + on_level        */
+    int32_t  off_level;         /* departure below zero + off_level     */
+    int32_t  noise;             /* largest plateau std deviation        */
+    int32_t  zero_band;         /* zero followed within +-zero_band     */
+    uint16_t plateau_min;       /* shortest usable plateau, samples     */
+    uint8_t  confirm;           /* samples in a row, 1..8               */
+    uint8_t  zero_shift;        /* dynamic zero average                 */
+
+    /* state */
+    uint8_t  started;
+    uint8_t  loaded;
+    uint8_t  run;               /* samples in a row past the level      */
+    int32_t  zero;
+    int64_t  zero_acc;          /* zero * 2^zero_shift                  */
+    int32_t  buf[CHECKW_BUF];
+    uint16_t n;
+
+    /* output */
+    CheckW_Item_t item;         /* last finished item                   */
+    uint32_t items;
+} CheckW_t;
+
+/* result of the grading */
+typedef enum {
+    CHECKW_OK      = 0,
+    CHECKW_UNDER   = 1,
+    CHECKW_OVER    = 2,
+    CHECKW_INVALID = 3          /* flags set, not weighed reliably      */
+} CheckW_Class_t;
+
+typedef struct {
+    /* settings, grams * 10 */
+    int32_t  nominal;
+    int32_t  under;             /* OK from nominal - under ...          */
+    int32_t  over;              /* ... to nominal + over                */
+
+    /* totals; weights over the valid (not CHECKW_INVALID) items */
+    uint32_t count[4];          /* per CheckW_Class_t                   */
+    int64_t  total;             /* sum of the weights                   */
+    int64_t  sum2;              /* sum of (w - nominal)^2               */
+    int32_t  min, max;
+    uint32_t first_ms, last_ms; /* first and last item                  */
+} CheckW_Batch_t;
+
+/* clear the state, keep the settings; zero starts at the first sample */
+void            CheckW_Reset(CheckW_t *c);
+
+/* one sample; 1 when an item left the platform (see c->item) */
+uint8_t         CheckW_Process(CheckW_t *c, int32_t x, uint32_t time);
+
+/* clear the totals, keep the limits */
+void            CheckW_BatchReset(CheckW_Batch_t *b);
+
+/* grade one item (weight in grams * 10) and add it to the totals */
+CheckW_Class_t  CheckW_BatchAdd(CheckW_Batch_t *b, int32_t weight, uint8_t flags, uint32_t now_ms);
+
+/* graded (not CHECKW_INVALID) items per minute * 10 between the first
+ * and the last item: the throughput that was actually weighed */
+uint32_t        CheckW_BatchRate(const CheckW_Batch_t *b);
+
+/* all items per minute * 10, CHECKW_INVALID ones included */
+uint32_t        CheckW_BatchRateAll(const CheckW_Batch_t *b);
+
+/* mean and std deviation of the valid items, grams * 10 */
+int32_t         CheckW_BatchMean(const CheckW_Batch_t *b);
+int32_t         CheckW_BatchDeviation(const CheckW_Batch_t *b);
+
+#endif /* __CHECKW_H__ */
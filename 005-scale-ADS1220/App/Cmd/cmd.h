@@ -0,0 +1,116 @@
+#ifndef __CMD_H__
+#define __CMD_H__
+
+#include <stdint.h>
+
+/* text command lines from a UART RX ring (HAL-free core, the application
+ * owns the UART and provides the reply callback).
+ *
+ * the UART receives into rx[] with a circular DMA; the application
+ * reports the DMA position from the receive event callback (idle line,
+ * half and full buffer) with Cmd_RxEvent. Cmd_Poll, from the main loop,
+ * scans the new bytes for the end of a line (CR or LF) and splits the
+ * line into tokens in place: a token is a position and a length in the
+ * ring, nothing is copied out of it, and a token may wrap around its end.
+ *
+ * the first token picks an entry of the dispatch table (case is
+ * ignored), the handler reads its arguments with Cmd_Arg* and returns a
+ * status, which is answered with "OK" or "ERR <reason>". "help" lists
+ * the table.
+ *
+ *   freq 12.5
+ *   OK
+ *
+ * the DMA keeps writing while a handler runs: a handler reads its
+ * arguments first and does the slow part (flash, display) after. a line
+ * the DMA has written over is given up with "ERR overrun", and parsing
+ * resumes at the next line end still intact. one ERR overrun covers every
+ * line from the one being read to the one parsing resumes in: the lines
+ * in between were written over unseen, and their number is not known
+ * (`overruns` counts the answers, not the lines). rx_head, if set, tells how
+ * far the DMA is now; without it the DMA may be up to half a ring past
+ * the last event, and a line has to be read within half a ring. */
+
+#define CMD_ARGS_MAX        6u      /* tokens per line, name included  */
+#define CMD_LINE_MAX        80u     /* longer lines are rejected       */
+
+typedef enum {
+    CMD_OK = 0,
+    CMD_ERR_UNKNOWN,                /* no such command                 */
+    CMD_ERR_ARGS,                   /* wrong count or not a number     */
+    CMD_ERR_RANGE,                  /* number out of range             */
+    CMD_ERR_STATE,                  /* not in this mode or state       */
+    CMD_ERR_FAIL,                   /* tried, failed (flash, ...)      */
+    CMD_ERR_LONG,                   /* line longer than CMD_LINE_MAX   */
+    CMD_ERR_OVERRUN,                /* RX ring overrun, line lost      */
+} Cmd_Status_t;
+
+typedef struct {
+    uint16_t pos;                   /* ring index of the first char    */
+    uint8_t  len;
+} Cmd_Tok_t;
+
+struct Cmd_Handle;
+
+typedef struct {
+    const char *name;
+    const char *usage;              /* arguments, shown by help        */
+    uint8_t     args_min;           /* arguments after the name        */
+    uint8_t     args_max;
+    Cmd_Status_t (*fn)(struct Cmd_Handle *h, uint8_t argc);
+} Cmd_Entry_t;
+
+typedef struct Cmd_Handle {
+    /* platform, set by the application before Cmd_Init */
+    const volatile uint8_t *rx;     /* DMA ring                        */
+    uint16_t           rx_size;     /* power of two                    */
+    const Cmd_Entry_t *table;
+    uint8_t            table_len;
+    void (*reply)(const char *s, uint16_t len);     /* one line, no EOL */
+    uint16_t (*rx_head)(void);      /* DMA write index now, or NULL    */
+
+    /* ring positions as running byte counts, the ring index is the
+     * count modulo rx_size */
+    volatile uint32_t rx_total;     /* written by the DMA              */
+    volatile uint32_t rx_base;      /* DMA (re)started here            */
+    volatile uint16_t rx_pos;       /* DMA position at the last event  */
+    uint32_t rd;                    /* scanned                         */
+    uint32_t line;                  /* start of the line being read    */
+    uint8_t  skip;                  /* drop up to the next line end    */
+
+    /* the line being dispatched */
+    Cmd_Tok_t tok[CMD_ARGS_MAX];
+    uint8_t   ntok;
+
+    /* statistics */
+    uint32_t lines;                 /* dispatched                      */
+    uint32_t errors;                /* answered with ERR               */
+    uint32_t overruns;              /* ERR overrun answers             */
+} Cmd_Handle_t;
+
+void         Cmd_Init(Cmd_Handle_t *h);
+
+/* receive event (interrupt): pos = DMA write index, 0..rx_size */
+void         Cmd_RxEvent(Cmd_Handle_t *h, uint16_t pos);
+
+/* the DMA was restarted at index 0 (UART error): whatever was pending
+ * is counted as an overrun */
+void         Cmd_RxRestart(Cmd_Handle_t *h);
+
+/* main loop: dispatch every complete line received; returns the lines
+ * handled */
+uint8_t      Cmd_Poll(Cmd_Handle_t *h);
+
+/* handler side, i = argument index (0 = first after the name) */
+uint8_t      Cmd_ArgIs(const Cmd_Handle_t *h, uint8_t i, const char *s);
+
+/* decimal number with up to dec fraction digits, scaled by 10^dec:
+ * "12.5" with dec 3 -> 12500. CMD_ERR_ARGS if it is not a number or has
+ * more fraction digits, CMD_ERR_RANGE outside min..max */
+Cmd_Status_t Cmd_ArgNum(const Cmd_Handle_t *h, uint8_t i, uint8_t dec,
+                        int32_t min, int32_t max, int32_t *v);
+
+/* one reply line before the final OK/ERR */
+void         Cmd_Reply(Cmd_Handle_t *h, const char *s);
+
+#endif /* __CMD_H__ */
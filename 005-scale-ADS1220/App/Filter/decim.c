@@ -0,0 +1,146 @@
+/**
+  ******************************************************************************
+  * @file    decim.c
+  * @brief   Multi-rate CIC + compensating FIR decimation chain (HAL-free,
+  *          fixed point)
+  ******************************************************************************
+  */
+
+#include "decim.h"
+
+/* least-squares designs, DC gain exactly 32768 (see decim.h) */
+const int16_t Decim_Taps200Hz[21] = {
+       44,    81,  -163,  -412,   351,  1305,  -478, -3462,   -90, 10679,
+    17058,
+    10679,   -90, -3462,  -478,  1305,   351,  -412,  -163,    81,    44
+};
+
+const int16_t Decim_Taps10Hz[31] = {
+      -15,   -54,  -127,  -232,  -353,  -450,  -464,  -331,     7,   576,
+     1356,  2274,  3210,  4024,  4577,
+     4772,
+     4577,  4024,  3210,  2274,  1356,   576,     7,  -331,  -464,  -450,
+     -353,  -232,  -127,   -54,   -15
+};
+
+static void stage_clear(Decim_Stage_t *s)
+{
+    for (uint8_t i = 0; i < DECIM_ORDER_MAX; i++) {
+        s->integ[i] = 0;
+        s->comb[i]  = 0;
+    }
+    for (uint8_t i = 0; i < 2u * DECIM_TAPS_MAX; i++) s->hist[i] = 0;
+    s->cic_phase = 0;
+    s->fir_phase = 0;
+    s->hidx      = 0;
+    s->out       = 0;
+    s->count     = 0;
+}
+
+int Decim_Init(Decim_t *d)
+{
+    if (!d || d->count == 0 || d->count > DECIM_STAGES_MAX) return -1;
+
+    for (uint8_t k = 0; k < d->count; k++) {
+        Decim_Stage_t *s    = &d->stage[k];
+        uint64_t       gain = 1;
+
+        if (s->r == 0 || s->n == 0 || s->n > DECIM_ORDER_MAX) return -1;
+        if (s->fir_decim == 0) s->fir_decim = 1;
+        if (s->taps) {
+            int32_t sum = 0;
+            if (s->ntaps == 0 || s->ntaps > DECIM_TAPS_MAX || (s->ntaps & 1u) == 0) return -1;
+            for (uint8_t i = 0; i < s->ntaps; i++) {
+                if (s->taps[i] != s->taps[s->ntaps - 1u - i]) return -1;   /* folded below */
+                sum += s->taps[i];
+            }
+            if (sum != 32768) return -1;
+        } else if (s->fir_decim != 1) {
+            return -1;
+        }
+
+        for (uint8_t i = 0; i < s->n; i++) gain *= s->r;
+        if (gain > 0xFFFFFFFFu) return -1;
+        s->recip = (int64_t)((((uint64_t)1 << 32) + gain / 2u) / gain);
+        stage_clear(s);
+    }
+    return 0;
+}
+
+/* one input into stage s; 1 if it produced an output */
+static uint8_t stage_process(Decim_Stage_t *s, int32_t x)
+{
+    int64_t y;
+
+    /* integrators at the input rate, wrapping */
+    s->integ[0] += (uint64_t)(int64_t)x;
+    for (uint8_t i = 1; i < s->n; i++) s->integ[i] += s->integ[i - 1];
+
+    if (++s->cic_phase < s->r) return 0;
+    s->cic_phase = 0;
+
+    /* combs at the output rate; the result is exact in 64 bits */
+    {
+        uint64_t v = s->integ[s->n - 1];
+        for (uint8_t i = 0; i < s->n; i++) {
+            uint64_t t = v;
+            v         -= s->comb[i];
+            s->comb[i] = t;
+        }
+        y = (int64_t)v;
+    }
+    /* remove the gain r^n: |y| < 2^29 * r^n, recip ~ 2^32 / r^n */
+    x = (int32_t)((y * s->recip + ((int64_t)1 << 31)) >> 32);
+
+    if (!s->taps) {
+        s->out = x;
+        s->count++;
+        return 1;
+    }
+
+    /* FIR history, every sample stored twice so the window is contiguous */
+    {
+        uint8_t L = s->ntaps;
+        s->hist[s->hidx]     = x;
+        s->hist[s->hidx + L] = x;
+        if (++s->hidx >= L) s->hidx = 0;
+    }
+    if (++s->fir_phase < s->fir_decim) return 0;
+    s->fir_phase = 0;
+
+    {
+        const int32_t *w    = &s->hist[s->hidx];    /* oldest .. newest */
+        const int16_t *h    = s->taps;
+        uint8_t        half = (uint8_t)(s->ntaps / 2u);
+        int64_t        acc  = (int64_t)h[half] * w[half];
+
+        /* symmetric taps: one SMLAL per pair */
+        for (uint8_t i = 0; i < half; i++) {
+            acc += (int64_t)h[i] * (int32_t)(w[i] + w[s->ntaps - 1u - i]);
+        }
+        s->out = (int32_t)((acc + (1 << 14)) >> 15);
+    }
+    s->count++;
+    return 1;
+}
+
+uint8_t Decim_Process(Decim_t *d, int32_t code)
+{
+    uint8_t ready = 0;
+    int32_t x     = code * (int32_t)(1u << DECIM_FRAC);
+
+    for (uint8_t k = 0; k < d->count; k++) {
+        if (!stage_process(&d->stage[k], x)) break;
+        ready |= (uint8_t)(1u << k);
+        x = d->stage[k].out;
+    }
+    return ready;
+}
+
+uint32_t Decim_Rate_mHz(const Decim_t *d, uint8_t k, uint32_t in_mhz)
+{
+    for (uint8_t i = 0; i <= k && i < d->count; i++) {
+        in_mhz /= (uint32_t)d->stage[i].r * d->stage[i].fir_decim;
+    }
+    return in_mhz;
+}
@@ -0,0 +1,75 @@
+#ifndef __DECIM_H__
+#define __DECIM_H__
+
+#include <stdint.h>
+
+/* multi-rate decimation chain: CIC stages with compensating FIR
+ * (HAL-free, fixed point).
+ *
+ * every stage is a CIC decimator (r, order n) followed by an optional
+ * FIR (Q15 taps, symmetric) that may decimate again by fir_decim:
+ *
+ *   in -> [CIC r, n] -> [FIR, fir_decim] -> out ---> next stage
+ *
+ * stage k runs on the output of stage k-1, and every stage output is
+ * available to the application, so a single ADS1220 stream gives
+ * several rates at once, e.g. 2000 SPS -> 200 Hz -> 10 Hz.
+ *
+ * values are ADC codes with DECIM_FRAC fractional bits (the averaging
+ * gains resolution). the CIC integrators wrap in 64 bits, which is
+ * exact as long as the code range times r^n fits; the gain r^n is
+ * removed by a reciprocal multiply, no division. the FIR adds symmetric
+ * pairs first and uses one 32x32+64 multiply-accumulate (SMLAL) per
+ * pair, so a 21-tap FIR costs 11 MACs per output. */
+
+#define DECIM_STAGES_MAX    3u
+#define DECIM_ORDER_MAX     4u
+#define DECIM_TAPS_MAX      48u
+#define DECIM_FRAC          6u      /* fractional bits of the outputs */
+
+typedef struct {
+    /* settings */
+    uint8_t        r;           /* CIC decimation, 1..255 (1 = bypass)    */
+    uint8_t        n;           /* CIC order, 1..DECIM_ORDER_MAX          */
+    const int16_t *taps;        /* FIR, Q15, symmetric, sum 32768; NULL   */
+    uint8_t        ntaps;       /* odd, <= DECIM_TAPS_MAX                 */
+    uint8_t        fir_decim;   /* FIR decimation, >= 1                   */
+
+    /* state */
+    uint64_t integ[DECIM_ORDER_MAX];
+    uint64_t comb[DECIM_ORDER_MAX];
+    uint8_t  cic_phase;
+    uint8_t  fir_phase;
+    uint8_t  hidx;
+    int32_t  hist[2u * DECIM_TAPS_MAX]; /* each sample twice: no wrap   */
+    int64_t  recip;             /* 2^32 / r^n                             */
+
+    /* output */
+    int32_t  out;               /* latest output, codes << DECIM_FRAC     */
+    uint32_t count;             /* outputs produced                       */
+} Decim_Stage_t;
+
+typedef struct {
+    Decim_Stage_t stage[DECIM_STAGES_MAX];
+    uint8_t       count;
+} Decim_t;
+
+/* FIR presets for the chain 2000 SPS -> 200 Hz -> 10 Hz */
+/* CIC r=10 n=3 (2000 -> 200 Hz), FIR without decimation: droop
+ * compensated to 30 Hz (+-0.02 dB), -36 dB from 70 Hz */
+extern const int16_t Decim_Taps200Hz[21];
+/* CIC r=5 n=3 (200 -> 40 Hz), FIR decimating by 4 to 10 Hz: flat to
+ * 1.5 Hz (+-0.2 dB), -56 dB from 5 Hz */
+extern const int16_t Decim_Taps10Hz[31];
+
+/* check the settings and clear the state; 0 on success, -1 otherwise */
+int     Decim_Init(Decim_t *d);
+
+/* one input sample (ADC code). returns a bit per stage that produced a
+ * new output (stage[k].out) with this sample */
+uint8_t Decim_Process(Decim_t *d, int32_t code);
+
+/* output rate of stage k in mHz for an input rate in mHz */
+uint32_t Decim_Rate_mHz(const Decim_t *d, uint8_t k, uint32_t in_mhz);
+
+#endif /* __DECIM_H__ */
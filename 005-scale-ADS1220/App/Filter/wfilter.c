@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file    wfilter.c
+  * @brief   Adaptive running-sum moving average with stability detection
+  *          (HAL-free, fixed point, O(1) per sample)
+  ******************************************************************************
+  */
+
+#include "wfilter.h"
+
+#define BUF_MASK    (WFILTER_MAX - 1u)
+
+static void wf_add(WFilter_t *f, int32_t x)
+{
+    int32_t d = x - f->ref;
+    f->sum  += d;
+    f->sum2 += (int64_t)d * d;
+    f->len++;
+}
+
+static void wf_remove_oldest(WFilter_t *f)
+{
+    int32_t d = f->buf[(uint16_t)(f->idx - f->len) & BUF_MASK] - f->ref;
+    f->sum  -= d;
+    f->sum2 -= (int64_t)d * d;
+    f->len--;
+}
+
+void WFilter_Reset(WFilter_t *f)
+{
+    f->idx     = 0;
+    f->len     = 0;
+    f->outside = 0;
+    f->ref     = 0;
+    f->sum     = 0;
+    f->sum2    = 0;
+    f->mean    = 0;
+    f->stable  = 0;
+}
+
+int32_t WFilter_Process(WFilter_t *f, int32_t x)
+{
+    uint16_t len_max = f->len_max;
+    uint8_t  confirm = f->step_confirm;
+
+    if (len_max == 0 || len_max > WFILTER_MAX) len_max = WFILTER_MAX;
+    if (confirm == 0) confirm = 1;
+    if (confirm > 4)  confirm = 4;
+
+    /* step detection against the current mean */
+    if (f->len != 0 && (x - f->mean > f->step || f->mean - x > f->step)) {
+        f->outside++;
+    } else {
+        f->outside = 0;
+    }
+
+    if (f->outside >= confirm) {
+        /* restart the window with the samples beyond the step */
+        uint8_t k = (uint8_t)(confirm - 1u);
+        f->ref  = x;
+        f->sum  = 0;
+        f->sum2 = 0;
+        f->len  = 0;
+        for (uint8_t j = k; j != 0; j--) {
+            wf_add(f, f->buf[(uint16_t)(f->idx - j) & BUF_MASK]);
+        }
+        f->outside = 0;
+        f->restarts++;
+    } else {
+        /* slide (or shrink after len_max was lowered) */
+        while (f->len >= len_max) wf_remove_oldest(f);
+        /* clearly off the mean but no step (platform still moving):
+           drop one more old sample, the window shortens by one */
+        if (f->outside == 0 && f->len > 1 &&
+            (x - f->mean > 3 * f->noise || f->mean - x > 3 * f->noise)) {
+            wf_remove_oldest(f);
+            f->shrinks++;
+        }
+    }
+
+    f->buf[f->idx & BUF_MASK] = x;
+    f->idx = (uint16_t)(f->idx + 1u);
+    if (f->len == 0) {
+        f->ref  = x;
+        f->sum  = 0;
+        f->sum2 = 0;
+    }
+    wf_add(f, x);
+
+    /* rounded mean: SDIV, no 64-bit division */
+    {
+        int32_t half = (int32_t)(f->len / 2u);
+        int32_t q    = (f->sum >= 0) ? (f->sum + half) / (int32_t)f->len
+                                     : (f->sum - half) / (int32_t)f->len;
+        f->mean = f->ref + q;
+    }
+
+    if (f->len >= f->stable_len) {
+        int64_t n   = (int64_t)f->len;
+        int64_t var = n * f->sum2 - (int64_t)f->sum * f->sum;     /* n^2 * variance */
+        int64_t lim = (int64_t)f->noise * f->noise * n * n;
+        f->stable = (uint8_t)(var <= lim);
+    } else {
+        f->stable = 0;
+    }
+
+    return f->mean;
+}
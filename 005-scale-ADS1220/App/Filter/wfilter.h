@@ -0,0 +1,59 @@
+#ifndef __WFILTER_H__
+#define __WFILTER_H__
+
+#include <stdint.h>
+
+/* adaptive moving average with stability detection for weight readings
+ * (HAL-free, fixed point, O(1) per sample).
+ *
+ * the output is the mean of a window of the latest samples, kept as a
+ * running sum. the window grows by one sample per input up to len_max,
+ * then slides. when step_confirm samples in a row are further than step
+ * from the mean, a load was put on or taken off: the window restarts with
+ * just those samples, so the output follows at once and smooths more and
+ * more as the reading settles. a sample more than 3 * noise off the mean
+ * (but no step) drops one extra old sample, so the window shortens
+ * while the platform still swings and lengthens again once it is quiet.
+ *
+ * stable is set while the window spans at least stable_len samples and
+ * its standard deviation is within noise. the variance is compared as
+ *   len * sum(d^2) - sum(d)^2 <= noise^2 * len^2
+ * over d = x - ref (ref = first sample of the window), so no division is
+ * needed and the sums stay small.
+ *
+ * inputs must be ADC codes (24-bit): sum(d) then fits 32 bits for up to
+ * WFILTER_MAX samples. thresholds are in the same unit. */
+
+#define WFILTER_MAX     64u         /* longest window, power of two */
+
+typedef struct {
+    /* settings, may be changed between samples */
+    uint16_t len_max;       /* window when settled, 1..WFILTER_MAX      */
+    uint16_t stable_len;    /* samples before stable, 1..len_max        */
+    int32_t  step;          /* deviation from the mean that is a step   */
+    uint8_t  step_confirm;  /* samples in a row beyond step, 1..4       */
+    int32_t  noise;         /* largest standard deviation when stable   */
+
+    /* state */
+    int32_t  buf[WFILTER_MAX];
+    uint16_t idx;           /* next write position                      */
+    uint16_t len;           /* samples in the window                    */
+    uint8_t  outside;       /* samples in a row beyond step             */
+    int32_t  ref;
+    int32_t  sum;           /* sum of (x - ref) over the window         */
+    int64_t  sum2;          /* sum of (x - ref)^2 over the window       */
+
+    /* output */
+    int32_t  mean;
+    uint8_t  stable;
+    uint32_t restarts;      /* steps detected                           */
+    uint32_t shrinks;       /* window shortened by one                  */
+} WFilter_t;
+
+/* empty the window, keep the settings */
+void    WFilter_Reset(WFilter_t *f);
+
+/* add one sample, returns the filtered value (also in f->mean) */
+int32_t WFilter_Process(WFilter_t *f, int32_t x);
+
+#endif /* __WFILTER_H__ */
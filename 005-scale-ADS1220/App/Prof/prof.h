@@ -0,0 +1,101 @@
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#include <stdint.h>
+
+/* execution time zones on the cycle counter (HAL-free; the application
+ * owns the zone table and the output).
+ *
+ * a zone is a block of code timed from PROF_BEGIN to PROF_END:
+ *
+ *   PROF_BEGIN(t);
+ *   Display_Update();
+ *   PROF_END(&hprof, PZ_DISPLAY, t);
+ *
+ * PROF_BEGIN keeps the start in a local variable, so zones nest, and an
+ * interrupt zone may interrupt a main loop zone. Each zone keeps count,
+ * min, max, the sum for the mean, and a log2 histogram: bin k counts the
+ * durations of 2^(k-1) to 2^k - 1 ticks (bin 0: 0 ticks, the last bin
+ * everything longer), which gives the percentiles to within a factor 2
+ * without storing samples.
+ *
+ * a zone is recorded from one context only (main loop, or one
+ * interrupt). readers (display, dump) may see count and sum of slightly
+ * different moments, which only shows in the last digit of the mean.
+ *
+ * the ticks are the DWT cycle counter on the Cortex-M (enabled by the
+ * application, TRCENA + CYCCNTENA) and CLOCK_MONOTONIC nanoseconds on a
+ * host, so the same zones can be timed in the host benches.
+ *
+ * PROF_ENABLE defaults to 1 in the Debug build configuration (DEBUG
+ * defined) and to 0 in Release, where PROF_BEGIN / PROF_END compile to
+ * nothing and the zone table is not touched. */
+
+#ifndef PROF_ENABLE
+#ifdef DEBUG
+#define PROF_ENABLE         1
+#else
+#define PROF_ENABLE         0
+#endif
+#endif
+
+#define PROF_BINS           28u     /* up to 2^27 ticks, 1.3 s at 100 MHz */
+
+#if defined(__arm__)
+/* DWT->CYCCNT, addressed directly to keep the module free of CMSIS */
+#define PROF_CLOCK()        (*(volatile uint32_t *)0xE0001004UL)
+#else
+uint32_t Prof_HostClock(void);
+#define PROF_CLOCK()        Prof_HostClock()
+#endif
+
+#if PROF_ENABLE
+#define PROF_BEGIN(t)       const uint32_t t = PROF_CLOCK()
+#define PROF_END(h, id, t)  Prof_Add((h), (id), PROF_CLOCK() - (t))
+#else
+#define PROF_BEGIN(t)       do { } while (0)
+#define PROF_END(h, id, t)  do { } while (0)
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t min, max;
+    uint64_t sum;
+    uint32_t hist[PROF_BINS];
+} Prof_Zone_t;
+
+typedef struct {
+    /* set by the application before Prof_Init */
+    Prof_Zone_t       *zone;
+    const char *const *names;       /* one per zone, short (display)   */
+    uint8_t            count;
+    uint32_t           tick_hz;     /* SystemCoreClock, 1e9 on a host  */
+
+    uint32_t           overhead;    /* ticks of an empty zone, removed */
+} Prof_Handle_t;
+
+/* clear the zones and measure the cost of an empty zone */
+void     Prof_Init(Prof_Handle_t *h);
+
+/* clear the zones, keep the overhead */
+void     Prof_Reset(Prof_Handle_t *h);
+
+/* one duration of zone id in ticks (PROF_END), less the overhead */
+void     Prof_Add(Prof_Handle_t *h, uint8_t id, uint32_t ticks);
+
+uint32_t Prof_Mean(const Prof_Zone_t *z);
+
+/* upper end (ticks) of the histogram bin holding the pct-th percentile,
+ * 0 without samples */
+uint32_t Prof_Percentile(const Prof_Zone_t *z, uint8_t pct);
+
+/* ticks -> microseconds, rounded */
+uint32_t Prof_Us(const Prof_Handle_t *h, uint32_t ticks);
+
+/* text report, one call of out per line, no EOL: a header, one line
+ * per zone (count, min, mean, p99, max in us) and, with hist, the
+ * non-empty histogram bins */
+void     Prof_Report(const Prof_Handle_t *h, uint8_t hist,
+                     void (*out)(const char *s, uint16_t len));
+
+#endif /* __PROF_H__ */
@@ -115,11 +115,30 @@ extern "C" {
 
 #define SH1106_UPDATE_CHUNK_SIZE (1 << SH1106_UPDATE_CHUNK_SIZE_POW)
 
+/**
+ * Delta update tuning (used with SH1106_DOUBLE_BUFFER)
+ *
+ * Each column run costs 11 bytes of command/address overhead on I2C,
+ * so two changed runs separated by fewer unchanged columns than this
+ * are merged into one transfer.
+ */
+#ifndef SH1106_DIFF_MERGE_GAP
+    #define SH1106_DIFF_MERGE_GAP 10
+#endif
+
+// Maximum column runs per page, the last one absorbs the remainder
+#ifndef SH1106_RUNS_PER_PAGE
+    #define SH1106_RUNS_PER_PAGE 4
+#endif
+
 // Enable DMA transfers (requires I2C DMA configuration in CubeMX)
+// Frames are then sent by SH1106_UpdateScreenAsync() without blocking
 //#define SH1106_USE_DMA
 
 // Enable double buffering (reduces tearing, uses 2x RAM)
-//#define SH1106_DOUBLE_BUFFER
+// The back buffer mirrors the panel: only columns that differ are sent
+// With DMA the frame is snapshotted so drawing can go on during transfer
+#define SH1106_DOUBLE_BUFFER
 
 /* ========================================================================
  * FONT CONFIGURATION
@@ -130,10 +149,17 @@ extern "C" {
 #define SH1106_INCLUDE_FONT_11x18
 #define SH1106_INCLUDE_FONT_8H      // Custom proportional font
 
+// Use the column-major fonts from sh1106_fonts_packed.c (generated by
+// tools/sh1106_fontc.py). Glyph bytes are copied to the buffer without
+// transposing. Comment out to build Font_8H from its row-major source.
+// Without packed fonts, only Font_8H is available.
+#define SH1106_PACKED_FONTS
+
 /* ========================================================================
  * BUFFER SIZE CALCULATION
  * ======================================================================== */
 #define SH1106_BUFFER_SIZE (SH1106_WIDTH * SH1106_HEIGHT / 8)
+#define SH1106_PAGES       (SH1106_HEIGHT / 8)
 
 #ifdef SH1106_DOUBLE_BUFFER
     #define SH1106_TOTAL_BUFFER_SIZE (SH1106_BUFFER_SIZE * 2)
@@ -14,6 +14,7 @@ extern "C" {
 
 /* ========================================================================
  * FONT DECLARATIONS
+ * Font_6x8, Font_7x10 and Font_11x18 require SH1106_PACKED_FONTS
  * ======================================================================== */
 
 #ifdef SH1106_INCLUDE_FONT_6x8
@@ -0,0 +1,291 @@
+/**
+  ******************************************************************************
+  * @file    sample_log.c
+  * @brief   Compressed sample logger in flash: delta-encoded blocks with
+  *          crc, written in the background (HAL-free core, uses callbacks
+  *          provided by app)
+  ******************************************************************************
+  */
+
+#include "sample_log.h"
+#include "cfg_log.h"
+
+#define ERASED_WORD  0xFFFFFFFFUL
+
+static uint32_t get16(const uint8_t *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | (get16(p + 2) << 16); }
+
+static uint64_t zigzag(int64_t v)   { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t  unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1u); }
+
+static uint8_t put_varint(uint8_t *p, uint64_t v)
+{
+    uint8_t n = 0;
+
+    while (v >= 0x80u) {
+        p[n++] = (uint8_t)(v | 0x80u);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/* 0 past end or after 10 bytes */
+static uint8_t get_varint(const uint8_t *p, const uint8_t *end, uint64_t *v)
+{
+    uint8_t n = 0;
+
+    *v = 0;
+    while (p + n < end && n < 10u) {
+        uint8_t b = p[n];
+        *v |= (uint64_t)(b & 0x7Fu) << (7u * n);
+        n++;
+        if (!(b & 0x80u)) return n;
+    }
+    return 0;
+}
+
+/* time step in units of 2^time_shift ticks, modulo 2^(32 - time_shift) */
+static int32_t time_step(uint32_t q, uint32_t q_prev, uint8_t s)
+{
+    return (int32_t)((q - q_prev) << s) >> s;
+}
+
+static uint8_t *cur(SampleLog_Handle_t *h) { return (uint8_t *)h->buf[h->enc]; }
+
+static uint8_t area_formatted(const SampleLog_Handle_t *h)
+{
+    return h->area[0] == SAMPLELOG_MAGIC &&
+           h->area[1] == (SAMPLELOG_VERSION | ((uint32_t)h->time_shift << 8) |
+                          ((uint32_t)h->block_size << 16));
+}
+
+static uint8_t block_erased(const SampleLog_Handle_t *h, uint32_t off)
+{
+    for (uint32_t i = 0u; i < h->block_size; i += 4u)
+        if (h->area[(off + i) / 4u] != ERASED_WORD) return 0u;
+    return 1u;
+}
+
+static void reset_state(SampleLog_Handle_t *h)
+{
+    h->running = 0;
+    h->session = 1;
+    h->full[0] = h->full[1] = 0;
+    h->enc     = 0;
+    h->flash   = 0;
+    h->pos     = 0;
+    h->count   = 0;
+    h->prog    = 0;
+}
+
+/* pad, seal with the crc and hand the block to SampleLog_Poll */
+static void close_block(SampleLog_Handle_t *h)
+{
+    uint8_t  *b   = cur(h);
+    uint32_t  end = h->block_size - 4u, crc;
+    uint16_t  count = h->count;
+
+    if (h->session) count |= SAMPLELOG_BLK_START;
+    h->session = 0;
+
+    h->buf[h->enc][0] = h->seq++;
+    h->buf[h->enc][2] = count | ((uint32_t)(h->pos - SAMPLELOG_BLK_HDR) << 16);
+    for (uint32_t i = h->pos; i < end; i++) b[i] = 0xFFu;
+    crc = CfgLog_Crc32(0u, b, end);
+    h->buf[h->enc][end / 4u] = crc;
+
+    h->off[h->enc]  = h->alloc;
+    h->full[h->enc] = 1;
+    h->alloc       += h->block_size;
+    h->enc         ^= 1u;
+    h->count        = 0;
+    h->pos          = 0;
+}
+
+/* a fresh block: time base t, predictors cleared */
+static uint8_t open_block(SampleLog_Handle_t *h, uint32_t t)
+{
+    if (h->full[h->enc] || h->alloc + h->block_size > h->area_size) return 0;
+
+    h->buf[h->enc][1] = t;
+    h->pos     = SAMPLELOG_BLK_HDR;
+    h->q_prev  = t >> h->time_shift;
+    h->dt_prev = 0;
+    for (uint8_t i = 0; i < SAMPLELOG_CHANNELS; i++) h->x_prev[i] = 0;
+    return 1;
+}
+
+static uint8_t encode(const SampleLog_Handle_t *h, uint8_t *p, uint8_t ch, uint32_t q, int32_t x)
+{
+    int32_t dt = time_step(q, h->q_prev, h->time_shift);
+    uint8_t n;
+
+    n  = put_varint(p, (zigzag((int64_t)dt - h->dt_prev) << 2) | ch);
+    n += put_varint(p + n, zigzag((int64_t)x - h->x_prev[ch]));
+    return n;
+}
+
+SampleLog_Status_t SampleLog_Init(SampleLog_Handle_t *h)
+{
+    uint32_t off;
+
+    if (!h->area || !h->program || !h->erase) return SAMPLELOG_ERROR;
+    if ((h->block_size & 3u) || h->block_size > SAMPLELOG_BLOCK_MAX ||
+        h->block_size < SAMPLELOG_BLK_HDR + 4u + SAMPLELOG_SAMPLE_MAX ||
+        h->time_shift > 16u) return SAMPLELOG_ERROR;
+
+    reset_state(h);
+    h->alloc = h->area_size;
+    h->seq   = 0;
+    if (!area_formatted(h)) return SAMPLELOG_EMPTY;
+
+    /* blocks are written in order: the log ends at the first erased one.
+     * a torn block is not erased and is skipped over */
+    for (off = SAMPLELOG_AREA_HDR; off + h->block_size <= h->area_size; off += h->block_size) {
+        if (block_erased(h, off)) break;
+        h->seq++;
+    }
+    h->alloc = off;
+    return off + h->block_size <= h->area_size ? SAMPLELOG_OK : SAMPLELOG_FULL;
+}
+
+SampleLog_Status_t SampleLog_Erase(SampleLog_Handle_t *h)
+{
+    uint32_t hdr[4];
+
+    reset_state(h);
+    h->alloc = h->area_size;
+    h->seq   = 0;
+    if (h->erase() != 0) return SAMPLELOG_ERROR;
+
+    hdr[0] = SAMPLELOG_MAGIC;
+    hdr[1] = SAMPLELOG_VERSION | ((uint32_t)h->time_shift << 8) | ((uint32_t)h->block_size << 16);
+    hdr[2] = h->tick_hz;
+    hdr[3] = ERASED_WORD;
+    if (h->program(0u, hdr, 4u) != 0) return SAMPLELOG_ERROR;
+    h->alloc = SAMPLELOG_AREA_HDR;
+    return SAMPLELOG_OK;
+}
+
+SampleLog_Status_t SampleLog_Start(SampleLog_Handle_t *h)
+{
+    if (!area_formatted(h)) return SAMPLELOG_EMPTY;
+    if (!h->running) h->session = 1;
+    h->running = 1;
+    return h->alloc + h->block_size <= h->area_size ? SAMPLELOG_OK : SAMPLELOG_FULL;
+}
+
+void SampleLog_Stop(SampleLog_Handle_t *h)
+{
+    if (h->count) close_block(h);
+    h->running = 0;
+}
+
+uint8_t SampleLog_Put(SampleLog_Handle_t *h, uint8_t channel, uint32_t time, int32_t value)
+{
+    uint8_t  tmp[SAMPLELOG_SAMPLE_MAX], n;
+    uint32_t q = time >> h->time_shift;
+
+    if (!h->running || channel >= SAMPLELOG_CHANNELS) return 0;
+
+    if (h->count == 0 && !open_block(h, time)) {
+        h->dropped++;
+        return 0;
+    }
+    n = encode(h, tmp, channel, q, value);
+    if (h->pos + n > h->block_size - 4u) {
+        /* does not fit: seal this block and start over in the other one */
+        close_block(h);
+        if (!open_block(h, time)) {
+            h->dropped++;
+            return 0;
+        }
+        n = encode(h, tmp, channel, q, value);
+    }
+
+    for (uint8_t i = 0; i < n; i++) cur(h)[h->pos + i] = tmp[i];
+    h->pos            += n;
+    h->count++;
+    h->dt_prev         = time_step(q, h->q_prev, h->time_shift);
+    h->q_prev          = q;
+    h->x_prev[channel] = value;
+    h->samples++;
+    return 1;
+}
+
+uint32_t SampleLog_Poll(SampleLog_Handle_t *h, uint32_t max_words)
+{
+    uint8_t  b     = h->flash;
+    uint32_t words = h->block_size / 4u, n;
+
+    if (!h->full[b] || max_words == 0) return 0;
+
+    n = words - h->prog;
+    if (n > max_words) n = max_words;
+    if (h->program(h->off[b] + h->prog * 4u, &h->buf[b][h->prog], n) != 0) {
+        /* the block is lost, its space stays allocated (torn) */
+        h->errors++;
+        h->prog = (uint16_t)words;
+    } else {
+        h->prog = (uint16_t)(h->prog + n);
+        if (h->prog == words) h->blocks++;
+    }
+    if (h->prog == words) {
+        h->full[b] = 0;
+        h->prog    = 0;
+        h->flash  ^= 1u;
+    }
+    return n;
+}
+
+uint32_t SampleLog_Used(const SampleLog_Handle_t *h)
+{
+    return h->alloc + (h->count ? h->block_size : 0u);
+}
+
+int SampleLog_Decode(const uint8_t *block, uint16_t block_size, uint8_t time_shift,
+                     SampleLog_Block_t *info, SampleLog_Sample_t *out, uint16_t max)
+{
+    uint32_t       end = block_size - 4u, len, q, mask = ERASED_WORD >> time_shift;
+    uint32_t       count;
+    int32_t        dt = 0, x[SAMPLELOG_CHANNELS] = { 0 };
+    const uint8_t *p, *stop;
+
+    if (block_size < SAMPLELOG_BLK_HDR + 4u || (block_size & 3u)) return -1;
+    if (CfgLog_Crc32(0u, block, end) != get32(block + end)) return -1;
+
+    count = get16(block + 8);
+    len   = get16(block + 10);
+    if (SAMPLELOG_BLK_HDR + len > end) return -1;
+    if (info) {
+        info->seq   = get32(block);
+        info->t0    = get32(block + 4);
+        info->count = (uint16_t)(count & ~SAMPLELOG_BLK_START);
+        info->start = (count & SAMPLELOG_BLK_START) ? 1u : 0u;
+    }
+    count &= ~SAMPLELOG_BLK_START;
+
+    q    = get32(block + 4) >> time_shift;
+    p    = block + SAMPLELOG_BLK_HDR;
+    stop = p + len;
+    for (uint32_t i = 0; i < count && i < max; i++) {
+        uint64_t tag, dx;
+        uint8_t  n, ch;
+
+        if (!(n = get_varint(p, stop, &tag))) return -1;
+        p += n;
+        if (!(n = get_varint(p, stop, &dx))) return -1;
+        p += n;
+
+        ch     = (uint8_t)(tag & 3u);
+        dt     = (int32_t)((int64_t)dt + unzigzag(tag >> 2));
+        q      = (q + (uint32_t)dt) & mask;
+        x[ch]  = (int32_t)((int64_t)x[ch] + unzigzag(dx));
+
+        out[i].time    = q << time_shift;
+        out[i].value   = x[ch];
+        out[i].channel = ch;
+    }
+    return (int)(count < max ? count : max);
+}
@@ -0,0 +1,128 @@
+#ifndef __SAMPLE_LOG_H__
+#define __SAMPLE_LOG_H__
+
+#include <stdint.h>
+
+/* compressed time-series logger into a reserved flash region (HAL-free
+ * core, the application provides program/erase callbacks).
+ *
+ * the region starts with a 16-byte header (SAMPLELOG_MAGIC, version,
+ * time_shift, block_size, tick_hz) followed by fixed-size blocks, filled
+ * in order until the region is full:
+ *
+ *   seq (u32) | t0 (u32) | count (u16) | len (u16) | payload | 0xFF.. | crc32
+ *
+ * the crc (CfgLog_Crc32) covers the whole block before it, so a block
+ * cut short by a power loss is recognised and skipped. every block
+ * decodes on its own: per sample the payload holds two LEB128 varints,
+ *
+ *   tag   = zigzag(dt - dt_prev) << 2 | channel
+ *   value = zigzag(x - x_prev[channel])
+ *
+ * with time in units of 2^time_shift ticks (modulo 2^(32 - time_shift))
+ * and dt the step from the previous sample; at the start of a block
+ * dt_prev = 0, x_prev[] = 0 and the time base is t0. a steady sample
+ * rate and a slowly moving value then cost 2 to 3 bytes per sample
+ * instead of 8. the first block after SampleLog_Start has
+ * SAMPLELOG_BLK_START set in count: the time base may restart there
+ * (a reset clears the cycle counter).
+ *
+ * SampleLog_Put only encodes into one of two RAM blocks and never
+ * touches the flash; a full block waits for SampleLog_Poll, which
+ * programs a few words per call from the main loop. when both blocks
+ * are busy, or the region is full, samples are dropped and counted.
+ * erasing the region (SampleLog_Erase) blocks and is meant for
+ * start-up, before the acquisition runs. */
+
+#define SAMPLELOG_MAGIC         0x474F4C53UL    /* "SLOG" */
+#define SAMPLELOG_VERSION       1u
+#define SAMPLELOG_AREA_HDR      16u
+#define SAMPLELOG_BLK_HDR       12u             /* seq, t0, count, len */
+#define SAMPLELOG_BLOCK_MAX     512u            /* largest block_size  */
+#define SAMPLELOG_CHANNELS      4u
+#define SAMPLELOG_SAMPLE_MAX    11u             /* worst case bytes    */
+#define SAMPLELOG_BLK_START     0x8000u         /* count: new session  */
+
+typedef enum {
+    SAMPLELOG_OK    = 0,
+    SAMPLELOG_EMPTY = 1,    /* region not formatted: SampleLog_Erase */
+    SAMPLELOG_FULL  = 2,    /* no room for another block             */
+    SAMPLELOG_ERROR = -1
+} SampleLog_Status_t;
+
+typedef struct {
+    uint32_t time;          /* caller's ticks, low time_shift bits 0 */
+    int32_t  value;
+    uint8_t  channel;
+} SampleLog_Sample_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t t0;            /* time of the first sample              */
+    uint16_t count;         /* samples                               */
+    uint8_t  start;         /* first block of a session              */
+} SampleLog_Block_t;
+
+typedef struct {
+    /* platform, set by the application before SampleLog_Init */
+    const volatile uint32_t *area;      /* memory-mapped start           */
+    uint32_t area_size;
+    uint16_t block_size;                /* multiple of 4, <= BLOCK_MAX   */
+    uint8_t  time_shift;                /* ticks dropped from the time   */
+    uint32_t tick_hz;                   /* ticks per second, for readers */
+    /* program count words at byte offset (erased words only) and erase
+     * the whole region. 0 on success */
+    int      (*program)(uint32_t offset, const uint32_t *words, uint32_t count);
+    int      (*erase)(void);
+
+    /* state */
+    uint8_t  running;
+    uint8_t  session;                   /* next block starts a session   */
+    uint32_t alloc;                     /* offset of the next free block */
+    uint32_t seq;                       /* of the next block             */
+    uint32_t buf[2][SAMPLELOG_BLOCK_MAX / 4u];
+    uint32_t off[2];                    /* flash offset of a full block  */
+    uint8_t  full[2];                   /* waiting for / being programmed */
+    uint8_t  enc;                       /* block being encoded           */
+    uint8_t  flash;                     /* block programmed next         */
+    uint16_t pos;                       /* write position in buf[enc]    */
+    uint16_t count;                     /* samples in buf[enc]           */
+    uint16_t prog;                      /* words of buf[flash] done      */
+    uint32_t q_prev;                    /* time of the last sample, units */
+    int32_t  dt_prev;                   /* its step                      */
+    int32_t  x_prev[SAMPLELOG_CHANNELS];
+
+    /* statistics */
+    uint32_t samples;                   /* encoded                       */
+    uint32_t dropped;                   /* no block free, or full        */
+    uint32_t blocks;                    /* programmed                    */
+    uint32_t errors;                    /* failed programs               */
+} SampleLog_Handle_t;
+
+/* check the region header and find the end of the log */
+SampleLog_Status_t SampleLog_Init(SampleLog_Handle_t *h);
+
+/* erase the region and write its header (blocking) */
+SampleLog_Status_t SampleLog_Erase(SampleLog_Handle_t *h);
+
+/* start / stop taking samples; stop closes the open block, Poll still
+ * writes it */
+SampleLog_Status_t SampleLog_Start(SampleLog_Handle_t *h);
+void               SampleLog_Stop(SampleLog_Handle_t *h);
+
+/* one sample (channel < SAMPLELOG_CHANNELS); 0 if it was dropped */
+uint8_t            SampleLog_Put(SampleLog_Handle_t *h, uint8_t channel, uint32_t time, int32_t value);
+
+/* program up to max_words of a full block; returns the words written */
+uint32_t           SampleLog_Poll(SampleLog_Handle_t *h, uint32_t max_words);
+
+/* bytes of the region in use, including blocks still in RAM */
+uint32_t           SampleLog_Used(const SampleLog_Handle_t *h);
+
+/* decode one block (block_size bytes as read from flash) into info
+ * (may be NULL) and out; returns the samples written to out, or -1 if
+ * the block is erased, torn or bad */
+int                SampleLog_Decode(const uint8_t *block, uint16_t block_size, uint8_t time_shift,
+                                    SampleLog_Block_t *info, SampleLog_Sample_t *out, uint16_t max);
+
+#endif /* __SAMPLE_LOG_H__ */
@@ -0,0 +1,209 @@
+/**
+  ******************************************************************************
+  * @file    telemetry.c
+  * @brief   COBS framed telemetry encoded into a TX ring, sent by DMA
+  *          (HAL-free core, uses callbacks provided by app)
+  ******************************************************************************
+  */
+
+#include "telemetry.h"
+#include "cfg_log.h"
+
+#define RING_MASK   (TLM_RING - 1u)
+
+static uint16_t ring_free(const Tlm_Handle_t *h)
+{
+    return (uint16_t)(RING_MASK - ((h->wr - h->tail) & RING_MASK));
+}
+
+static void put_le(uint8_t *p, uint32_t v, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) { p[i] = (uint8_t)v; v >>= 8; }
+}
+
+/* one byte through the COBS encoder: a run ends at a zero or after 254
+ * bytes, its code byte (run length + 1) is patched in afterwards */
+static void cobs_byte(Tlm_Handle_t *h, uint8_t b)
+{
+    if (b != 0) {
+        h->buf[h->wr] = b;
+        h->wr = (uint16_t)((h->wr + 1u) & RING_MASK);
+        if (++h->code != 0xFFu) return;
+    }
+    h->buf[h->code_pos] = h->code;
+    h->code_pos = h->wr;
+    h->wr   = (uint16_t)((h->wr + 1u) & RING_MASK);
+    h->code = 1;
+}
+
+static void put_raw(Tlm_Handle_t *h, const uint8_t *p, uint16_t len)
+{
+    h->crc = CfgLog_Crc32(h->crc, p, len);
+    while (len--) cobs_byte(h, *p++);
+}
+
+void Tlm_Init(Tlm_Handle_t *h)
+{
+    h->head    = 0;
+    h->tail    = 0;
+    h->tx_len  = 0;
+    h->busy    = 0;
+    h->wr      = 0;
+    h->open    = 0;
+    h->seq     = 0;
+    h->frames  = 0;
+    h->bytes   = 0;
+    h->dropped = 0;
+}
+
+uint8_t Tlm_Begin(Tlm_Handle_t *h, uint8_t type, uint16_t len)
+{
+    uint32_t raw  = TLM_HDR + (uint32_t)len + 4u;
+    uint32_t need = raw + raw / 254u + 2u;     /* code bytes + delimiter */
+    uint8_t  hdr[TLM_HDR];
+
+    if (h->open || need > ring_free(h) || need > TLM_RING / 2u) {
+        h->dropped++;
+        h->seq++;
+        return 0;
+    }
+    h->open     = 1;
+    h->room     = len;
+    h->crc      = 0;
+    h->code_pos = h->wr;
+    h->wr       = (uint16_t)((h->wr + 1u) & RING_MASK);
+    h->code     = 1;
+
+    hdr[0] = type;
+    put_le(&hdr[1], h->seq++, 2);
+    put_raw(h, hdr, TLM_HDR);
+    return 1;
+}
+
+void Tlm_Put(Tlm_Handle_t *h, const void *data, uint16_t len)
+{
+    if (!h->open) return;
+    if (len > h->room) {
+        /* more than reserved: give the frame up */
+        h->wr   = h->head;
+        h->open = 0;
+        h->dropped++;
+        return;
+    }
+    h->room = (uint16_t)(h->room - len);
+    put_raw(h, (const uint8_t *)data, len);
+}
+
+void Tlm_PutU32(Tlm_Handle_t *h, uint32_t v)
+{
+    uint8_t b[4];
+    put_le(b, v, 4);
+    Tlm_Put(h, b, 4);
+}
+
+void Tlm_PutSample(Tlm_Handle_t *h, uint32_t time, int32_t code, uint8_t channel)
+{
+    uint8_t b[TLM_SAMPLE_SIZE];
+
+    put_le(&b[0], time, 4);
+    put_le(&b[4], (uint32_t)code, 3);
+    b[7] = channel;
+    Tlm_Put(h, b, TLM_SAMPLE_SIZE);
+}
+
+void Tlm_End(Tlm_Handle_t *h)
+{
+    uint8_t c[4];
+
+    if (!h->open) return;
+    put_le(c, h->crc, 4);
+    for (uint8_t i = 0; i < 4u; i++) cobs_byte(h, c[i]);
+    h->buf[h->code_pos] = h->code;
+    h->buf[h->wr] = 0;
+    h->wr   = (uint16_t)((h->wr + 1u) & RING_MASK);
+    h->open = 0;
+    h->head = h->wr;        /* publish */
+    h->frames++;
+    Tlm_Kick(h);
+}
+
+uint8_t Tlm_Event(Tlm_Handle_t *h, uint32_t time_ms, uint8_t id, int32_t arg)
+{
+    if (!Tlm_Begin(h, TLM_T_EVENT, 9)) return 0;
+    Tlm_PutU32(h, time_ms);
+    Tlm_Put(h, &id, 1);
+    Tlm_PutU32(h, (uint32_t)arg);
+    Tlm_End(h);
+    return 1;
+}
+
+uint8_t Tlm_Stats(Tlm_Handle_t *h, const Tlm_Stats_t *s)
+{
+    uint8_t b[TLM_STATS_SIZE];
+
+    put_le(&b[0],  s->time_ms, 4);
+    put_le(&b[4],  s->samples, 4);
+    put_le(&b[8],  s->sps, 2);
+    put_le(&b[10], s->acq_dropped, 2);
+    put_le(&b[12], s->acq_overruns, 2);
+    put_le(&b[14], s->tlm_dropped, 2);
+    put_le(&b[16], (uint32_t)s->weight_x10, 4);
+    put_le(&b[20], (uint32_t)s->filtered, 4);
+    put_le(&b[24], (uint32_t)(int32_t)s->temp, 2);
+    b[26] = s->stable;
+    b[27] = s->mode;
+
+    if (!Tlm_Begin(h, TLM_T_STATS, TLM_STATS_SIZE)) return 0;
+    Tlm_Put(h, b, TLM_STATS_SIZE);
+    Tlm_End(h);
+    return 1;
+}
+
+void Tlm_Kick(Tlm_Handle_t *h)
+{
+    uint16_t tail = h->tail, head = h->head, len;
+
+    /* no transfer in flight, so no Tlm_TxDone can run meanwhile */
+    if (h->busy || head == tail) return;
+    len = (head > tail) ? (uint16_t)(head - tail) : (uint16_t)(TLM_RING - tail);
+    h->tx_len = len;
+    h->busy   = 1;
+    if (h->tx_start(&h->buf[tail], len) != 0) h->busy = 0;
+}
+
+void Tlm_TxDone(Tlm_Handle_t *h)
+{
+    h->tail   = (uint16_t)((h->tail + h->tx_len) & RING_MASK);
+    h->bytes += h->tx_len;
+    h->busy   = 0;
+    Tlm_Kick(h);
+}
+
+uint16_t Tlm_Pending(const Tlm_Handle_t *h)
+{
+    return (uint16_t)((h->head - h->tail) & RING_MASK);
+}
+
+int Tlm_Unframe(const uint8_t *in, uint16_t len, uint8_t *out, uint16_t max)
+{
+    uint16_t i = 0, n = 0;
+    uint32_t crc;
+
+    while (i < len) {
+        uint8_t c = in[i++];
+        if (c == 0) return -1;
+        for (uint8_t k = 1; k < c; k++) {
+            if (i >= len || n >= max || in[i] == 0) return -1;
+            out[n++] = in[i++];
+        }
+        if (c != 0xFFu && i < len) {
+            if (n >= max) return -1;
+            out[n++] = 0;
+        }
+    }
+    if (n < TLM_HDR + 4u) return -1;
+    n = (uint16_t)(n - 4u);
+    crc = (uint32_t)out[n] | ((uint32_t)out[n + 1] << 8) | ((uint32_t)out[n + 2] << 16) |
+          ((uint32_t)out[n + 3] << 24);
+    return CfgLog_Crc32(0u, out, n) == crc ? (int)n : -1;
+}
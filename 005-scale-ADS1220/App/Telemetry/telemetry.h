@@ -0,0 +1,111 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+
+/* framed binary telemetry out of a UART (HAL-free core, the application
+ * provides the DMA start callback).
+ *
+ * every frame is COBS encoded and ends with a 0x00 byte, so a receiver
+ * can start anywhere and resynchronise on the next zero. decoded, a
+ * frame is
+ *
+ *   type (u8) | seq (u16) | record | crc32
+ *
+ * little endian, crc (CfgLog_Crc32) over type, seq and the record. seq
+ * counts every frame begun, so a frame dropped on a full ring, or lost
+ * on the line, shows as a gap at the receiver.
+ *
+ * frames are encoded straight into a byte ring: Tlm_Begin reserves room
+ * for the worst case, Tlm_Put* encode and checksum on the way in (the
+ * caller reads its own buffers, e.g. the ADC batch, no staging copy),
+ * Tlm_End publishes the frame. the DMA sends directly out of the ring,
+ * one contiguous span at a time; Tlm_TxDone, called from the transfer
+ * complete interrupt, frees the span and starts the next one. the main
+ * loop is the only writer. */
+
+#define TLM_RING            4096u   /* bytes, a frame must fit in 1/2  */
+#define TLM_HDR             3u      /* type + seq                      */
+
+/* record types */
+#define TLM_T_SAMPLES       0x01u   /* index (u32), count (u8), count *
+                                     * { time (u32), code (i24), ch (u8) } */
+#define TLM_T_EVENT         0x02u   /* time_ms (u32), id (u8), arg (i32) */
+#define TLM_T_STATS         0x03u   /* Tlm_Stats_t, field by field     */
+#define TLM_T_REPLY         0x04u   /* text, one answer line to a command */
+
+#define TLM_SAMPLE_SIZE     8u
+#define TLM_SAMPLES_MAX     32u     /* per frame                       */
+
+typedef struct {
+    uint32_t time_ms;
+    uint32_t samples;       /* ADC results taken                       */
+    uint16_t sps;           /* in the last second                      */
+    uint16_t acq_dropped;   /* acquisition ring full                   */
+    uint16_t acq_overruns;  /* DRDY during a read                      */
+    uint16_t tlm_dropped;   /* telemetry frames not sent               */
+    int32_t  weight_x10;    /* displayed weight, grams * 10            */
+    int32_t  filtered;      /* filtered ADC code                       */
+    int16_t  temp;          /* 1/32 degC, 0 without the MUX scan       */
+    uint8_t  stable;
+    uint8_t  mode;
+} Tlm_Stats_t;
+
+#define TLM_STATS_SIZE      28u
+
+typedef struct {
+    /* platform, set by the application before Tlm_Init: start sending
+     * len bytes at data (DMA), 0 on success; Tlm_TxDone when done */
+    int      (*tx_start)(const uint8_t *data, uint16_t len);
+
+    /* ring: [tail, head) being sent or waiting, [head, wr) the open
+     * frame, the rest free */
+    uint8_t           buf[TLM_RING];
+    volatile uint16_t head;         /* written by the main loop only   */
+    volatile uint16_t tail;         /* written by Tlm_TxDone only      */
+    volatile uint16_t tx_len;       /* span on the wire                */
+    volatile uint8_t  busy;
+    uint16_t wr;
+    uint16_t code_pos;              /* COBS code byte of the open run  */
+    uint8_t  code;
+    uint8_t  open;
+    uint16_t room;                  /* bytes the open frame may still take */
+    uint32_t crc;
+    uint16_t seq;
+
+    /* statistics */
+    uint32_t frames;                /* published                       */
+    uint32_t bytes;                 /* sent, framing included          */
+    uint32_t dropped;               /* no room in the ring             */
+} Tlm_Handle_t;
+
+void     Tlm_Init(Tlm_Handle_t *h);
+
+/* open a frame of up to len record bytes; 0 if the ring has no room
+ * (the frame is counted as dropped and its seq skipped) */
+uint8_t  Tlm_Begin(Tlm_Handle_t *h, uint8_t type, uint16_t len);
+void     Tlm_Put(Tlm_Handle_t *h, const void *data, uint16_t len);
+void     Tlm_PutU32(Tlm_Handle_t *h, uint32_t v);
+void     Tlm_PutSample(Tlm_Handle_t *h, uint32_t time, int32_t code, uint8_t channel);
+/* close and publish the frame, start the DMA if idle */
+void     Tlm_End(Tlm_Handle_t *h);
+
+/* one-call records */
+uint8_t  Tlm_Event(Tlm_Handle_t *h, uint32_t time_ms, uint8_t id, int32_t arg);
+uint8_t  Tlm_Stats(Tlm_Handle_t *h, const Tlm_Stats_t *s);
+
+/* start the DMA if idle and bytes are waiting (main loop) */
+void     Tlm_Kick(Tlm_Handle_t *h);
+
+/* transfer complete (interrupt): free the span, send the next one */
+void     Tlm_TxDone(Tlm_Handle_t *h);
+
+/* bytes waiting or on the wire */
+uint16_t Tlm_Pending(const Tlm_Handle_t *h);
+
+/* receiver side: decode one COBS frame (without its 0x00) into out and
+ * check the crc; returns the decoded length without the crc (type, seq,
+ * record), or -1 */
+int      Tlm_Unframe(const uint8_t *in, uint16_t len, uint8_t *out, uint16_t max);
+
+#endif /* __TELEMETRY_H__ */
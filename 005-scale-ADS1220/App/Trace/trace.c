@@ -0,0 +1,138 @@
+/**
+  ******************************************************************************
+  * @file    trace.c
+  * @brief   Deferred binary logging: per priority level lock-free rings of
+  *          format ids and raw arguments, merged by time in idle time
+  *          (HAL-free core, the application provides the output)
+  ******************************************************************************
+  */
+
+#include "trace.h"
+#include <stddef.h>
+
+#if !defined(__arm__) && !defined(TRACE_CLOCK)
+#include <time.h>
+
+uint32_t Trace_HostClock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+#endif
+
+/* keeps the stores of a record before the store of head; on the
+ * Cortex-M4 the interrupts see the stores in program order */
+#define TRACE_BARRIER()     __asm__ volatile ("" ::: "memory")
+
+void Trace_Init(Trace_Handle_t *h)
+{
+    for (uint8_t i = 0; i < h->count; i++) {
+        h->ring[i].head         = 0u;
+        h->ring[i].tail         = 0u;
+        h->ring[i].dropped      = 0u;
+        h->ring[i].dropped_told = 0u;
+    }
+    h->lost = 0u;
+}
+
+void Trace_Log(Trace_Handle_t *h, uint32_t hdr,
+               uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    uint32_t      t   = TRACE_CLOCK();
+    uint8_t       lvl = h->level();
+    Trace_Ring_t *r;
+    uint32_t     *b;
+    uint32_t      m, head, n, drops;
+
+    if (lvl >= h->count) return;
+    r     = &h->ring[lvl];
+    b     = r->buf;
+    m     = r->size - 1u;
+    head  = r->head;
+    n     = 2u + ((hdr >> 8) & 0x0Fu);
+    drops = r->dropped - r->dropped_told;
+    TRACE_PREEMPT_POINT();
+
+    if (r->size - (head - r->tail) < n + (drops ? 3u : 0u)) {
+        r->dropped++;
+        return;
+    }
+    hdr |= (uint32_t)lvl << 12;
+
+    /* drop record first, with the time of the record that follows */
+    if (drops) {
+        b[head++ & m] = ((uint32_t)TRACE_ID_DROP << 16) | (hdr & 0xF000u) | (1u << 8) | TRACE_SYNC;
+        b[head++ & m] = t;
+        b[head++ & m] = drops;
+        r->dropped_told += drops;
+    }
+
+    b[head & m]        = hdr;
+    b[(head + 1u) & m] = t;
+    switch (n) {
+    case 6u: b[(head + 5u) & m] = a3; /* fall through */
+    case 5u: b[(head + 4u) & m] = a2; /* fall through */
+    case 4u: b[(head + 3u) & m] = a1; /* fall through */
+    case 3u: b[(head + 2u) & m] = a0; /* fall through */
+    default: break;
+    }
+    TRACE_PREEMPT_POINT();
+
+    TRACE_BARRIER();
+    r->head = head + n;
+}
+
+/* ring with the oldest record, count if all are empty */
+static uint8_t oldest(const Trace_Handle_t *h)
+{
+    uint8_t  best = h->count;
+    uint32_t best_t = 0u;
+
+    for (uint8_t i = 0; i < h->count; i++) {
+        const Trace_Ring_t *r = &h->ring[i];
+        uint32_t tail = r->tail, t;
+
+        if (r->head == tail) continue;
+        t = r->buf[(tail + 1u) & (r->size - 1u)];
+        /* signed difference: the clock wraps */
+        if (best == h->count || (int32_t)(t - best_t) < 0) {
+            best   = i;
+            best_t = t;
+        }
+    }
+    return best;
+}
+
+uint32_t Trace_Drain(Trace_Handle_t *h, uint32_t max_words)
+{
+    uint32_t sent = 0u;
+
+    for (;;) {
+        uint8_t       i = oldest(h);
+        Trace_Ring_t *r;
+        uint32_t      m, tail, n;
+
+        if (i == h->count) break;
+        r    = &h->ring[i];
+        m    = r->size - 1u;
+        tail = r->tail;
+        n    = 2u + ((r->buf[tail & m] >> 8) & 0x0Fu);
+        if (sent + n > max_words) break;
+        TRACE_PREEMPT_POINT();
+
+        if (h->put(r->buf[tail & m]) != 0) break;
+        for (uint32_t k = 1u; k < n; k++) {
+            if (h->put(r->buf[(tail + k) & m]) != 0) {
+                /* the decoder resyncs on the next header */
+                h->lost++;
+                break;
+            }
+        }
+        sent += n;
+
+        TRACE_BARRIER();
+        r->tail = tail + n;
+    }
+    return sent;
+}
@@ -22,18 +22,24 @@
   *  Display top bar always shows current mode:
   *    [ SCALE  ] or [ CALIBRATE ]
   *
-  * Flash sector — adjust for your MCU:
-  *   STM32F401 (256 KB): FLASH_SECTOR_5  @ 0x08020000
-  *   STM32F411 (512 KB):   FLASH_SECTOR_7  @ 0x08060000
-  *   STM32F405/F407 (1 MB):   FLASH_SECTOR_7  @ 0x08060000
+  *  USART1 (PA10 RX, COMMANDS): the same actions as text command lines,
+  *    "help" lists them
+  *
+  * Flash sectors (settings log, two 128 KB sectors used in turn) — adjust
+  * for your MCU:
+  *   STM32F401 (256 KB): FLASH_SECTOR_4/5  @ 0x08010000 / 0x08020000, 64 KB
+  *   STM32F411 (512 KB):   FLASH_SECTOR_6/7  @ 0x08040000 / 0x08060000
+  *   STM32F405/F407 (1 MB):   FLASH_SECTOR_6/7  @ 0x08040000 / 0x08060000
   ******************************************************************************
   */
 /* USER CODE END Header */
 
 #include "main.h"
+#include "dma.h"
 #include "i2c.h"
 #include "spi.h"
 #include "tim.h"
+#include "usart.h"
 #include "gpio.h"
 
 /* USER CODE BEGIN Includes */
@@ -43,6 +49,18 @@
 #include "sh1106_fonts.h"
 #include "EC11.h"
 #include "ads1220.h"
+#include "ads1220_acq.h"
+#include "cfg_log.h"
+#include "wfilter.h"
+#include "decim.h"
+#include "calib.h"
+#include "ztrack.h"
+#include "checkw.h"
+#include "sample_log.h"
+#include "telemetry.h"
+#include "cmd.h"
+#include "prof.h"
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* USER CODE BEGIN PD */
@@ -56,10 +74,86 @@
 #define BTN_PUSH_PORT       GPIOA
 #define BTN_PUSH_PIN        GPIO_PIN_2
 
-/* Flash storage configuration - adjust for your device */
-#define FLASH_STORAGE_SECTOR    FLASH_SECTOR_7
-#define FLASH_STORAGE_ADDR      0x08060000U
-#define FLASH_MAGIC             0xA55A1234U
+/* 1: run the ADC at 2000 SPS (turbo) and decimate in firmware, see
+ * decim.h: a 200 Hz stream in weight_fast_x10 and for the checkweigher
+ * (Check mode), and a 10 Hz stream for the weight filter and display */
+#define ADC_DECIM               0
+
+/* ADC setting (see the data rate table in readme.md). 20 SPS normal mode
+ * suits the display filter; ADS1220_OPMODE_TURBO with DR 6 gives 2000 SPS */
+#if ADC_DECIM
+#define ADC_OPMODE              ADS1220_OPMODE_TURBO
+#define ADC_DR                  6
+#else
+#define ADC_OPMODE              ADS1220_OPMODE_NORMAL
+#define ADC_DR                  0
+#endif
+#define ADC_GAIN                128
+
+/* 1: interleave the bridge with the temperature sensor, AVDD/4 and a
+ * shorted input (offset) through the MUX scan list; only the bridge
+ * results feed the weight. the scan list must be in continuous mode */
+#define ADC_SCAN                0
+#define ADC_SCAN_BRIDGE_SAMPLES 8       /* bridge conversions per visit */
+#define ADC_SCAN_OFFSET_EVERY   4       /* shorted input every n-th cycle */
+
+#if ADC_SCAN && ADC_DECIM
+#error "the decimation chain needs the bridge at a fixed rate, no MUX scan"
+#endif
+
+/* Flash storage configuration - adjust for your device.
+ * the settings log alternates between two sectors; the linker script
+ * keeps the program below the first one */
+#define FLASH_STORAGE_SECTOR0   FLASH_SECTOR_6
+#define FLASH_STORAGE_ADDR0     0x08040000U
+#define FLASH_STORAGE_SECTOR1   FLASH_SECTOR_7
+#define FLASH_STORAGE_ADDR1     0x08060000U
+#define FLASH_STORAGE_SIZE      (128U * 1024U)
+#define FLASH_LOG_SLOT          128U        /* bytes per record, room to grow */
+#define FLASH_CONFIG_VERSION    2U          /* bump when FlashConfig_t changes */
+#define FLASH_LEGACY_ADDR       FLASH_STORAGE_ADDR1
+#define FLASH_LEGACY_MAGIC      0xA55A1234U
+
+/* 1: record every ADC result (raw code, DWT time, scan channel) into the
+ * sample log sector below the settings log, see sample_log.h. hold Back
+ * at power-up to erase it; otherwise the log is appended to until full */
+#define SAMPLE_LOG              0
+#define SAMPLE_LOG_SECTOR       FLASH_SECTOR_5
+#define SAMPLE_LOG_ADDR         0x08020000U
+#define SAMPLE_LOG_SIZE         (128U * 1024U)
+#define SAMPLE_LOG_BLOCK        512U
+#define SAMPLE_LOG_TIME_SHIFT   10U         /* 2^10 cycles, 10.24 us       */
+#define SAMPLE_LOG_POLL_WORDS   8U          /* programmed per loop pass    */
+
+/* 1: stream every ADC result, events and once a second the stats as COBS
+ * framed telemetry on USART1 TX (PA9, 921600 baud, DMA), see telemetry.h
+ * and tools/tlm_decode.c */
+#define TELEMETRY               1
+
+/* telemetry event ids (TLM_T_EVENT) and their argument */
+#define TLM_EV_TARE             1   /* tare code                        */
+#define TLM_EV_MODE             2   /* new AppMode_t                    */
+#define TLM_EV_CAL_POINT        3   /* reference mass, grams * 10       */
+#define TLM_EV_CAL_SAVED        4   /* points in the table              */
+#define TLM_EV_CHECK_ITEM       5   /* + CheckW_Class_t, grams * 10     */
+
+/* 1: text commands on USART1 RX (PA10, circular DMA, idle line), see
+ * cmd.h; answers go out as telemetry reply frames, or as text lines
+ * without TELEMETRY. "help" lists them */
+#define COMMANDS                1
+#define CMD_RX_SIZE             1024u   /* RX DMA ring, power of two    */
+
+/* execution time zones (prof.h), on with PROF_ENABLE: Debug builds.
+ * the Diag screen (Confirm held at power-up, or "mode diag") lists
+ * them, Confirm there dumps them over ITM; "prof" over the console */
+#define DIAG_ROWS               4u      /* zones on screen, encoder scrolls */
+
+/* deferred log (trace.h), on with TRACE_ENABLE: TRACE points store a
+ * format id and raw arguments in one ring per interrupt priority, the
+ * main loop sends them on ITM port 1 while a debugger is attached.
+ * tools/trace_decode.c prints them with the strings from the ELF */
+#define TRACE_ITM_PORT          1u
+#define TRACE_DRAIN_WORDS       32u     /* per loop pass, ~0.8 ms of SWO at 2 Mbit/s */
 /* USER CODE END PD */
 
 /* USER CODE BEGIN PM */
@@ -74,14 +168,51 @@
 typedef enum {
     MODE_SCALE = 0,
     MODE_CALIBRATE,
+    MODE_CHECK,                 /* checkweigher, needs ADC_DECIM */
+    MODE_DIAG,                  /* execution times, needs PROF_ENABLE */
 } AppMode_t;
 
-/* Structure stored in flash to persist calibration divisor */
+/* execution time zones (PROF_BEGIN / PROF_END) */
+typedef enum {
+    PZ_LOOP = 0,                /* one main loop pass                   */
+    PZ_ACQ,                     /* one ADC batch: telemetry, log, math  */
+    PZ_DRDY,                    /* DRDY EXTI, starts the SPI DMA read   */
+    PZ_READ,                    /* SPI DMA complete, result to the ring */
+    PZ_SLOG,                    /* SampleLog_Poll                       */
+    PZ_CMD,                     /* Cmd_Poll with the handlers           */
+    PZ_INPUT,                   /* buttons and encoder                  */
+    PZ_DISPLAY,                 /* Display_Update, drawing + I2C        */
+    PZ_OLED,                    /* SH1106_UpdateScreen, the I2C part    */
+    PZ_TRACE,                   /* Trace_Drain to the ITM               */
+    PZ_COUNT
+} ProfZone_t;
+
+/* trace rings, one per preemption priority that logs */
+typedef enum {
+    TL_THREAD = 0,              /* main loop                            */
+    TL_UART,                    /* priority 2: USART1, its DMA streams  */
+    TL_ADC,                     /* priority 1: DRDY EXTI, SPI1 DMA      */
+    TL_COUNT
+} TraceLevel_t;
+
+/* Record stored in the flash settings log (the log adds seq, version
+   and CRC-32 around it) */
+typedef struct {
+    Calib_Table_t calibration;  /* reference points, temperature drift */
+} FlashConfig_t;
+
+/* version 1 record: a single divisor, converted on load */
+typedef struct {
+    int32_t  calibration_divisor;
+} FlashConfigV1_t;
+
+/* the single record of firmware before the settings log, erased and
+ * rewritten on every save at the start of sector 7 */
 typedef struct {
     uint32_t magic;
     int32_t  calibration_divisor;
-    uint32_t checksum;
-} FlashConfig_t;
+    uint32_t checksum;      /* magic ^ divisor */
+} FlashLegacy_t;
 
 /* Simple debounced button — call every main loop iteration
    only basic edge detection implemented (sufficient for ~200 ms update loop) */
@@ -96,20 +227,85 @@ typedef struct {
 /* USER CODE BEGIN PV */
 /* Hardware interface objects */
 ADS1220_Handle_t hads1220;
+ADS1220_Acq_t    hacq;          /* DRDY -> SPI DMA -> sample ring */
+#if ADC_SCAN
+ADS1220_Scan_t       hscan;     /* MUX scan switched from the read ISR */
+ADS1220_ScanEntry_t  scan_list[4];
+#endif
 EC11_Encoder_t   encoder;
+CfgLog_Handle_t  hcfglog;
+#if SAMPLE_LOG
+SampleLog_Handle_t hslog;       /* encoded in the loop, programmed by Poll */
+#endif
+#if TELEMETRY
+Tlm_Handle_t     htlm;          /* TX ring, sent by USART1 DMA */
+uint32_t         tlm_index  = 0;            /* ADC results read so far */
+AppMode_t        tlm_mode   = MODE_SCALE;   /* last mode reported      */
+#endif
+#if COMMANDS
+Cmd_Handle_t     hcmd;          /* lines parsed in place from cmd_rx */
+uint8_t          cmd_rx[CMD_RX_SIZE];       /* USART1 RX, circular DMA */
+#endif
+#if PROF_ENABLE
+Prof_Handle_t    hprof;         /* zones on the DWT cycle counter */
+Prof_Zone_t      prof_zone[PZ_COUNT];
+const char *const prof_name[PZ_COUNT] = {
+    "loop", "acq", "drdy", "read", "slog", "cmd", "input", "display", "oled", "trace"
+};
+uint8_t          diag_first = 0;            /* first zone on the screen */
+#endif
+#if TRACE_ENABLE
+Trace_Handle_t   htrace;        /* drained to ITM port 1 by the main loop */
+uint32_t         trace_buf_thread[256];
+uint32_t         trace_buf_uart[64];
+uint32_t         trace_buf_adc[64];
+Trace_Ring_t     trace_ring[TL_COUNT] = {
+    [TL_THREAD] = { .buf = trace_buf_thread, .size = 256 },
+    [TL_UART]   = { .buf = trace_buf_uart,   .size = 64  },
+    [TL_ADC]    = { .buf = trace_buf_adc,    .size = 64  },
+};
+#endif
 
 /* Measurement variables */
 int32_t  adc_raw            = 0;   /* raw 24-bit ADC value from ADS1220 */
 int32_t  adc_code           = 0;   /* adc_raw - tare_offset */
 int32_t  weight_grams_x10   = 0;   /* grams * 10 (one decimal digit) */
 
-/* Simple moving average filter for displayed weight */
-#define FILTER_SIZE     8
-static int32_t  filter_buf[FILTER_SIZE];
-static uint8_t  filter_idx  = 0;
-static uint8_t  filter_full = 0;
+/* Adaptive filter for displayed weight (on raw codes, see wfilter.h) */
+#define FILTER_WINDOW_MS        1600    /* longest window when settled   */
+#define FILTER_STABLE_MS        500     /* quiet time before "stable"    */
+#define FILTER_STEP_G_X10       20      /* load change that restarts it  */
+#define FILTER_NOISE_G_X10      1       /* std deviation when stable     */
+WFilter_t wfilter;
+int32_t  adc_filtered       = 0;   /* filtered raw code */
 int32_t  weight_filtered    = 0;
 
+/* Automatic zero tracking and offset correction (ztrack.h); d is the
+ * display division, 0.1 g */
+#define ZTRACK_BAND_D_X10       10      /* tracked within +-1 d of zero   */
+#define ZTRACK_RECAPTURE_D_X10  50      /* +-5 d after a load is removed  */
+#define ZTRACK_RATE_D_X10       5       /* at most 0.5 d per second       */
+#define ZTRACK_RANGE_G          20      /* +-20 g from the manual tare    */
+#define ZTRACK_HOLD_MS          1000    /* empty and stable this long     */
+#define ZTRACK_OFFSET_SHIFT     3       /* offset average over ~8 samples */
+ZTrack_t hztrack;
+#if ADC_DECIM
+Decim_t  hdecim;                   /* 2000 SPS -> 200 Hz -> 10 Hz */
+int32_t  weight_fast_x10    = 0;   /* 200 Hz stream, grams * 10 */
+
+/* Checkweigher on the 200 Hz stream (checkw.h), items moving across */
+#define CHECK_NOMINAL_G         100     /* target at start, encoder sets it */
+#define CHECK_UNDER_G_X10       20      /* accepted from nominal - 2.0 g   */
+#define CHECK_OVER_G_X10        30      /* ... up to nominal + 3.0 g       */
+#define CHECK_ON_G              5       /* item arrives above 5 g          */
+#define CHECK_NOISE_G_X10       5       /* plateau std deviation limit     */
+#define CHECK_PLATEAU_MS        50      /* shortest usable plateau         */
+CheckW_t        hcheck;
+CheckW_Batch_t  hbatch;
+int32_t         check_item_x10  = 0;    /* last item, grams * 10 */
+CheckW_Class_t  check_item_cls  = CHECKW_OK;
+#endif
+
 /* Timing / counters */
 uint32_t last_update        = 0;
 uint32_t sample_count       = 0;
@@ -123,10 +319,17 @@ char     display_buf[64];
 
 /* Scale settings */
 int32_t  tare_offset            = 0;
-int32_t  calibration_divisor    = 1724; /* counts per gram (×10 internal) */
-int32_t  cal_divisor_backup     = 1724; /* temporary backup while editing */
+int32_t  calibration_divisor    = 1724; /* counts per gram, from the table */
 uint8_t  tare_pressed           = 0;
 
+/* Calibration: multi-point table (calib.h) */
+#define CAL_DEFAULT_DIVISOR     1724    /* counts per gram without a table */
+#define CAL_FAST_MS             60      /* detents closer than this: 10 g  */
+Calib_t  hcal;
+Calib_t  cal_backup;                    /* restored by Back               */
+int32_t  cal_ref_g              = 0;    /* reference mass being entered   */
+uint32_t cal_last_detent        = 0;
+
 /* Application mode */
 AppMode_t app_mode = MODE_SCALE;
 
@@ -149,17 +352,65 @@ void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
 /* Display update helper */
 void     Display_Update(void);
+#if ADC_DECIM
+static void Display_CheckRows(void);
+#endif
+#if PROF_ENABLE
+static void Display_DiagRows(void);
+#endif
 
 /* show a short message on the bottom line, auto-expire after NOTIFY_DURATION_MS */
 void     Notify(const char *msg);
 
+/* weight math for one ADC result */
+static void     Scale_ProcessSample(int32_t raw);
+static void     Scale_FilterSetup(void);
+static void     Scale_DefaultCalibration(void);
+static int32_t  Scale_TareWeight(void);
+#if ADC_DECIM
+static void     Scale_CheckItem(void);
+#endif
+static void     Scale_Tare(void);
+static void     Cal_Start(void);
+static uint8_t  Cal_TakePoint(void);
+static uint8_t  Cal_Finish(void);
+static void     Cal_Cancel(void);
+#if ADC_DECIM
+static void     Check_Enter(void);
+#endif
+#if PROF_ENABLE
+static void     Diag_Enter(void);
+static void     Diag_Dump(void);
+#endif
+#if TRACE_ENABLE
+static uint8_t  Trace_Level(void);
+static int      Trace_ItmPut(uint32_t w);
+#endif
+
 /* poll a simple edge-detect button (active-low) */
 static void     Button_Poll(Button_t *b);
 
 /* persistence helpers */
 static void     Flash_SaveConfig(void);
 static uint8_t  Flash_LoadConfig(void);
-static uint32_t Config_Checksum(const FlashConfig_t *c);
+static uint8_t  Flash_LoadLegacy(FlashConfigV1_t *v1);
+static int      Flash_LogProgram(uint8_t area, uint32_t offset, const uint32_t *words, uint32_t count);
+static int      Flash_LogErase(uint8_t area);
+/* telemetry records (see TELEMETRY) */
+static void     Telemetry_Event(uint8_t id, int32_t arg);
+#if TELEMETRY
+static void     Telemetry_Samples(const ADS1220_Sample_t *s, uint16_t n);
+static void     Telemetry_Stats(uint32_t now);
+static int      Telemetry_TxStart(const uint8_t *data, uint16_t len);
+#endif
+#if COMMANDS
+static void     Console_Start(void);
+#endif
+#if SAMPLE_LOG
+static void     Flash_SampleLogStart(void);
+static int      Flash_SampleProgram(uint32_t offset, const uint32_t *words, uint32_t count);
+static int      Flash_SampleErase(void);
+#endif
 /* USER CODE END PFP */
 
 /* USER CODE BEGIN 0 */
@@ -167,6 +418,11 @@ static void    adsCsLow(void);
 static void    adsCsHigh(void);
 static int     adsSpiTxRx(const uint8_t *tx, uint8_t *rx, uint16_t len);
 static uint8_t adsDrdyRead(void);
+#if ADC_SCAN
+static uint8_t adsDrdyClear(void);
+#endif
+static int      adsReadStart(uint8_t *rx, uint16_t len);
+static uint32_t adsTimestamp(void);
 /* USER CODE END 0 */
 
 /* ============================================================
@@ -185,6 +441,20 @@ int main(void)
     ITM->TCR = ITM_TCR_ITMENA_Msk | ITM_TCR_TSENA_Msk;
     ITM->TER = 1;
 
+    /* cycle counter: sample timestamps */
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+
+#if TRACE_ENABLE
+    /* deferred log on its own stimulus port, before any interrupt */
+    ITM->TER   |= 1u << TRACE_ITM_PORT;
+    htrace.ring  = trace_ring;
+    htrace.count = TL_COUNT;
+    htrace.level = Trace_Level;
+    htrace.put   = Trace_ItmPut;
+    Trace_Init(&htrace);
+#endif
+
 
     /* provide platform callbacks to ADS1220 driver */
     hads1220.csLow    = adsCsLow;
@@ -193,16 +463,77 @@ int main(void)
     hads1220.drdyRead = adsDrdyRead;
     hads1220.gain     = 128;
     hads1220.vref     = 2.048f;
+
+    /* acquisition: DRDY EXTI starts a DMA read, samples go to a ring */
+    hacq.hads      = &hads1220;
+    hacq.readStart = adsReadStart;
+    hacq.timestamp = adsTimestamp;
+
+#if ADC_DECIM
+    /* 2000 SPS -> CIC 10x3 + FIR 21 -> 200 Hz -> CIC 5x3 + FIR 31 /4 -> 10 Hz */
+    hdecim.count              = 2;
+    hdecim.stage[0].r         = 10;
+    hdecim.stage[0].n         = 3;
+    hdecim.stage[0].taps      = Decim_Taps200Hz;
+    hdecim.stage[0].ntaps     = 21;
+    hdecim.stage[0].fir_decim = 1;
+    hdecim.stage[1].r         = 5;
+    hdecim.stage[1].n         = 3;
+    hdecim.stage[1].taps      = Decim_Taps10Hz;
+    hdecim.stage[1].ntaps     = 31;
+    hdecim.stage[1].fir_decim = 4;
+    Decim_Init(&hdecim);
+
+    /* checkweigher batch limits (levels follow the calibration) */
+    hbatch.nominal = CHECK_NOMINAL_G * 10;
+    hbatch.under   = CHECK_UNDER_G_X10;
+    hbatch.over    = CHECK_OVER_G_X10;
+    CheckW_BatchReset(&hbatch);
+#endif
+
+    /* settings log in the two storage sectors */
+    hcfglog.area[0]   = (const volatile uint32_t *)FLASH_STORAGE_ADDR0;
+    hcfglog.area[1]   = (const volatile uint32_t *)FLASH_STORAGE_ADDR1;
+    hcfglog.area_size = FLASH_STORAGE_SIZE;
+    hcfglog.slot_size = FLASH_LOG_SLOT;
+    hcfglog.program   = Flash_LogProgram;
+    hcfglog.erase     = Flash_LogErase;
+
+#if SAMPLE_LOG
+    /* sample log in its own sector, DWT cycles as the time base */
+    hslog.area       = (const volatile uint32_t *)SAMPLE_LOG_ADDR;
+    hslog.area_size  = SAMPLE_LOG_SIZE;
+    hslog.block_size = SAMPLE_LOG_BLOCK;
+    hslog.time_shift = SAMPLE_LOG_TIME_SHIFT;
+    hslog.program    = Flash_SampleProgram;
+    hslog.erase      = Flash_SampleErase;
+#endif
+
+#if TELEMETRY
+    htlm.tx_start = Telemetry_TxStart;
+    Tlm_Init(&htlm);
+#endif
     /* USER CODE END Init */
 
     SystemClock_Config();
 
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_I2C1_Init();
     MX_TIM2_Init();
     MX_SPI1_Init();
+    MX_USART1_UART_Init();
 
     /* USER CODE BEGIN 2 */
+#if PROF_ENABLE
+    /* zones in DWT cycles, clock set up by now */
+    hprof.zone    = prof_zone;
+    hprof.names   = prof_name;
+    hprof.count   = PZ_COUNT;
+    hprof.tick_hz = SystemCoreClock;
+    Prof_Init(&hprof);
+#endif
+
     HAL_Delay(100); /* allow supplies and sensors to settle */
 
     /* initialize OLED; hang if display not present */
@@ -217,10 +548,51 @@ int main(void)
     HAL_TIM_Encoder_Start(&htim2, TIM_CHANNEL_ALL);
     ENC_RESET();
 
+#if SAMPLE_LOG
+    /* before the acquisition: an erase stalls the flash for ~2 s */
+    Flash_SampleLogStart();
+#endif
+
     /* initialize ADS1220 ADC */
-    if (ADS1220_Init(&hads1220) == ADS1220_OK) {
+    ADS1220_Config_t adc_cfg;
+    ADS1220_DefaultConfig(&adc_cfg);
+    adc_cfg.mode = ADC_OPMODE;
+    adc_cfg.dr   = ADC_DR;
+    adc_cfg.gain = ADC_GAIN;
+
+#if ADC_SCAN
+    /* 0: bridge, 1: temperature, 2: AVDD/4, 3: shorted input (offset) */
+    adc_cfg.continuous = 1;
+    for (uint8_t i = 0; i < 4; i++) {
+        scan_list[i].cfg     = adc_cfg;
+        scan_list[i].samples = 1;
+        scan_list[i].discard = 0;
+        scan_list[i].every   = 0;
+    }
+    scan_list[0].samples           = ADC_SCAN_BRIDGE_SAMPLES;
+    scan_list[1].cfg.temp_sensor   = 1;
+    scan_list[1].cfg.gain          = 1;
+    scan_list[2].cfg.input         = ADS1220_IN_AVDD_DIV4;
+    scan_list[2].cfg.gain          = 1;
+    scan_list[2].cfg.pga_bypass    = 1;
+    scan_list[3].cfg.input         = ADS1220_IN_SHORTED;
+    scan_list[3].every             = ADC_SCAN_OFFSET_EVERY;
+    hscan.hads  = &hads1220;
+    hscan.list  = scan_list;
+    hscan.count = 4;
+    hscan.drdyClear = adsDrdyClear;
+    hacq.scan   = &hscan;
+#endif
+
+    if (ADS1220_Init(&hads1220) == ADS1220_OK &&
+#if ADC_SCAN
+        ADS1220_ScanInit(&hscan) == ADS1220_OK &&                 /* entry 0, read back */
+#else
+        ADS1220_Configure(&hads1220, &adc_cfg) == ADS1220_OK &&   /* written + read back */
+#endif
+        ADS1220_AcqInit(&hacq) == ADS1220_OK) {
         ads_init_ok   = 1;
-        hads1220.gain = 128; /* confirm gain */
+        ADS1220_AcqStart(&hacq); /* DRDY edges are ignored until now */
     } else {
         /* show error and halt */
         SH1106_WriteStringAt(10, 28, "ADS1220 INIT FAIL", Font_8H, SH1106_COLOR_WHITE);
@@ -229,7 +601,22 @@ int main(void)
     }
 
     /* restore previous calibration (if present) - silent fallback to defaults */
-    Flash_LoadConfig();
+    if (!Flash_LoadConfig()) Scale_DefaultCalibration();
+    Calib_SetTemperature(&hcal, hcal.tab.temp0);  /* neutral until measured */
+    calibration_divisor = Calib_CodesPerGram(&hcal);
+    Scale_FilterSetup();
+
+#if COMMANDS
+    Console_Start();
+#endif
+
+#if PROF_ENABLE
+    /* Confirm held at power-up: the Diag screen (held, so no edge) */
+    if (BTN_PRESSED(BTN_CONFIRM_PORT, BTN_CONFIRM_PIN)) {
+        Diag_Enter();
+        btn_confirm.last_raw = 0;
+    }
+#endif
 
     last_update   = HAL_GetTick();
     last_sps_time = HAL_GetTick();
@@ -240,38 +627,92 @@ int main(void)
     {
         /* USER CODE BEGIN 3 */
         uint32_t now = HAL_GetTick();
+        PROF_BEGIN(t_loop);
 
-        /* ---- ADC sampling & basic processing ----
-         * Read raw ADC, subtract tare, compute weight (integer math)
-         * Apply lightweight moving average for display smoothing.
+        /* ---- ADC samples ----
+         * the DRDY/DMA engine fills the ring in the background, even while
+         * Display_Update() blocks on I2C; take everything collected since
+         * the last pass. each batch is used in place in the ring and
+         * handed back once done.
          */
         if (ads_init_ok) {
-            if (ADS1220_ReadData(&hads1220, &adc_raw) == ADS1220_OK) {
-                adc_code         = adc_raw - tare_offset;
-                weight_grams_x10 = (adc_code * 10) / calibration_divisor;
-
-                /* moving average buffer update */
-                filter_buf[filter_idx] = weight_grams_x10;
-                filter_idx = (filter_idx + 1) % FILTER_SIZE;
-                if (filter_idx == 0) filter_full = 1;
-
-                uint8_t  count = filter_full ? FILTER_SIZE : filter_idx;
-                int32_t  sum   = 0;
-                for (uint8_t i = 0; i < count; i++) sum += filter_buf[i];
-                weight_filtered = sum / (count ? count : 1);
-
-                sample_count++;
+            const ADS1220_Sample_t *batch;
+            uint16_t                n;
+            while ((n = ADS1220_AcqPeek(&hacq, &batch, 16)) != 0) {
+                PROF_BEGIN(t_acq);
+#if TELEMETRY
+                Telemetry_Samples(batch, n);    /* straight into the TX ring */
+#endif
+                for (uint16_t i = 0; i < n; i++) {
+#if SAMPLE_LOG
+                    SampleLog_Put(&hslog, batch[i].channel, batch[i].time, batch[i].code);
+#endif
+#if ADC_SCAN
+                    if (batch[i].channel == 3) ZTrack_OffsetSample(&hztrack, batch[i].code);
+#endif
+                    if (batch[i].channel != 0) continue;   /* scan: bridge only */
+                    /* ADC offset from the shorted input, 0 without the scan */
+                    int32_t bridge = batch[i].code - hztrack.offset;
+#if ADC_DECIM
+                    uint8_t ready = Decim_Process(&hdecim, bridge);
+                    if (ready & 1u) {
+                        int32_t code = (hdecim.stage[0].out + (1 << (DECIM_FRAC - 1))) >> DECIM_FRAC;
+                        weight_fast_x10 = Calib_Weight(&hcal, code) - Scale_TareWeight();
+                        if (app_mode == MODE_CHECK && CheckW_Process(&hcheck, hdecim.stage[0].out, now)) {
+                            Scale_CheckItem();
+                        }
+                    }
+                    if (ready & 2u) {
+                        Scale_ProcessSample((hdecim.stage[1].out + (1 << (DECIM_FRAC - 1))) >> DECIM_FRAC);
+                    }
+#else
+                    Scale_ProcessSample(bridge);
+#endif
+                    sample_count++;
+                }
+                ADS1220_AcqCommit(&hacq, n);
+                PROF_END(&hprof, PZ_ACQ, t_acq);
             }
         }
+#if SAMPLE_LOG
+        /* a few words per pass, the acquisition keeps running meanwhile */
+        PROF_BEGIN(t_slog);
+        SampleLog_Poll(&hslog, SAMPLE_LOG_POLL_WORDS);
+        PROF_END(&hprof, PZ_SLOG, t_slog);
+#endif
+#if COMMANDS
+        PROF_BEGIN(t_cmd);
+        Cmd_Poll(&hcmd);    /* before Tlm_Kick: the answers go out right away */
+        PROF_END(&hprof, PZ_CMD, t_cmd);
+#endif
+#if TELEMETRY
+        Tlm_Kick(&htlm);    /* normally restarted by the TX complete interrupt */
+#endif
+
+        /* zero tracking on the empty platform (after the first tare) */
+        if (app_mode == MODE_SCALE && tare_pressed) {
+            tare_offset = ZTrack_Update(&hztrack, adc_filtered, wfilter.stable, now);
+        }
 
         /* update samples per second every 1 second */
         if ((now - last_sps_time) >= 1000) {
             samples_per_sec = sample_count;
             sample_count    = 0;
             last_sps_time   = now;
+#if TELEMETRY
+            Telemetry_Stats(now);
+#endif
+#if ADC_SCAN
+            /* temperature compensation from the scan's sensor entry
+               (14-bit result, left aligned, 1/32 degC per LSB) */
+            if (hscan.result[1].count != 0) {
+                Calib_SetTemperature(&hcal, (int16_t)(hscan.result[1].code >> 10));
+            }
+#endif
         }
 
         /* ---- Input processing: buttons and encoder ---- */
+        PROF_BEGIN(t_input);
         Button_Poll(&btn_confirm);
         Button_Poll(&btn_back);
         Button_Poll(&btn_push);
@@ -286,53 +727,91 @@ int main(void)
                 enc_delta = encoder.step - before; /* logical detent steps */
             }
         }
+        PROF_END(&hprof, PZ_INPUT, t_input);
 
         /* ---- Application state machine ----
-         * SCALE: confirm = tare, push = enter calibrate
-         * CALIBRATE: encoder adjusts divisor live, confirm=save, back=undo
+         * SCALE: confirm = tare, push = enter calibrate, back = check
+         * CALIBRATE: encoder sets the reference mass, confirm = take the
+         * point (reading must be stable), push = fit + save, back = undo
+         * CHECK: encoder sets the nominal weight, confirm = new batch,
+         * back = scale
+         * DIAG: encoder scrolls the zones, confirm = ITM dump,
+         * push = clear, back = scale
          */
         switch (app_mode)
         {
         case MODE_SCALE:
-            if (btn_confirm.pressed) {
-                /* store current raw as tare reference */
-                tare_offset  = adc_raw;
-                tare_pressed = 1;
-                Notify("Tared");
-            }
-            if (btn_push.pressed) {
-                /* enter calibration; keep backup so Back can restore */
-                cal_divisor_backup = calibration_divisor;
-                app_mode = MODE_CALIBRATE;
-                Notify("CAL");
-                /* force immediate UI refresh */
-                last_update = 0;
-            }
+            if (btn_confirm.pressed) Scale_Tare();
+            if (btn_push.pressed)    Cal_Start();
+#if ADC_DECIM
+            if (btn_back.pressed)    Check_Enter();
+#endif
             /* encoder ignored in SCALE mode */
             break;
 
         case MODE_CALIBRATE:
             if (enc_delta != 0) {
-                /* adjust divisor by detents (increase divisor -> less grams) */
-                calibration_divisor -= enc_delta;
-                if (calibration_divisor <= 0) calibration_divisor = 1;
-                /* indicate direction quickly */
-                Notify(enc_delta > 0 ? ">" : "<");
+                /* reference mass: 1 g per detent, 10 g when turned fast */
+                int32_t step = ((now - cal_last_detent) < CAL_FAST_MS) ? 10 : 1;
+                cal_last_detent = now;
+                cal_ref_g += enc_delta * step;
+                if (cal_ref_g < 0) cal_ref_g = 0;
                 last_update = 0; /* immediate redraw to show feedback */
             }
+            if (btn_confirm.pressed) Cal_TakePoint();
+            if (btn_push.pressed)    Cal_Finish();
+            if (btn_back.pressed)    Cal_Cancel();
+            break;
+
+        case MODE_CHECK:
+#if ADC_DECIM
+            if (enc_delta != 0) {
+                /* nominal weight, 1 g per detent */
+                hbatch.nominal += enc_delta * 10;
+                if (hbatch.nominal < 10) hbatch.nominal = 10;
+                last_update = 0;
+            }
             if (btn_confirm.pressed) {
-                Flash_SaveConfig(); /* persist new divisor */
+                CheckW_BatchReset(&hbatch);
+                check_item_x10 = 0;
+                Notify("New batch");
+            }
+#endif
+            if (btn_back.pressed) {
                 app_mode = MODE_SCALE;
-                Notify("Saved");
+                Notify("SCALE");
+            }
+            break;
+
+        case MODE_DIAG:
+#if PROF_ENABLE
+            if (enc_delta != 0) {
+                int32_t first = diag_first + enc_delta;
+                if (first > (int32_t)(PZ_COUNT - DIAG_ROWS)) first = PZ_COUNT - DIAG_ROWS;
+                if (first < 0) first = 0;
+                diag_first  = (uint8_t)first;
+                last_update = 0;
+            }
+            if (btn_confirm.pressed) Diag_Dump();
+            if (btn_push.pressed) {
+                Prof_Reset(&hprof);
+                Notify("Cleared");
             }
+#endif
             if (btn_back.pressed) {
-                calibration_divisor = cal_divisor_backup; /* restore old value */
                 app_mode = MODE_SCALE;
-                Notify("Canceled");
+                Notify("SCALE");
             }
             break;
         }
 
+#if TELEMETRY
+        if (app_mode != tlm_mode) {
+            tlm_mode = app_mode;
+            Telemetry_Event(TLM_EV_MODE, app_mode);
+        }
+#endif
+
         /* expire short notifications */
         if (notify_msg[0] && (now - notify_time) >= NOTIFY_DURATION_MS) {
             notify_msg[0] = '\0';
@@ -342,12 +821,284 @@ int main(void)
         if ((now - last_update) >= UPDATE_DELAY_MS) {
             last_update = now;
             LED_TOGGLE();
+            PROF_BEGIN(t_display);
             Display_Update();
+            PROF_END(&hprof, PZ_DISPLAY, t_display);
         }
+#if TRACE_ENABLE
+        /* what the interrupts and this pass logged, oldest first */
+        PROF_BEGIN(t_trace);
+        Trace_Drain(&htrace, TRACE_DRAIN_WORDS);
+        PROF_END(&hprof, PZ_TRACE, t_trace);
+#endif
+        PROF_END(&hprof, PZ_LOOP, t_loop);
         /* USER CODE END 3 */
     }
 }
 
+/* ============================================================
+ *  Sample processing
+ *  - Read raw ADC, subtract tare, compute weight (integer math)
+ *  - Apply lightweight moving average for display smoothing.
+ * ============================================================ */
+static void Scale_ProcessSample(int32_t raw)
+{
+    int32_t tare_w = Scale_TareWeight();
+
+    adc_raw          = raw;
+    adc_code         = adc_raw - tare_offset;
+    weight_grams_x10 = Calib_Weight(&hcal, raw) - tare_w;
+
+    /* adaptive running-sum filter, O(1) per sample */
+    adc_filtered    = WFilter_Process(&wfilter, raw);
+    weight_filtered = Calib_Weight(&hcal, adc_filtered) - tare_w;
+}
+
+#if ADC_DECIM
+/* an item left the checkweigher: its plateau on the calibration curve,
+ * against the dynamic zero, graded into the batch */
+static void Scale_CheckItem(void)
+{
+    const int32_t half = 1 << (DECIM_FRAC - 1);
+    int32_t zero = (hcheck.zero + half) >> DECIM_FRAC;
+    int32_t item = (hcheck.zero + hcheck.item.plateau + half) >> DECIM_FRAC;
+
+    check_item_x10 = Calib_Weight(&hcal, item) - Calib_Weight(&hcal, zero);
+    check_item_cls = CheckW_BatchAdd(&hbatch, check_item_x10, hcheck.item.flags, hcheck.item.time);
+    TRACE(&htrace, "check item %d g/10, class %u, flags 0x%x", check_item_x10, check_item_cls,
+          hcheck.item.flags);
+    Telemetry_Event((uint8_t)(TLM_EV_CHECK_ITEM + check_item_cls), check_item_x10);
+}
+#endif
+
+/* weight of the tare code on the (nonlinear, temperature corrected)
+ * curve; 0 until tared, the table's zero point is the reference then */
+static int32_t Scale_TareWeight(void)
+{
+    return tare_pressed ? Calib_Weight(&hcal, tare_offset) : 0;
+}
+
+/* two-point table equivalent to the former fixed divisor */
+static void Scale_DefaultCalibration(void)
+{
+    Calib_Clear(&hcal);
+    Calib_AddPoint(&hcal, 0, 0);
+    Calib_AddPoint(&hcal, CAL_DEFAULT_DIVISOR * 1000, 10000);
+    Calib_Fit(&hcal);
+}
+
+/* filter window, filter and zero tracking thresholds from the data rate
+ * and the calibration (calibration_divisor = codes per gram) */
+static void Scale_FilterSetup(void)
+{
+    uint32_t msps = ADS1220_DataRate_mSPS(ADC_OPMODE, ADC_DR);
+#if ADC_DECIM
+    msps = Decim_Rate_mHz(&hdecim, 1, msps);   /* the filter sees 10 Hz */
+#endif
+    uint32_t len  = (msps * FILTER_WINDOW_MS) / 1000000u;
+    uint32_t st   = (msps * FILTER_STABLE_MS) / 1000000u;
+
+    if (len < 1) len = 1;
+    if (len > WFILTER_MAX) len = WFILTER_MAX;
+    if (st < 1) st = 1;
+    if (st > len) st = len;
+
+    wfilter.len_max      = (uint16_t)len;
+    wfilter.stable_len   = (uint16_t)st;
+    wfilter.step         = (calibration_divisor * FILTER_STEP_G_X10) / 10;
+    wfilter.step_confirm = 2;
+    wfilter.noise        = (calibration_divisor * FILTER_NOISE_G_X10) / 10;
+    if (wfilter.noise < 1) wfilter.noise = 1;
+
+    /* one display division (0.1 g) is calibration_divisor / 10 codes */
+    hztrack.band         = (calibration_divisor * ZTRACK_BAND_D_X10) / 100;
+    hztrack.recapture    = (calibration_divisor * ZTRACK_RECAPTURE_D_X10) / 100;
+    hztrack.rate         = (calibration_divisor * ZTRACK_RATE_D_X10) / 100;
+    hztrack.limit        = calibration_divisor * ZTRACK_RANGE_G;
+    hztrack.hold_ms      = ZTRACK_HOLD_MS;
+    hztrack.offset_shift = ZTRACK_OFFSET_SHIFT;
+
+#if ADC_DECIM
+    /* checkweigher levels in Q(DECIM_FRAC) codes of the 200 Hz stream */
+    {
+        int32_t  g    = calibration_divisor * (1 << DECIM_FRAC);
+        uint32_t fast = Decim_Rate_mHz(&hdecim, 0, ADS1220_DataRate_mSPS(ADC_OPMODE, ADC_DR));
+
+        hcheck.on_level    = g * CHECK_ON_G;
+        hcheck.off_level   = hcheck.on_level / 2;
+        hcheck.noise       = (g * CHECK_NOISE_G_X10) / 10;
+        hcheck.zero_band   = 2 * hcheck.noise;
+        hcheck.plateau_min = (uint16_t)((fast * CHECK_PLATEAU_MS) / 1000000u);
+        hcheck.confirm     = 3;
+        hcheck.zero_shift  = 6;
+        if (hcheck.plateau_min < 4) hcheck.plateau_min = 4;
+    }
+#endif
+}
+
+/* ============================================================
+ *  Operator actions, from the buttons and the command channel
+ * ============================================================ */
+
+/* store current (filtered) raw as tare reference, the zero tracking
+ * follows it from here */
+static void Scale_Tare(void)
+{
+    ZTrack_Set(&hztrack, adc_filtered);
+    tare_offset  = hztrack.zero;
+    tare_pressed = 1;
+    Notify("Tared");
+    Telemetry_Event(TLM_EV_TARE, tare_offset);
+    TRACE(&htrace, "tare at code %d", tare_offset);
+}
+
+/* enter calibration with an empty table, first point is the empty
+ * platform; keep backup so Back can restore */
+static void Cal_Start(void)
+{
+    cal_backup = hcal;
+    Calib_Clear(&hcal);
+    cal_ref_g   = 0;
+    app_mode    = MODE_CALIBRATE;
+    Notify("CAL");
+    last_update = 0;    /* force immediate UI refresh */
+}
+
+/* take a point at the filtered code once it has settled */
+static uint8_t Cal_TakePoint(void)
+{
+    if (!wfilter.stable) {
+        Notify("Unstable");
+        return 0;
+    }
+    if (Calib_AddPoint(&hcal, adc_filtered, cal_ref_g * 10) != CALIB_OK) {
+        Notify("Table full");
+        return 0;
+    }
+    snprintf(notify_msg, sizeof(notify_msg), "P%u ok", hcal.tab.count);
+    notify_time = HAL_GetTick();
+    Telemetry_Event(TLM_EV_CAL_POINT, cal_ref_g * 10);
+    TRACE(&htrace, "cal point %u: %d g at code %d", hcal.tab.count, cal_ref_g, adc_filtered);
+    return 1;
+}
+
+/* fit the points and persist the table */
+static uint8_t Cal_Finish(void)
+{
+    if (Calib_Fit(&hcal) != CALIB_OK) {
+        Notify(hcal.tab.count < 2 ? "Need 2 pts" : "Bad points");
+        return 0;
+    }
+    calibration_divisor = Calib_CodesPerGram(&hcal);
+    Scale_FilterSetup();
+    Flash_SaveConfig();
+    app_mode = MODE_SCALE;
+    Notify("Saved");
+    Telemetry_Event(TLM_EV_CAL_SAVED, hcal.tab.count);
+    TRACE(&htrace, "cal saved, %u points, %d codes/g", hcal.tab.count, calibration_divisor);
+    return 1;
+}
+
+static void Cal_Cancel(void)
+{
+    hcal     = cal_backup; /* restore old table */
+    app_mode = MODE_SCALE;
+    Notify("Canceled");
+    TRACE(&htrace, "cal canceled");
+}
+
+#if ADC_DECIM
+static void Check_Enter(void)
+{
+    /* the dynamic zero restarts from the next sample */
+    CheckW_Reset(&hcheck);
+    app_mode    = MODE_CHECK;
+    Notify("CHECK");
+    last_update = 0;
+}
+#endif
+
+#if PROF_ENABLE
+/* the zones keep counting in every mode, the screen only shows them */
+static void Diag_Enter(void)
+{
+    app_mode    = MODE_DIAG;
+    Notify("DIAG");
+    last_update = 0;
+}
+
+/* one character on ITM stimulus port 0; the FIFO drains only while the
+ * SWO trace is read, so the wait is bounded */
+static void Diag_ItmPut(char c)
+{
+    uint32_t spin = 10000u;
+
+    if (!(ITM->TCR & ITM_TCR_ITMENA_Msk) || !(ITM->TER & 1u)) return;
+    while (ITM->PORT[0].u32 == 0u) {
+        if (--spin == 0u) return;
+    }
+    ITM->PORT[0].u8 = (uint8_t)c;
+}
+
+static void Diag_ItmLine(const char *s, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) Diag_ItmPut(s[i]);
+    Diag_ItmPut('\r');
+    Diag_ItmPut('\n');
+}
+
+/* the report with the histograms to the SWV console; without a debugger
+ * nothing reads the port */
+static void Diag_Dump(void)
+{
+    if (!(CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk)) {
+        Notify("No debugger");
+        return;
+    }
+    Prof_Report(&hprof, 1, Diag_ItmLine);
+    Notify("ITM sent");
+}
+#endif
+
+#if TRACE_ENABLE
+/* ============================================================
+ *  Deferred log (trace.h)
+ *  - one ring per preemption priority: an interrupt only preempts
+ *    higher rings, each ring has one writer at a time
+ * ============================================================ */
+
+/* ring of the running context, from the active exception and its NVIC
+ * priority (MX_DMA_Init, MX_USART1_UART_Init, MX_GPIO_Init). SysTick,
+ * the buttons' EXTI and the faults are not traced */
+static uint8_t Trace_Level(void)
+{
+    uint32_t ipsr = __get_IPSR();
+
+    if (ipsr == 0u) return TL_THREAD;
+    if (ipsr < 16u) return TL_COUNT;
+    switch (NVIC_GetPriority((IRQn_Type)((int32_t)ipsr - 16))) {
+    case 2u:  return TL_UART;
+    case 1u:  return TL_ADC;
+    default:  return TL_COUNT;
+    }
+}
+
+/* one record word on ITM port 1. without a debugger the port is never
+ * free: the records wait in the rings, full rings count the drops */
+static int Trace_ItmPut(uint32_t w)
+{
+    uint32_t spin = 10000u;
+
+    if (!(CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk)) return 1;
+    if (!(ITM->TCR & ITM_TCR_ITMENA_Msk) || !(ITM->TER & (1u << TRACE_ITM_PORT))) return 1;
+    while (ITM->PORT[TRACE_ITM_PORT].u32 == 0u) {
+        if (--spin == 0u) return 1;
+    }
+    ITM->PORT[TRACE_ITM_PORT].u32 = w;
+    return 0;
+}
+#endif
+
 /* ============================================================
  *  Display
  *
@@ -363,30 +1114,52 @@ void Display_Update(void)
     SH1106_FillRectangle(0, 0, 127, 11, SH1106_COLOR_WHITE);
     if (app_mode == MODE_SCALE) {
         SH1106_WriteStringAt(26, 2, "   SCALE   ", Font_8H, SH1106_COLOR_BLACK);
+    } else if (app_mode == MODE_CHECK) {
+        SH1106_WriteStringAt(26, 2, "   CHECK   ", Font_8H, SH1106_COLOR_BLACK);
+    } else if (app_mode == MODE_DIAG) {
+        SH1106_WriteStringAt(26, 2, "    DIAG   ", Font_8H, SH1106_COLOR_BLACK);
     } else {
         SH1106_WriteStringAt(14, 2, "  CALIBRATE  ", Font_8H, SH1106_COLOR_BLACK);
     }
+    /* stability annunciator: small square at the right of the bar */
+    if (wfilter.stable) SH1106_FillRectangle(119, 3, 124, 8, SH1106_COLOR_BLACK);
+
+#if ADC_DECIM
+    if (app_mode == MODE_CHECK) {
+        Display_CheckRows();
+    } else
+#endif
+#if PROF_ENABLE
+    if (app_mode == MODE_DIAG) {
+        Display_DiagRows();
+    } else
+#endif
+    {
+        /* Weight line: show filtered value if tare performed */
+        if (tare_pressed && hcal.valid) {
+            int32_t g = weight_filtered / 10;
+            int32_t d = (weight_filtered < 0) ? -(weight_filtered % 10) : weight_filtered % 10;
+            snprintf(display_buf, sizeof(display_buf), "Weight: %ld.%ld g", g, d);
+        } else {
+            snprintf(display_buf, sizeof(display_buf), "Weight: -- tare --");
+        }
+        SH1106_WriteStringAt(2, 13, display_buf, Font_8H, SH1106_COLOR_WHITE);
 
-    /* Weight line: show filtered value if tare performed */
-    if (tare_pressed) {
-        int32_t g = weight_filtered / 10;
-        int32_t d = (weight_filtered < 0) ? -(weight_filtered % 10) : weight_filtered % 10;
-        snprintf(display_buf, sizeof(display_buf), "Weight: %ld.%ld g", g, d);
-    } else {
-        snprintf(display_buf, sizeof(display_buf), "Weight: -- tare --");
-    }
-    SH1106_WriteStringAt(2, 13, display_buf, Font_8H, SH1106_COLOR_WHITE);
+        /* Raw ADC and net ADC */
+        snprintf(display_buf, sizeof(display_buf), "RAW: %ld", adc_raw);
+        SH1106_WriteStringAt(2, 23, display_buf, Font_8H, SH1106_COLOR_WHITE);
 
-    /* Raw ADC and net ADC */
-    snprintf(display_buf, sizeof(display_buf), "RAW: %ld", adc_raw);
-    SH1106_WriteStringAt(2, 23, display_buf, Font_8H, SH1106_COLOR_WHITE);
+        snprintf(display_buf, sizeof(display_buf), "ADC: %ld", adc_code);
+        SH1106_WriteStringAt(2, 33, display_buf, Font_8H, SH1106_COLOR_WHITE);
 
-    snprintf(display_buf, sizeof(display_buf), "ADC: %ld", adc_code);
-    SH1106_WriteStringAt(2, 33, display_buf, Font_8H, SH1106_COLOR_WHITE);
-
-    /* Divisor display (calibration parameter) */
-    snprintf(display_buf, sizeof(display_buf), "DIV: %ld", calibration_divisor);
-    SH1106_WriteStringAt(2, 43, display_buf, Font_8H, SH1106_COLOR_WHITE);
+        /* Calibration: counts per gram, or the point being entered */
+        if (app_mode == MODE_CALIBRATE) {
+            snprintf(display_buf, sizeof(display_buf), "P%u REF: %ld g", hcal.tab.count + 1u, cal_ref_g);
+        } else {
+            snprintf(display_buf, sizeof(display_buf), "DIV: %ld P%u", calibration_divisor, hcal.tab.count);
+        }
+        SH1106_WriteStringAt(2, 43, display_buf, Font_8H, SH1106_COLOR_WHITE);
+    }
 
     /* Bottom line: either notification centered, or context hint + SPS */
     if (notify_msg[0]) {
@@ -398,13 +1171,67 @@ void Display_Update(void)
     } else if (app_mode == MODE_SCALE) {
         snprintf(display_buf, sizeof(display_buf), "OK=tare push=cal %lu", samples_per_sec);
         SH1106_WriteStringAt(2, 53, display_buf, Font_8H, SH1106_COLOR_WHITE);
+    } else if (app_mode == MODE_CHECK) {
+        SH1106_WriteStringAt(2, 53, "OK=batch back=end", Font_8H, SH1106_COLOR_WHITE);
+    } else if (app_mode == MODE_DIAG) {
+        SH1106_WriteStringAt(2, 53, "OK=itm push=clear", Font_8H, SH1106_COLOR_WHITE);
     } else {
-        snprintf(display_buf, sizeof(display_buf), "OK=save back=undo %lu", samples_per_sec);
+        snprintf(display_buf, sizeof(display_buf), "OK=add push=done");
         SH1106_WriteStringAt(2, 53, display_buf, Font_8H, SH1106_COLOR_WHITE);
     }
 
+    PROF_BEGIN(t_oled);
     SH1106_UpdateScreen();
+    PROF_END(&hprof, PZ_OLED, t_oled);
+}
+
+#if ADC_DECIM
+/* Check mode rows: last item, batch counts, statistics, target + rate */
+static void Display_CheckRows(void)
+{
+    static const char *const grade[] = { "OK", "UNDER", "OVER", "BAD" };
+    uint32_t n    = hbatch.count[0] + hbatch.count[1] + hbatch.count[2] + hbatch.count[3];
+    int32_t  mean = CheckW_BatchMean(&hbatch);
+    int32_t  sd   = CheckW_BatchDeviation(&hbatch);
+    uint32_t ipm  = CheckW_BatchRate(&hbatch);      /* graded items only */
+
+    /* last item and its grade */
+    if (n) {
+        int32_t a = (check_item_x10 < 0) ? -check_item_x10 : check_item_x10;
+        snprintf(display_buf, sizeof(display_buf), "%s%ld.%ld g %s", (check_item_x10 < 0) ? "-" : "",
+                 a / 10, a % 10, grade[check_item_cls]);
+    } else {
+        snprintf(display_buf, sizeof(display_buf), "Item: --");
+    }
+    SH1106_WriteStringAt(2, 13, display_buf, Font_8H, SH1106_COLOR_WHITE);
+
+    /* items, under + over, not weighed reliably */
+    snprintf(display_buf, sizeof(display_buf), "N:%lu R:%lu X:%lu", n,
+             hbatch.count[CHECKW_UNDER] + hbatch.count[CHECKW_OVER], hbatch.count[CHECKW_INVALID]);
+    SH1106_WriteStringAt(2, 23, display_buf, Font_8H, SH1106_COLOR_WHITE);
+
+    snprintf(display_buf, sizeof(display_buf), "M:%ld.%ld SD:%ld.%ld", mean / 10,
+             (mean < 0 ? -mean : mean) % 10, sd / 10, sd % 10);
+    SH1106_WriteStringAt(2, 33, display_buf, Font_8H, SH1106_COLOR_WHITE);
+
+    snprintf(display_buf, sizeof(display_buf), "T:%ld g %lu/min", hbatch.nominal / 10, ipm / 10);
+    SH1106_WriteStringAt(2, 43, display_buf, Font_8H, SH1106_COLOR_WHITE);
 }
+#endif
+
+#if PROF_ENABLE
+/* Diag rows: zone, mean / max in us (the ITM dump has the rest) */
+static void Display_DiagRows(void)
+{
+    for (uint8_t r = 0; r < DIAG_ROWS; r++) {
+        const Prof_Zone_t *z = &prof_zone[diag_first + r];
+
+        snprintf(display_buf, sizeof(display_buf), "%s %lu / %lu us", prof_name[diag_first + r],
+                 Prof_Us(&hprof, Prof_Mean(z)), Prof_Us(&hprof, z->max));
+        SH1106_WriteStringAt(2, (uint8_t)(13 + r * 10), display_buf, Font_8H, SH1106_COLOR_WHITE);
+    }
+}
+#endif
 
 /* show a short centered message on the bottom line */
 void Notify(const char *msg)
@@ -432,54 +1259,519 @@ static void Button_Poll(Button_t *b)
 
 /* ============================================================
  *  Flash persistence helpers
- *  - store only a small FlashConfig_t containing magic/checksum/divisor
- *  - caller must ensure sector/address match MCU layout
+ *  - every save appends a record to the settings log (cfg_log.c);
+ *    a sector is erased only when the log moves to the other one
+ *  - caller must ensure sectors/addresses match MCU layout
  * ============================================================ */
-static uint32_t Config_Checksum(const FlashConfig_t *c)
+static void Flash_SaveConfig(void)
 {
-    return c->magic ^ (uint32_t)c->calibration_divisor;
+    FlashConfig_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.calibration = hcal.tab;
+
+    CfgLog_Save(&hcfglog, FLASH_CONFIG_VERSION, &cfg, sizeof(cfg));
 }
 
-static void Flash_SaveConfig(void)
+/* Load config from flash, return 1 if valid and applied, 0 otherwise */
+static uint8_t Flash_LoadConfig(void)
 {
-    FlashConfig_t cfg;
-    cfg.magic               = FLASH_MAGIC;
-    cfg.calibration_divisor = calibration_divisor;
-    cfg.checksum            = Config_Checksum(&cfg);
+    FlashConfig_t   cfg;
+    FlashConfigV1_t v1;
+    CfgLog_Status_t st = CfgLog_Init(&hcfglog);
+
+    if (st == CFGLOG_EMPTY && Flash_LoadLegacy(&v1)) {
+        /* first boot after the upgrade: the old record becomes a version
+         * 1 log record. it goes to sector 6 (area 0, sector 7 is not
+         * formatted), so the old record stays until the log first moves
+         * to sector 7 */
+        CfgLog_Save(&hcfglog, 1U, &v1, sizeof(v1));
+    } else {
+        if (st != CFGLOG_OK) return 0;
+
+        if (CfgLog_Load(&hcfglog, FLASH_CONFIG_VERSION, &cfg, sizeof(cfg)) == CFGLOG_OK) {
+            hcal.tab = cfg.calibration;
+            if (Calib_Fit(&hcal) == CALIB_OK) return 1;
+            return 0;
+        }
+        if (CfgLog_Load(&hcfglog, 1U, &v1, sizeof(v1)) != CFGLOG_OK) return 0;
+    }
+
+    /* older firmware: a single divisor becomes a two-point table */
+    if (v1.calibration_divisor <= 0)    return 0;
+    Calib_Clear(&hcal);
+    Calib_AddPoint(&hcal, 0, 0);
+    Calib_AddPoint(&hcal, v1.calibration_divisor * 1000, 10000);
+    return Calib_Fit(&hcal) == CALIB_OK;
+}
+
+/* the record of firmware before the settings log, as a version 1
+ * record; 0 if there is none */
+static uint8_t Flash_LoadLegacy(FlashConfigV1_t *v1)
+{
+    const FlashLegacy_t *old = (const FlashLegacy_t *)FLASH_LEGACY_ADDR;
+
+    if (old->magic    != FLASH_LEGACY_MAGIC)                                return 0;
+    if (old->checksum != (old->magic ^ (uint32_t)old->calibration_divisor)) return 0;
+    v1->calibration_divisor = old->calibration_divisor;
+    return 1;
+}
+
+/* settings log platform callbacks: area 0/1 = storage sector 0/1 */
+static int Flash_LogProgram(uint8_t area, uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    uint32_t addr = (area ? FLASH_STORAGE_ADDR1 : FLASH_STORAGE_ADDR0) + offset;
+    int      rc   = 0;
 
     HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < count; i++) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, words[i]) != HAL_OK) { rc = -1; break; }
+        addr += 4;
+    }
+    HAL_FLASH_Lock();
 
-    /* erase one sector (Flash layout dependent) */
+    /* the data cache may still hold the erased words read by the scan */
+    __HAL_FLASH_DATA_CACHE_DISABLE();
+    __HAL_FLASH_DATA_CACHE_RESET();
+    __HAL_FLASH_DATA_CACHE_ENABLE();
+    return rc;
+}
+
+static int Flash_LogErase(uint8_t area)
+{
     FLASH_EraseInitTypeDef erase = {0};
+    uint32_t err = 0;
+    int      rc  = 0;
+
     erase.TypeErase    = FLASH_TYPEERASE_SECTORS;
-    erase.Sector       = FLASH_STORAGE_SECTOR;
+    erase.Sector       = area ? FLASH_STORAGE_SECTOR1 : FLASH_STORAGE_SECTOR0;
     erase.NbSectors    = 1;
     erase.VoltageRange = FLASH_VOLTAGE_RANGE_3; /* 2.7V - 3.6V devices */
 
-    uint32_t err = 0;
-    HAL_FLASHEx_Erase(&erase, &err);
+    HAL_FLASH_Unlock();
+    if (HAL_FLASHEx_Erase(&erase, &err) != HAL_OK) rc = -1;
+    HAL_FLASH_Lock();
+    return rc;
+}
 
-    /* program words sequentially */
-    uint32_t addr  = FLASH_STORAGE_ADDR;
-    uint32_t *data = (uint32_t *)&cfg;
-    for (uint32_t i = 0; i < sizeof(FlashConfig_t) / 4; i++) {
-        HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, data[i]);
-        addr += 4;
+/* ============================================================
+ *  Telemetry (USART1 TX DMA, see telemetry.h)
+ *  - records are encoded straight into the TX ring; a full ring
+ *    drops whole frames, the receiver sees the seq gap
+ * ============================================================ */
+static void Telemetry_Event(uint8_t id, int32_t arg)
+{
+#if TELEMETRY
+    Tlm_Event(&htlm, HAL_GetTick(), id, arg);
+#else
+    (void)id;
+    (void)arg;
+#endif
+}
+
+#if TELEMETRY
+/* a batch straight out of the acquisition ring, up to TLM_SAMPLES_MAX
+ * samples per frame */
+static void Telemetry_Samples(const ADS1220_Sample_t *s, uint16_t n)
+{
+    while (n) {
+        uint8_t count = (uint8_t)((n > TLM_SAMPLES_MAX) ? TLM_SAMPLES_MAX : n);
+
+        if (Tlm_Begin(&htlm, TLM_T_SAMPLES, (uint16_t)(5U + count * TLM_SAMPLE_SIZE))) {
+            Tlm_PutU32(&htlm, tlm_index);
+            Tlm_Put(&htlm, &count, 1);
+            for (uint8_t i = 0; i < count; i++) Tlm_PutSample(&htlm, s[i].time, s[i].code, s[i].channel);
+            Tlm_End(&htlm);
+        }
+        tlm_index += count;
+        s += count;
+        n -= count;
+    }
+}
+
+static void Telemetry_Stats(uint32_t now)
+{
+    Tlm_Stats_t st;
+
+    st.time_ms      = now;
+    st.samples      = tlm_index;
+    st.sps          = (uint16_t)samples_per_sec;
+    st.acq_dropped  = (uint16_t)hacq.dropped;
+    st.acq_overruns = (uint16_t)hacq.overruns;
+    st.tlm_dropped  = (uint16_t)htlm.dropped;
+    st.weight_x10   = weight_grams_x10;
+    st.filtered     = adc_filtered;
+#if ADC_SCAN
+    st.temp         = hcal.temp;
+#else
+    st.temp         = 0;
+#endif
+    st.stable       = wfilter.stable;
+    st.mode         = (uint8_t)app_mode;
+    Tlm_Stats(&htlm, &st);
+}
+
+static int Telemetry_TxStart(const uint8_t *data, uint16_t len)
+{
+    return HAL_UART_Transmit_DMA(&huart1, (uint8_t *)data, len) == HAL_OK ? 0 : -1;
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart1) Tlm_TxDone(&htlm);
+}
+#endif
+
+#if COMMANDS
+/* ============================================================
+ *  Commands (USART1 RX circular DMA, see cmd.h)
+ *  - lines are parsed in place in cmd_rx by Cmd_Poll in the main
+ *    loop; the handlers are the button actions plus a few settings
+ * ============================================================ */
+static const char *const mode_name[] = { "scale", "calibrate", "check", "diag" };
+
+#if PROF_ENABLE
+#define CMD_MODE_DIAG   "|diag"
+#else
+#define CMD_MODE_DIAG   ""
+#endif
+
+/* grams * 10 as text, "-0.5" */
+static void Console_Grams(char *buf, uint16_t size, const char *label, int32_t x10)
+{
+    int32_t a = (x10 < 0) ? -x10 : x10;
+    snprintf(buf, size, "%s %s%ld.%ld g", label, (x10 < 0) ? "-" : "", a / 10, a % 10);
+}
+
+static Cmd_Status_t Cmd_Get(Cmd_Handle_t *h, uint8_t argc)
+{
+    char line[64];
+
+    (void)argc;
+    if (tare_pressed && hcal.valid) Console_Grams(line, sizeof(line), "weight", weight_filtered);
+    else                            snprintf(line, sizeof(line), "weight -- tare --");
+    Cmd_Reply(h, line);
+    snprintf(line, sizeof(line), "raw %ld filtered %ld stable %u", adc_raw, adc_filtered, wfilter.stable);
+    Cmd_Reply(h, line);
+    snprintf(line, sizeof(line), "mode %s points %u sps %lu", mode_name[app_mode], hcal.tab.count, samples_per_sec);
+    Cmd_Reply(h, line);
+    snprintf(line, sizeof(line), "cmd lines %lu errors %lu overruns %lu", h->lines, h->errors, h->overruns);
+    Cmd_Reply(h, line);
+    return CMD_OK;
+}
+
+static Cmd_Status_t Cmd_Tare(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)h;
+    (void)argc;
+    if (app_mode != MODE_SCALE) return CMD_ERR_STATE;
+    Scale_Tare();
+    return CMD_OK;
+}
+
+/* cal start | point <g> | save | cancel: the Calibrate mode, with the
+ * reference mass typed instead of dialled */
+static Cmd_Status_t Cmd_Cal(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      g;
+    Cmd_Status_t st;
+
+    if (Cmd_ArgIs(h, 0, "start")) {
+        if (argc != 1) return CMD_ERR_ARGS;
+        if (app_mode != MODE_SCALE) return CMD_ERR_STATE;
+        Cal_Start();
+        return CMD_OK;
+    }
+    if (app_mode != MODE_CALIBRATE) {
+        return (Cmd_ArgIs(h, 0, "point") || Cmd_ArgIs(h, 0, "save") || Cmd_ArgIs(h, 0, "cancel"))
+               ? CMD_ERR_STATE : CMD_ERR_ARGS;
+    }
+    if (Cmd_ArgIs(h, 0, "point")) {
+        if (argc != 2) return CMD_ERR_ARGS;
+        if ((st = Cmd_ArgNum(h, 1, 0, 0, 100000, &g)) != CMD_OK) return st;
+        cal_ref_g   = g;
+        last_update = 0;
+        return Cal_TakePoint() ? CMD_OK : CMD_ERR_STATE;
+    }
+    if (argc != 1) return CMD_ERR_ARGS;
+    if (Cmd_ArgIs(h, 0, "save"))   return Cal_Finish() ? CMD_OK : CMD_ERR_FAIL;
+    if (Cmd_ArgIs(h, 0, "cancel")) { Cal_Cancel(); return CMD_OK; }
+    return CMD_ERR_ARGS;
+}
+
+#if ADC_SCAN
+/* tc zero | span <g>: learn the temperature coefficients at the current
+ * temperature, against the table's temp0 (readme, Calibration) */
+static Cmd_Status_t Cmd_Tc(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t        g;
+    Cmd_Status_t   st;
+    Calib_Status_t cs;
+
+    if (app_mode != MODE_SCALE || !wfilter.stable) return CMD_ERR_STATE;
+    if (Cmd_ArgIs(h, 0, "zero") && argc == 1) {
+        cs = Calib_LearnZeroTc(&hcal, adc_filtered);
+    } else if (Cmd_ArgIs(h, 0, "span") && argc == 2) {
+        if ((st = Cmd_ArgNum(h, 1, 0, 1, 100000, &g)) != CMD_OK) return st;
+        cs = Calib_LearnSpanTc(&hcal, adc_filtered, g * 10);
+    } else {
+        return CMD_ERR_ARGS;
     }
+    if (cs == CALIB_TOO_CLOSE) return CMD_ERR_STATE;  /* warm it up first */
+    if (cs != CALIB_OK)        return CMD_ERR_FAIL;
+    Flash_SaveConfig();
+    Notify("TC saved");
+    return CMD_OK;
+}
+#endif
+
+static Cmd_Status_t Cmd_Mode(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)argc;
+    if (app_mode == MODE_CALIBRATE) return CMD_ERR_STATE;  /* cal save / cancel */
+    if (Cmd_ArgIs(h, 0, "scale")) {
+        if (app_mode != MODE_SCALE) {
+            app_mode = MODE_SCALE;
+            Notify("SCALE");
+        }
+        return CMD_OK;
+    }
+#if ADC_DECIM
+    if (Cmd_ArgIs(h, 0, "check")) {
+        if (app_mode != MODE_CHECK) Check_Enter();
+        return CMD_OK;
+    }
+#endif
+#if PROF_ENABLE
+    if (Cmd_ArgIs(h, 0, "diag")) {
+        if (app_mode != MODE_DIAG) Diag_Enter();
+        return CMD_OK;
+    }
+#endif
+    return CMD_ERR_ARGS;
+}
+
+#if ADC_DECIM
+/* nominal <g>: the checkweigher's target weight, 0.1 g resolution */
+static Cmd_Status_t Cmd_Nominal(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      x10;
+    Cmd_Status_t st;
+
+    (void)argc;
+    if ((st = Cmd_ArgNum(h, 0, 1, 10, 1000000, &x10)) != CMD_OK) return st;
+    hbatch.nominal = x10;
+    last_update    = 0;
+    return CMD_OK;
+}
 
+/* batch [reset]: the batch statistics, then optionally a new batch */
+static Cmd_Status_t Cmd_Batch(Cmd_Handle_t *h, uint8_t argc)
+{
+    char line[64];
+    int32_t mean = CheckW_BatchMean(&hbatch);
+    int32_t sd   = CheckW_BatchDeviation(&hbatch);
+    uint32_t ipm = CheckW_BatchRate(&hbatch);
+    uint32_t all = CheckW_BatchRateAll(&hbatch);
+
+    if (argc == 1 && !Cmd_ArgIs(h, 0, "reset")) return CMD_ERR_ARGS;
+
+    snprintf(line, sizeof(line), "ok %lu under %lu over %lu bad %lu", hbatch.count[CHECKW_OK],
+             hbatch.count[CHECKW_UNDER], hbatch.count[CHECKW_OVER], hbatch.count[CHECKW_INVALID]);
+    Cmd_Reply(h, line);
+    Console_Grams(line, sizeof(line), "nominal", hbatch.nominal);
+    Cmd_Reply(h, line);
+    Console_Grams(line, sizeof(line), "mean", mean);
+    Cmd_Reply(h, line);
+    Console_Grams(line, sizeof(line), "sd", sd);
+    Cmd_Reply(h, line);
+    snprintf(line, sizeof(line), "rate %lu.%lu /min graded, %lu.%lu /min all",
+             ipm / 10u, ipm % 10u, all / 10u, all % 10u);
+    Cmd_Reply(h, line);
+
+    if (argc == 1) {
+        CheckW_BatchReset(&hbatch);
+        check_item_x10 = 0;
+        Notify("New batch");
+    }
+    return CMD_OK;
+}
+#endif
+
+#if PROF_ENABLE
+/* prof [hist | reset]: the zone times, with the histograms, or then
+ * clear them */
+static Cmd_Status_t Cmd_Prof(Cmd_Handle_t *h, uint8_t argc)
+{
+    uint8_t hist = argc == 1 && Cmd_ArgIs(h, 0, "hist");
+
+    if (argc == 1 && !hist && !Cmd_ArgIs(h, 0, "reset")) return CMD_ERR_ARGS;
+    Prof_Report(&hprof, hist, h->reply);
+    if (argc == 1 && !hist) Prof_Reset(&hprof);
+    return CMD_OK;
+}
+#endif
+
+#if SAMPLE_LOG
+/* log [start | stop | erase]: the sample log state, or change it. erase
+ * blocks for the sector erase (1 to 2 s), stop the log first */
+static Cmd_Status_t Cmd_Log(Cmd_Handle_t *h, uint8_t argc)
+{
+    char line[64];
+
+    if (argc == 1) {
+        if (Cmd_ArgIs(h, 0, "start")) {
+            if (hslog.running) return CMD_OK;
+            switch (SampleLog_Start(&hslog)) {
+            case SAMPLELOG_OK:    break;
+            case SAMPLELOG_EMPTY: return CMD_ERR_STATE;     /* log erase */
+            default:              return CMD_ERR_FAIL;      /* full */
+            }
+        } else if (Cmd_ArgIs(h, 0, "stop")) {
+            SampleLog_Stop(&hslog);
+        } else if (Cmd_ArgIs(h, 0, "erase")) {
+            if (hslog.running) return CMD_ERR_STATE;
+            if (SampleLog_Erase(&hslog) != SAMPLELOG_OK) return CMD_ERR_FAIL;
+        } else {
+            return CMD_ERR_ARGS;
+        }
+    }
+    snprintf(line, sizeof(line), "log %s used %lu of %lu dropped %lu", hslog.running ? "on" : "off",
+             SampleLog_Used(&hslog), (uint32_t)SAMPLE_LOG_SIZE, hslog.dropped);
+    Cmd_Reply(h, line);
+    return CMD_OK;
+}
+#endif
+
+static const Cmd_Entry_t cmd_table[] = {
+    { "get",     "",                            0, 0, Cmd_Get     },
+    { "tare",    "",                            0, 0, Cmd_Tare    },
+    { "cal",     "start|point <g>|save|cancel", 1, 2, Cmd_Cal     },
+#if ADC_SCAN
+    { "tc",      "zero|span <g>",               1, 2, Cmd_Tc      },
+#endif
+#if ADC_DECIM
+    { "mode",    "scale|check" CMD_MODE_DIAG,   1, 1, Cmd_Mode    },
+    { "nominal", "<g>",                         1, 1, Cmd_Nominal },
+    { "batch",   "[reset]",                     0, 1, Cmd_Batch   },
+#else
+    { "mode",    "scale" CMD_MODE_DIAG,         1, 1, Cmd_Mode    },
+#endif
+#if SAMPLE_LOG
+    { "log",     "[start|stop|erase]",          0, 1, Cmd_Log     },
+#endif
+#if PROF_ENABLE
+    { "prof",    "[hist|reset]",                0, 1, Cmd_Prof    },
+#endif
+};
+
+/* DMA write index now: NDTR counts down from the ring size */
+static uint16_t Console_RxHead(void)
+{
+    return (uint16_t)((CMD_RX_SIZE - __HAL_DMA_GET_COUNTER(huart1.hdmarx)) & (CMD_RX_SIZE - 1u));
+}
+
+/* one answer line: a reply frame in the telemetry stream (dropped with
+ * the stream when its ring is full), or plain text */
+static void Console_Reply(const char *s, uint16_t len)
+{
+#if TELEMETRY
+    if (Tlm_Begin(&htlm, TLM_T_REPLY, len)) {
+        Tlm_Put(&htlm, s, len);
+        Tlm_End(&htlm);
+    }
+#else
+    HAL_UART_Transmit(&huart1, (uint8_t *)s, len, 10);
+    HAL_UART_Transmit(&huart1, (uint8_t *)"\r\n", 2, 10);
+#endif
+}
+
+static void Console_Start(void)
+{
+    hcmd.rx        = cmd_rx;
+    hcmd.rx_size   = CMD_RX_SIZE;
+    hcmd.table     = cmd_table;
+    hcmd.table_len = (uint8_t)(sizeof(cmd_table) / sizeof(cmd_table[0]));
+    hcmd.reply     = Console_Reply;
+    hcmd.rx_head   = Console_RxHead;
+    Cmd_Init(&hcmd);
+    HAL_UARTEx_ReceiveToIdle_DMA(&huart1, cmd_rx, CMD_RX_SIZE);
+}
+
+/* idle line, half and full ring: Size is the DMA write index */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (huart == &huart1) Cmd_RxEvent(&hcmd, Size);
+}
+
+/* framing / noise / overrun errors stop the DMA reception: start it
+ * again at index 0, the line in progress is lost */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart1 && huart->RxState == HAL_UART_STATE_READY) {
+        TRACE(&htrace, "usart1 error 0x%02x, rx restarted", huart->ErrorCode);
+        Cmd_RxRestart(&hcmd);
+        HAL_UARTEx_ReceiveToIdle_DMA(&huart1, cmd_rx, CMD_RX_SIZE);
+    }
+}
+#endif
+
+#if SAMPLE_LOG
+/* Back held at power-up erases the sample log; a sector without the log
+ * header (first run) is formatted the same way */
+static void Flash_SampleLogStart(void)
+{
+    SampleLog_Status_t st;
+
+    hslog.tick_hz = SystemCoreClock;    /* DWT cycles, clock set up by now */
+    st = SampleLog_Init(&hslog);
+
+    if (BTN_PRESSED(BTN_BACK_PORT, BTN_BACK_PIN) || st == SAMPLELOG_EMPTY) {
+        SH1106_WriteStringAt(10, 28, "ERASING LOG", Font_8H, SH1106_COLOR_WHITE);
+        SH1106_UpdateScreen();
+        st = SampleLog_Erase(&hslog);
+        SH1106_Fill(SH1106_COLOR_BLACK);
+        SH1106_UpdateScreen();
+        while (BTN_PRESSED(BTN_BACK_PORT, BTN_BACK_PIN)) {}
+    }
+    if (st == SAMPLELOG_OK) SampleLog_Start(&hslog);
+}
+
+/* sample log platform callbacks: one sector, offsets from its start */
+static int Flash_SampleProgram(uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    uint32_t addr = SAMPLE_LOG_ADDR + offset;
+    int      rc   = 0;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < count; i++) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, words[i]) != HAL_OK) { rc = -1; break; }
+        addr += 4;
+    }
     HAL_FLASH_Lock();
+
+    __HAL_FLASH_DATA_CACHE_DISABLE();
+    __HAL_FLASH_DATA_CACHE_RESET();
+    __HAL_FLASH_DATA_CACHE_ENABLE();
+    return rc;
 }
 
-/* Load config from flash, return 1 if valid and applied, 0 otherwise */
-static uint8_t Flash_LoadConfig(void)
+static int Flash_SampleErase(void)
 {
-    const FlashConfig_t *cfg = (const FlashConfig_t *)FLASH_STORAGE_ADDR;
-    if (cfg->magic    != FLASH_MAGIC)          return 0;
-    if (cfg->checksum != Config_Checksum(cfg)) return 0;
-    if (cfg->calibration_divisor == 0)         return 0;
-    calibration_divisor = cfg->calibration_divisor;
-    return 1;
+    FLASH_EraseInitTypeDef erase = {0};
+    uint32_t err = 0;
+    int      rc  = 0;
+
+    erase.TypeErase    = FLASH_TYPEERASE_SECTORS;
+    erase.Sector       = SAMPLE_LOG_SECTOR;
+    erase.NbSectors    = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+    HAL_FLASH_Unlock();
+    if (HAL_FLASHEx_Erase(&erase, &err) != HAL_OK) rc = -1;
+    HAL_FLASH_Lock();
+    return rc;
 }
+#endif
 
 /* ============================================================
  *  ADS1220 platform callbacks (SPI + CS + DRDY)
@@ -511,6 +1803,58 @@ static uint8_t adsDrdyRead(void)
     return HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_1) == GPIO_PIN_RESET;
 }
 
+#if ADC_SCAN
+/* a DRDY edge latched while the scan wrote the next entry: drop it, the
+ * EXTI handler does nothing once the pending bit is clear */
+static uint8_t adsDrdyClear(void)
+{
+    if (__HAL_GPIO_EXTI_GET_IT(GPIO_PIN_1) == 0u) return 0;
+    __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_1);
+    return 1;
+}
+#endif
+
+/* acquisition: 3-byte result read by SPI1 DMA (RX DMA2 S0, TX DMA2 S3),
+ * completion comes back through HAL_SPI_TxRxCpltCallback */
+static int adsReadStart(uint8_t *rx, uint16_t len)
+{
+    static uint8_t zeros[3];
+    if (len > sizeof(zeros)) return -1;
+    return (HAL_SPI_TransmitReceive_DMA(&hspi1, zeros, rx, len) == HAL_OK) ? 0 : -1;
+}
+
+static uint32_t adsTimestamp(void)
+{
+    return DWT->CYCCNT;
+}
+
+/* DRDY falling edge (PB1, EXTI1) */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if (GPIO_Pin == GPIO_PIN_1) {
+        PROF_BEGIN(t);
+        ADS1220_AcqOnDrdy(&hacq);
+        PROF_END(&hprof, PZ_DRDY, t);
+    }
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &hspi1) {
+        PROF_BEGIN(t);
+        ADS1220_AcqOnReadDone(&hacq, 0);
+        PROF_END(&hprof, PZ_READ, t);
+    }
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &hspi1) {
+        TRACE(&htrace, "spi1 error 0x%02x, ADC result lost", hspi->ErrorCode);
+        ADS1220_AcqOnReadDone(&hacq, -1);
+    }
+}
+
 /* ============================================================
  *  System Clock (CubeMX generated values retained)
  * ============================================================ */
@@ -0,0 +1,68 @@
+#ifndef __CFG_LOG_H__
+#define __CFG_LOG_H__
+
+#include <stdint.h>
+
+/* append-only settings log in internal flash (HAL-free core, the
+ * application provides program/erase callbacks).
+ *
+ * two flash sectors ("areas") are used in turn. an area starts with an
+ * 8-byte header (CFGLOG_AREA_MAGIC, slot size) followed by fixed-size
+ * slots, each holding at most one record:
+ *
+ *   seq (u32) | version (u16) | len (u16) | data, padded to 4 | crc32
+ *
+ * a save programs the next erased slot, nothing is erased. the newest
+ * record is the valid one (CRC over header and data) with the highest
+ * seq, so a record cut short by a power loss is simply ignored and the
+ * one before it is used. only when an area is full is the other one
+ * erased and the log continues there; the full area stays intact until
+ * the next switch, so there is always a valid copy. */
+
+#define CFGLOG_AREA_MAGIC   0x474F4C43UL    /* "CLOG" */
+#define CFGLOG_AREA_HDR     8u              /* magic + slot size          */
+#define CFGLOG_REC_HDR      8u              /* seq + version + len        */
+#define CFGLOG_REC_EXTRA    (CFGLOG_REC_HDR + 4u)   /* header + crc       */
+#define CFGLOG_SLOT_MAX     256u            /* largest slot_size          */
+
+typedef enum {
+    CFGLOG_OK    = 0,
+    CFGLOG_EMPTY = 1,   /* no valid record (of this version and size) */
+    CFGLOG_ERROR = -1
+} CfgLog_Status_t;
+
+typedef struct {
+    /* platform, set by the application before CfgLog_Init */
+    const volatile uint32_t *area[2];   /* memory-mapped start of each area */
+    uint32_t area_size;                 /* bytes used in each area          */
+    uint16_t slot_size;                 /* bytes per slot, multiple of 4    */
+    /* program count words at byte offset of area (only 1->0 bits, the
+     * words are erased) and erase a whole area. 0 on success */
+    int      (*program)(uint8_t area, uint32_t offset, const uint32_t *words, uint32_t count);
+    int      (*erase)(uint8_t area);
+
+    /* state, filled by CfgLog_Init */
+    uint8_t  active;    /* area the next record goes to                 */
+    uint32_t next;      /* offset of the next free slot, 0 = area needs
+                         * an erase and a header first                  */
+    uint8_t  newest_area;   /* area holding the newest record; differs
+                             * from active after a failed area switch   */
+    uint32_t newest;    /* offset of the newest record, 0 = none        */
+    uint32_t seq;       /* its sequence number                          */
+    uint32_t erases;    /* area erases since init                       */
+} CfgLog_Handle_t;
+
+/* scan both areas for the newest record and the next free slot */
+CfgLog_Status_t CfgLog_Init(CfgLog_Handle_t *h);
+
+/* copy the newest record into data if it has this version and length */
+CfgLog_Status_t CfgLog_Load(const CfgLog_Handle_t *h, uint16_t version, void *data, uint16_t len);
+
+/* append a record. erases only when the active area is full (or on the
+ * very first save) */
+CfgLog_Status_t CfgLog_Save(CfgLog_Handle_t *h, uint16_t version, const void *data, uint16_t len);
+
+/* CRC-32 (IEEE, reflected), start with crc = 0 */
+uint32_t        CfgLog_Crc32(uint32_t crc, const void *data, uint32_t len);
+
+#endif /* __CFG_LOG_H__ */
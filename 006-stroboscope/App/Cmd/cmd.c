@@ -0,0 +1,266 @@
+/**
+  ******************************************************************************
+  * @file    cmd.c
+  * @brief   Command lines parsed in place from a UART RX DMA ring
+  *          (HAL-free core, uses callbacks provided by app)
+  ******************************************************************************
+  */
+
+#include "cmd.h"
+#include <string.h>
+
+static const char *const status_text[] = {
+    "OK",
+    "ERR unknown command",
+    "ERR arguments",
+    "ERR range",
+    "ERR state",
+    "ERR failed",
+    "ERR line too long",
+    "ERR overrun",
+};
+
+static uint8_t lower(uint8_t c)
+{
+    return (c >= 'A' && c <= 'Z') ? (uint8_t)(c + ('a' - 'A')) : c;
+}
+
+static uint8_t blank(uint8_t c)
+{
+    return c == ' ' || c == '\t';
+}
+
+/* k-th char of a token, wrapping around the ring */
+static uint8_t tok_char(const Cmd_Handle_t *h, const Cmd_Tok_t *t, uint8_t k)
+{
+    return h->rx[(t->pos + k) & (h->rx_size - 1u)];
+}
+
+static uint8_t tok_is(const Cmd_Handle_t *h, const Cmd_Tok_t *t, const char *s)
+{
+    uint8_t k;
+
+    for (k = 0; k < t->len; k++) {
+        if (s[k] == '\0' || lower(tok_char(h, t, k)) != lower((uint8_t)s[k])) return 0;
+    }
+    return s[k] == '\0';
+}
+
+static void answer(Cmd_Handle_t *h, Cmd_Status_t st)
+{
+    if (st != CMD_OK) h->errors++;
+    Cmd_Reply(h, status_text[st]);
+}
+
+/* bytes the DMA has written past rx_total. without rx_head, up to the
+ * next half or full buffer event: almost half a ring */
+static uint16_t dma_ahead(Cmd_Handle_t *h, uint32_t *total)
+{
+    uint16_t pos, head;
+
+    if (!h->rx_head) {
+        *total = h->rx_total;
+        return (uint16_t)(h->rx_size / 2u);
+    }
+    /* rx_pos and rx_total as one pair: an event in between changes rx_pos */
+    do {
+        pos    = h->rx_pos;
+        *total = h->rx_total;
+        head   = h->rx_head();
+    } while (pos != h->rx_pos);
+    return (uint16_t)((head - pos) & (h->rx_size - 1u));
+}
+
+/* the DMA has written over the start of the line being read: give it up
+ * and go on from the oldest byte still intact (not older than a DMA
+ * restart), skipping to the next line end */
+static uint8_t overrun(Cmd_Handle_t *h)
+{
+    uint32_t total;
+    uint32_t keep  = h->rx_size - dma_ahead(h, &total);
+    uint32_t start = total - keep;
+
+    if (total - h->line <= keep) return 0;
+    if ((int32_t)(h->rx_base - start) > 0) start = h->rx_base;
+    h->overruns++;
+    h->rd   = start;
+    h->line = start;
+    h->skip = 1;
+    answer(h, CMD_ERR_OVERRUN);
+    return 1;
+}
+
+/* split [start, end) at blanks; 0 if there are more than CMD_ARGS_MAX */
+static uint8_t tokenize(Cmd_Handle_t *h, uint32_t start, uint32_t end)
+{
+    uint32_t mask = h->rx_size - 1u;
+
+    h->ntok = 0;
+    for (;;) {
+        while (start != end && blank(h->rx[start & mask])) start++;
+        if (start == end) return 1;
+        if (h->ntok == CMD_ARGS_MAX) return 0;
+
+        Cmd_Tok_t *t = &h->tok[h->ntok++];
+        t->pos = (uint16_t)(start & mask);
+        t->len = 0;
+        while (start != end && !blank(h->rx[start & mask])) { start++; t->len++; }
+    }
+}
+
+static void help(Cmd_Handle_t *h)
+{
+    char     line[CMD_LINE_MAX];
+    uint16_t n, k;
+
+    for (uint8_t i = 0; i < h->table_len; i++) {
+        const Cmd_Entry_t *e = &h->table[i];
+        n = 0;
+        for (k = 0; e->name[k] && n < sizeof(line) - 1u; k++) line[n++] = e->name[k];
+        if (e->usage && e->usage[0] && n < sizeof(line) - 1u) {
+            line[n++] = ' ';
+            for (k = 0; e->usage[k] && n < sizeof(line) - 1u; k++) line[n++] = e->usage[k];
+        }
+        line[n] = '\0';
+        Cmd_Reply(h, line);
+    }
+}
+
+static void dispatch(Cmd_Handle_t *h, uint32_t start, uint32_t end)
+{
+    if (!tokenize(h, start, end)) { answer(h, CMD_ERR_ARGS); return; }
+    if (h->ntok == 0) return;              /* empty line, e.g. CR LF */
+    h->lines++;
+
+    if (tok_is(h, &h->tok[0], "help")) {
+        help(h);
+        answer(h, CMD_OK);
+        return;
+    }
+    for (uint8_t i = 0; i < h->table_len; i++) {
+        const Cmd_Entry_t *e = &h->table[i];
+        uint8_t argc = (uint8_t)(h->ntok - 1u);
+
+        if (!tok_is(h, &h->tok[0], e->name)) continue;
+        if (argc < e->args_min || argc > e->args_max) answer(h, CMD_ERR_ARGS);
+        else                                          answer(h, e->fn(h, argc));
+        return;
+    }
+    answer(h, CMD_ERR_UNKNOWN);
+}
+
+void Cmd_Init(Cmd_Handle_t *h)
+{
+    h->rx_total = 0;
+    h->rx_base  = 0;
+    h->rx_pos   = 0;
+    h->rd       = 0;
+    h->line     = 0;
+    h->skip     = 0;
+    h->ntok     = 0;
+    h->lines    = 0;
+    h->errors   = 0;
+    h->overruns = 0;
+}
+
+void Cmd_RxEvent(Cmd_Handle_t *h, uint16_t pos)
+{
+    uint16_t mask = (uint16_t)(h->rx_size - 1u);
+
+    /* the half and full buffer events come at least twice a lap, so the
+     * distance is never a whole lap */
+    h->rx_total += (uint16_t)(pos - h->rx_pos) & mask;
+    h->rx_pos    = pos & mask;
+}
+
+void Cmd_RxRestart(Cmd_Handle_t *h)
+{
+    uint32_t mask = h->rx_size - 1u;
+
+    uint32_t base = ((h->rx_total + h->rx_size) | mask) + 1u;
+
+    /* a lap ahead and at index 0: Cmd_Poll sees an overrun and
+     * resumes no earlier than here (base first, it reads total first) */
+    h->rx_base  = base;
+    h->rx_total = base;
+    h->rx_pos   = 0;
+}
+
+uint8_t Cmd_Poll(Cmd_Handle_t *h)
+{
+    uint32_t mask = h->rx_size - 1u;
+    uint32_t total;
+    uint8_t  n = 0;
+
+    overrun(h);
+    total = h->rx_total;
+
+    while (h->rd != total) {
+        uint8_t c = h->rx[h->rd & mask];
+        h->rd++;
+
+        if (c == '\r' || c == '\n') {
+            /* the line as read is intact, and still was after the handler */
+            if (overrun(h)) { total = h->rx_total; continue; }
+            if (!h->skip) {
+                dispatch(h, h->line, h->rd - 1u);
+                n++;
+                if (overrun(h)) { total = h->rx_total; continue; }
+            }
+            h->skip = 0;
+            h->line = h->rd;
+        } else if (h->skip) {
+            h->line = h->rd;
+        } else if (h->rd - h->line > CMD_LINE_MAX) {
+            h->skip = 1;
+            h->line = h->rd;
+            answer(h, CMD_ERR_LONG);
+        }
+    }
+    return n;
+}
+
+uint8_t Cmd_ArgIs(const Cmd_Handle_t *h, uint8_t i, const char *s)
+{
+    if ((uint16_t)i + 1u >= h->ntok) return 0;
+    return tok_is(h, &h->tok[i + 1u], s);
+}
+
+Cmd_Status_t Cmd_ArgNum(const Cmd_Handle_t *h, uint8_t i, uint8_t dec,
+                        int32_t min, int32_t max, int32_t *v)
+{
+    const Cmd_Tok_t *t;
+    int64_t  acc    = 0;
+    uint8_t  k      = 0, neg = 0, digits = 0, frac = 0, point = 0;
+
+    if ((uint16_t)i + 1u >= h->ntok) return CMD_ERR_ARGS;
+    t = &h->tok[i + 1u];
+
+    if (tok_char(h, t, 0) == '-' || tok_char(h, t, 0) == '+') {
+        neg = tok_char(h, t, 0) == '-';
+        k++;
+    }
+    for (; k < t->len; k++) {
+        uint8_t c = tok_char(h, t, k);
+        if (c == '.' && !point) { point = 1; continue; }
+        if (c < '0' || c > '9') return CMD_ERR_ARGS;
+        if (point && frac++ == dec) return CMD_ERR_ARGS;
+        acc = acc * 10 + (c - '0');
+        if (acc > 0x7FFFFFFFLL) return CMD_ERR_RANGE;
+        digits++;
+    }
+    if (!digits) return CMD_ERR_ARGS;
+    for (; frac < dec; frac++) {
+        acc *= 10;
+        if (acc > 0x7FFFFFFFLL) return CMD_ERR_RANGE;
+    }
+    if (neg) acc = -acc;
+    if (acc < min || acc > max) return CMD_ERR_RANGE;
+    *v = (int32_t)acc;
+    return CMD_OK;
+}
+
+void Cmd_Reply(Cmd_Handle_t *h, const char *s)
+{
+    h->reply(s, (uint16_t)strlen(s));
+}
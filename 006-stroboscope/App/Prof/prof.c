@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file    prof.c
+  * @brief   Execution time zones with log2 histograms on the cycle counter
+  *          (HAL-free core, the application provides the output)
+  ******************************************************************************
+  */
+
+#include "prof.h"
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(__arm__)
+#include <time.h>
+
+uint32_t Prof_HostClock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+#endif
+
+/* bin of a duration: 0 for 0, else the bit length, the last bin open */
+static uint8_t bin_of(uint32_t d)
+{
+    uint8_t k = d ? (uint8_t)(32 - __builtin_clz(d)) : 0u;
+    return (k < PROF_BINS) ? k : (uint8_t)(PROF_BINS - 1u);
+}
+
+void Prof_Reset(Prof_Handle_t *h)
+{
+    memset(h->zone, 0, h->count * sizeof(h->zone[0]));
+    for (uint8_t i = 0; i < h->count; i++) h->zone[i].min = UINT32_MAX;
+}
+
+void Prof_Init(Prof_Handle_t *h)
+{
+    uint32_t best = UINT32_MAX;
+
+    /* the shortest of a few back to back reads: the clock read itself,
+     * as PROF_BEGIN / PROF_END see it around an empty block */
+    for (uint8_t i = 0; i < 64u; i++) {
+        uint32_t t = PROF_CLOCK();
+        uint32_t d = PROF_CLOCK() - t;
+        if (d < best) best = d;
+    }
+    h->overhead = best;
+    Prof_Reset(h);
+}
+
+void Prof_Add(Prof_Handle_t *h, uint8_t id, uint32_t ticks)
+{
+    Prof_Zone_t *z = &h->zone[id];
+
+    ticks = (ticks > h->overhead) ? ticks - h->overhead : 0u;
+    z->count++;
+    z->sum += ticks;
+    if (ticks < z->min) z->min = ticks;
+    if (ticks > z->max) z->max = ticks;
+    z->hist[bin_of(ticks)]++;
+}
+
+uint32_t Prof_Mean(const Prof_Zone_t *z)
+{
+    return z->count ? (uint32_t)((z->sum + z->count / 2u) / z->count) : 0u;
+}
+
+uint32_t Prof_Percentile(const Prof_Zone_t *z, uint8_t pct)
+{
+    uint64_t need = ((uint64_t)z->count * pct + 99u) / 100u;
+    uint64_t seen = 0;
+
+    if (!z->count) return 0;
+    if (need == 0) need = 1;
+    for (uint8_t k = 0; k < PROF_BINS; k++) {
+        seen += z->hist[k];
+        if (seen >= need) {
+            /* the bin's upper end, no more than the longest seen */
+            uint32_t top = (k == 0) ? 0u : (k >= 32u) ? UINT32_MAX : (uint32_t)((1ull << k) - 1u);
+            return (k == PROF_BINS - 1u || top > z->max) ? z->max : top;
+        }
+    }
+    return z->max;
+}
+
+uint32_t Prof_Us(const Prof_Handle_t *h, uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000000u + h->tick_hz / 2u) / h->tick_hz);
+}
+
+/* ticks as microseconds with two decimals */
+static int fmt_us(char *buf, size_t size, const Prof_Handle_t *h, uint32_t ticks)
+{
+    uint32_t c = (uint32_t)(((uint64_t)ticks * 100000000u + h->tick_hz / 2u) / h->tick_hz);
+    return snprintf(buf, size, " %7lu.%02lu", (unsigned long)(c / 100u), (unsigned long)(c % 100u));
+}
+
+void Prof_Report(const Prof_Handle_t *h, uint8_t hist,
+                 void (*out)(const char *s, uint16_t len))
+{
+    char line[96];
+    int  n;
+
+    n = snprintf(line, sizeof(line), "zone          count        min       mean        p99        max  us");
+    out(line, (uint16_t)n);
+
+    for (uint8_t i = 0; i < h->count; i++) {
+        const Prof_Zone_t *z = &h->zone[i];
+
+        n = snprintf(line, sizeof(line), "%-10s %8lu", h->names[i], (unsigned long)z->count);
+        if (z->count) {
+            n += fmt_us(line + n, sizeof(line) - (size_t)n, h, z->min);
+            n += fmt_us(line + n, sizeof(line) - (size_t)n, h, Prof_Mean(z));
+            n += fmt_us(line + n, sizeof(line) - (size_t)n, h, Prof_Percentile(z, 99));
+            n += fmt_us(line + n, sizeof(line) - (size_t)n, h, z->max);
+        }
+        out(line, (uint16_t)n);
+
+        if (!hist || !z->count) continue;
+        /* bin k: up to 2^k - 1 ticks, several lines if needed */
+        n = snprintf(line, sizeof(line), "  hist");
+        for (uint8_t k = 0; k < PROF_BINS; k++) {
+            if (!z->hist[k]) continue;
+            if (n > (int)sizeof(line) - 20) {
+                out(line, (uint16_t)n);
+                n = snprintf(line, sizeof(line), "  hist");
+            }
+            n += snprintf(line + n, sizeof(line) - (size_t)n, " %u:%lu", k, (unsigned long)z->hist[k]);
+        }
+        out(line, (uint16_t)n);
+    }
+}
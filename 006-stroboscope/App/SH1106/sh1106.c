@@ -44,11 +44,58 @@
 static uint8_t sh1106_buffer[SH1106_BUFFER_SIZE];
 
 #ifdef SH1106_DOUBLE_BUFFER
+// Mirror of the display RAM: holds what was last sent
 static uint8_t sh1106_buffer_back[SH1106_BUFFER_SIZE];
 #endif
 
 static SH1106_t sh1106;
 
+/**
+ * Dirty column span per page, clean when x0 > x1.
+ * Updated by every drawing function, consumed by the next update.
+ */
+static uint8_t sh1106_dirty_x0[SH1106_PAGES];
+static uint8_t sh1106_dirty_x1[SH1106_PAGES];
+
+// Tallest glyph the column blitter handles: rows + 7 bit shift fit 32 bits
+#define SH1106_BLIT_MAX_HEIGHT  25
+
+// Next update resends every page (display RAM contents unknown)
+static bool sh1106_full_refresh = true;
+
+/**
+ * Column run queued for transmission: page, first column, length.
+ */
+typedef struct {
+    uint8_t page;
+    uint8_t col;
+    uint8_t len;
+} SH1106_Run_t;
+
+static SH1106_Run_t sh1106_runs[SH1106_PAGES * SH1106_RUNS_PER_PAGE];
+
+#ifdef SH1106_USE_DMA
+/**
+ * Asynchronous frame pipeline state.
+ * Each run is sent as three command transfers followed by one data
+ * transfer, exactly the sequence produced by the blocking path.
+ * The next transfer is started from the I2C completion callback.
+ */
+typedef enum {
+    SH1106_TX_IDLE = 0,
+    SH1106_TX_PAGE,
+    SH1106_TX_COL_LOW,
+    SH1106_TX_COL_HIGH,
+    SH1106_TX_DATA
+} SH1106_TxPhase_t;
+
+static volatile SH1106_TxPhase_t sh1106_tx_phase = SH1106_TX_IDLE;
+static volatile uint8_t          sh1106_tx_run   = 0;
+static uint8_t                   sh1106_tx_count = 0;
+static const uint8_t*            sh1106_tx_src   = NULL;
+static uint8_t                   sh1106_tx_cmd[2];   // must outlive the DMA transfer
+#endif
+
 /* ========================================================================
  * PRIVATE FUNCTION PROTOTYPES
  * ======================================================================== */
@@ -63,6 +110,17 @@ static void SH1106_SPI_WriteCommand(uint8_t cmd);
 static void SH1106_SPI_WriteData(const uint8_t* data, size_t len);
 #endif
 
+static void SH1106_MarkDirty(uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1);
+static void SH1106_MarkDirtyAll(void);
+static uint8_t SH1106_PrepareRuns(void);
+static const uint8_t* SH1106_RunSource(void);
+static void SH1106_SendRun(const SH1106_Run_t* run, const uint8_t* src);
+static void SH1106_MarkSent(uint8_t page, uint8_t x0, uint8_t x1);
+
+#ifdef SH1106_USE_DMA
+static bool SH1106_Async_Kick(void);
+#endif
+
 /* ========================================================================
  * LOW-LEVEL I/O FUNCTIONS
  * ======================================================================== */
@@ -91,6 +149,8 @@ static bool SH1106_I2C_WriteCommand(uint8_t cmd) {
     uint8_t data[2] = {0x00, cmd};  // 0x00 = command mode
     
 #ifdef SH1106_USE_DMA
+    // Let a running asynchronous frame finish first
+    while (sh1106_tx_phase != SH1106_TX_IDLE) {}
     if (HAL_I2C_Master_Transmit_DMA(&SH1106_I2C_PORT, SH1106_I2C_ADDR, data, 2) != HAL_OK) {
         return false;
     }
@@ -113,6 +173,8 @@ static bool SH1106_I2C_WriteData(const uint8_t* buffer, size_t len) {
     // We'll send it with the data
     
 #ifdef SH1106_USE_DMA
+    while (sh1106_tx_phase != SH1106_TX_IDLE) {}
+
     // For DMA, we need a continuous buffer
     static uint8_t temp_buffer[SH1106_BUFFER_SIZE + 1];
     temp_buffer[0] = 0x40;  // Data mode
@@ -163,6 +225,9 @@ SH1106_Status_t SH1106_Init(void) {
     // Initialize structure
     memset(&sh1106, 0, sizeof(sh1106));
     
+    // Display RAM is undefined after power on, first update sends everything
+    SH1106_Invalidate();
+    
     // Small delay after power on
     HAL_Delay(100);
     
@@ -270,6 +335,7 @@ void SH1106_SetBrightness(uint8_t value) {
 void SH1106_Fill(SH1106_COLOR_t color) {
     uint8_t fill_value = (color == SH1106_COLOR_BLACK) ? 0x00 : 0xFF;
     memset(sh1106_buffer, fill_value, SH1106_BUFFER_SIZE);
+    SH1106_MarkDirtyAll();
 }
 
 void SH1106_Clear(void) {
@@ -277,25 +343,283 @@ void SH1106_Clear(void) {
 }
 
 uint8_t* SH1106_GetBuffer(void) {
+    // Caller may write anywhere, let the back buffer diff sort it out
+    SH1106_MarkDirtyAll();
     return sh1106_buffer;
 }
 
-void SH1106_UpdateScreen(void) {
-    uint8_t page;
+void SH1106_Invalidate(void) {
+    sh1106_full_refresh = true;
+}
+
+/**
+ * @brief Widen the dirty spans of pages page0..page1 to cover x0..x1
+ */
+static void SH1106_MarkDirty(uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+    for (uint8_t page = page0; page <= page1; page++) {
+        if (x0 < sh1106_dirty_x0[page]) {
+            sh1106_dirty_x0[page] = x0;
+        }
+        if (x1 > sh1106_dirty_x1[page]) {
+            sh1106_dirty_x1[page] = x1;
+        }
+    }
+}
+
+/**
+ * @brief Mark every page as fully dirty
+ */
+static void SH1106_MarkDirtyAll(void) {
+    memset(sh1106_dirty_x0, 0, sizeof(sh1106_dirty_x0));
+    memset(sh1106_dirty_x1, SH1106_WIDTH - 1, sizeof(sh1106_dirty_x1));
+}
+
+/**
+ * @brief Turn dirty spans into the list of column runs to send
+ * @note With SH1106_DOUBLE_BUFFER only columns that differ from the back
+ *       buffer are sent; runs closer than SH1106_DIFF_MERGE_GAP are merged
+ *       since every run costs its own page/column commands. The sent bytes
+ *       are copied to the back buffer, which the transfer then reads from.
+ * @return Number of runs in sh1106_runs
+ */
+static uint8_t SH1106_PrepareRuns(void) {
+    uint8_t count = 0;
+
+    for (uint8_t page = 0; page < SH1106_PAGES; page++) {
+        uint8_t x0 = sh1106_dirty_x0[page];
+        uint8_t x1 = sh1106_dirty_x1[page];
+
+        if (sh1106_full_refresh) {
+            x0 = 0;
+            x1 = SH1106_WIDTH - 1;
+        } else if (x0 > x1) {
+            continue;  // page untouched since the last update
+        }
+
+        sh1106_dirty_x0[page] = SH1106_WIDTH;
+        sh1106_dirty_x1[page] = 0;
+
+#ifdef SH1106_DOUBLE_BUFFER
+        const uint8_t* front = &sh1106_buffer[SH1106_WIDTH * page];
+        uint8_t* back = &sh1106_buffer_back[SH1106_WIDTH * page];
+        uint8_t first = count;
+        uint16_t x = x0;
+
+        while (x <= x1) {
+            if (!sh1106_full_refresh && front[x] == back[x]) {
+                x++;
+                continue;
+            }
+
+            // Last run allowed on this page absorbs everything up to x1
+            bool last = (uint8_t)(count - first) == SH1106_RUNS_PER_PAGE - 1;
+            uint16_t start = x;
+            uint16_t end = x;
+            uint8_t gap = 0;
+
+            for (x++; x <= x1; x++) {
+                if (sh1106_full_refresh || front[x] != back[x]) {
+                    end = x;
+                    gap = 0;
+                } else if (++gap > SH1106_DIFF_MERGE_GAP && !last) {
+                    break;
+                }
+            }
+
+            sh1106_runs[count].page = page;
+            sh1106_runs[count].col = (uint8_t)start;
+            sh1106_runs[count].len = (uint8_t)(end - start + 1);
+            memcpy(&back[start], &front[start], end - start + 1);
+            count++;
+        }
+#else
+        sh1106_runs[count].page = page;
+        sh1106_runs[count].col = x0;
+        sh1106_runs[count].len = (uint8_t)(x1 - x0 + 1);
+        count++;
+#endif
+    }
+
+    sh1106_full_refresh = false;
+    return count;
+}
+
+/**
+ * @brief Buffer the prepared runs are transmitted from
+ */
+static const uint8_t* SH1106_RunSource(void) {
+#ifdef SH1106_DOUBLE_BUFFER
+    return sh1106_buffer_back;
+#else
+    return sh1106_buffer;
+#endif
+}
+
+/**
+ * @brief Send one column run with blocking writes
+ */
+static void SH1106_SendRun(const SH1106_Run_t* run, const uint8_t* src) {
+    uint8_t col = run->col + SH1106_X_OFFSET;
+
+    // Set page address
+    SH1106_WriteCommand(SH1106_CMD_SET_PAGE_ADDR | run->page);
     
-    for (page = 0; page < SH1106_HEIGHT / 8; page++) {
-        // Set page address
-        SH1106_WriteCommand(SH1106_CMD_SET_PAGE_ADDR | page);
-        
-        // Set column address (with offset)
-        SH1106_WriteCommand(SH1106_CMD_SET_COL_ADDR_LOW | (SH1106_X_OFFSET & 0x0F));
-        SH1106_WriteCommand(SH1106_CMD_SET_COL_ADDR_HIGH | ((SH1106_X_OFFSET >> 4) & 0x0F));
-        
-        // Write data for this page
-        SH1106_WriteData(&sh1106_buffer[SH1106_WIDTH * page], SH1106_WIDTH);
+    // Set column address (with offset)
+    SH1106_WriteCommand(SH1106_CMD_SET_COL_ADDR_LOW | (col & 0x0F));
+    SH1106_WriteCommand(SH1106_CMD_SET_COL_ADDR_HIGH | ((col >> 4) & 0x0F));
+    
+    // Write data for this run
+    SH1106_WriteData(&src[SH1106_WIDTH * run->page + run->col], run->len);
+}
+
+/**
+ * @brief Account for columns x0..x1 of a page sent outside the run list
+ * @note The back buffer takes the front bytes, so the next delta update
+ *       neither resends them nor skips them against stale data. The
+ *       dirty span is trimmed where the sent columns cover one of its
+ *       ends; a span sent in the middle stays whole, which costs a
+ *       resend only without SH1106_DOUBLE_BUFFER.
+ */
+static void SH1106_MarkSent(uint8_t page, uint8_t x0, uint8_t x1) {
+    uint8_t d0 = sh1106_dirty_x0[page];
+    uint8_t d1 = sh1106_dirty_x1[page];
+
+#ifdef SH1106_DOUBLE_BUFFER
+    memcpy(&sh1106_buffer_back[SH1106_WIDTH * page + x0],
+           &sh1106_buffer[SH1106_WIDTH * page + x0], x1 - x0 + 1);
+#endif
+
+    if (d0 > d1) {
+        return;  // page clean
+    }
+    if (x0 <= d0 && x1 >= d1) {
+        sh1106_dirty_x0[page] = SH1106_WIDTH;
+        sh1106_dirty_x1[page] = 0;
+    } else if (x0 <= d0 && x1 >= d0) {
+        sh1106_dirty_x0[page] = x1 + 1;
+    } else if (x0 <= d1 && x1 >= d1) {
+        sh1106_dirty_x1[page] = x0 - 1;
     }
 }
 
+void SH1106_UpdateScreen(void) {
+#ifdef SH1106_USE_DMA
+    // Same bus traffic as below, but chained from the completion callback
+    while (SH1106_UpdateScreenAsync() == SH1106_BUSY) {}
+    while (SH1106_IsBusy()) {}
+#else
+    uint8_t count = SH1106_PrepareRuns();
+    const uint8_t* src = SH1106_RunSource();
+
+    for (uint8_t i = 0; i < count; i++) {
+        SH1106_SendRun(&sh1106_runs[i], src);
+    }
+#endif
+}
+
+SH1106_Status_t SH1106_UpdateScreenAsync(void) {
+#ifdef SH1106_USE_DMA
+    if (sh1106_tx_phase != SH1106_TX_IDLE) {
+        return SH1106_BUSY;
+    }
+
+    // With SH1106_DOUBLE_BUFFER the runs are snapshotted into the back
+    // buffer, so drawing may continue during the transfer. Otherwise the
+    // caller must not draw until SH1106_IsBusy() returns false.
+    sh1106_tx_count = SH1106_PrepareRuns();
+    sh1106_tx_src = SH1106_RunSource();
+
+    if (sh1106_tx_count == 0) {
+        return SH1106_OK;  // nothing changed
+    }
+
+    sh1106_tx_run   = 0;
+    sh1106_tx_phase = SH1106_TX_PAGE;
+
+    if (!SH1106_Async_Kick()) {
+        sh1106_tx_phase = SH1106_TX_IDLE;
+        SH1106_Invalidate();
+        return SH1106_ERROR;
+    }
+    return SH1106_OK;
+#else
+    SH1106_UpdateScreen();
+    return SH1106_OK;
+#endif
+}
+
+bool SH1106_IsBusy(void) {
+#ifdef SH1106_USE_DMA
+    return sh1106_tx_phase != SH1106_TX_IDLE;
+#else
+    return false;
+#endif
+}
+
+#ifdef SH1106_USE_DMA
+/**
+ * @brief Start the transfer for the current pipeline phase
+ * @return false if the HAL refused the transfer
+ */
+static bool SH1106_Async_Kick(void) {
+    const SH1106_Run_t* run = &sh1106_runs[sh1106_tx_run];
+    uint8_t col = run->col + SH1106_X_OFFSET;
+
+    switch (sh1106_tx_phase) {
+    case SH1106_TX_PAGE:
+        sh1106_tx_cmd[1] = SH1106_CMD_SET_PAGE_ADDR | run->page;
+        break;
+    case SH1106_TX_COL_LOW:
+        sh1106_tx_cmd[1] = SH1106_CMD_SET_COL_ADDR_LOW | (col & 0x0F);
+        break;
+    case SH1106_TX_COL_HIGH:
+        sh1106_tx_cmd[1] = SH1106_CMD_SET_COL_ADDR_HIGH | ((col >> 4) & 0x0F);
+        break;
+    case SH1106_TX_DATA:
+        // Zero-copy: 0x40 goes out as the memory address byte
+        return HAL_I2C_Mem_Write_DMA(&SH1106_I2C_PORT, SH1106_I2C_ADDR, 0x40, 1,
+                                     (uint8_t*)&sh1106_tx_src[SH1106_WIDTH * run->page + run->col],
+                                     run->len) == HAL_OK;
+    default:
+        return false;
+    }
+
+    sh1106_tx_cmd[0] = 0x00;  // command mode
+    return HAL_I2C_Master_Transmit_DMA(&SH1106_I2C_PORT, SH1106_I2C_ADDR,
+                                       sh1106_tx_cmd, 2) == HAL_OK;
+}
+
+void SH1106_I2C_TxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c->Instance != SH1106_I2C_PORT.Instance || sh1106_tx_phase == SH1106_TX_IDLE) {
+        return;
+    }
+
+    if (sh1106_tx_phase == SH1106_TX_DATA) {
+        if (++sh1106_tx_run >= sh1106_tx_count) {
+            sh1106_tx_phase = SH1106_TX_IDLE;
+            return;
+        }
+        sh1106_tx_phase = SH1106_TX_PAGE;
+    } else {
+        sh1106_tx_phase = (SH1106_TxPhase_t)(sh1106_tx_phase + 1);
+    }
+
+    if (!SH1106_Async_Kick()) {
+        sh1106_tx_phase = SH1106_TX_IDLE;
+        SH1106_Invalidate();
+    }
+}
+
+void SH1106_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c->Instance != SH1106_I2C_PORT.Instance) {
+        return;
+    }
+    // Back buffer no longer matches the panel, resend everything next time
+    sh1106_tx_phase = SH1106_TX_IDLE;
+    SH1106_Invalidate();
+}
+#endif
+
 bool SH1106_UpdateScreenChunk(uint16_t chunk) {
     uint16_t total_chunks = SH1106_GetTotalChunks();
     
@@ -311,20 +635,16 @@ bool SH1106_UpdateScreenChunk(uint16_t chunk) {
         bytes_to_send = SH1106_BUFFER_SIZE - start_byte;
     }
     
-    // Calculate page and column from byte offset
-    uint16_t page = start_byte / SH1106_WIDTH;
-    uint16_t col = start_byte % SH1106_WIDTH;
-    
-    // Set page address
-    SH1106_WriteCommand(SH1106_CMD_SET_PAGE_ADDR | page);
-    
-    // Set column address (with offset)
-    uint16_t actual_col = col + SH1106_X_OFFSET;
-    SH1106_WriteCommand(SH1106_CMD_SET_COL_ADDR_LOW | (actual_col & 0x0F));
-    SH1106_WriteCommand(SH1106_CMD_SET_COL_ADDR_HIGH | ((actual_col >> 4) & 0x0F));
-    
-    // Write chunk data
-    SH1106_WriteData(&sh1106_buffer[start_byte], bytes_to_send);
+    // One run of a single page (the chunk size divides the page width)
+    SH1106_Run_t run;
+    run.page = (uint8_t)(start_byte / SH1106_WIDTH);
+    run.col = (uint8_t)(start_byte % SH1106_WIDTH);
+    run.len = (uint8_t)bytes_to_send;
+
+    // Keep the delta update in step: the back buffer holds what the panel
+    // shows, and a dirty span the chunk covered at one end is trimmed
+    SH1106_MarkSent(run.page, run.col, (uint8_t)(run.col + run.len - 1));
+    SH1106_SendRun(&run, SH1106_RunSource());
     
     return (chunk + 1 < total_chunks);  // true if more chunks remain
 }
@@ -348,9 +668,17 @@ void SH1106_DrawPixel(int16_t x, uint8_t y, SH1106_COLOR_t color) {
     
     // Calculate buffer position
     // Buffer is organized in pages (8 rows per page)
-    uint16_t byte_index = x + (y / 8) * SH1106_WIDTH;
+    uint8_t page = y / 8;
+    uint16_t byte_index = x + page * SH1106_WIDTH;
     uint8_t bit_position = y % 8;
     
+    if (x < sh1106_dirty_x0[page]) {
+        sh1106_dirty_x0[page] = (uint8_t)x;
+    }
+    if (x > sh1106_dirty_x1[page]) {
+        sh1106_dirty_x1[page] = (uint8_t)x;
+    }
+    
     if (color == SH1106_COLOR_WHITE) {
         sh1106_buffer[byte_index] |= (1 << bit_position);
     } else {
@@ -477,6 +805,78 @@ void SH1106_GetCursor(int16_t* x, uint16_t* y) {
     }
 }
 
+/**
+ * @brief Per-pixel glyph renderer for fonts too tall for the blitter
+ */
+static void SH1106_DrawGlyphPixels(const uint16_t* rows, uint8_t height,
+                                   int16_t base_x, int16_t top,
+                                   int16_t glyph_col_start, int16_t glyph_col_end,
+                                   SH1106_COLOR_t color) {
+    for (uint8_t row = 0; row < height; row++) {
+        uint16_t row_bits = rows[row];
+        int16_t py = top + row;
+
+        if (py < 0 || py >= SH1106_HEIGHT) {
+            continue;
+        }
+
+        for (int16_t glyph_col = glyph_col_start;
+             glyph_col < glyph_col_end;
+             glyph_col++) {
+
+            if (row_bits & (1U << (15 - glyph_col))) {
+                SH1106_DrawPixel(base_x + glyph_col, (uint8_t)py, color);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Glyph renderer for page-packed fonts (see SH1106_Font_t)
+ * @note Glyph bytes already match the buffer layout: on a page boundary they
+ *       are ORed/ANDed as they are, otherwise split over two pages by a shift
+ */
+static void SH1106_DrawGlyphColumns(const uint8_t* glyph, uint8_t char_width,
+                                    uint8_t height, int16_t base_x, int16_t top,
+                                    int16_t glyph_col_start, int16_t glyph_col_end,
+                                    SH1106_COLOR_t color) {
+    uint8_t glyph_pages = (uint8_t)((height + 7) / 8);
+    int16_t count = glyph_col_end - glyph_col_start;
+    uint8_t fill  = (color == SH1106_COLOR_WHITE) ? 0xFF : 0x00;
+
+    for (uint8_t glyph_page = 0; glyph_page < glyph_pages; glyph_page++) {
+        int16_t row = top + glyph_page * 8;    // screen row of bit 0
+
+        if (row <= -8 || row >= SH1106_HEIGHT) {
+            continue;
+        }
+
+        /* row >= -7, so (row + 8) / 8 - 1 is floor(row / 8) */
+        int16_t page  = (row + 8) / 8 - 1;
+        uint8_t shift = (uint8_t)((row + 8) % 8);
+
+        const uint8_t* src = &glyph[glyph_page * char_width + glyph_col_start];
+        uint8_t* lo = (page >= 0) ?
+            &sh1106_buffer[page * SH1106_WIDTH + base_x + glyph_col_start] : NULL;
+        uint8_t* hi = (shift && page + 1 < SH1106_PAGES) ?
+            &sh1106_buffer[(page + 1) * SH1106_WIDTH + base_x + glyph_col_start] : NULL;
+
+        /* set or clear the glyph bits: (dst & ~mask) | (mask & fill) */
+        if (lo) {
+            for (int16_t i = 0; i < count; i++) {
+                uint8_t mask = (uint8_t)(src[i] << shift);
+                lo[i] = (uint8_t)((lo[i] & ~mask) | (mask & fill));
+            }
+        }
+        if (hi) {
+            for (int16_t i = 0; i < count; i++) {
+                uint8_t mask = (uint8_t)(src[i] >> (8 - shift));
+                hi[i] = (uint8_t)((hi[i] & ~mask) | (mask & fill));
+            }
+        }
+    }
+}
+
 char SH1106_WriteChar(char ch, SH1106_Font_t font, SH1106_COLOR_t color) {
     if (ch < 32 || ch > 126) {
         return 0;
@@ -489,11 +889,7 @@ char SH1106_WriteChar(char ch, SH1106_Font_t font, SH1106_COLOR_t color) {
     int8_t y_offset = font.y_offset ? font.y_offset[char_index] : 0;
 
     int16_t base_x = sh1106.current_x;
-    int16_t base_y = (int16_t)sh1106.current_y
-                   + font.baseline
-                   + y_offset;
-
-    uint16_t glyph_offset = (uint16_t)char_index * font.height;
+    int16_t top    = (int16_t)sh1106.current_y + y_offset;
 
     /* determine visible column range in glyph */
     int16_t glyph_col_start = 0;
@@ -512,29 +908,88 @@ char SH1106_WriteChar(char ch, SH1106_Font_t font, SH1106_COLOR_t color) {
         return ch;
     }
 
+    /* clip vertically once per glyph */
+    if (top >= SH1106_HEIGHT || top + font.height <= 0) {
+        sh1106.current_x += char_width;
+        return ch;
+    }
+
+    switch (font.format) {
+    case SH1106_FONT_PAGES: {
+        uint16_t offset = font.offsets ? font.offsets[char_index] :
+            (uint16_t)(char_index * char_width * ((font.height + 7) / 8));
+
+        int16_t last_page = (top + font.height - 1) / 8;
+
+        SH1106_DrawGlyphColumns(&font.cols[offset], char_width, font.height,
+                                base_x, top, glyph_col_start, glyph_col_end, color);
+        SH1106_MarkDirty(base_x + glyph_col_start, base_x + glyph_col_end - 1,
+                         (top < 0) ? 0 : (uint8_t)(top / 8),
+                         (last_page >= SH1106_PAGES) ? SH1106_PAGES - 1 : (uint8_t)last_page);
+        sh1106.current_x += char_width;
+        return ch;
+    }
+
+    case SH1106_FONT_ROWS:
+    default:
+        break;
+    }
+
+    const uint16_t* rows = &font.data[(uint16_t)char_index * font.height];
+
+    if (font.height > SH1106_BLIT_MAX_HEIGHT) {
+        SH1106_DrawGlyphPixels(rows, font.height, base_x, top,
+                               glyph_col_start, glyph_col_end, color);
+        sh1106.current_x += char_width;
+        return ch;
+    }
+
+    uint8_t skip  = (top < 0) ? (uint8_t)(-top) : 0;   // rows above the screen
+    uint8_t y     = (top < 0) ? 0 : (uint8_t)top;
+    uint8_t shift = y % 8;
+    uint8_t page0 = y / 8;
+    uint8_t page1 = (uint8_t)((y + font.height - skip - 1) / 8);
+
+    if (page1 >= SH1106_PAGES) {
+        page1 = SH1106_PAGES - 1;
+    }
+
+    /* transpose the visible glyph columns into bit masks (bit n = row n).
+     * only set pixels are visited: CLZ finds the next set column in a row */
+    uint32_t cols[16] = {0};
+    uint16_t visible = (uint16_t)((0xFFFFU >> glyph_col_start) &
+                                  ~(0xFFFFU >> glyph_col_end));
+
     for (uint8_t row = 0; row < font.height; row++) {
-        uint16_t row_bits = font.data[glyph_offset + row];
+        uint32_t bits = rows[row] & visible;
 
-        for (int16_t glyph_col = glyph_col_start;
-             glyph_col < glyph_col_end;
-             glyph_col++) {
+        while (bits) {
+            uint8_t glyph_col = (uint8_t)(__CLZ(bits) - 16);
+            cols[glyph_col] |= 1UL << row;
+            bits &= ~(0x8000UL >> glyph_col);
+        }
+    }
 
-            if (row_bits & (1U << (15 - glyph_col))) {
+    /* OR/AND each column mask into the page-aligned frame buffer bytes */
+    uint8_t* dst = &sh1106_buffer[page0 * SH1106_WIDTH + base_x + glyph_col_start];
 
-                int16_t px = base_x + glyph_col;
-                int16_t py = base_y + row - font.baseline;
+    for (int16_t glyph_col = glyph_col_start; glyph_col < glyph_col_end; glyph_col++, dst++) {
+        uint32_t mask = (cols[glyph_col] >> skip) << shift;
 
-                if (py >= 0 && py < SH1106_HEIGHT) {
-                    SH1106_DrawPixel(
-                        (uint8_t)px,
-                        (uint8_t)py,
-                        color
-                    );
-                }
+        uint8_t* p = dst;
+        for (uint8_t page = page0; page <= page1 && mask; page++) {
+            if (color == SH1106_COLOR_WHITE) {
+                *p |= (uint8_t)mask;
+            } else {
+                *p &= (uint8_t)~mask;
             }
+            mask >>= 8;
+            p += SH1106_WIDTH;
         }
     }
 
+    SH1106_MarkDirty(base_x + glyph_col_start, base_x + glyph_col_end - 1, page0, page1);
+
     // sh1106.current_x += char_width + 1;
     sh1106.current_x += char_width;
     return ch;
@@ -27,7 +27,8 @@ extern "C" {
  */
 typedef enum {
     SH1106_OK = 0,      /**< Success */
-    SH1106_ERROR = 1    /**< Error occurred */
+    SH1106_ERROR = 1,   /**< Error occurred */
+    SH1106_BUSY = 2     /**< Previous asynchronous frame still in flight */
 } SH1106_Status_t;
 
 /**
@@ -38,16 +39,31 @@ typedef enum {
     SH1106_COLOR_WHITE = 1   /**< Pixel on */
 } SH1106_COLOR_t;
 
+/**
+ * @brief Glyph storage format of a font
+ */
+typedef enum {
+    SH1106_FONT_ROWS = 0,   /**< Row-major data, one uint16_t per row, MSB = leftmost pixel */
+    SH1106_FONT_PAGES = 1   /**< Column-major page-packed cols from tools/sh1106_fontc.py */
+} SH1106_FontFormat_t;
+
 /**
  * @brief Font structure for character rendering
+ * @note The renderer picks the glyph path from format, not from which
+ *       pointers are set. SH1106_FONT_PAGES glyphs are ceil(height/8) pages
+ *       of char_width bytes each, bit 0 = top pixel, same as the frame
+ *       buffer. Fonts that leave format out are SH1106_FONT_ROWS.
  */
 typedef struct {
     uint8_t width;              /**< Maximum character width in pixels */
     uint8_t height;             /**< Font height in pixels */
-    const uint16_t *data;       /**< Pointer to font data array */
+    const uint16_t *data;       /**< Pointer to row-major font data array */
     const uint8_t *char_width;  /**< Pointer to character width array */
     const int8_t *y_offset;     /**< Pointer to Y offset array (for descenders) */
     uint8_t baseline;           /**< Baseline position from top */
+    const uint8_t *cols;        /**< Page-packed glyph columns (NULL = use data) */
+    const uint16_t *offsets;    /**< Glyph start in cols (NULL = fixed stride) */
+    SH1106_FontFormat_t format; /**< Which of data / cols holds the glyphs */
 } SH1106_Font_t;
 
 /**
@@ -80,14 +96,41 @@ void SH1106_Fill(SH1106_COLOR_t color);
 
 /**
  * @brief Update display with buffer contents
- * @note This function sends the entire buffer to the display
+ * @note Only pages touched since the last update are sent. With
+ *       SH1106_DOUBLE_BUFFER they are further reduced to the column runs
+ *       that differ from what the display already shows.
  */
 void SH1106_UpdateScreen(void);
 
+/**
+ * @brief Force the next update to resend the whole buffer
+ * @note Use after the panel lost its RAM contents (reset, bus error)
+ */
+void SH1106_Invalidate(void);
+
+/**
+ * @brief Start sending the buffer without blocking
+ * @return SH1106_OK if the frame was started, SH1106_BUSY if the previous
+ *         frame is still being sent, SH1106_ERROR on bus failure
+ * @note With SH1106_USE_DMA the pages are chained from the I2C completion
+ *       callback; without it this falls back to SH1106_UpdateScreen().
+ *       Without SH1106_DOUBLE_BUFFER do not draw while SH1106_IsBusy().
+ */
+SH1106_Status_t SH1106_UpdateScreenAsync(void);
+
+/**
+ * @brief Check whether an asynchronous frame is still being sent
+ * @return true while the transfer is in progress
+ */
+bool SH1106_IsBusy(void);
+
 /**
  * @brief Update a portion of the screen (incremental update)
  * @param chunk Chunk number to update (0 to num_chunks-1)
  * @return true if more chunks to update, false if done
+ * @note Sends with blocking writes and keeps the delta update in step
+ *       (back buffer and dirty spans), so it can be mixed with
+ *       SH1106_UpdateScreen and SH1106_UpdateScreenAsync.
  */
 bool SH1106_UpdateScreenChunk(uint16_t chunk);
 
@@ -278,6 +321,22 @@ void SH1106_WriteCommand(uint8_t cmd);
  */
 void SH1106_WriteData(const uint8_t* data, size_t len);
 
+#ifdef SH1106_USE_DMA
+/**
+ * @brief Advance the asynchronous frame pipeline
+ * @note Call from HAL_I2C_MasterTxCpltCallback and HAL_I2C_MemTxCpltCallback
+ * @param hi2c I2C handle passed to the HAL callback
+ */
+void SH1106_I2C_TxCpltCallback(I2C_HandleTypeDef* hi2c);
+
+/**
+ * @brief Abort the asynchronous frame pipeline after a bus error
+ * @note Call from HAL_I2C_ErrorCallback
+ * @param hi2c I2C handle passed to the HAL callback
+ */
+void SH1106_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,7 +10,12 @@
  * FONT 8H - VARIABLE-WIDTH 8x8 PIXEL FONT WITH DESCENDERS
  * ======================================================================== */
 
-#ifdef SH1106_INCLUDE_FONT_8H
+/*
+ * The tables below are the editable source of Font_8H. With
+ * SH1106_PACKED_FONTS the font is compiled from them by tools/sh1106_fontc.py
+ * into sh1106_fonts_packed.c, so this copy is left out of the build.
+ */
+#if defined(SH1106_INCLUDE_FONT_8H) && !defined(SH1106_PACKED_FONTS)
 
 /**
  * @brief Font data for 8H proportional font (max 8x8 pixels)
@@ -265,24 +270,13 @@ const SH1106_Font_t Font_8H = {
     .data = Font8H_data,          // Font data
     .char_width = Font8H_width,   // Character widths (proportional)
     .y_offset = Font8H_y_offset,  // Y offsets for descenders
-    .baseline = 5                 // Baseline position (5 pixels from top, capitals height = 6px)
+    .baseline = 5,                // Baseline position (5 pixels from top, capitals height = 6px)
+    .format = SH1106_FONT_ROWS    // Row-major glyph data
 };
 
-#endif /* SH1106_INCLUDE_FONT_8H */
+#endif /* SH1106_INCLUDE_FONT_8H && !SH1106_PACKED_FONTS */
 
 /* ========================================================================
  * OTHER STANDARD FONTS (6x8, 7x10, 11x18)
- * Add implementations here if needed
+ * Generated into sh1106_fonts_packed.c from 003-display-i2c ssd1306_fonts.c
  * ======================================================================== */
-
-#ifdef SH1106_INCLUDE_FONT_6x8
-// TODO: Add Font_6x8 implementation
-#endif
-
-#ifdef SH1106_INCLUDE_FONT_7x10
-// TODO: Add Font_7x10 implementation
-#endif
-
-#ifdef SH1106_INCLUDE_FONT_11x18
-// TODO: Add Font_11x18 implementation
-#endif
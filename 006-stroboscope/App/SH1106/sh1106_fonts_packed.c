@@ -0,0 +1,524 @@
+/**
+ * @file    sh1106_fonts_packed.c
+ * @brief   Column-major page-packed fonts for SH1106 OLED Display Driver
+ * @note    GENERATED by tools/sh1106_fontc.py - do not edit by hand.
+ *          Edit the row-major source tables and rerun the script.
+ *
+ * Glyph layout: ceil(height/8) pages of char_width bytes, page 0 first.
+ * Bit 0 of each byte is the top pixel of that page, as in the frame buffer.
+ */
+
+#include "sh1106_fonts.h"
+
+#ifdef SH1106_PACKED_FONTS
+
+/* ========================================================================
+ * Font_6x8 - monospace, 1 byte per column
+ * Source: 003-display-i2c/Src/ssd1306_fonts.c (Font6x8)
+ * Size: 570 bytes (row-major source: 1520 bytes)
+ * ======================================================================== */
+
+#ifdef SH1106_INCLUDE_FONT_6x8
+
+static const uint8_t Font6x8_cols[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // ' '
+    0x00, 0x00, 0x5F, 0x00, 0x00, 0x00,  // '!'
+    0x00, 0x07, 0x00, 0x07, 0x00, 0x00,  // '"'
+    0x14, 0x7F, 0x14, 0x7F, 0x14, 0x00,  // '#'
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, 0x00,  // '$'
+    0x23, 0x13, 0x08, 0x64, 0x62, 0x00,  // '%'
+    0x36, 0x49, 0x56, 0x20, 0x50, 0x00,  // '&'
+    0x00, 0x08, 0x07, 0x03, 0x00, 0x00,  // '''
+    0x00, 0x1C, 0x22, 0x41, 0x00, 0x00,  // '('
+    0x00, 0x41, 0x22, 0x1C, 0x00, 0x00,  // ')'
+    0x2A, 0x1C, 0x7F, 0x1C, 0x2A, 0x00,  // '*'
+    0x08, 0x08, 0x3E, 0x08, 0x08, 0x00,  // '+'
+    0x00, 0x00, 0x70, 0x30, 0x00, 0x00,  // ','
+    0x08, 0x08, 0x08, 0x08, 0x08, 0x00,  // '-'
+    0x00, 0x00, 0x60, 0x60, 0x00, 0x00,  // '.'
+    0x20, 0x10, 0x08, 0x04, 0x02, 0x00,  // '/'
+    0x3E, 0x51, 0x49, 0x45, 0x3E, 0x00,  // '0'
+    0x00, 0x42, 0x7F, 0x40, 0x00, 0x00,  // '1'
+    0x72, 0x49, 0x49, 0x49, 0x46, 0x00,  // '2'
+    0x21, 0x41, 0x49, 0x4D, 0x33, 0x00,  // '3'
+    0x18, 0x14, 0x12, 0x7F, 0x10, 0x00,  // '4'
+    0x27, 0x45, 0x45, 0x45, 0x39, 0x00,  // '5'
+    0x3C, 0x4A, 0x49, 0x49, 0x31, 0x00,  // '6'
+    0x41, 0x21, 0x11, 0x09, 0x07, 0x00,  // '7'
+    0x36, 0x49, 0x49, 0x49, 0x36, 0x00,  // '8'
+    0x46, 0x49, 0x49, 0x29, 0x1E, 0x00,  // '9'
+    0x00, 0x00, 0x14, 0x00, 0x00, 0x00,  // ':'
+    0x00, 0x40, 0x34, 0x00, 0x00, 0x00,  // ';'
+    0x00, 0x08, 0x14, 0x22, 0x41, 0x00,  // '<'
+    0x14, 0x14, 0x14, 0x14, 0x14, 0x00,  // '='
+    0x00, 0x41, 0x22, 0x14, 0x08, 0x00,  // '>'
+    0x02, 0x01, 0x59, 0x09, 0x06, 0x00,  // '?'
+    0x3E, 0x41, 0x5D, 0x59, 0x4E, 0x00,  // '@'
+    0x7C, 0x12, 0x11, 0x12, 0x7C, 0x00,  // 'A'
+    0x7F, 0x49, 0x49, 0x49, 0x36, 0x00,  // 'B'
+    0x3E, 0x41, 0x41, 0x41, 0x22, 0x00,  // 'C'
+    0x7F, 0x41, 0x41, 0x41, 0x3E, 0x00,  // 'D'
+    0x7F, 0x49, 0x49, 0x49, 0x41, 0x00,  // 'E'
+    0x7F, 0x09, 0x09, 0x09, 0x01, 0x00,  // 'F'
+    0x3E, 0x41, 0x41, 0x51, 0x73, 0x00,  // 'G'
+    0x7F, 0x08, 0x08, 0x08, 0x7F, 0x00,  // 'H'
+    0x00, 0x41, 0x7F, 0x41, 0x00, 0x00,  // 'I'
+    0x20, 0x40, 0x41, 0x3F, 0x01, 0x00,  // 'J'
+    0x7F, 0x08, 0x14, 0x22, 0x41, 0x00,  // 'K'
+    0x7F, 0x40, 0x40, 0x40, 0x40, 0x00,  // 'L'
+    0x7F, 0x02, 0x1C, 0x02, 0x7F, 0x00,  // 'M'
+    0x7F, 0x04, 0x08, 0x10, 0x7F, 0x00,  // 'N'
+    0x3E, 0x41, 0x41, 0x41, 0x3E, 0x00,  // 'O'
+    0x7F, 0x09, 0x09, 0x09, 0x06, 0x00,  // 'P'
+    0x3E, 0x41, 0x51, 0x21, 0x5E, 0x00,  // 'Q'
+    0x7F, 0x09, 0x19, 0x29, 0x46, 0x00,  // 'R'
+    0x26, 0x49, 0x49, 0x49, 0x32, 0x00,  // 'S'
+    0x03, 0x01, 0x7F, 0x01, 0x03, 0x00,  // 'T'
+    0x3F, 0x40, 0x40, 0x40, 0x3F, 0x00,  // 'U'
+    0x1F, 0x20, 0x40, 0x20, 0x1F, 0x00,  // 'V'
+    0x3F, 0x40, 0x38, 0x40, 0x3F, 0x00,  // 'W'
+    0x63, 0x14, 0x08, 0x14, 0x63, 0x00,  // 'X'
+    0x03, 0x04, 0x78, 0x04, 0x03, 0x00,  // 'Y'
+    0x61, 0x59, 0x49, 0x4D, 0x43, 0x00,  // 'Z'
+    0x00, 0x7F, 0x41, 0x41, 0x41, 0x00,  // '['
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x00,  // '\'
+    0x00, 0x41, 0x41, 0x41, 0x7F, 0x00,  // ']'
+    0x04, 0x02, 0x01, 0x02, 0x04, 0x00,  // '^'
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x00,  // '_'
+    0x00, 0x03, 0x07, 0x08, 0x00, 0x00,  // '`'
+    0x20, 0x54, 0x54, 0x78, 0x40, 0x00,  // 'a'
+    0x7F, 0x28, 0x44, 0x44, 0x38, 0x00,  // 'b'
+    0x38, 0x44, 0x44, 0x44, 0x28, 0x00,  // 'c'
+    0x38, 0x44, 0x44, 0x28, 0x7F, 0x00,  // 'd'
+    0x38, 0x54, 0x54, 0x54, 0x18, 0x00,  // 'e'
+    0x00, 0x08, 0x7E, 0x09, 0x02, 0x00,  // 'f'
+    0x18, 0x24, 0x24, 0x1C, 0x78, 0x00,  // 'g'
+    0x7F, 0x08, 0x04, 0x04, 0x78, 0x00,  // 'h'
+    0x00, 0x44, 0x7D, 0x40, 0x00, 0x00,  // 'i'
+    0x20, 0x40, 0x40, 0x3D, 0x00, 0x00,  // 'j'
+    0x7F, 0x10, 0x28, 0x44, 0x00, 0x00,  // 'k'
+    0x00, 0x41, 0x7F, 0x40, 0x00, 0x00,  // 'l'
+    0x7C, 0x04, 0x78, 0x04, 0x78, 0x00,  // 'm'
+    0x7C, 0x08, 0x04, 0x04, 0x78, 0x00,  // 'n'
+    0x38, 0x44, 0x44, 0x44, 0x38, 0x00,  // 'o'
+    0x7C, 0x18, 0x24, 0x24, 0x18, 0x00,  // 'p'
+    0x18, 0x24, 0x24, 0x18, 0x7C, 0x00,  // 'q'
+    0x7C, 0x08, 0x04, 0x04, 0x08, 0x00,  // 'r'
+    0x48, 0x54, 0x54, 0x54, 0x24, 0x00,  // 's'
+    0x04, 0x04, 0x3F, 0x44, 0x24, 0x00,  // 't'
+    0x3C, 0x40, 0x40, 0x20, 0x7C, 0x00,  // 'u'
+    0x1C, 0x20, 0x40, 0x20, 0x1C, 0x00,  // 'v'
+    0x3C, 0x40, 0x30, 0x40, 0x3C, 0x00,  // 'w'
+    0x44, 0x28, 0x10, 0x28, 0x44, 0x00,  // 'x'
+    0x4C, 0x10, 0x10, 0x10, 0x7C, 0x00,  // 'y'
+    0x44, 0x64, 0x54, 0x4C, 0x44, 0x00,  // 'z'
+    0x00, 0x08, 0x36, 0x41, 0x00, 0x00,  // '{'
+    0x00, 0x00, 0x77, 0x00, 0x00, 0x00,  // '|'
+    0x00, 0x41, 0x36, 0x08, 0x00, 0x00,  // '}'
+    0x02, 0x01, 0x02, 0x04, 0x02, 0x00,  // '~'
+};
+
+const SH1106_Font_t Font_6x8 = {
+    .width = 6,
+    .height = 8,
+    .data = NULL,
+    .char_width = NULL,
+    .y_offset = NULL,
+    .baseline = 6,
+    .cols = Font6x8_cols,
+    .offsets = NULL,
+    .format = SH1106_FONT_PAGES
+};
+
+#endif /* SH1106_INCLUDE_FONT_6x8 */
+
+/* ========================================================================
+ * Font_7x10 - monospace, 2 bytes per column
+ * Source: 003-display-i2c/Src/ssd1306_fonts.c (Font7x10)
+ * Size: 1330 bytes (row-major source: 1900 bytes)
+ * ======================================================================== */
+
+#ifdef SH1106_INCLUDE_FONT_7x10
+
+static const uint8_t Font7x10_cols[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // ' '
+    0x00, 0x00, 0x00, 0xBF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '!'
+    0x00, 0x00, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '"'
+    0x00, 0xF4, 0x2F, 0x24, 0xF4, 0x2F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '#'
+    0x00, 0x66, 0x89, 0xFF, 0x89, 0x72, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  // '$'
+    0x00, 0x26, 0x19, 0x6E, 0x94, 0x62, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '%'
+    0x00, 0x60, 0x96, 0x99, 0x66, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '&'
+    0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '''
+    0x00, 0x00, 0xFC, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00,  // '('
+    0x00, 0x00, 0x01, 0x02, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x00,  // ')'
+    0x00, 0x00, 0x0A, 0x07, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '*'
+    0x00, 0x10, 0x10, 0x7C, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '+'
+    0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  // ','
+    0x00, 0x00, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '-'
+    0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '.'
+    0x00, 0x00, 0xC0, 0x3C, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '/'
+    0x00, 0x7E, 0x81, 0x89, 0x81, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '0'
+    0x00, 0x04, 0x02, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '1'
+    0x00, 0x86, 0xC1, 0xA1, 0x91, 0x8E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '2'
+    0x00, 0x42, 0x81, 0x89, 0x89, 0x76, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '3'
+    0x00, 0x30, 0x2C, 0x22, 0xFF, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '4'
+    0x00, 0x4F, 0x89, 0x89, 0x89, 0x71, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '5'
+    0x00, 0x7E, 0x89, 0x89, 0x89, 0x72, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '6'
+    0x00, 0x01, 0xE1, 0x19, 0x05, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '7'
+    0x00, 0x76, 0x89, 0x89, 0x89, 0x76, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '8'
+    0x00, 0x4E, 0x91, 0x91, 0x91, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '9'
+    0x00, 0x00, 0x00, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // ':'
+    0x00, 0x00, 0x00, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  // ';'
+    0x00, 0x10, 0x28, 0x28, 0x44, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '<'
+    0x00, 0x28, 0x28, 0x28, 0x28, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '='
+    0x00, 0x44, 0x44, 0x28, 0x28, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '>'
+    0x00, 0x02, 0x01, 0xB1, 0x09, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '?'
+    0x00, 0x7E, 0x81, 0x99, 0x95, 0x1E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '@'
+    0x00, 0xE0, 0x3E, 0x21, 0x3E, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'A'
+    0x00, 0xFF, 0x89, 0x89, 0x89, 0x76, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'B'
+    0x00, 0x7E, 0x81, 0x81, 0x81, 0x42, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'C'
+    0x00, 0xFF, 0x81, 0x81, 0x42, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'D'
+    0x00, 0xFF, 0x89, 0x89, 0x89, 0x89, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'E'
+    0x00, 0xFF, 0x09, 0x09, 0x09, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'F'
+    0x00, 0x7E, 0x81, 0x91, 0x91, 0x72, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'G'
+    0x00, 0xFF, 0x08, 0x08, 0x08, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'H'
+    0x00, 0x00, 0x81, 0xFF, 0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'I'
+    0x00, 0x40, 0x80, 0x80, 0x80, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'J'
+    0x00, 0xFF, 0x08, 0x14, 0x62, 0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'K'
+    0x00, 0xFF, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'L'
+    0x00, 0xFF, 0x06, 0x08, 0x06, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'M'
+    0x00, 0xFF, 0x06, 0x18, 0x60, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'N'
+    0x00, 0x7E, 0x81, 0x81, 0x81, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'O'
+    0x00, 0xFF, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'P'
+    0x00, 0x7E, 0x81, 0xC1, 0x81, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,  // 'Q'
+    0x00, 0xFF, 0x11, 0x11, 0x71, 0x8E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'R'
+    0x00, 0x46, 0x89, 0x89, 0x91, 0x62, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'S'
+    0x00, 0x01, 0x01, 0xFF, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'T'
+    0x00, 0x7F, 0x80, 0x80, 0x80, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'U'
+    0x00, 0x07, 0x38, 0xC0, 0x38, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'V'
+    0x00, 0x3F, 0xE0, 0x1C, 0xE0, 0x3F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'W'
+    0x00, 0x81, 0x66, 0x18, 0x66, 0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'X'
+    0x00, 0x03, 0x0C, 0xF0, 0x0C, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'Y'
+    0x00, 0xC1, 0xA1, 0x99, 0x85, 0x83, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'Z'
+    0x00, 0x00, 0x00, 0xFF, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x02, 0x00, 0x00,  // '['
+    0x00, 0x00, 0x03, 0x3C, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '\'
+    0x00, 0x00, 0x01, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x00, 0x00, 0x00,  // ']'
+    0x00, 0x08, 0x06, 0x01, 0x06, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '^'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02,  // '_'
+    0x00, 0x00, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '`'
+    0x00, 0x68, 0x94, 0x94, 0x54, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'a'
+    0x00, 0xFF, 0x48, 0x84, 0x84, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'b'
+    0x00, 0x78, 0x84, 0x84, 0x84, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'c'
+    0x00, 0x78, 0x84, 0x84, 0x48, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'd'
+    0x00, 0x78, 0x94, 0x94, 0x94, 0x58, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'e'
+    0x00, 0x04, 0x04, 0xFE, 0x05, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'f'
+    0x00, 0x78, 0x84, 0x84, 0x48, 0xFC, 0x00, 0x00, 0x02, 0x02, 0x02, 0x02, 0x01, 0x00,  // 'g'
+    0x00, 0xFF, 0x08, 0x04, 0x04, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'h'
+    0x00, 0x04, 0x04, 0xFD, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'i'
+    0x00, 0x04, 0x04, 0xFD, 0x00, 0x00, 0x00, 0x02, 0x02, 0x02, 0x01, 0x00, 0x00, 0x00,  // 'j'
+    0x00, 0xFF, 0x10, 0x28, 0x44, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'k'
+    0x00, 0x01, 0x01, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'l'
+    0x00, 0xFC, 0x04, 0xFC, 0x04, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'm'
+    0x00, 0xFC, 0x08, 0x04, 0x04, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'n'
+    0x00, 0x78, 0x84, 0x84, 0x84, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'o'
+    0x00, 0xFC, 0x48, 0x84, 0x84, 0x78, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'p'
+    0x00, 0x78, 0x84, 0x84, 0x48, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00,  // 'q'
+    0x00, 0xFC, 0x08, 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'r'
+    0x00, 0x48, 0x94, 0x94, 0xA4, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 's'
+    0x00, 0x04, 0x7F, 0x84, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 't'
+    0x00, 0x7C, 0x80, 0x80, 0x40, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'u'
+    0x00, 0x0C, 0x70, 0x80, 0x70, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'v'
+    0x00, 0x3C, 0xE0, 0x1C, 0xE0, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'w'
+    0x00, 0x84, 0x48, 0x30, 0x48, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'x'
+    0x00, 0x0C, 0x30, 0xC0, 0x30, 0x0C, 0x00, 0x00, 0x02, 0x02, 0x01, 0x00, 0x00, 0x00,  // 'y'
+    0x00, 0xC4, 0xA4, 0x94, 0x8C, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'z'
+    0x00, 0x00, 0x30, 0xCF, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x02, 0x00, 0x00,  // '{'
+    0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  // '|'
+    0x00, 0x00, 0x01, 0xCF, 0x30, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x00, 0x00, 0x00,  // '}'
+    0x00, 0x18, 0x08, 0x08, 0x10, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '~'
+};
+
+const SH1106_Font_t Font_7x10 = {
+    .width = 7,
+    .height = 10,
+    .data = NULL,
+    .char_width = NULL,
+    .y_offset = NULL,
+    .baseline = 7,
+    .cols = Font7x10_cols,
+    .offsets = NULL,
+    .format = SH1106_FONT_PAGES
+};
+
+#endif /* SH1106_INCLUDE_FONT_7x10 */
+
+/* ========================================================================
+ * Font_11x18 - monospace, 3 bytes per column
+ * Source: 003-display-i2c/Src/ssd1306_fonts.c (Font11x18)
+ * Size: 3135 bytes (row-major source: 3420 bytes)
+ * ======================================================================== */
+
+#ifdef SH1106_INCLUDE_FONT_11x18
+
+static const uint8_t Font11x18_cols[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // ' '
+    0x00, 0x00, 0x00, 0x00, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6F, 0x6F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '!'
+    0x00, 0x00, 0x00, 0x3E, 0x3E, 0x00, 0x3E, 0x3E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '"'
+    0x00, 0x60, 0x60, 0xFE, 0xFE, 0x60, 0x60, 0xFE, 0xFE, 0x60, 0x00, 0x00, 0x06, 0x7F, 0x7F, 0x06, 0x06, 0x7F, 0x7F, 0x06, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '#'
+    0x00, 0x38, 0x7C, 0xEE, 0xC6, 0xFE, 0x86, 0x1C, 0x18, 0x00, 0x00, 0x00, 0x1C, 0x3C, 0x70, 0x60, 0xFF, 0x61, 0x3F, 0x1E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,  // '$'
+    0x3C, 0x7E, 0x42, 0x7E, 0x3C, 0x80, 0xC0, 0x60, 0x30, 0x18, 0x00, 0x00, 0x18, 0x0C, 0x06, 0x03, 0x3D, 0x7E, 0x42, 0x7E, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '%'
+    0x00, 0x00, 0x3C, 0x7E, 0xC6, 0xC6, 0x7E, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x1E, 0x3F, 0x61, 0x61, 0x63, 0x36, 0x1C, 0x7F, 0x23, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '&'
+    0x00, 0x00, 0x00, 0x00, 0x3E, 0x3E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '''
+    0x00, 0x00, 0x00, 0x00, 0xC0, 0xF8, 0x1C, 0x06, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x7F, 0xE0, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00,  // '('
+    0x00, 0x00, 0x01, 0x06, 0x1C, 0xF8, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0xE0, 0x7F, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // ')'
+    0x00, 0x00, 0x2C, 0x38, 0x1E, 0x1E, 0x38, 0x2C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '*'
+    0x80, 0x80, 0x80, 0x80, 0xF8, 0xF8, 0x80, 0x80, 0x80, 0x80, 0x00, 0x01, 0x01, 0x01, 0x01, 0x1F, 0x1F, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '+'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,  // ','
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06, 0x06, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '-'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '.'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0xFE, 0x0E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x7F, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '/'
+    0x00, 0xF0, 0xFC, 0x0E, 0x86, 0x86, 0x0E, 0xFC, 0xF0, 0x00, 0x00, 0x00, 0x0F, 0x3F, 0x70, 0x61, 0x61, 0x70, 0x3F, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '0'
+    0x00, 0x00, 0x30, 0x18, 0x0C, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '1'
+    0x00, 0x38, 0x3C, 0x0E, 0x06, 0x06, 0x8E, 0xFC, 0x78, 0x00, 0x00, 0x00, 0x70, 0x78, 0x6C, 0x66, 0x63, 0x61, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '2'
+    0x00, 0x18, 0x1C, 0x06, 0xC6, 0xC6, 0xFC, 0x38, 0x00, 0x00, 0x00, 0x00, 0x18, 0x38, 0x70, 0x60, 0x60, 0x71, 0x3F, 0x1E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '3'
+    0x00, 0x00, 0x80, 0xF0, 0x3C, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0E, 0x0F, 0x0D, 0x0C, 0x7F, 0x7F, 0x0C, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '4'
+    0x00, 0xFE, 0xFE, 0x86, 0xC6, 0xC6, 0xC6, 0x86, 0x00, 0x00, 0x00, 0x00, 0x19, 0x39, 0x70, 0x60, 0x60, 0x71, 0x3F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '5'
+    0x00, 0xF0, 0xFC, 0x8E, 0xC6, 0xC6, 0xCE, 0x9C, 0x18, 0x00, 0x00, 0x00, 0x0F, 0x3F, 0x71, 0x60, 0x60, 0x71, 0x3F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '6'
+    0x00, 0x06, 0x06, 0x06, 0x06, 0xC6, 0xF6, 0x3E, 0x0E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x7F, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '7'
+    0x00, 0x38, 0x7C, 0x86, 0x86, 0x86, 0x8E, 0x7C, 0x38, 0x00, 0x00, 0x00, 0x1E, 0x3F, 0x61, 0x61, 0x61, 0x61, 0x3F, 0x1E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '8'
+    0x00, 0xF8, 0xFC, 0x8E, 0x06, 0x06, 0x8E, 0xFC, 0xF0, 0x00, 0x00, 0x00, 0x18, 0x39, 0x73, 0x63, 0x63, 0x71, 0x3F, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '9'
+    0x00, 0x00, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // ':'
+    0x00, 0x00, 0x00, 0x00, 0xC0, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,  // ';'
+    0x00, 0x00, 0x80, 0x80, 0xC0, 0x40, 0x60, 0x20, 0x30, 0x00, 0x00, 0x00, 0x01, 0x03, 0x02, 0x06, 0x04, 0x0C, 0x08, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '<'
+    0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '='
+    0x00, 0x30, 0x20, 0x60, 0x40, 0xC0, 0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x18, 0x08, 0x0C, 0x04, 0x06, 0x02, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '>'
+    0x00, 0x18, 0x1C, 0x0E, 0x06, 0x06, 0x86, 0xCE, 0xFC, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6E, 0x6F, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '?'
+    0x00, 0xF0, 0xFC, 0x1E, 0xC6, 0xC6, 0x66, 0xFC, 0xF8, 0x00, 0x00, 0x00, 0x0F, 0x3F, 0x70, 0x63, 0x67, 0x36, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '@'
+    0x00, 0x00, 0x80, 0xF8, 0x7E, 0x06, 0x7E, 0xF8, 0x80, 0x00, 0x00, 0x00, 0x70, 0x7F, 0x0F, 0x06, 0x06, 0x06, 0x0F, 0x7F, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'A'
+    0x00, 0xFE, 0xFE, 0x86, 0x86, 0x86, 0xFC, 0x78, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x61, 0x61, 0x61, 0x73, 0x3E, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'B'
+    0x00, 0xF0, 0xFC, 0x0E, 0x06, 0x06, 0x06, 0x1C, 0x18, 0x00, 0x00, 0x00, 0x0F, 0x3F, 0x70, 0x60, 0x60, 0x60, 0x38, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'C'
+    0x00, 0xFE, 0xFE, 0x06, 0x06, 0x06, 0x1C, 0xFC, 0xF0, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x60, 0x60, 0x60, 0x38, 0x1F, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'D'
+    0x00, 0xFE, 0xFE, 0x86, 0x86, 0x86, 0x86, 0x86, 0x06, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x61, 0x61, 0x61, 0x61, 0x61, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'E'
+    0x00, 0xFE, 0xFE, 0x86, 0x86, 0x86, 0x86, 0x86, 0x06, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'F'
+    0x00, 0xF0, 0xFC, 0x0E, 0x06, 0x06, 0x06, 0x1C, 0x18, 0x00, 0x00, 0x00, 0x0F, 0x3F, 0x70, 0x60, 0x60, 0x63, 0x3F, 0x3F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'G'
+    0x00, 0xFE, 0xFE, 0x80, 0x80, 0x80, 0x80, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x01, 0x01, 0x01, 0x01, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'H'
+    0x00, 0x00, 0x06, 0x06, 0xFE, 0xFE, 0x06, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60, 0x7F, 0x7F, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'I'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x1C, 0x3C, 0x70, 0x60, 0x60, 0x70, 0x3F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'J'
+    0x00, 0xFE, 0xFE, 0x80, 0xC0, 0x70, 0x38, 0x0C, 0x06, 0x02, 0x00, 0x00, 0x7F, 0x7F, 0x01, 0x01, 0x07, 0x0E, 0x38, 0x70, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'K'
+    0x00, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'L'
+    0x00, 0xFE, 0xFE, 0x1E, 0xF8, 0x80, 0xF8, 0x0E, 0xFE, 0xFE, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x01, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'M'
+    0x00, 0xFE, 0xFE, 0x3E, 0xF8, 0xC0, 0x00, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x01, 0x1F, 0x7C, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'N'
+    0x00, 0xF0, 0xFC, 0x0E, 0x06, 0x06, 0x0E, 0xFC, 0xF0, 0x00, 0x00, 0x00, 0x0F, 0x3F, 0x70, 0x60, 0x60, 0x70, 0x3F, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'O'
+    0x00, 0xFE, 0xFE, 0x06, 0x06, 0x06, 0x8E, 0xFC, 0xF8, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x03, 0x03, 0x03, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'P'
+    0x00, 0xF0, 0xFC, 0x0E, 0x06, 0x06, 0x0E, 0xFC, 0xF0, 0x00, 0x00, 0x00, 0x0F, 0x3F, 0x70, 0x60, 0x6C, 0x78, 0x3F, 0x2F, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'Q'
+    0x00, 0xFE, 0xFE, 0x86, 0x86, 0x86, 0xCE, 0xFC, 0x78, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x01, 0x01, 0x03, 0x0F, 0x3C, 0x70, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'R'
+    0x00, 0x00, 0x78, 0xFC, 0xC6, 0x86, 0x86, 0x1C, 0x18, 0x00, 0x00, 0x00, 0x0C, 0x3C, 0x70, 0x60, 0x61, 0x63, 0x3F, 0x1E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'S'
+    0x06, 0x06, 0x06, 0x06, 0xFE, 0xFE, 0x06, 0x06, 0x06, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'T'
+    0x00, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x00, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x1F, 0x3F, 0x70, 0x60, 0x60, 0x70, 0x3F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'U'
+    0x00, 0x0E, 0x7E, 0xF0, 0x80, 0x00, 0x80, 0xF0, 0x7E, 0x0E, 0x00, 0x00, 0x00, 0x00, 0x07, 0x3F, 0x78, 0x3F, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'V'
+    0x7E, 0xFE, 0x00, 0x00, 0xC0, 0xC0, 0x00, 0x00, 0xFE, 0x7E, 0x00, 0x00, 0x7F, 0x70, 0x1E, 0x03, 0x03, 0x1E, 0x70, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'W'
+    0x02, 0x0E, 0x3C, 0x70, 0xE0, 0xC0, 0x70, 0x38, 0x0E, 0x02, 0x00, 0x40, 0x70, 0x38, 0x1E, 0x0F, 0x07, 0x0E, 0x3C, 0x70, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'X'
+    0x02, 0x0E, 0x3C, 0xF0, 0xC0, 0xC0, 0xF0, 0x3C, 0x0E, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'Y'
+    0x00, 0x00, 0x06, 0x06, 0x86, 0xC6, 0x76, 0x3E, 0x0E, 0x00, 0x00, 0x00, 0x70, 0x78, 0x6E, 0x67, 0x61, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'Z'
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x03, 0x03, 0x00, 0x00, 0x00,  // '['
+    0x00, 0x00, 0x00, 0x0E, 0xFE, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x7F, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '\'
+    0x00, 0x00, 0x00, 0x03, 0x03, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00,  // ']'
+    0x00, 0x80, 0xE0, 0x78, 0x0E, 0x0E, 0x78, 0xE0, 0x80, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '^'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,  // '_'
+    0x00, 0x00, 0x02, 0x06, 0x0E, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '`'
+    0x00, 0x80, 0xC0, 0x60, 0x60, 0x60, 0x60, 0xE0, 0xC0, 0x00, 0x00, 0x00, 0x38, 0x7C, 0x66, 0x66, 0x26, 0x36, 0x3F, 0x7F, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'a'
+    0x00, 0xFE, 0xFE, 0xC0, 0x60, 0x60, 0xE0, 0xC0, 0x80, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x30, 0x60, 0x60, 0x70, 0x3F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'b'
+    0x00, 0x80, 0xC0, 0xE0, 0x60, 0x60, 0xE0, 0xC0, 0x80, 0x00, 0x00, 0x00, 0x1F, 0x3F, 0x70, 0x60, 0x60, 0x70, 0x39, 0x19, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'c'
+    0x00, 0x80, 0xC0, 0xE0, 0x60, 0x60, 0xC0, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x1F, 0x3F, 0x70, 0x60, 0x60, 0x30, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'd'
+    0x00, 0x80, 0xC0, 0xE0, 0x60, 0x60, 0xE0, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x3F, 0x76, 0x66, 0x66, 0x66, 0x37, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'e'
+    0x00, 0x60, 0x60, 0x60, 0xFC, 0xFE, 0x66, 0x66, 0x66, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'f'
+    0x00, 0xC0, 0xE0, 0x70, 0x30, 0x30, 0x60, 0xF0, 0xF0, 0x00, 0x00, 0x00, 0x8F, 0x9F, 0x38, 0x30, 0x30, 0x98, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x01, 0x03, 0x03, 0x03, 0x03, 0x03, 0x01, 0x00, 0x00, 0x00,  // 'g'
+    0x00, 0xFE, 0xFE, 0xC0, 0x60, 0x60, 0x60, 0xE0, 0xC0, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'h'
+    0x00, 0x00, 0x60, 0x60, 0x60, 0xE6, 0xE6, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'i'
+    0x00, 0x00, 0x30, 0x30, 0x30, 0xF3, 0xF3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x03, 0x03, 0x03, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00,  // 'j'
+    0x00, 0xFE, 0xFE, 0x00, 0x00, 0x80, 0xC0, 0x60, 0x20, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x06, 0x03, 0x07, 0x1C, 0x38, 0x60, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'k'
+    0x00, 0x00, 0x06, 0x06, 0x06, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'l'
+    0xE0, 0xE0, 0x40, 0x60, 0xE0, 0xE0, 0xC0, 0x60, 0xE0, 0xC0, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'm'
+    0x00, 0xE0, 0xE0, 0xC0, 0x60, 0x60, 0x60, 0xE0, 0xC0, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'n'
+    0x00, 0x80, 0xC0, 0xE0, 0x60, 0x60, 0xE0, 0xC0, 0x80, 0x00, 0x00, 0x00, 0x1F, 0x3F, 0x70, 0x60, 0x60, 0x70, 0x3F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'o'
+    0x00, 0xF0, 0xF0, 0x60, 0x30, 0x30, 0x70, 0xE0, 0xC0, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x18, 0x30, 0x30, 0x38, 0x1F, 0x0F, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'p'
+    0x00, 0xC0, 0xE0, 0x70, 0x30, 0x30, 0x60, 0xF0, 0xF0, 0x00, 0x00, 0x00, 0x0F, 0x1F, 0x38, 0x30, 0x30, 0x18, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00,  // 'q'
+    0x00, 0x20, 0xE0, 0xC0, 0xC0, 0x60, 0x60, 0xE0, 0x40, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'r'
+    0x00, 0x80, 0xC0, 0x60, 0x60, 0x60, 0x60, 0xC0, 0xC0, 0x00, 0x00, 0x00, 0x33, 0x37, 0x66, 0x66, 0x66, 0x66, 0x3E, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 's'
+    0x00, 0x60, 0x60, 0xF8, 0xFC, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3F, 0x7F, 0x60, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 't'
+    0x00, 0xE0, 0xE0, 0x00, 0x00, 0x00, 0x00, 0xE0, 0xE0, 0x00, 0x00, 0x00, 0x3F, 0x7F, 0x60, 0x60, 0x60, 0x30, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'u'
+    0x00, 0x20, 0xE0, 0xC0, 0x00, 0x00, 0x00, 0xC0, 0xE0, 0x20, 0x00, 0x00, 0x00, 0x01, 0x0F, 0x3E, 0x70, 0x7E, 0x0F, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'v'
+    0xE0, 0xE0, 0x00, 0xE0, 0xE0, 0xE0, 0x00, 0xE0, 0xE0, 0x00, 0x00, 0x00, 0x1F, 0x78, 0x1F, 0x00, 0x1F, 0x78, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'w'
+    0x00, 0x20, 0xE0, 0xC0, 0x00, 0x00, 0xC0, 0xE0, 0x20, 0x00, 0x00, 0x00, 0x40, 0x70, 0x39, 0x0F, 0x0F, 0x39, 0x70, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'x'
+    0x00, 0x30, 0xF0, 0xC0, 0x00, 0x00, 0x80, 0xF0, 0x70, 0x00, 0x00, 0x00, 0x00, 0x01, 0x8F, 0xFE, 0xF0, 0x7F, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'y'
+    0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0xE0, 0xE0, 0x60, 0x00, 0x00, 0x60, 0x70, 0x78, 0x6C, 0x66, 0x63, 0x61, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 'z'
+    0x00, 0x00, 0x00, 0x00, 0x80, 0xFE, 0xFF, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x07, 0xFF, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x03, 0x03, 0x03, 0x00, 0x00,  // '{'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00,  // '|'
+    0x00, 0x00, 0x03, 0x03, 0xFF, 0xFE, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFC, 0xFF, 0x07, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,  // '}'
+    0x00, 0x00, 0x80, 0x80, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x03, 0x01, 0x01, 0x01, 0x03, 0x03, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '~'
+};
+
+const SH1106_Font_t Font_11x18 = {
+    .width = 11,
+    .height = 18,
+    .data = NULL,
+    .char_width = NULL,
+    .y_offset = NULL,
+    .baseline = 14,
+    .cols = Font11x18_cols,
+    .offsets = NULL,
+    .format = SH1106_FONT_PAGES
+};
+
+#endif /* SH1106_INCLUDE_FONT_11x18 */
+
+/* ========================================================================
+ * Font_8H - proportional, 1 byte per column
+ * Source: 006-stroboscope/App/SH1106/sh1106_fonts.c (Font8H_data)
+ * Size: 840 bytes (row-major source: 1520 bytes)
+ * ======================================================================== */
+
+#ifdef SH1106_INCLUDE_FONT_8H
+
+static const uint8_t Font8H_cols[] = {
+    0x00, 0x00, 0x00,  // ' '
+    0x2F, 0x00,  // '!'
+    0x03, 0x00, 0x03, 0x00,  // '"'
+    0x14, 0x3E, 0x14, 0x3E, 0x14, 0x00,  // '#'
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, 0x00,  // '$'
+    0x23, 0x13, 0x08, 0x04, 0x32, 0x31, 0x00,  // '%'
+    0x1A, 0x25, 0x2A, 0x10, 0x28, 0x00,  // '&'
+    0x03, 0x00,  // '''
+    0x1C, 0x22, 0x41, 0x00,  // '('
+    0x41, 0x22, 0x1C, 0x00,  // ')'
+    0x22, 0x14, 0x7F, 0x14, 0x22, 0x00,  // '*'
+    0x08, 0x08, 0x3E, 0x08, 0x08, 0x00,  // '+'
+    0x80, 0x60, 0x00,  // ','
+    0x08, 0x08, 0x08, 0x08, 0x00,  // '-'
+    0x20, 0x00,  // '.'
+    0x30, 0x0C, 0x03, 0x00,  // '/'
+    0x1E, 0x21, 0x21, 0x1E, 0x00,  // '0'
+    0x22, 0x3F, 0x20, 0x00,  // '1'
+    0x22, 0x31, 0x29, 0x26, 0x00,  // '2'
+    0x21, 0x21, 0x25, 0x1A, 0x00,  // '3'
+    0x0C, 0x0A, 0x3F, 0x08, 0x00,  // '4'
+    0x27, 0x25, 0x25, 0x19, 0x00,  // '5'
+    0x1E, 0x25, 0x25, 0x18, 0x00,  // '6'
+    0x01, 0x39, 0x05, 0x03, 0x00,  // '7'
+    0x1A, 0x25, 0x25, 0x1A, 0x00,  // '8'
+    0x06, 0x29, 0x29, 0x1E, 0x00,  // '9'
+    0x24, 0x00,  // ':'
+    0x80, 0x64, 0x00,  // ';'
+    0x08, 0x14, 0x22, 0x00,  // '<'
+    0x14, 0x14, 0x14, 0x14, 0x00,  // '='
+    0x22, 0x14, 0x08, 0x00,  // '>'
+    0x02, 0x01, 0x29, 0x06, 0x00,  // '?'
+    0x1C, 0x22, 0x49, 0x55, 0x55, 0x1E, 0x00,  // '@'
+    0x38, 0x0E, 0x09, 0x0E, 0x38, 0x00,  // 'A'
+    0x3F, 0x25, 0x25, 0x25, 0x1A, 0x00,  // 'B'
+    0x1E, 0x21, 0x21, 0x21, 0x12, 0x00,  // 'C'
+    0x3F, 0x21, 0x21, 0x21, 0x1E, 0x00,  // 'D'
+    0x3F, 0x25, 0x25, 0x25, 0x21, 0x00,  // 'E'
+    0x3F, 0x05, 0x05, 0x05, 0x01, 0x00,  // 'F'
+    0x1E, 0x21, 0x21, 0x29, 0x3A, 0x00,  // 'G'
+    0x3F, 0x04, 0x04, 0x04, 0x3F, 0x00,  // 'H'
+    0x3F, 0x00,  // 'I'
+    0x10, 0x20, 0x21, 0x1F, 0x01, 0x00,  // 'J'
+    0x3F, 0x04, 0x0A, 0x31, 0x00,  // 'K'
+    0x3F, 0x20, 0x20, 0x20, 0x00,  // 'L'
+    0x3F, 0x02, 0x04, 0x08, 0x04, 0x02, 0x3F, 0x00,  // 'M'
+    0x3F, 0x02, 0x04, 0x08, 0x3F, 0x00,  // 'N'
+    0x1E, 0x21, 0x21, 0x21, 0x1E, 0x00,  // 'O'
+    0x3F, 0x09, 0x09, 0x09, 0x06, 0x00,  // 'P'
+    0x1E, 0x21, 0x29, 0x11, 0x2E, 0x00,  // 'Q'
+    0x3F, 0x09, 0x09, 0x19, 0x26, 0x00,  // 'R'
+    0x22, 0x25, 0x25, 0x25, 0x19, 0x00,  // 'S'
+    0x01, 0x01, 0x3F, 0x01, 0x01, 0x00,  // 'T'
+    0x1F, 0x20, 0x20, 0x20, 0x1F, 0x00,  // 'U'
+    0x0F, 0x10, 0x20, 0x10, 0x0F, 0x00,  // 'V'
+    0x1F, 0x20, 0x1C, 0x20, 0x1F, 0x00,  // 'W'
+    0x21, 0x12, 0x0C, 0x12, 0x21, 0x00,  // 'X'
+    0x03, 0x04, 0x38, 0x04, 0x03, 0x00,  // 'Y'
+    0x21, 0x31, 0x29, 0x25, 0x23, 0x00,  // 'Z'
+    0x7F, 0x41, 0x00,  // '['
+    0x03, 0x0C, 0x30, 0x00,  // '\'
+    0x41, 0x7F, 0x00,  // ']'
+    0x02, 0x01, 0x02, 0x00,  // '^'
+    0x40, 0x40, 0x40, 0x40, 0x40,  // '_'
+    0x01, 0x02, 0x00,  // '`'
+    0x18, 0x24, 0x24, 0x3C, 0x20, 0x00,  // 'a'
+    0x3F, 0x24, 0x24, 0x18, 0x00,  // 'b'
+    0x18, 0x24, 0x24, 0x00,  // 'c'
+    0x18, 0x24, 0x24, 0x3F, 0x00,  // 'd'
+    0x38, 0x54, 0x54, 0x18, 0x00,  // 'e'
+    0x04, 0x3E, 0x05, 0x05, 0x00,  // 'f'
+    0x98, 0xA4, 0xA4, 0x7C, 0x00,  // 'g'
+    0x3F, 0x04, 0x04, 0x38, 0x00,  // 'h'
+    0x3D, 0x00,  // 'i'
+    0x80, 0x84, 0x7D, 0x00,  // 'j'
+    0x3F, 0x08, 0x34, 0x00,  // 'k'
+    0x3F, 0x20, 0x00,  // 'l'
+    0x3C, 0x04, 0x3C, 0x04, 0x38, 0x00,  // 'm'
+    0x3C, 0x04, 0x04, 0x38, 0x00,  // 'n'
+    0x18, 0x24, 0x24, 0x18, 0x00,  // 'o'
+    0xFC, 0x24, 0x24, 0x18, 0x00,  // 'p'
+    0x18, 0x24, 0x24, 0xFC, 0x00,  // 'q'
+    0x3C, 0x08, 0x04, 0x04, 0x00,  // 'r'
+    0x48, 0x54, 0x54, 0x64, 0x00,  // 's'
+    0x04, 0x3F, 0x44, 0x00,  // 't'
+    0x1C, 0x20, 0x20, 0x3C, 0x00,  // 'u'
+    0x1C, 0x20, 0x1C, 0x00,  // 'v'
+    0x1C, 0x20, 0x18, 0x20, 0x1C, 0x00,  // 'w'
+    0x34, 0x08, 0x34, 0x00,  // 'x'
+    0x9C, 0xA0, 0xA0, 0x7C, 0x00,  // 'y'
+    0x24, 0x34, 0x2C, 0x24, 0x00,  // 'z'
+    0x08, 0x3E, 0x41, 0x00,  // '{'
+    0x7F, 0x00,  // '|'
+    0x41, 0x3E, 0x08, 0x00,  // '}'
+    0x08, 0x04, 0x08, 0x04, 0x00,  // '~'
+};
+
+static const uint16_t Font8H_offsets[] = {
+       0,    3,    5,    9,   15,   21,   28,   34,   36,   40,   44,   50,
+      56,   59,   64,   66,   70,   75,   79,   84,   89,   94,   99,  104,
+     109,  114,  119,  121,  124,  128,  133,  137,  142,  149,  155,  161,
+     167,  173,  179,  185,  191,  197,  199,  205,  210,  215,  223,  229,
+     235,  241,  247,  253,  259,  265,  271,  277,  283,  289,  295,  301,
+     304,  308,  311,  315,  320,  323,  329,  334,  338,  343,  348,  353,
+     358,  363,  365,  369,  373,  376,  382,  387,  392,  397,  402,  407,
+     412,  416,  421,  425,  431,  435,  440,  445,  449,  451,  455,
+};
+
+static const uint8_t Font8H_width[] = {
+    3, 2, 4, 6, 6, 7, 6, 2, 4, 4, 6, 6, 3, 5, 2, 4,
+    5, 4, 5, 5, 5, 5, 5, 5, 5, 5, 2, 3, 4, 5, 4, 5,
+    7, 6, 6, 6, 6, 6, 6, 6, 6, 2, 6, 5, 5, 8, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 3, 4, 3, 4, 5,
+    3, 6, 5, 4, 5, 5, 5, 5, 5, 2, 4, 4, 3, 6, 5, 5,
+    5, 5, 5, 5, 4, 5, 4, 6, 4, 5, 5, 4, 2, 4, 5,
+};
+
+static const int8_t Font8H_y_offset[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+const SH1106_Font_t Font_8H = {
+    .width = 8,
+    .height = 8,
+    .data = NULL,
+    .char_width = Font8H_width,
+    .y_offset = Font8H_y_offset,
+    .baseline = 5,
+    .cols = Font8H_cols,
+    .offsets = Font8H_offsets,
+    .format = SH1106_FONT_PAGES
+};
+
+#endif /* SH1106_INCLUDE_FONT_8H */
+
+#endif /* SH1106_PACKED_FONTS */
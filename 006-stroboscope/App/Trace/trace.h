@@ -0,0 +1,128 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+
+/* deferred binary logging (HAL-free; the application tells the running
+ * priority level and sends the words out).
+ *
+ * a trace point stores no text, only the id of its format string, a
+ * timestamp and up to four 32-bit arguments, ~20 cycles in an ISR:
+ *
+ *   TRACE(&htrace, "tare at code %d", tare);
+ *
+ * the formats go to the section trace_fmt, which the linker scripts keep
+ * in the ELF as a non-loaded (INFO) section: no flash is used, and the id
+ * is the offset of the string in that section. tools/trace_decode.c reads
+ * them back from the ELF and prints the records as text. the arguments
+ * are raw words: %d %i %u %x %X %o %c %p with flags and width, no %s
+ * (the decoder has no access to the target memory).
+ *
+ * there is one ring per priority level, the application maps the running
+ * context to its ring (level callback, thread mode 0 and one per
+ * preemption priority in use). a ring has a single producer that way: a
+ * level is only ever interrupted by higher levels, which do not write to
+ * it, and a record is committed by one store of head after its words are
+ * in, so a record is never seen half written and no interrupt is masked.
+ * a full ring drops the record and counts it; the next record of that
+ * ring that fits is preceded by a drop record (TRACE_ID_DROP) with the
+ * count.
+ *
+ * Trace_Drain runs in thread mode, in idle time: it merges the rings by
+ * timestamp and hands the words to put (ITM stimulus port on the target).
+ * records come out in the order of their timestamps: a record takes its
+ * time before it is committed, and a level that preempts the drainer
+ * finishes before the drainer looks at the heads again.
+ *
+ * record: header, timestamp, 0..4 args
+ *   header  31..16 format id  15..12 level  11..8 arg count  7..0 0xA5
+ *
+ * the timestamp is DWT->CYCCNT on the Cortex-M (enabled by the
+ * application, TRCENA + CYCCNTENA) and CLOCK_MONOTONIC nanoseconds on a
+ * host. TRACE_ENABLE 0 compiles the trace points to nothing. */
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE        1
+#endif
+
+#define TRACE_SYNC          0xA5u
+#define TRACE_ID_DROP       0xFFFFu     /* 1 arg: records dropped      */
+#define TRACE_MAX_ARGS      4u
+#define TRACE_MAX_WORDS     (2u + TRACE_MAX_ARGS)
+
+#if defined(TRACE_CLOCK)
+uint32_t TRACE_CLOCK(void);             /* bench clock, -DTRACE_CLOCK=fn */
+#elif defined(__arm__)
+/* DWT->CYCCNT, addressed directly to keep the module free of CMSIS */
+#define TRACE_CLOCK()       (*(volatile uint32_t *)0xE0001004UL)
+#else
+uint32_t Trace_HostClock(void);
+#define TRACE_CLOCK()       Trace_HostClock()
+#endif
+
+/* host benches only: called where an interrupt would hurt most */
+#if defined(TRACE_PREEMPT_POINT)
+void TRACE_PREEMPT_POINT(void);
+#else
+#define TRACE_PREEMPT_POINT()   do { } while (0)
+#endif
+
+typedef struct {
+    /* set by the application before Trace_Init */
+    uint32_t         *buf;
+    uint32_t          size;         /* words, power of two             */
+
+    volatile uint32_t head;         /* words written, producer         */
+    volatile uint32_t tail;         /* words taken, Trace_Drain        */
+    volatile uint32_t dropped;      /* records that did not fit        */
+    uint32_t          dropped_told; /* of those, in drop records       */
+} Trace_Ring_t;
+
+typedef struct {
+    /* set by the application before Trace_Init */
+    Trace_Ring_t *ring;             /* index = level                   */
+    uint8_t       count;
+    uint8_t     (*level)(void);     /* ring of the running context,
+                                     * count or more: not traced       */
+    int         (*put)(uint32_t w); /* one word out, nonzero if busy   */
+
+    uint32_t      lost;             /* records cut off by a busy put   */
+} Trace_Handle_t;
+
+#if TRACE_ENABLE
+/* format string section, start provided by the linker */
+extern const char __start_trace_fmt[];
+
+#define TRACE_NARGS_(_0, _1, _2, _3, _4, _5, n, ...)  n
+#define TRACE_NARGS(...)    TRACE_NARGS_(_, ##__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define TRACE_ARGS_(h, hdr, a0, a1, a2, a3, ...) \
+    Trace_Log((h), (hdr), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3))
+
+#define TRACE(h, fmt, ...)                                                         \
+    do {                                                                           \
+        static const char trace_fmt_[]                                             \
+            __attribute__((section("trace_fmt"), used)) = fmt;                     \
+        _Static_assert(TRACE_NARGS(__VA_ARGS__) <= TRACE_MAX_ARGS,                 \
+                       "TRACE takes up to 4 arguments");                           \
+        TRACE_ARGS_((h), ((uint32_t)((uintptr_t)trace_fmt_ -                       \
+                                     (uintptr_t)__start_trace_fmt) << 16) |        \
+                         ((uint32_t)TRACE_NARGS(__VA_ARGS__) << 8) | TRACE_SYNC,   \
+                    ##__VA_ARGS__, 0, 0, 0, 0);                                    \
+    } while (0)
+#else
+#define TRACE(h, fmt, ...)  do { } while (0)
+#endif
+
+/* empty rings */
+void     Trace_Init(Trace_Handle_t *h);
+
+/* one record, from TRACE: hdr without the level */
+void     Trace_Log(Trace_Handle_t *h, uint32_t hdr,
+                   uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+/* thread mode only: up to max_words words to put, oldest record first,
+ * whole records only. stops early when put is busy at the start of a
+ * record (the record stays). returns the words sent. */
+uint32_t Trace_Drain(Trace_Handle_t *h, uint32_t max_words);
+
+#endif /* __TRACE_H__ */
@@ -0,0 +1,82 @@
+/* Core/Inc/strobe_calc.h */
+
+#ifndef STROBE_CALC_H
+#define STROBE_CALC_H
+
+#include <stdint.h>
+
+/* strobe timer register math, kept free of HAL so it can be checked on
+ * the host against a model of TIM3/TIM1.
+ *
+ * TIM3 (100 MHz timer clock) sets the strobe period and the flash window:
+ *
+ *   tick          = (PSC + 1) / 100 MHz
+ *   period_ticks  = ARR + 1
+ *   window_ticks  = CCR1          (OC1REF high while CNT < CCR1)
+ *
+ * PSC is the smallest one that keeps the period within 16-bit ARR, so the
+ * resolution near 1 kHz is 20 ns instead of 0.1 ms. PSC+1 is always a
+ * divisor of the TIM1 PWM period (10000 clocks) and the window is a whole
+ * number of PWM periods: a gate window then never cuts a PWM period and
+ * TIM1 always stops at CNT=0.
+ *
+ * the ideal period is rarely a whole number of ticks. ARR is either the
+ * nearest tick, or arr_lo and arr_lo+1 are alternated by a Q0.32 phase
+ * accumulator (Strobe_DitherARR, once per period) so that the average
+ * period matches the requested frequency.
+ *
+ * a phase shift is a one-off change of the period: one (or a few) periods
+ * run longer or shorter through the preloaded ARR, and every later flash
+ * moves by that much. Nothing is stopped, so no flash is lost. */
+
+#define STROBE_TIM_CLK_HZ    100000000UL    /* TIM1 and TIM3 kernel clock     */
+#define STROBE_TIM1_PSC             9u      /* TIM1 counts at 10 MHz          */
+#define STROBE_TIM1_ARR           999u      /* 10 kHz brightness PWM          */
+
+/* TIM1 PWM period in timer clocks, the unit of a flash window */
+#define STROBE_PWM_PERIOD_CLK  ((STROBE_TIM1_PSC + 1u) * (STROBE_TIM1_ARR + 1u))
+
+typedef struct {
+    uint16_t psc;       /* TIM3 PSC                                     */
+    uint16_t arr;       /* TIM3 ARR, nearest tick: period = ARR+1 ticks */
+    uint16_t ccr;       /* TIM3 CCR1: flash window in ticks             */
+    uint16_t arr_lo;    /* ARR with the fractional tick dropped         */
+    uint32_t frac;      /* dropped fraction of a tick, Q0.32            */
+} Strobe_Timing_t;
+
+/* TIM3 setting for a frequency (mHz) and a duty of num/den of the period.
+ * the window is rounded down to whole PWM periods, at least one. */
+void Strobe_CalcTiming(uint32_t freq_mhz, uint32_t duty_num, uint32_t duty_den,
+                       Strobe_Timing_t *t);
+
+/* same for a period in timer clocks, Q24.8 (the tach PLL output).
+ * the caller keeps the period inside the frequency range. */
+void Strobe_CalcTimingPeriod(uint64_t period_q8, uint32_t duty_num, uint32_t duty_den,
+                             Strobe_Timing_t *t);
+
+/* flash window for an existing PSC and the shortest ARR in use (arr_lo),
+ * rounded down to whole PWM periods within ARR, at least one */
+uint16_t Strobe_CalcWindow(uint16_t psc, uint16_t arr, uint32_t duty_num, uint32_t duty_den);
+
+/* ARR for the next period when dithering. acc is the phase accumulator,
+ * start it at 0 with arr_lo loaded; call once per update event. */
+uint16_t Strobe_DitherARR(const Strobe_Timing_t *t, uint32_t *acc);
+
+/* phase shift of deg/360 of the period in TIM3 ticks, folded into
+ * -period/2..+period/2 so the flash takes the shorter way round.
+ * positive = later flashes. */
+int32_t Strobe_CalcPhaseTicks(const Strobe_Timing_t *t, int32_t deg);
+
+/* ARR for the next period with *pending ticks of phase shift folded in:
+ * the period is lengthened (up to ARR 65535) or shortened (down to the
+ * window, ccr), the other way round by a whole period if only that fits.
+ * whole periods in *pending are dropped, they would not move the flash.
+ * what did not fit is left in *pending for the next period. */
+uint16_t Strobe_PhaseARR(uint16_t arr, uint16_t ccr, int32_t *pending);
+
+/* TIM1 CCR1 in PWM mode 2 for on_counts of the TIM1 period lit.
+ * PWM2 is inactive at CNT=0, where a closed gate leaves TIM1, so the LED
+ * can never be frozen on; on_counts is therefore limited to ARR. */
+uint16_t Strobe_CalcGatedCompare(uint32_t on_counts);
+
+#endif /* STROBE_CALC_H */
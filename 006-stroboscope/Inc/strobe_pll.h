@@ -0,0 +1,63 @@
+/* Core/Inc/strobe_pll.h */
+
+#ifndef STROBE_PLL_H
+#define STROBE_PLL_H
+
+#include <stdint.h>
+
+/* tachometer tracking for the strobe, free of HAL like strobe_calc.
+ * all times are 100 MHz timer clocks.
+ *
+ * tach filter: every pulse period goes through a median of the last
+ * STROBE_TACH_MEDIAN periods (a missed or doubled pulse is dropped) and
+ * then a first order IIR (1/STROBE_TACH_IIR per pulse).
+ *
+ * PLL: the strobe runs `mult` flashes per `div` tach pulses. On every
+ * div-th pulse (the reference) the time to the next flash is compared
+ * with the wanted delay, folded into +-half a strobe period, and a PI
+ * loop trims the strobe period:
+ *
+ *   period = tach * div / mult - (e/2 + I) / mult,   I += e/4
+ *
+ * the tach period is the feed-forward, so the loop only has to remove
+ * the phase error and the lag of the filter. */
+
+#define STROBE_TACH_MEDIAN   5u     /* odd, periods in the median window  */
+#define STROBE_TACH_IIR      2u     /* IIR divisor, power of two          */
+
+#define STROBE_PLL_LOCK_IN   8u     /* references within 1/64 period      */
+
+typedef struct {
+    uint32_t hist[STROBE_TACH_MEDIAN];
+    uint8_t  count;         /* valid entries in hist                      */
+    uint8_t  pos;           /* next slot in hist                          */
+    uint64_t period_q8;     /* filtered tach period, clocks Q24.8         */
+} Strobe_Tach_t;
+
+typedef struct {
+    uint16_t mult;          /* flashes ...                                */
+    uint16_t div;           /* ... per div tach pulses                    */
+    uint16_t delay_deg;     /* flash after the reference, 0..359 degrees
+                             * of the strobe period                       */
+    uint16_t pulse;         /* tach pulses since the last reference       */
+    int64_t  integ_q8;      /* integrator, clocks Q.8                     */
+    int32_t  error;         /* last phase error, clocks, + = flash late   */
+    uint8_t  good;          /* references in a row within the lock window */
+    uint8_t  locked;
+} Strobe_Pll_t;
+
+void     Strobe_TachReset(Strobe_Tach_t *t);
+
+/* add one tach period, return the filtered period (Q24.8) */
+uint64_t Strobe_TachFilter(Strobe_Tach_t *t, uint32_t period);
+
+/* mult/div and delay_deg are kept, the loop state is cleared */
+void     Strobe_PllReset(Strobe_Pll_t *p);
+
+/* one tach pulse. tach_q8 is the filtered tach period, to_flash the time
+ * from the pulse to the next flash. returns 1 on a reference pulse with
+ * the new strobe period (Q24.8) in *period_q8, 0 otherwise. */
+uint8_t  Strobe_PllEdge(Strobe_Pll_t *p, uint64_t tach_q8, int32_t to_flash,
+                        uint64_t *period_q8);
+
+#endif /* STROBE_PLL_H */
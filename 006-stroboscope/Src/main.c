@@ -8,8 +8,15 @@
   *
   * TIM1_CH1 (PA8) -- LED brightness PWM, 10 kHz
   * TIM2           -- EC11 rotary encoder (PA0/PA1)
-  * TIM3           -- strobe timer, Update + CC1 interrupts
-  * I2C1           -- SH1106 display (PB6/PB7)
+  * TIM3           -- strobe timer. STROBE_HW_GATE=1: CH1 OC1REF gates TIM1
+  *                   through TRGO (no ISR in the flash), CH3 mirrors it on PB0.
+  *                   STROBE_HW_GATE=0: Update + CC1 interrupts
+  *                   PSC chosen per frequency, ARR dithered (STROBE_DITHER),
+  *                   phase and drift applied from the Update ISR
+  * TIM4_CH3 (PB8)  -- tach input capture, 100 MHz, extended to 32 bits
+  * I2C1           -- SH1106 display (PB6/PB7), TX via DMA1 Stream6
+  * USART1         -- command lines, 115200 8N1 (PA9 TX, PA10 RX). RX via
+  *                   DMA2 Stream2 (circular ring), TX via DMA2 Stream7
   *
   * Display note: pixel rows 1-8 (1-indexed from top) are partially broken.
   * Nothing is drawn above y=11 (0-indexed).
@@ -20,6 +27,11 @@
   *   SCREEN_MAIN   -- big 7-segment frequency display, encoder adjusts freq
   *   SCREEN_DUTY   -- duty cycle settings, encoder adjusts duty
   *   SCREEN_BRIGHT -- brightness settings, encoder adjusts brightness
+  *   SCREEN_PHASE  -- encoder nudges the flash phase (degrees)
+  *   SCREEN_DRIFT  -- encoder sets a drift (slow motion) offset in Hz
+  *   SCREEN_TACH   -- encoder picks the tach ratio (OFF = internal)
+  *   SCREEN_DIAG   -- hidden, Debug builds: execution times (App/Prof),
+  *                    BTN2 hold enters, BTN2 short leaves
   *
   * Frequency stored as millihertz (g_freq_mhz). Step multiplier sets
   * the Hz-linear step per encoder detent:
@@ -36,14 +48,35 @@
   *   PERC mode : 10-100%, step 1%
   *   DIV mode  : 1/N, N=10-200, step 1
   *
+  * Phase -- step 1/10/100 degrees per click. Applied by lengthening or
+  *   shortening the next period(s), the strobe keeps running.
+  * Drift -- +-10 Hz added to the frequency, step 0.01/0.1/1 Hz. The
+  *   machine then seems to turn slowly at the drift rate. Applied at the
+  *   next period without stopping the strobe.
+  * Tach -- the strobe follows pulses on PB8 through a software PLL,
+  *   flashes per pulse from a ratio table (1/8 .. 8/1). The phase screen
+  *   then sets the delay after the pulse; frequency and drift are locked.
+  *
   * Controls:
   *   Encoder push   -- short: cycle step multiplier (x1/x10/x100)
   *                     hold:  save to flash
-  *   Bottom button  -- short: cycle screens (main->duty->bright->main)
+  *   Bottom button  -- short: cycle screens (main->duty->bright->phase->drift->tach)
+  *                     hold:  diag screen (Debug builds)
   *   Top button     -- short: strobe on/off
   *                     hold:  reset all to defaults
   *
-  * Flash storage (sector 7, 0x08060000, 128 KB).
+  * Commands (USART1, one per line, "help" lists them): freq, duty,
+  *   bright, phase, drift, tach, run, save, reset, get. Each is answered
+  *   with OK or ERR <reason>; see App/Cmd/cmd.h and the readme.
+  *
+  * Flash storage: settings log in sectors 6 and 7 (0x08040000, 2 x 128 KB),
+  * one record appended per save (App/CfgLog). The linker script ends the
+  * program at 0x08040000.
+  *
+  * Deferred log (App/Trace): TRACE points in the timer ISRs and the main
+  * loop store a format id and raw arguments; the main loop sends them on
+  * ITM port 1 while a debugger is attached, tools/trace_decode.c prints
+  * them with the strings from the ELF.
   *
   * NOTE: TIM3_IRQHandler is defined here (USER CODE 0).
   * In stm32f4xx_it.c comment out the body of TIM3_IRQHandler:
@@ -51,14 +84,18 @@
   *   {
   *       // HAL_TIM_IRQHandler(&htim3);
   *   }
+  * TIM4 (tach) is set up in Tach_Init, not by CubeMX; TIM4_IRQHandler is
+  * defined here too.
   ******************************************************************************
   */
 /* USER CODE END Header */
 
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "i2c.h"
 #include "tim.h"
+#include "usart.h"
 #include "gpio.h"
 
 /* USER CODE BEGIN Includes */
@@ -68,11 +105,19 @@
 #include "sh1106_fonts.h"
 #include "EC11.h"
 #include "big_freq.h"
+#include "strobe_calc.h"
+#include "strobe_pll.h"
+#include "cfg_log.h"
+#include "cmd.h"
+#include "prof.h"
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
-typedef enum { SCREEN_MAIN = 0, SCREEN_DUTY, SCREEN_BRIGHT, SCREEN_COUNT } Screen_t;
+typedef enum { SCREEN_MAIN = 0, SCREEN_DUTY, SCREEN_BRIGHT,
+               SCREEN_PHASE, SCREEN_DRIFT, SCREEN_TACH, SCREEN_COUNT,
+               SCREEN_DIAG /* not in the BTN2 cycle */ }                    Screen_t;
 typedef enum { DUTY_MODE_PERC = 0, DUTY_MODE_DIV }                         DutyMode_t;
 typedef enum { BRIG_MODE_PERC = 0, BRIG_MODE_DIV }                         BrigMode_t;
 
@@ -87,9 +132,9 @@ typedef struct {
     uint32_t      press_time;   /* timestamp of current press start       */
 } Button_t;
 
-/* settings saved to flash */
+/* settings saved to flash, one settings log record (the log adds seq,
+ * version and CRC-32) */
 typedef struct {
-    uint32_t  magic;
     uint32_t  freq_mhz;
     uint8_t   step_idx;
     uint8_t   duty_mode;
@@ -100,8 +145,52 @@ typedef struct {
     uint32_t  brig_val;
     uint8_t   running;
     uint8_t   _pad2[3];
-    uint32_t  checksum;
+    int32_t   drift_mhz;
+    uint8_t   tach_ratio;
+    uint8_t   _pad3;
+    uint16_t  tach_delay;
 } FlashConfig_t;
+
+/* the single record of firmware before the settings log, erased and
+ * rewritten on every save at the start of sector 7 */
+typedef struct {
+    uint32_t  magic;
+    uint32_t  freq_mhz;
+    uint8_t   step_idx;
+    uint8_t   duty_mode;
+    uint8_t   _pad0[2];
+    uint32_t  duty_val;
+    uint8_t   brig_mode;
+    uint8_t   _pad1[3];
+    uint32_t  brig_val;
+    uint8_t   running;
+    uint8_t   _pad2[3];
+    uint32_t  checksum;     /* XOR of the bytes before it */
+} FlashLegacy_t;
+
+/* execution time zones (PROF_BEGIN / PROF_END) */
+typedef enum {
+    PZ_LOOP = 0,        /* one main loop pass                     */
+    PZ_TIM3,            /* strobe timer ISR                       */
+    PZ_TIM4,            /* tach capture ISR, PLL step             */
+    PZ_I2C,             /* I2C DMA done: next SH1106 page         */
+    PZ_ENCODER,         /* Encoder_Process, retune included       */
+    PZ_TACH,            /* Tach_Poll                              */
+    PZ_CMD,             /* Cmd_Poll with the handlers             */
+    PZ_DISPLAY,         /* Display_Update, drawing                */
+    PZ_OLED,            /* SH1106_UpdateScreenAsync, frame start  */
+    PZ_TRACE,           /* Trace_Drain to the ITM                 */
+    PZ_COUNT
+} ProfZone_t;
+
+/* trace rings, one per preemption priority that logs */
+typedef enum {
+    TL_THREAD = 0,      /* main loop                              */
+    TL_COMM,            /* priority 5: I2C1, USART1, their DMA    */
+    TL_TACH,            /* priority 3: TIM4 capture, PLL          */
+    TL_STROBE,          /* priority 2: TIM3 update                */
+    TL_COUNT
+} TraceLevel_t;
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
@@ -119,8 +208,8 @@ typedef struct {
 #define BTN3_PIN   GPIO_PIN_4
 
 /* frequency in millihertz.
- * at FREQ_MHZ_MIN=153: ARR = 10000000/153 - 1 = 65358 (fits 16-bit).
- * at FREQ_MHZ_MAX=1000000: ARR = 9. */
+ * at FREQ_MHZ_MIN=153:     PSC = 9999, ARR = 65358 (fits 16-bit).
+ * at FREQ_MHZ_MAX=1000000: PSC = 1,    ARR = 49999. */
 #define FREQ_MHZ_MIN         153u
 #define FREQ_MHZ_MAX     1000000u
 #define FREQ_MHZ_INIT      30000u   /* 30.0 Hz */
@@ -136,6 +225,13 @@ typedef struct {
 #define DUTY_DIV_MAX         200u
 #define DUTY_DIV_STEP          5u
 
+/* phase nudge -- degrees per click at x1 */
+#define PHASE_STEP_DEG         1
+
+/* drift -- offset added to the frequency for slow motion */
+#define DRIFT_MHZ_MAX      10000    /* +-10 Hz */
+#define DRIFT_STEP_MHZ        10    /* x1 = 0.01 Hz per click */
+
 /* brightness -- percent mode */
 #define BRIG_PERC_MIN         10u
 #define BRIG_PERC_MAX        100u
@@ -146,20 +242,56 @@ typedef struct {
 #define BRIG_DIV_MAX         200u
 #define BRIG_DIV_STEP          1u
 
-/* TIM1: PSC=9, ARR=999 -> 10 kHz PWM */
-#define TIM1_PWM_ARR         999u
-
-/* TIM3: PSC=9999 -> tick = 0.1 ms, 10,000,000 mHz per second */
-#define TIM3_MHZ_RATE     10000000u
-
-/* flash -- last sector of STM32F411CE (512 KB) */
-#define FLASH_CONFIG_SECTOR  FLASH_SECTOR_7
-#define FLASH_CONFIG_ADDR    0x08060000UL
-#define FLASH_CONFIG_MAGIC   0x5752B008UL
+/* strobe generation.
+ * 1: TIM3 OC1REF -> TRGO -> TIM1 gated slave (ITR2), flash edges come
+ *    from hardware only. TIM1 runs PWM mode 2, PB0 is TIM3_CH3 (AF2).
+ * 0: TIM3 Update/CC1 ISR writes TIM1 CCR1, PB0 and PC13. */
+#define STROBE_HW_GATE         1u
+
+/* TIM3 ticks that must be left before the update event for the CC1
+ * interrupt to load a new brightness with TIM1 UG: covers the register
+ * accesses between its check and the UG (64 clocks at PSC+1 = 2) */
+#define STROBE_UG_MARGIN_TICKS 32u
+
+/* 1: alternate ARR between two neighbouring ticks from the TIM3 update
+ *    interrupt so the average period hits the millihertz setting */
+#define STROBE_DITHER          1u
+
+/* tach input -- TIM4_CH3 on PB8 (AF2), counting 100 MHz timer clocks.
+ * pulses closer than TACH_PERIOD_MIN_CLK are contact bounce or noise. */
+#define TACH_IC_FILTER         8u       /* fDTS/8, N=6 at 25 MHz: ~2 us   */
+#define TACH_PERIOD_MIN_CLK 10000u      /* 10 kHz                         */
+#define TACH_TIMEOUT_PERIODS   3u       /* missed periods until NO TACH   */
+#define TACH_TIMEOUT_MIN_MS   50u
+#define TACH_TIMEOUT_FIRST_MS 10000u    /* wait for the second pulse      */
+#define TACH_RATIO_COUNT      10u
+
+/* strobe period limits for the PLL output, Q24.8 clocks, and the
+ * numerator that turns a Q24.8 period into millihertz */
+#define TACH_MHZ_Q8          ((uint64_t)STROBE_TIM_CLK_HZ * 1000u * 256u)
+#define TACH_PERIOD_Q8_MIN   (TACH_MHZ_Q8 / FREQ_MHZ_MAX)
+#define TACH_PERIOD_Q8_MAX   (TACH_MHZ_Q8 / FREQ_MHZ_MIN)
+
+/* flash -- settings log in the last two sectors of STM32F411CE (512 KB) */
+#define FLASH_CONFIG_SECTOR0 FLASH_SECTOR_6
+#define FLASH_CONFIG_ADDR0   0x08040000UL
+#define FLASH_CONFIG_SECTOR1 FLASH_SECTOR_7
+#define FLASH_CONFIG_ADDR1   0x08060000UL
+#define FLASH_CONFIG_SIZE    (128UL * 1024UL)
+#define FLASH_CONFIG_SLOT    64u             /* record slot, bytes          */
+#define FLASH_CONFIG_VERSION 11u             /* bump when FlashConfig_t changes */
+#define FLASH_LEGACY_ADDR    FLASH_CONFIG_ADDR1
+#define FLASH_LEGACY_MAGIC   0x5752B008UL
 
 /* notification duration */
 #define NOTIFY_DURATION_MS   600u
 
+/* commands -- USART1 RX ring (circular DMA, power of two) and the two
+ * TX buffers: one is sent while the answers go into the other */
+#define CMD_RX_SIZE          256u
+#define CON_TX_SIZE          512u
+#define CON_TX_WAIT_MS       100u    /* for the other buffer, on a burst */
+
 /* display layout -- nothing drawn above y=11 (rows 1-8 are broken).
  * status bar: y=53..63, height=11. */
 #define ROW_TOP_Y            11
@@ -167,6 +299,15 @@ typedef struct {
 #define STATUSBAR_Y          53
 #define STATUSBAR_H          11
 #define STATUSBAR_TEXT_Y     55
+
+/* execution times (App/Prof, PROF_ENABLE: Debug builds) on SCREEN_DIAG:
+ * encoder scrolls, BTN1 short = dump over ITM, BTN1 hold = clear */
+#define DIAG_ROWS            3u
+
+/* deferred log (App/Trace, TRACE_ENABLE): drained to ITM port 1 in idle
+ * time, a few records per loop pass */
+#define TRACE_ITM_PORT       1u
+#define TRACE_DRAIN_WORDS    32u     /* ~0.8 ms of SWO at 2 Mbit/s */
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -195,6 +336,8 @@ static uint32_t   g_duty_val  = DUTY_PERC_INIT;
 static BrigMode_t g_brig_mode = BRIG_MODE_PERC;
 static uint32_t   g_brig_val  = BRIG_PERC_INIT;
 static uint8_t    g_running   = 1u;
+static int32_t    g_drift_mhz = 0;      /* 0 = drift off */
+static int32_t    g_phase_deg = 0;      /* nudges since start, 0..359 */
 static Screen_t   g_screen    = SCREEN_MAIN;
 
 static Button_t btn1 = { BTN1_PORT, BTN1_PIN, 1, 0, 0, 0, 0, 0 };
@@ -205,21 +348,109 @@ static char     notify_msg[17]    = "";
 static uint32_t notify_time       = (uint32_t)(-NOTIFY_DURATION_MS - 1u);
 static uint32_t last_display_tick = 0u;
 static char     disp_buf[32];
+
+/* current TIM3 setting and ARR dither phase, used by the TIM3 ISR */
+static Strobe_Timing_t   g_timing;
+static uint32_t          g_dither_acc = 0u;
+
+/* phase ticks not yet applied, and the part already in the ARR preload */
+static volatile int32_t  g_phase_pending = 0;
+static int32_t           g_phase_in_arr  = 0;
+
+#if STROBE_HW_GATE
+/* TIM1 compare for the next flash, loaded by the TIM3 CC1 interrupt */
+static volatile uint16_t g_bright_cmp = 0u;
+
+/* for that interrupt: ARR of the running TIM3 period, taken from the
+ * preload by the update interrupt, or by Strobe_Commit if it runs between
+ * an update event and its interrupt (g_arr_run_set). g_wrap_hidden: TIM3
+ * wrapped under UDIS, the running period began with no update flag. */
+static volatile uint16_t g_arr_run     = 0u;
+static volatile uint8_t  g_arr_run_set = 0u;
+static volatile uint8_t  g_wrap_hidden = 0u;
+#endif
+
+/* preloaded period (clocks) and PSC: what the next update event loads */
+static uint32_t          g_period_next = 0u;
+static uint16_t          g_psc_next    = 0u;
+
+/* tach input and PLL, TIM4 ISR. times are TIM4 clocks (g_tach_hi holds
+ * the counted overflows); mult/div/delay_deg of g_pll are the settings. */
+static TIM_HandleTypeDef htim4;
+static Strobe_Tach_t     g_tach;
+static Strobe_Pll_t      g_pll;
+static uint8_t           g_tach_ratio = 0u;            /* 0 = internal */
+static volatile uint32_t g_tach_hi    = 0u;
+static uint32_t          g_tach_last  = 0u;            /* last pulse   */
+static volatile uint8_t  g_tach_seen  = 0u;            /* 2 = period known */
+static volatile uint32_t g_tach_tick  = 0u;            /* HAL tick of the last pulse */
+static volatile uint32_t g_tach_timeout_ms = TACH_TIMEOUT_FIRST_MS;
+static volatile uint32_t g_tach_mhz   = 0u;            /* input, filtered     */
+static volatile uint32_t g_strobe_mhz = 0u;            /* PLL output          */
+static volatile int32_t  g_pll_err_d10 = 0;            /* 0.1 deg, + = late   */
+static volatile uint32_t g_flash_next_t = 0u;          /* TIM4 time, TIM3 ISR */
+
+/* tach ratio: mult flashes per div pulses, index 0 = off */
+static const uint8_t g_tach_mult[TACH_RATIO_COUNT] = { 0u, 1u, 1u, 1u, 1u, 1u, 2u, 3u, 4u, 8u };
+static const uint8_t g_tach_div[TACH_RATIO_COUNT]  = { 0u, 8u, 4u, 3u, 2u, 1u, 1u, 1u, 1u, 1u };
+
+/* settings log, sectors 6/7 */
+static CfgLog_Handle_t g_cfglog;
+
+/* command channel: lines parsed in place from the RX ring */
+static Cmd_Handle_t      g_cmd;
+static uint8_t           g_cmd_rx[CMD_RX_SIZE];
+static uint8_t           g_con_tx[2][CON_TX_SIZE];
+static uint16_t          g_con_tx_len[2];
+static uint8_t           g_con_fill    = 0u;     /* buffer taking answers */
+static volatile uint8_t  g_con_tx_busy = 0u;
+static uint32_t          g_con_dropped = 0u;     /* answer lines lost     */
+
+#if PROF_ENABLE
+/* execution time zones on the DWT cycle counter */
+static Prof_Handle_t     g_prof;
+static Prof_Zone_t       g_prof_zone[PZ_COUNT];
+static const char *const g_prof_name[PZ_COUNT] = {
+    "loop", "tim3", "tim4", "i2c", "encoder", "tach", "cmd", "display", "oled", "trace"
+};
+static uint8_t           g_diag_first = 0u;      /* first row shown       */
+#endif
+
+#if TRACE_ENABLE
+/* deferred log, one ring per level */
+static Trace_Handle_t    g_trace;
+static uint32_t          g_trace_buf_thread[256];
+static uint32_t          g_trace_buf_comm[32];
+static uint32_t          g_trace_buf_tach[128];
+static uint32_t          g_trace_buf_strobe[64];
+static Trace_Ring_t      g_trace_ring[TL_COUNT] = {
+    [TL_THREAD] = { .buf = g_trace_buf_thread, .size = 256u },
+    [TL_COMM]   = { .buf = g_trace_buf_comm,   .size = 32u  },
+    [TL_TACH]   = { .buf = g_trace_buf_tach,   .size = 128u },
+    [TL_STROBE] = { .buf = g_trace_buf_strobe, .size = 64u  },
+};
+#endif
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 
 /* USER CODE BEGIN PFP */
-static uint32_t  Strobe_GetARR(void);
 static void      Strobe_ApplyFreq(void);
+static void      Strobe_Commit(const Strobe_Timing_t *t);
+static void      Strobe_Retune(void);
+static void      Strobe_PhaseShift(int32_t deg);
 static void      Strobe_ApplyDuty(void);
 static void      Strobe_SetRunning(uint8_t on);
-static uint32_t  Duty_GetCCR(uint32_t arr);
+static void      Strobe_ApplyBright(void);
+static void      Tach_Init(void);
+static void      Tach_SetRatio(uint8_t idx);
+static void      Tach_Poll(void);
 static uint32_t  Duty_GetPerc(void);
 static uint32_t  Duty_GetDivisor(void);
 static void      Duty_Increase(void);
 static void      Duty_Decrease(void);
+static uint32_t  Freq_GetEffective(void);
 static uint32_t  Brig_GetCCR(void);
 static uint32_t  Brig_GetPerc(void);
 static uint32_t  Brig_GetDivisor(void);
@@ -229,14 +460,34 @@ static void      Apply_Defaults(void);
 static void      Button_Poll(Button_t *b);
 static void      Encoder_Process(void);
 static void      Display_Update(void);
-static uint32_t  Config_Checksum(const FlashConfig_t *c);
 static void      Flash_SaveConfig(void);
 static void      Flash_LoadConfig(void);
+static uint8_t   Flash_LoadLegacy(FlashConfig_t *cfg);
+static int       Flash_LogProgram(uint8_t area, uint32_t offset, const uint32_t *words, uint32_t count);
+static int       Flash_LogErase(uint8_t area);
 static void      Notify(const char *msg);
+static void      Console_Start(void);
+static void      Console_Flush(void);
+#if PROF_ENABLE
+static void      Diag_Dump(void);
+#endif
+#if TRACE_ENABLE
+static uint8_t   Trace_Level(void);
+static int       Trace_ItmPut(uint32_t w);
+#endif
 /* USER CODE END PFP */
 
 /* USER CODE BEGIN 0 */
 
+/* frequency the strobe runs at: base plus drift, kept in range */
+static uint32_t Freq_GetEffective(void)
+{
+    int32_t f = (int32_t)g_freq_mhz + g_drift_mhz;
+    if (f < (int32_t)FREQ_MHZ_MIN) f = (int32_t)FREQ_MHZ_MIN;
+    if (f > (int32_t)FREQ_MHZ_MAX) f = (int32_t)FREQ_MHZ_MAX;
+    return (uint32_t)f;
+}
+
 /* brightness helpers */
 static uint32_t Brig_GetPerc(void)
 {
@@ -254,9 +505,9 @@ static uint32_t Brig_GetCCR(void)
 {
     uint32_t ccr;
     if (g_brig_mode == BRIG_MODE_PERC)
-        ccr = ((TIM1_PWM_ARR + 1u) * g_brig_val) / 100u;
+        ccr = ((STROBE_TIM1_ARR + 1u) * g_brig_val) / 100u;
     else
-        ccr = (TIM1_PWM_ARR + 1u) / g_brig_val;
+        ccr = (STROBE_TIM1_ARR + 1u) / g_brig_val;
     if (ccr == 0u) ccr = 1u;
     return ccr;
 }
@@ -294,14 +545,11 @@ static uint32_t Duty_GetDivisor(void)
     return (100u + g_duty_val / 2u) / g_duty_val;
 }
 
-static uint32_t Duty_GetCCR(uint32_t arr)
+/* duty as a fraction num/den of the period */
+static void Duty_GetFraction(uint32_t *num, uint32_t *den)
 {
-    uint32_t ccr = (g_duty_mode == DUTY_MODE_PERC)
-                   ? ((arr + 1u) * g_duty_val) / 100u
-                   : (arr + 1u) / g_duty_val;
-    if (ccr == 0u) ccr = 1u;
-    if (ccr > arr) ccr = arr;
-    return ccr;
+    if (g_duty_mode == DUTY_MODE_PERC) { *num = g_duty_val; *den = 100u; }
+    else                               { *num = 1u;         *den = g_duty_val; }
 }
 
 static void Duty_Increase(void)
@@ -324,80 +572,495 @@ static void Duty_Decrease(void)
     }
 }
 
-/* frequency helpers */
-static uint32_t Strobe_GetARR(void)
+/* ARR to start a period with: the dither base or the nearest tick */
+static uint16_t Strobe_StartARR(void)
+{
+#if STROBE_DITHER
+    if (g_timing.frac != 0u) return g_timing.arr_lo;
+#endif
+    return g_timing.arr;
+}
+
+/* TIM4 time in 32 bits. runs with the TIM4 overflow handling held off
+ * (TIM3 ISR, TIM4 ISR): an overflow not yet counted shows as UIF, and it
+ * came before CNT if CNT is still in the low half. */
+static uint32_t Tach_Now(void)
+{
+    uint32_t hi  = g_tach_hi;
+    uint32_t cnt = htim4.Instance->CNT;
+    if ((htim4.Instance->SR & TIM_SR_UIF) && cnt < 0x8000u) hi += 0x10000u;
+    return hi | cnt;
+}
+
+/* per-period work of the TIM3 update interrupt. PSC, ARR and CCR are
+ * preloaded, so whatever is written here sets the next period and the
+ * running one is never cut: ARR gets the dither step and any phase shift
+ * still pending. In tach mode the time of the next flash is noted for
+ * the PLL: the flash starts at the update event. */
+static void Strobe_UpdateEvent(void)
+{
+    uint16_t arr, base;
+    int32_t  phase;
+
+#if STROBE_HW_GATE
+    if (!g_arr_run_set) g_arr_run = (uint16_t)htim3.Instance->ARR;
+    g_arr_run_set = 0u;
+    g_wrap_hidden = 0u;
+#endif
+
+    /* the period that just started is the one preloaded last time */
+    if (g_tach_ratio != 0u)
+        g_flash_next_t = Tach_Now() - htim3.Instance->CNT * ((uint32_t)g_psc_next + 1u)
+                         + g_period_next;
+
+    arr = g_timing.arr;
+#if STROBE_DITHER
+    if (g_timing.frac != 0u) arr = Strobe_DitherARR(&g_timing, &g_dither_acc);
+#endif
+
+    base  = arr;
+    phase = g_phase_pending;
+    if (phase != 0) {
+        arr = Strobe_PhaseARR(arr, g_timing.ccr, &phase);
+        g_phase_pending = phase;
+        TRACE(&g_trace, "phase step %d ticks, %d left", (int32_t)arr - (int32_t)base, phase);
+    }
+    g_phase_in_arr = (int32_t)arr - (int32_t)base;
+
+    __HAL_TIM_SET_AUTORELOAD(&htim3, arr);
+    g_period_next = ((uint32_t)arr + 1u) * ((uint32_t)g_timing.psc + 1u);
+    g_psc_next    = g_timing.psc;
+}
+
+#if STROBE_HW_GATE
+/* hardware gate setup, run once before TIM1 is started.
+ * TIM3 CH1 (PWM1) holds OC1REF high for the flash window and drives TRGO;
+ * TIM1 counts only while its ITR2 (= TIM3 TRGO) is high. A window is a
+ * whole number of TIM3 ticks = whole TIM1 periods, so TIM1 always stops
+ * at CNT=0, where PWM mode 2 keeps the LED off. */
+static void Strobe_HwInit(void)
+{
+    TIM_MasterConfigTypeDef master = {0};
+    TIM_SlaveConfigTypeDef  slave  = {0};
+    TIM_OC_InitTypeDef      oc     = {0};
+    GPIO_InitTypeDef        gpio   = {0};
+
+    oc.OCMode       = TIM_OCMODE_PWM1;
+    oc.Pulse        = 0u;
+    oc.OCPolarity   = TIM_OCPOLARITY_HIGH;
+    oc.OCNPolarity  = TIM_OCNPOLARITY_HIGH;
+    oc.OCFastMode   = TIM_OCFAST_DISABLE;
+    oc.OCIdleState  = TIM_OCIDLESTATE_RESET;
+    oc.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+    HAL_TIM_PWM_ConfigChannel(&htim3, &oc, TIM_CHANNEL_1);
+    HAL_TIM_PWM_ConfigChannel(&htim3, &oc, TIM_CHANNEL_3);
+
+    master.MasterOutputTrigger = TIM_TRGO_OC1REF;
+    master.MasterSlaveMode     = TIM_MASTERSLAVEMODE_DISABLE;
+    HAL_TIMEx_MasterConfigSynchronization(&htim3, &master);
+
+    slave.SlaveMode    = TIM_SLAVEMODE_GATED;
+    slave.InputTrigger = TIM_TS_ITR2;
+    HAL_TIM_SlaveConfigSynchro(&htim1, &slave);
+
+    oc.OCMode = TIM_OCMODE_PWM2;
+    oc.Pulse  = Strobe_CalcGatedCompare(Brig_GetCCR());
+    HAL_TIM_PWM_ConfigChannel(&htim1, &oc, TIM_CHANNEL_1);
+    /* load CCR1 now: the old shadow value 0 is "always on" in PWM2 */
+    htim1.Instance->EGR = TIM_EGR_UG;
+
+    /* PB0 debug mirror: GPIO output -> TIM3_CH3 */
+    gpio.Pin       = GPIO_PIN_0;
+    gpio.Mode      = GPIO_MODE_AF_PP;
+    gpio.Pull      = GPIO_NOPULL;
+    gpio.Speed     = GPIO_SPEED_FREQ_HIGH;
+    gpio.Alternate = GPIO_AF2_TIM3;
+    HAL_GPIO_Init(GPIOB, &gpio);
+    TIM_CCxChannelCmd(htim3.Instance, TIM_CHANNEL_3, TIM_CCx_ENABLE);
+}
+
+/* close the gate: OC1REF/OC3REF forced low, TIM3 stopped, TIM1 parked at
+ * CNT=0. __HAL_TIM_DISABLE would leave CEN set while CC3 is enabled. */
+static void Strobe_HwStop(void)
+{
+    MODIFY_REG(htim3.Instance->CCMR1, TIM_CCMR1_OC1M, TIM_OCMODE_FORCED_INACTIVE);
+    MODIFY_REG(htim3.Instance->CCMR2, TIM_CCMR2_OC3M, TIM_OCMODE_FORCED_INACTIVE);
+    htim3.Instance->CR1 &= ~TIM_CR1_CEN;
+    __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_UPDATE | TIM_IT_CC1);
+    __HAL_TIM_SET_COUNTER(&htim1, 0u);
+}
+
+/* load g_timing and restart at ARR: the first update opens the gate one
+ * tick later. UG loads the preloaded PSC/ARR/CCR at once. The update
+ * interrupt (once per period) does dithering, phase and retuning. */
+static void Strobe_HwStart(void)
+{
+    uint16_t arr = Strobe_StartARR();
+
+    __HAL_TIM_SET_PRESCALER(&htim3, g_timing.psc);
+    __HAL_TIM_SET_AUTORELOAD(&htim3, arr);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, g_timing.ccr);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, g_timing.ccr);
+    htim3.Instance->EGR = TIM_EGR_UG;
+    __HAL_TIM_SET_COUNTER(&htim3, arr);
+    __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE | TIM_FLAG_CC1 | TIM_FLAG_CC3);
+    g_period_next = ((uint32_t)arr + 1u) * ((uint32_t)g_timing.psc + 1u);
+    g_psc_next    = g_timing.psc;
+    g_arr_run     = arr;
+    g_arr_run_set = 0u;
+    g_wrap_hidden = 0u;
+    __HAL_TIM_ENABLE_IT(&htim3, TIM_IT_UPDATE);
+
+    MODIFY_REG(htim3.Instance->CCMR1, TIM_CCMR1_OC1M, TIM_OCMODE_PWM1);
+    MODIFY_REG(htim3.Instance->CCMR2, TIM_CCMR2_OC3M, TIM_OCMODE_PWM1);
+    htim3.Instance->CR1 |= TIM_CR1_CEN;
+}
+#endif
+
+/* brightness apply -- hardware mode only, the ISR reads it live.
+ * TIM1 CCR1 is preloaded, but TIM1 only has update events inside a flash:
+ * a plain write would switch after the first PWM period of a flash. the
+ * compare goes to the TIM3 CC1 interrupt instead, which runs when a window
+ * has closed and TIM1 is parked at CNT=0, and UG loads it there, so every
+ * flash has one brightness. close to an update event it waits for the next
+ * window. with TIM3 stopped it is loaded at once. */
+static void Strobe_ApplyBright(void)
 {
-    uint32_t ticks = (TIM3_MHZ_RATE + g_freq_mhz / 2u) / g_freq_mhz;
-    return ticks - 1u;
+#if STROBE_HW_GATE
+    g_bright_cmp = Strobe_CalcGatedCompare(Brig_GetCCR());
+
+    if (!(htim3.Instance->CR1 & TIM_CR1_CEN)) {
+        __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, g_bright_cmp);
+        htim1.Instance->EGR = TIM_EGR_UG;
+        return;
+    }
+    __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_CC1);
+    __HAL_TIM_ENABLE_IT(&htim3, TIM_IT_CC1);
+#endif
 }
 
-/* strobe apply */
+/* strobe (re)start -- on power up, strobe on and reset only: the timer
+ * is stopped before g_timing changes under the dither ISR. a running
+ * strobe is changed through Strobe_Commit. the tach ISR is held off
+ * meanwhile; in tach mode the strobe restarts at the last PLL frequency
+ * and the loop starts over. */
 static void Strobe_ApplyFreq(void)
 {
-    uint32_t arr = Strobe_GetARR();
-    uint32_t ccr = Duty_GetCCR(arr);
+    uint32_t num, den;
+    uint32_t freq = Freq_GetEffective();
+
+    HAL_NVIC_DisableIRQ(TIM4_IRQn);
+    if (g_tach_ratio != 0u) {
+        if (g_strobe_mhz != 0u) freq = g_strobe_mhz;
+        Strobe_PllReset(&g_pll);
+    }
 
+#if STROBE_HW_GATE
+    Strobe_HwStop();
+#else
     HAL_TIM_Base_Stop_IT(&htim3);
     __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_CC1);
 
     __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, 0u);
     HAL_GPIO_WritePin(GPIOB, GPIO_PIN_0, GPIO_PIN_RESET);
     HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_SET);
-
-    __HAL_TIM_SET_AUTORELOAD(&htim3, arr);
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, ccr);
-    __HAL_TIM_SET_COUNTER(&htim3, arr);
+#endif
+
+    Duty_GetFraction(&num, &den);
+    Strobe_CalcTiming(freq, num, den, &g_timing);
+    g_dither_acc    = 0u;
+    g_phase_pending = 0;
+    g_phase_in_arr  = 0;
+    g_phase_deg     = 0;
+
+#if STROBE_HW_GATE
+    Strobe_ApplyBright();
+    HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, g_running ? GPIO_PIN_RESET : GPIO_PIN_SET);
+    if (g_running) Strobe_HwStart();
+#else
+    __HAL_TIM_SET_PRESCALER(&htim3, g_timing.psc);
+    __HAL_TIM_SET_AUTORELOAD(&htim3, Strobe_StartARR());
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, g_timing.ccr);
+    htim3.Instance->EGR = TIM_EGR_UG;
+    __HAL_TIM_SET_COUNTER(&htim3, Strobe_StartARR());
     __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE | TIM_FLAG_CC1);
+    g_period_next = ((uint32_t)Strobe_StartARR() + 1u) * ((uint32_t)g_timing.psc + 1u);
+    g_psc_next    = g_timing.psc;
     if (g_running) HAL_TIM_Base_Start_IT(&htim3);
+#endif
+    HAL_NVIC_EnableIRQ(TIM4_IRQn);
+}
+
+/* load a new setting into the running TIM3: the running period ends as
+ * it was, the next one starts with the new PSC/ARR/CCR (all preloaded).
+ * UDIS keeps an update event from loading half of them and the update
+ * ISR is held off. the phase step the ISR had put into the old ARR goes
+ * back to pending, rescaled to the new prescaler. */
+static void Strobe_Commit(const Strobe_Timing_t *t)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t arr;
+#if STROBE_HW_GATE
+    uint16_t cnt0;
+#endif
+
+    __disable_irq();
+    htim3.Instance->CR1 |= TIM_CR1_UDIS;
+#if STROBE_HW_GATE
+    /* an update event whose interrupt has not run loaded this ARR */
+    cnt0 = (uint16_t)htim3.Instance->CNT;
+    if (__HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_UPDATE) && !g_arr_run_set) {
+        g_arr_run     = (uint16_t)htim3.Instance->ARR;
+        g_arr_run_set = 1u;
+    }
+#endif
+
+    g_phase_pending = (int32_t)((int64_t)(g_phase_pending + g_phase_in_arr) *
+                                ((int32_t)g_timing.psc + 1) / ((int32_t)t->psc + 1));
+    g_phase_in_arr  = 0;
+    g_timing        = *t;
+    g_dither_acc    = 0u;
+    arr             = Strobe_StartARR();
+
+    __HAL_TIM_SET_PRESCALER(&htim3, g_timing.psc);
+    __HAL_TIM_SET_AUTORELOAD(&htim3, arr);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, g_timing.ccr);
+#if STROBE_HW_GATE
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, g_timing.ccr);
+#endif
+    g_period_next = ((uint32_t)arr + 1u) * ((uint32_t)g_timing.psc + 1u);
+    g_psc_next    = g_timing.psc;
+
+    htim3.Instance->CR1 &= ~TIM_CR1_UDIS;
+#if STROBE_HW_GATE
+    if ((uint16_t)htim3.Instance->CNT < cnt0) g_wrap_hidden = 1u;
+#endif
+    __set_PRIMASK(primask);
 }
 
+/* frequency change without stopping TIM3 (frequency, drift, leaving
+ * tach mode): the running period and flash end as they were */
+static void Strobe_Retune(void)
+{
+    Strobe_Timing_t t;
+    uint32_t        num, den;
+
+    if (!g_running) { Strobe_ApplyFreq(); return; }
+
+    Duty_GetFraction(&num, &den);
+    Strobe_CalcTiming(Freq_GetEffective(), num, den, &t);
+    Strobe_Commit(&t);
+}
+
+/* move every following flash by deg/360 of the period, the shorter way
+ * round. the ISR inserts it into ARR over the next period(s). in tach
+ * mode this is the PLL delay after the reference pulse instead. */
+static void Strobe_PhaseShift(int32_t deg)
+{
+    int32_t ticks = Strobe_CalcPhaseTicks(&g_timing, deg);
+
+    if (g_tach_ratio != 0u) {
+        g_pll.delay_deg = (uint16_t)((((int32_t)g_pll.delay_deg + deg) % 360 + 360) % 360);
+        return;
+    }
+    if (!g_running) return;
+
+    g_phase_deg = ((g_phase_deg + deg) % 360 + 360) % 360;
+
+    __disable_irq();
+    g_phase_pending += ticks;
+    __enable_irq();
+}
+
+/* new window from the next period on. it is committed with ARR, not
+ * written to CCR alone: the preloaded ARR may be a period shortened for a
+ * phase shift down to the old window, and a wider window there would hold
+ * the gate across the update event. interrupts are held off so the tach
+ * PLL cannot commit another PSC between reading g_timing and the commit. */
 static void Strobe_ApplyDuty(void)
 {
-    uint32_t arr = __HAL_TIM_GET_AUTORELOAD(&htim3);
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, Duty_GetCCR(arr));
+    Strobe_Timing_t t;
+    uint32_t        num, den;
+    Duty_GetFraction(&num, &den);
+
+    __disable_irq();
+    t     = g_timing;
+    t.ccr = Strobe_CalcWindow(t.psc, t.arr_lo, num, den);
+    Strobe_Commit(&t);
+    __enable_irq();
 }
 
 static void Strobe_SetRunning(uint8_t on)
 {
     g_running = on;
+    TRACE(&g_trace, "strobe running %u", on);
     if (on) {
         Strobe_ApplyFreq();
     } else {
+#if STROBE_HW_GATE
+        Strobe_HwStop();
+#else
         HAL_TIM_Base_Stop_IT(&htim3);
         __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_CC1);
         __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, 0u);
         HAL_GPIO_WritePin(GPIOB, GPIO_PIN_0, GPIO_PIN_RESET);
+#endif
         HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_SET);
     }
 }
 
+/* tach input: TIM4 CH3 on PB8 (AF2) captures rising edges of the free
+ * running 100 MHz counter. PB8 is free in the .ioc, so TIM4 is set up
+ * here like the hardware gate. the update interrupt counts overflows. */
+static void Tach_Init(void)
+{
+    TIM_IC_InitTypeDef ic   = {0};
+    GPIO_InitTypeDef   gpio = {0};
+
+    __HAL_RCC_TIM4_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+
+    /* pull-up for open collector hall and NPN sensors */
+    gpio.Pin       = GPIO_PIN_8;
+    gpio.Mode      = GPIO_MODE_AF_PP;
+    gpio.Pull      = GPIO_PULLUP;
+    gpio.Speed     = GPIO_SPEED_FREQ_LOW;
+    gpio.Alternate = GPIO_AF2_TIM4;
+    HAL_GPIO_Init(GPIOB, &gpio);
+
+    htim4.Instance               = TIM4;
+    htim4.Init.Prescaler         = 0u;
+    htim4.Init.CounterMode       = TIM_COUNTERMODE_UP;
+    htim4.Init.Period            = 0xFFFFu;
+    htim4.Init.ClockDivision     = TIM_CLOCKDIVISION_DIV4;
+    htim4.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_IC_Init(&htim4);
+
+    ic.ICPolarity  = TIM_ICPOLARITY_RISING;
+    ic.ICSelection = TIM_ICSELECTION_DIRECTTI;
+    ic.ICPrescaler = TIM_ICPSC_DIV1;
+    ic.ICFilter    = TACH_IC_FILTER;
+    HAL_TIM_IC_ConfigChannel(&htim4, &ic, TIM_CHANNEL_3);
+
+    /* below TIM3: a flash update never waits for the PLL */
+    HAL_NVIC_SetPriority(TIM4_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(TIM4_IRQn);
+}
+
+static void Tach_Stop(void)
+{
+    HAL_TIM_IC_Stop_IT(&htim4, TIM_CHANNEL_3);
+    __HAL_TIM_DISABLE_IT(&htim4, TIM_IT_UPDATE);
+    g_tach_seen = 0u;
+}
+
+/* filter and loop start over, the strobe keeps its frequency until the
+ * second pulse gives a period */
+static void Tach_Start(void)
+{
+    Strobe_TachReset(&g_tach);
+    Strobe_PllReset(&g_pll);
+    g_tach_seen       = 0u;
+    g_tach_hi         = 0u;
+    g_tach_mhz        = 0u;
+    g_strobe_mhz      = Freq_GetEffective();
+    g_tach_timeout_ms = TACH_TIMEOUT_FIRST_MS;
+
+    __HAL_TIM_SET_COUNTER(&htim4, 0u);
+    __HAL_TIM_CLEAR_FLAG(&htim4, TIM_FLAG_UPDATE | TIM_FLAG_CC3);
+    __HAL_TIM_ENABLE_IT(&htim4, TIM_IT_UPDATE);
+    HAL_TIM_IC_Start_IT(&htim4, TIM_CHANNEL_3);
+}
+
+/* ratio from the table, 0 = back to the set frequency */
+static void Tach_SetRatio(uint8_t idx)
+{
+    TRACE(&g_trace, "tach ratio %u/%u", g_tach_mult[idx], g_tach_div[idx]);
+    Tach_Stop();
+    g_tach_ratio = idx;
+    g_pll.mult   = g_tach_mult[idx];
+    g_pll.div    = g_tach_div[idx];
+    if (idx != 0u) Tach_Start();
+    else           Strobe_Retune();
+}
+
+/* no pulse for TACH_TIMEOUT_PERIODS periods: the input is lost, the strobe
+ * keeps its last frequency and the loop waits for two new pulses */
+static void Tach_Poll(void)
+{
+    if (g_tach_ratio == 0u || g_tach_seen == 0u) return;
+    if ((HAL_GetTick() - g_tach_tick) < g_tach_timeout_ms) return;
+
+    TRACE(&g_trace, "tach lost, no pulse for %u ms", g_tach_timeout_ms);
+    HAL_NVIC_DisableIRQ(TIM4_IRQn);
+    Strobe_TachReset(&g_tach);
+    Strobe_PllReset(&g_pll);
+    g_tach_seen       = 0u;
+    g_tach_mhz        = 0u;
+    g_tach_timeout_ms = TACH_TIMEOUT_FIRST_MS;
+    HAL_NVIC_EnableIRQ(TIM4_IRQn);
+}
+
+/* one tach pulse at TIM4 time t, from the TIM4 ISR. every reference pulse
+ * of the PLL gives a new strobe period, loaded without stopping TIM3. */
+static void Tach_Edge(uint32_t t)
+{
+    uint32_t        period = t - g_tach_last;
+    uint64_t        tach_q8, period_q8;
+    Strobe_Timing_t timing;
+    uint32_t        num, den;
+
+    if (g_tach_seen != 0u && period < TACH_PERIOD_MIN_CLK) return;
+    g_tach_last = t;
+    g_tach_tick = HAL_GetTick();
+    if (g_tach_seen == 0u) { g_tach_seen = 1u; return; }
+
+    tach_q8           = Strobe_TachFilter(&g_tach, period);
+    g_tach_mhz        = (uint32_t)(TACH_MHZ_Q8 / tach_q8);
+    g_tach_timeout_ms = (uint32_t)(tach_q8 >> 8) / (STROBE_TIM_CLK_HZ / 1000u) *
+                        TACH_TIMEOUT_PERIODS + TACH_TIMEOUT_MIN_MS;
+    g_tach_seen       = 2u;
+
+    if (!Strobe_PllEdge(&g_pll, tach_q8, (int32_t)(g_flash_next_t - t), &period_q8))
+        return;
+    TRACE(&g_trace, "pll tach %u mHz, period %u clk, err %d clk", g_tach_mhz,
+          (uint32_t)(period_q8 >> 8), g_pll.error);
+
+    if (period_q8 < TACH_PERIOD_Q8_MIN) period_q8 = TACH_PERIOD_Q8_MIN;
+    if (period_q8 > TACH_PERIOD_Q8_MAX) period_q8 = TACH_PERIOD_Q8_MAX;
+    g_strobe_mhz  = (uint32_t)(TACH_MHZ_Q8 / period_q8);
+    g_pll_err_d10 = (int32_t)((int64_t)g_pll.error * 3600 / (int64_t)(period_q8 >> 8));
+    if (!g_running) return;
+
+    Duty_GetFraction(&num, &den);
+    Strobe_CalcTimingPeriod(period_q8, num, den, &timing);
+    Strobe_Commit(&timing);
+}
+
 /* defaults */
 static void Apply_Defaults(void)
 {
+    TRACE(&g_trace, "defaults");
     g_freq_mhz  = FREQ_MHZ_INIT;
     g_step_idx  = 0u;
     g_duty_mode = DUTY_MODE_PERC;
     g_duty_val  = DUTY_PERC_INIT;
     g_brig_mode = BRIG_MODE_PERC;
     g_brig_val  = BRIG_PERC_INIT;
+    g_drift_mhz = 0;
+    g_pll.delay_deg = 0u;
+    if (g_tach_ratio != 0u) Tach_SetRatio(0u);
     Strobe_ApplyFreq();
 }
 
-/* flash config */
-static uint32_t Config_Checksum(const FlashConfig_t *c)
-{
-    const uint8_t *p   = (const uint8_t *)c;
-    uint32_t       len = sizeof(FlashConfig_t) - sizeof(uint32_t);
-    uint32_t       crc = 0u;
-    for (uint32_t i = 0u; i < len; i++) crc ^= (uint32_t)p[i];
-    return crc;
-}
-
+/* flash config. a save appends one record to the settings log; a sector
+ * erase (~1 s, the CPU stalls on flash) only happens when the log moves to
+ * the other sector, once every ~2000 saves. the strobe keeps flashing
+ * from the timers meanwhile. */
 static void Flash_SaveConfig(void)
 {
     FlashConfig_t cfg;
     memset(&cfg, 0, sizeof(cfg));
-    cfg.magic     = FLASH_CONFIG_MAGIC;
     cfg.freq_mhz  = g_freq_mhz;
     cfg.step_idx  = g_step_idx;
     cfg.duty_mode = (uint8_t)g_duty_mode;
@@ -405,49 +1068,118 @@ static void Flash_SaveConfig(void)
     cfg.brig_mode = (uint8_t)g_brig_mode;
     cfg.brig_val  = g_brig_val;
     cfg.running   = g_running;
-    cfg.checksum  = Config_Checksum(&cfg);
-
-    HAL_FLASH_Unlock();
-
-    FLASH_EraseInitTypeDef erase = {
-        .TypeErase    = FLASH_TYPEERASE_SECTORS,
-        .Sector       = FLASH_CONFIG_SECTOR,
-        .NbSectors    = 1,
-        .VoltageRange = FLASH_VOLTAGE_RANGE_3
-    };
-    uint32_t sector_error = 0u;
-    HAL_FLASHEx_Erase(&erase, &sector_error);
-
-    const uint32_t *src  = (const uint32_t *)&cfg;
-    uint32_t        addr = FLASH_CONFIG_ADDR;
-    for (uint32_t i = 0u; i < sizeof(FlashConfig_t) / 4u; i++) {
-        HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, src[i]);
-        addr += 4u;
-    }
+    cfg.drift_mhz  = g_drift_mhz;
+    cfg.tach_ratio = g_tach_ratio;
+    cfg.tach_delay = g_pll.delay_deg;
 
-    HAL_FLASH_Lock();
+    TRACE(&g_trace, "config saved, %u mHz", g_freq_mhz);
+    CfgLog_Save(&g_cfglog, FLASH_CONFIG_VERSION, &cfg, sizeof(cfg));
 }
 
 static void Flash_LoadConfig(void)
 {
-    const FlashConfig_t *cfg = (const FlashConfig_t *)FLASH_CONFIG_ADDR;
-
-    if (cfg->magic    != FLASH_CONFIG_MAGIC)   return;
-    if (cfg->checksum != Config_Checksum(cfg)) return;
+    FlashConfig_t   cfg;
+    CfgLog_Status_t st;
+
+    g_cfglog.area[0]   = (const volatile uint32_t *)FLASH_CONFIG_ADDR0;
+    g_cfglog.area[1]   = (const volatile uint32_t *)FLASH_CONFIG_ADDR1;
+    g_cfglog.area_size = FLASH_CONFIG_SIZE;
+    g_cfglog.slot_size = FLASH_CONFIG_SLOT;
+    g_cfglog.program   = Flash_LogProgram;
+    g_cfglog.erase     = Flash_LogErase;
+
+    st = CfgLog_Init(&g_cfglog);
+    if (st == CFGLOG_EMPTY && Flash_LoadLegacy(&cfg)) {
+        /* first boot after the upgrade: the old record becomes the first
+         * log record. it goes to sector 6 (area 0, sector 7 is not
+         * formatted), so the old record stays until the log first moves
+         * to sector 7 */
+        CfgLog_Save(&g_cfglog, FLASH_CONFIG_VERSION, &cfg, sizeof(cfg));
+    } else if (st != CFGLOG_OK ||
+               CfgLog_Load(&g_cfglog, FLASH_CONFIG_VERSION, &cfg, sizeof(cfg)) != CFGLOG_OK) {
+        return;
+    }
 
-    g_freq_mhz  = cfg->freq_mhz;
-    g_step_idx  = cfg->step_idx;
-    g_duty_mode = (DutyMode_t)cfg->duty_mode;
-    g_duty_val  = cfg->duty_val;
-    g_brig_mode = (BrigMode_t)cfg->brig_mode;
-    g_brig_val  = cfg->brig_val;
-    g_running   = cfg->running;
+    g_freq_mhz  = cfg.freq_mhz;
+    g_step_idx  = cfg.step_idx;
+    g_duty_mode = (DutyMode_t)cfg.duty_mode;
+    g_duty_val  = cfg.duty_val;
+    g_brig_mode = (BrigMode_t)cfg.brig_mode;
+    g_brig_val  = cfg.brig_val;
+    g_running   = cfg.running;
+    g_drift_mhz = cfg.drift_mhz;
+    g_tach_ratio    = cfg.tach_ratio;
+    g_pll.delay_deg = cfg.tach_delay;
 
     if (g_freq_mhz < FREQ_MHZ_MIN)  g_freq_mhz = FREQ_MHZ_INIT;
     if (g_freq_mhz > FREQ_MHZ_MAX)  g_freq_mhz = FREQ_MHZ_MAX;
     if (g_step_idx > 2u)             g_step_idx = 0u;
     if (g_duty_val == 0u)            g_duty_val = DUTY_PERC_INIT;
     if (g_brig_val == 0u)            g_brig_val = BRIG_PERC_INIT;
+    if (g_drift_mhz >  DRIFT_MHZ_MAX ||
+        g_drift_mhz < -DRIFT_MHZ_MAX) g_drift_mhz = 0;
+    if (g_tach_ratio >= TACH_RATIO_COUNT) g_tach_ratio = 0u;
+    if (g_pll.delay_deg >= 360u)      g_pll.delay_deg = 0u;
+}
+
+/* the record of firmware before the settings log, converted; 0 if
+ * there is none. drift and tach were not saved then */
+static uint8_t Flash_LoadLegacy(FlashConfig_t *cfg)
+{
+    const FlashLegacy_t *old = (const FlashLegacy_t *)FLASH_LEGACY_ADDR;
+    const uint8_t       *p   = (const uint8_t *)old;
+    uint32_t             crc = 0u;
+
+    if (old->magic != FLASH_LEGACY_MAGIC) return 0u;
+    for (uint32_t i = 0u; i < sizeof(FlashLegacy_t) - sizeof(uint32_t); i++) crc ^= (uint32_t)p[i];
+    if (old->checksum != crc) return 0u;
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->freq_mhz  = old->freq_mhz;
+    cfg->step_idx  = old->step_idx;
+    cfg->duty_mode = old->duty_mode;
+    cfg->duty_val  = old->duty_val;
+    cfg->brig_mode = old->brig_mode;
+    cfg->brig_val  = old->brig_val;
+    cfg->running   = old->running;
+    return 1u;
+}
+
+/* settings log platform callbacks: area 0/1 = sector 6/7 */
+static int Flash_LogProgram(uint8_t area, uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    uint32_t addr = (area ? FLASH_CONFIG_ADDR1 : FLASH_CONFIG_ADDR0) + offset;
+    int      rc   = 0;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0u; i < count; i++) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, words[i]) != HAL_OK) { rc = -1; break; }
+        addr += 4u;
+    }
+    HAL_FLASH_Lock();
+
+    /* the data cache may still hold the erased words read by the scan */
+    __HAL_FLASH_DATA_CACHE_DISABLE();
+    __HAL_FLASH_DATA_CACHE_RESET();
+    __HAL_FLASH_DATA_CACHE_ENABLE();
+    return rc;
+}
+
+static int Flash_LogErase(uint8_t area)
+{
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase    = FLASH_TYPEERASE_SECTORS,
+        .Sector       = area ? FLASH_CONFIG_SECTOR1 : FLASH_CONFIG_SECTOR0,
+        .NbSectors    = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3
+    };
+    uint32_t sector_error = 0u;
+    int      rc           = 0;
+
+    HAL_FLASH_Unlock();
+    if (HAL_FLASHEx_Erase(&erase, &sector_error) != HAL_OK) rc = -1;
+    HAL_FLASH_Lock();
+    return rc;
 }
 
 /* notification */
@@ -507,12 +1239,13 @@ static void Encoder_Process(void)
 
     switch (g_screen) {
     case SCREEN_MAIN: {
+        if (g_tach_ratio != 0u) { Notify(" TACH MODE  "); break; }
         uint32_t step_mhz = g_step_mults[g_step_idx] * FREQ_STEP_BASE_MHZ;
         int32_t  new_mhz  = (int32_t)g_freq_mhz + dir * count * (int32_t)step_mhz;
         if (new_mhz < (int32_t)FREQ_MHZ_MIN) new_mhz = (int32_t)FREQ_MHZ_MIN;
         if (new_mhz > (int32_t)FREQ_MHZ_MAX) new_mhz = (int32_t)FREQ_MHZ_MAX;
         g_freq_mhz = (uint32_t)new_mhz;
-        Strobe_ApplyFreq();
+        Strobe_Retune();
         break;
     }
     case SCREEN_DUTY: {
@@ -528,13 +1261,318 @@ static void Encoder_Process(void)
         for (int32_t i = 0; i < count; i++)
             for (uint32_t m = 0u; m < mult; m++)
                 if (dir > 0) Brig_Increase(); else Brig_Decrease();
-        /* Brig_GetCCR() is read live in the TIM3 ISR */
+        /* hardware mode: loaded between two flashes, ISR mode reads it live */
+        Strobe_ApplyBright();
         break;
     }
+    case SCREEN_PHASE:
+        Strobe_PhaseShift(dir * count * (int32_t)g_step_mults[g_step_idx] * PHASE_STEP_DEG);
+        break;
+    case SCREEN_DRIFT: {
+        if (g_tach_ratio != 0u) { Notify(" TACH MODE  "); break; }
+        int32_t step_mhz = (int32_t)g_step_mults[g_step_idx] * DRIFT_STEP_MHZ;
+        int32_t drift    = g_drift_mhz + dir * count * step_mhz;
+        if (drift < -DRIFT_MHZ_MAX) drift = -DRIFT_MHZ_MAX;
+        if (drift >  DRIFT_MHZ_MAX) drift =  DRIFT_MHZ_MAX;
+        g_drift_mhz = drift;
+        Strobe_Retune();
+        break;
+    }
+    case SCREEN_TACH: {
+        int32_t idx = (int32_t)g_tach_ratio + dir * count;
+        if (idx < 0) idx = 0;
+        if (idx > (int32_t)TACH_RATIO_COUNT - 1) idx = (int32_t)TACH_RATIO_COUNT - 1;
+        if ((uint8_t)idx != g_tach_ratio) Tach_SetRatio((uint8_t)idx);
+        break;
+    }
+#if PROF_ENABLE
+    case SCREEN_DIAG: {
+        int32_t first = (int32_t)g_diag_first + dir * count;
+        if (first > (int32_t)(PZ_COUNT - DIAG_ROWS)) first = (int32_t)(PZ_COUNT - DIAG_ROWS);
+        if (first < 0) first = 0;
+        g_diag_first = (uint8_t)first;
+        break;
+    }
+#endif
     default: break;
     }
 }
 
+/* commands. the handlers are the encoder and button actions with the
+ * value typed in: same limits, same tach mode lock */
+
+/* millihertz as "12.345" */
+static void Con_FmtMhz(char *buf, uint16_t size, const char *label, int32_t mhz)
+{
+    uint32_t a = (mhz < 0) ? (uint32_t)-mhz : (uint32_t)mhz;
+    snprintf(buf, size, "%s %s%lu.%03lu Hz", label, (mhz < 0) ? "-" : "", a / 1000u, a % 1000u);
+}
+
+static Cmd_Status_t Con_Get(Cmd_Handle_t *h, uint8_t argc)
+{
+    char line[64];
+
+    (void)argc;
+    Con_FmtMhz(line, sizeof(line), "freq", (int32_t)g_freq_mhz);
+    Cmd_Reply(h, line);
+    Con_FmtMhz(line, sizeof(line), "drift", g_drift_mhz);
+    Cmd_Reply(h, line);
+    if (g_duty_mode == DUTY_MODE_PERC) snprintf(line, sizeof(line), "duty %lu %%", g_duty_val);
+    else                               snprintf(line, sizeof(line), "duty div %lu", g_duty_val);
+    Cmd_Reply(h, line);
+    if (g_brig_mode == BRIG_MODE_PERC) snprintf(line, sizeof(line), "bright %lu %%", g_brig_val);
+    else                               snprintf(line, sizeof(line), "bright div %lu", g_brig_val);
+    Cmd_Reply(h, line);
+    if (g_tach_ratio == 0u) {
+        snprintf(line, sizeof(line), "phase %ld deg, tach off", g_phase_deg);
+    } else {
+        snprintf(line, sizeof(line), "tach %u (%u/%u) delay %u deg %s", g_tach_ratio,
+                 g_tach_mult[g_tach_ratio], g_tach_div[g_tach_ratio], g_pll.delay_deg,
+                 (g_tach_seen == 2u) ? "locked" : "no input");
+    }
+    Cmd_Reply(h, line);
+    if (g_tach_ratio != 0u && g_tach_seen == 2u) {
+        Con_FmtMhz(line, sizeof(line), "tach in", (int32_t)g_tach_mhz);
+        Cmd_Reply(h, line);
+        Con_FmtMhz(line, sizeof(line), "strobe", (int32_t)g_strobe_mhz);
+        Cmd_Reply(h, line);
+    }
+    snprintf(line, sizeof(line), "run %u", g_running);
+    Cmd_Reply(h, line);
+    snprintf(line, sizeof(line), "cmd lines %lu errors %lu overruns %lu dropped %lu",
+             h->lines, h->errors, h->overruns, g_con_dropped);
+    Cmd_Reply(h, line);
+    return CMD_OK;
+}
+
+/* freq <Hz>, 0.001 Hz resolution */
+static Cmd_Status_t Con_Freq(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v;
+    Cmd_Status_t st;
+
+    (void)argc;
+    if ((st = Cmd_ArgNum(h, 0, 3, FREQ_MHZ_MIN, FREQ_MHZ_MAX, &v)) != CMD_OK) return st;
+    if (g_tach_ratio != 0u) return CMD_ERR_STATE;
+    g_freq_mhz = (uint32_t)v;
+    Strobe_Retune();
+    return CMD_OK;
+}
+
+/* drift <Hz>, signed, 0.001 Hz resolution */
+static Cmd_Status_t Con_Drift(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v;
+    Cmd_Status_t st;
+
+    (void)argc;
+    if ((st = Cmd_ArgNum(h, 0, 3, -DRIFT_MHZ_MAX, DRIFT_MHZ_MAX, &v)) != CMD_OK) return st;
+    if (g_tach_ratio != 0u) return CMD_ERR_STATE;
+    g_drift_mhz = v;
+    Strobe_Retune();
+    return CMD_OK;
+}
+
+/* duty <percent> | duty div <N> */
+static Cmd_Status_t Con_Duty(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v;
+    Cmd_Status_t st;
+
+    if (argc == 2) {
+        if (!Cmd_ArgIs(h, 0, "div")) return CMD_ERR_ARGS;
+        if ((st = Cmd_ArgNum(h, 1, 0, DUTY_DIV_MIN, DUTY_DIV_MAX, &v)) != CMD_OK) return st;
+        if ((uint32_t)v % DUTY_DIV_STEP != 0u) return CMD_ERR_RANGE;   /* the encoder's grid */
+        g_duty_mode = DUTY_MODE_DIV;
+    } else {
+        if ((st = Cmd_ArgNum(h, 0, 0, DUTY_PERC_MIN, DUTY_PERC_MAX, &v)) != CMD_OK) return st;
+        g_duty_mode = DUTY_MODE_PERC;
+    }
+    g_duty_val = (uint32_t)v;
+    Strobe_ApplyDuty();
+    return CMD_OK;
+}
+
+/* bright <percent> | bright div <N> */
+static Cmd_Status_t Con_Bright(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v;
+    Cmd_Status_t st;
+
+    if (argc == 2) {
+        if (!Cmd_ArgIs(h, 0, "div")) return CMD_ERR_ARGS;
+        if ((st = Cmd_ArgNum(h, 1, 0, BRIG_DIV_MIN, BRIG_DIV_MAX, &v)) != CMD_OK) return st;
+        g_brig_mode = BRIG_MODE_DIV;
+    } else {
+        if ((st = Cmd_ArgNum(h, 0, 0, BRIG_PERC_MIN, BRIG_PERC_MAX, &v)) != CMD_OK) return st;
+        g_brig_mode = BRIG_MODE_PERC;
+    }
+    g_brig_val = (uint32_t)v;
+    Strobe_ApplyBright();
+    return CMD_OK;
+}
+
+/* phase <deg>: nudge the flashes by deg, or in tach mode the delay after
+ * the pulse, as the phase screen */
+static Cmd_Status_t Con_Phase(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v;
+    Cmd_Status_t st;
+
+    (void)argc;
+    if ((st = Cmd_ArgNum(h, 0, 0, -359, 359, &v)) != CMD_OK) return st;
+    if (g_tach_ratio == 0u && !g_running) return CMD_ERR_STATE;
+    Strobe_PhaseShift(v);
+    return CMD_OK;
+}
+
+/* tach off | <index>: index into the ratio table, as the tach screen */
+static Cmd_Status_t Con_Tach(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v = 0;
+    Cmd_Status_t st;
+
+    (void)argc;
+    if (!Cmd_ArgIs(h, 0, "off") &&
+        (st = Cmd_ArgNum(h, 0, 0, 0, TACH_RATIO_COUNT - 1, &v)) != CMD_OK) return st;
+    if ((uint8_t)v != g_tach_ratio) Tach_SetRatio((uint8_t)v);
+    return CMD_OK;
+}
+
+static Cmd_Status_t Con_Run(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)argc;
+    if      (Cmd_ArgIs(h, 0, "on"))  { if (!g_running) Strobe_SetRunning(1u); }
+    else if (Cmd_ArgIs(h, 0, "off")) { if (g_running)  Strobe_SetRunning(0u); }
+    else return CMD_ERR_ARGS;
+    return CMD_OK;
+}
+
+static Cmd_Status_t Con_Save(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)h;
+    (void)argc;
+    Flash_SaveConfig();
+    Notify("   SAVED    ");
+    return CMD_OK;
+}
+
+static Cmd_Status_t Con_Reset(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)h;
+    (void)argc;
+    Apply_Defaults();
+    Notify("   RESET    ");
+    return CMD_OK;
+}
+
+#if PROF_ENABLE
+/* prof [hist|reset]: the zone times, with the histograms, or then clear */
+static Cmd_Status_t Con_Prof(Cmd_Handle_t *h, uint8_t argc)
+{
+    uint8_t hist = (argc == 1u) && Cmd_ArgIs(h, 0, "hist");
+
+    if (argc == 1u && !hist && !Cmd_ArgIs(h, 0, "reset")) return CMD_ERR_ARGS;
+    Prof_Report(&g_prof, hist, h->reply);
+    if (argc == 1u && !hist) Prof_Reset(&g_prof);
+    return CMD_OK;
+}
+#endif
+
+static const Cmd_Entry_t g_cmd_table[] = {
+    { "get",    "",                 0u, 0u, Con_Get    },
+    { "freq",   "<Hz>",             1u, 1u, Con_Freq   },
+    { "duty",   "<%>|div <N>",      1u, 2u, Con_Duty   },
+    { "bright", "<%>|div <N>",      1u, 2u, Con_Bright },
+    { "phase",  "<deg>",            1u, 1u, Con_Phase  },
+    { "drift",  "<Hz>",             1u, 1u, Con_Drift  },
+    { "tach",   "off|<ratio 1-9>",  1u, 1u, Con_Tach   },
+    { "run",    "on|off",           1u, 1u, Con_Run    },
+    { "save",   "",                 0u, 0u, Con_Save   },
+    { "reset",  "",                 0u, 0u, Con_Reset  },
+#if PROF_ENABLE
+    { "prof",   "[hist|reset]",     0u, 1u, Con_Prof   },
+#endif
+};
+
+/* DMA write index now: NDTR counts down from the ring size */
+static uint16_t Console_RxHead(void)
+{
+    return (uint16_t)((CMD_RX_SIZE - __HAL_DMA_GET_COUNTER(huart1.hdmarx)) & (CMD_RX_SIZE - 1u));
+}
+
+/* start sending the answers collected so far, if the line is free */
+static void Console_Flush(void)
+{
+    uint8_t b = g_con_fill;
+
+    if (g_con_tx_busy || g_con_tx_len[b] == 0u) return;
+    g_con_tx_busy = 1u;
+    if (HAL_UART_Transmit_DMA(&huart1, g_con_tx[b], g_con_tx_len[b]) != HAL_OK) {
+        g_con_tx_busy = 0u;
+        return;
+    }
+    g_con_fill = b ^ 1u;
+    g_con_tx_len[g_con_fill] = 0u;
+}
+
+/* one answer line into the fill buffer. a burst (help, get) longer than
+ * a buffer waits for the one on the wire, the strobe runs from the timers
+ * meanwhile */
+static void Console_Reply(const char *s, uint16_t len)
+{
+    uint8_t *p;
+
+    if (len > CON_TX_SIZE - 2u) len = CON_TX_SIZE - 2u;
+    if (g_con_tx_len[g_con_fill] + len + 2u > CON_TX_SIZE) {
+        uint32_t t0 = HAL_GetTick();
+        while (g_con_tx_busy && (HAL_GetTick() - t0) < CON_TX_WAIT_MS) {}
+        Console_Flush();
+        if (g_con_tx_len[g_con_fill] + len + 2u > CON_TX_SIZE) { g_con_dropped++; return; }
+    }
+    p = &g_con_tx[g_con_fill][g_con_tx_len[g_con_fill]];
+    memcpy(p, s, len);
+    p[len]     = '\r';
+    p[len + 1] = '\n';
+    g_con_tx_len[g_con_fill] += len + 2u;
+}
+
+static void Console_Start(void)
+{
+    g_cmd.rx        = g_cmd_rx;
+    g_cmd.rx_size   = CMD_RX_SIZE;
+    g_cmd.table     = g_cmd_table;
+    g_cmd.table_len = (uint8_t)(sizeof(g_cmd_table) / sizeof(g_cmd_table[0]));
+    g_cmd.reply     = Console_Reply;
+    g_cmd.rx_head   = Console_RxHead;
+    Cmd_Init(&g_cmd);
+    HAL_UARTEx_ReceiveToIdle_DMA(&huart1, g_cmd_rx, CMD_RX_SIZE);
+}
+
+/* idle line, half and full ring: Size is the DMA write index */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (huart == &huart1) Cmd_RxEvent(&g_cmd, Size);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart1) g_con_tx_busy = 0u;
+}
+
+/* an RX error (framing, noise, overrun) stops the DMA reception: start it
+ * again at index 0, the line in progress is lost. a TX DMA error ends the
+ * transfer */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart != &huart1) return;
+    if (huart->RxState == HAL_UART_STATE_READY) {
+        Cmd_RxRestart(&g_cmd);
+        HAL_UARTEx_ReceiveToIdle_DMA(&huart1, g_cmd_rx, CMD_RX_SIZE);
+    }
+    if (huart->gState == HAL_UART_STATE_READY) g_con_tx_busy = 0u;
+}
+
 /* display */
 static void Display_Update(void)
 {
@@ -547,16 +1585,28 @@ static void Display_Update(void)
     /* ---- SCREEN_MAIN ---- */
     if (g_screen == SCREEN_MAIN) {
 
-        {
+        if (g_tach_ratio != 0u) {
+            /* tach mode: the big digits follow the PLL */
+            snprintf(disp_buf, sizeof(disp_buf), "TACH %u/%u",
+                     g_tach_mult[g_tach_ratio], g_tach_div[g_tach_ratio]);
+            SH1106_WriteStringAt(0, ROW_TOP_Y, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+            SH1106_WriteStringAt(96, ROW_TOP_Y,
+                                 (g_tach_seen < 2u) ? "NONE" : g_pll.locked ? "LOCK" : "WAIT",
+                                 Font_8H, SH1106_COLOR_WHITE);
+        } else {
             static const char * const hz_lbl[3] = { "0.1 Hz", "1 Hz", "10 Hz" };
             snprintf(disp_buf, sizeof(disp_buf), "STEP %s", hz_lbl[g_step_idx]);
             SH1106_WriteStringAt(0, ROW_TOP_Y, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+            /* the big digits show the base frequency, drift runs on top */
+            if (g_drift_mhz != 0)
+                SH1106_WriteStringAt(92, ROW_TOP_Y, "DRIFT", Font_8H, SH1106_COLOR_WHITE);
         }
 
         {
-            uint8_t fw = Big_FreqWidth(g_freq_mhz);
-            uint8_t fx = (fw < 128u) ? (uint8_t)((128u - fw) / 2u) : 0u;
-            Draw_BigFreq(g_freq_mhz, fx, (uint8_t)ROW_BIG_Y);
+            uint32_t f  = (g_tach_ratio != 0u) ? g_strobe_mhz : g_freq_mhz;
+            uint8_t  fw = Big_FreqWidth(f);
+            uint8_t  fx = (fw < 128u) ? (uint8_t)((128u - fw) / 2u) : 0u;
+            Draw_BigFreq(f, fx, (uint8_t)ROW_BIG_Y);
         }
 
     /* ---- SCREEN_DUTY ---- */
@@ -576,6 +1626,92 @@ static void Display_Update(void)
 
         SH1106_WriteStringAt(20, 44, "BTN2: next", Font_8H, SH1106_COLOR_WHITE);
 
+    /* ---- SCREEN_PHASE ---- */
+    } else if (g_screen == SCREEN_PHASE) {
+
+        if (g_tach_ratio != 0u) {
+            SH1106_WriteStringAt(24, ROW_TOP_Y, "TACH DELAY", Font_8H, SH1106_COLOR_WHITE);
+            snprintf(disp_buf, sizeof(disp_buf), "%u deg", g_pll.delay_deg);
+        } else {
+            SH1106_WriteStringAt(20, ROW_TOP_Y, "PHASE SHIFT", Font_8H, SH1106_COLOR_WHITE);
+            snprintf(disp_buf, sizeof(disp_buf), "%ld deg", (long)g_phase_deg);
+        }
+        SH1106_WriteStringAt(8, 23, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+
+        {
+            static const char * const sl[3] = { "1", "10", "100" };
+            snprintf(disp_buf, sizeof(disp_buf), "STEP %s deg", sl[g_step_idx]);
+            SH1106_WriteStringAt(0, 35, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+        }
+
+        SH1106_WriteStringAt(20, 44, "BTN2: next", Font_8H, SH1106_COLOR_WHITE);
+
+    /* ---- SCREEN_DRIFT ---- */
+    } else if (g_screen == SCREEN_DRIFT) {
+
+        SH1106_WriteStringAt(12, ROW_TOP_Y, "DRIFT (SLOW)", Font_8H, SH1106_COLOR_WHITE);
+
+        {
+            uint32_t d = (uint32_t)((g_drift_mhz < 0) ? -g_drift_mhz : g_drift_mhz);
+            uint32_t f = Freq_GetEffective();
+            snprintf(disp_buf, sizeof(disp_buf), "%c%lu.%02lu Hz",
+                     (g_drift_mhz < 0) ? '-' : '+', d / 1000u, (d % 1000u) / 10u);
+            SH1106_WriteStringAt(8, 23, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+            snprintf(disp_buf, sizeof(disp_buf), "RUN %lu.%02lu Hz",
+                     f / 1000u, (f % 1000u) / 10u);
+            SH1106_WriteStringAt(0, 44, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+        }
+
+        {
+            static const char * const sl[3] = { "0.01", "0.1", "1" };
+            snprintf(disp_buf, sizeof(disp_buf), "STEP %s Hz", sl[g_step_idx]);
+            SH1106_WriteStringAt(0, 35, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+        }
+
+    /* ---- SCREEN_TACH ---- */
+    } else if (g_screen == SCREEN_TACH) {
+
+        SH1106_WriteStringAt(24, ROW_TOP_Y, "TACH INPUT", Font_8H, SH1106_COLOR_WHITE);
+
+        if (g_tach_ratio == 0u) {
+            SH1106_WriteStringAt(8, 23, "OFF (PB8)", Font_8H, SH1106_COLOR_WHITE);
+            SH1106_WriteStringAt(20, 44, "BTN2: next", Font_8H, SH1106_COLOR_WHITE);
+        } else {
+            uint32_t f = g_tach_mhz;
+            int32_t  e = g_pll_err_d10;
+            uint32_t ea = (uint32_t)((e < 0) ? -e : e);
+
+            snprintf(disp_buf, sizeof(disp_buf), "RATIO %u/%u",
+                     g_tach_mult[g_tach_ratio], g_tach_div[g_tach_ratio]);
+            SH1106_WriteStringAt(8, 23, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+
+            if (g_tach_seen < 2u) {
+                SH1106_WriteStringAt(0, 35, "NO TACH", Font_8H, SH1106_COLOR_WHITE);
+            } else {
+                snprintf(disp_buf, sizeof(disp_buf), "IN %lu.%02lu Hz",
+                         f / 1000u, (f % 1000u) / 10u);
+                SH1106_WriteStringAt(0, 35, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+                snprintf(disp_buf, sizeof(disp_buf), "%s %c%lu.%lu deg",
+                         g_pll.locked ? "LOCK" : "WAIT", (e < 0) ? '-' : '+',
+                         ea / 10u, ea % 10u);
+                SH1106_WriteStringAt(0, 44, disp_buf, Font_8H, SH1106_COLOR_WHITE);
+            }
+        }
+
+#if PROF_ENABLE
+    /* ---- SCREEN_DIAG ---- */
+    } else if (g_screen == SCREEN_DIAG) {
+
+        SH1106_WriteStringAt(0, ROW_TOP_Y, "DIAG  mean/max us", Font_8H, SH1106_COLOR_WHITE);
+
+        for (uint8_t r = 0u; r < DIAG_ROWS; r++) {
+            const Prof_Zone_t *z = &g_prof_zone[g_diag_first + r];
+            snprintf(disp_buf, sizeof(disp_buf), "%s %lu/%lu", g_prof_name[g_diag_first + r],
+                     Prof_Us(&g_prof, Prof_Mean(z)), Prof_Us(&g_prof, z->max));
+            SH1106_WriteStringAt(0, (uint8_t)(23u + r * 10u), disp_buf, Font_8H, SH1106_COLOR_WHITE);
+        }
+#endif
+
     /* ---- SCREEN_BRIGHT ---- */
     } else {
 
@@ -607,17 +1743,155 @@ static void Display_Update(void)
             Font_8H, SH1106_COLOR_BLACK);
     }
 
-    SH1106_UpdateScreen();
+    /* non-blocking: pages are chained from the I2C DMA callbacks below,
+     * so buttons and encoder keep being polled during the ~23 ms frame.
+     * a frame still in flight just drops this one; the next tick redraws. */
+    PROF_BEGIN(t);
+    SH1106_UpdateScreenAsync();
+    PROF_END(&g_prof, PZ_OLED, t);
+}
+
+#if PROF_ENABLE
+/* one character on ITM stimulus port 0; the FIFO drains only while the
+ * SWO trace is read, so the wait is bounded */
+static void Diag_ItmPut(char c)
+{
+    uint32_t spin = 10000u;
+
+    if (!(ITM->TCR & ITM_TCR_ITMENA_Msk) || !(ITM->TER & 1u)) return;
+    while (ITM->PORT[0].u32 == 0u) {
+        if (--spin == 0u) return;
+    }
+    ITM->PORT[0].u8 = (uint8_t)c;
+}
+
+static void Diag_ItmLine(const char *s, uint16_t len)
+{
+    for (uint16_t i = 0u; i < len; i++) Diag_ItmPut(s[i]);
+    Diag_ItmPut('\r');
+    Diag_ItmPut('\n');
+}
+
+/* the report with the histograms to the SWV console; without a debugger
+ * nothing reads the port */
+static void Diag_Dump(void)
+{
+    if (!(CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk)) {
+        Notify("NO DEBUGGER");
+        return;
+    }
+    Prof_Report(&g_prof, 1u, Diag_ItmLine);
+    Notify("  ITM SENT  ");
+}
+#endif
+
+#if TRACE_ENABLE
+/* ring of the running context: thread mode, or the NVIC priority of the
+ * active interrupt (TIM3 2 and TIM4 3 set here, 5 in the CubeMX files).
+ * SysTick, the button EXTIs and the faults are not traced */
+static uint8_t Trace_Level(void)
+{
+    uint32_t ipsr = __get_IPSR();
+
+    if (ipsr == 0u) return TL_THREAD;
+    if (ipsr < 16u) return TL_COUNT;
+    switch (NVIC_GetPriority((IRQn_Type)((int32_t)ipsr - 16))) {
+    case 5u:  return TL_COMM;
+    case 3u:  return TL_TACH;
+    case 2u:  return TL_STROBE;
+    default:  return TL_COUNT;
+    }
+}
+
+/* one record word on ITM port 1. without a debugger the port is never
+ * free: the records wait in the rings, full rings count the drops */
+static int Trace_ItmPut(uint32_t w)
+{
+    uint32_t spin = 10000u;
+
+    if (!(CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk)) return 1;
+    if (!(ITM->TCR & ITM_TCR_ITMENA_Msk) || !(ITM->TER & (1u << TRACE_ITM_PORT))) return 1;
+    while (ITM->PORT[TRACE_ITM_PORT].u32 == 0u) {
+        if (--spin == 0u) return 1;
+    }
+    ITM->PORT[TRACE_ITM_PORT].u32 = w;
+    return 0;
+}
+#endif
+
+/* I2C1 completion -- advance the SH1106 frame pipeline.
+ * command bytes go out via Master_Transmit_DMA, page data via
+ * Mem_Write_DMA, so both completion callbacks must be forwarded. */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    PROF_BEGIN(t);
+    SH1106_I2C_TxCpltCallback(hi2c);
+    PROF_END(&g_prof, PZ_I2C, t);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    PROF_BEGIN(t);
+    SH1106_I2C_TxCpltCallback(hi2c);
+    PROF_END(&g_prof, PZ_I2C, t);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    TRACE(&g_trace, "i2c1 error 0x%02x", hi2c->ErrorCode);
+    SH1106_I2C_ErrorCallback(hi2c);
 }
 
 /* TIM3_IRQHandler -- strobe timer.
  * Important: comment out HAL_TIM_IRQHandler(&htim3) in stm32f4xx_it.c! */
+#if STROBE_HW_GATE
+/* hardware gate: the flash does not depend on this ISR. the update
+ * interrupt does the per-period ARR/PSC bookkeeping; CC1 is enabled only
+ * while a new brightness waits for the end of a window. */
+void TIM3_IRQHandler(void)
+{
+    PROF_BEGIN(t);
+
+    /* window closed, TIM1 parked at CNT=0. if the next period has begun
+     * already (UIF, or a wrap under UDIS) the gate may be open again, and
+     * an update event close ahead could open it before the UG: wait for
+     * the next window. CNT is read before UIF, interrupts are off so the
+     * margin covers the accesses up to the UG. */
+    if (__HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_CC1) &&
+        __HAL_TIM_GET_IT_SOURCE(&htim3, TIM_IT_CC1))
+    {
+        uint32_t cnt;
+
+        __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_CC1);
+        __disable_irq();
+        cnt = htim3.Instance->CNT;
+        if (!__HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_UPDATE) && !g_wrap_hidden &&
+            (uint32_t)g_arr_run >= cnt + STROBE_UG_MARGIN_TICKS) {
+            __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, g_bright_cmp);
+            htim1.Instance->EGR = TIM_EGR_UG;
+            __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_CC1);
+        }
+        __enable_irq();
+    }
+
+    if (__HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_UPDATE) &&
+        __HAL_TIM_GET_IT_SOURCE(&htim3, TIM_IT_UPDATE))
+    {
+        __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE);
+        Strobe_UpdateEvent();
+    }
+    PROF_END(&g_prof, PZ_TIM3, t);
+}
+#else
 void TIM3_IRQHandler(void)
 {
+    PROF_BEGIN(t);
+
     if (__HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_UPDATE) &&
         __HAL_TIM_GET_IT_SOURCE(&htim3, TIM_IT_UPDATE))
     {
         __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE);
+        Strobe_UpdateEvent();
         __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, Brig_GetCCR());
         HAL_GPIO_WritePin(GPIOB, GPIO_PIN_0, GPIO_PIN_SET);
         HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_RESET);
@@ -634,6 +1908,34 @@ void TIM3_IRQHandler(void)
         HAL_GPIO_WritePin(GPIOB, GPIO_PIN_0, GPIO_PIN_RESET);
         HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_SET);
     }
+    PROF_END(&g_prof, PZ_TIM3, t);
+}
+#endif
+
+/* TIM4_IRQHandler -- tach input capture and counter overflow.
+ * TIM4 is not in the .ioc; if it is ever added, comment out
+ * HAL_TIM_IRQHandler(&htim4) in stm32f4xx_it.c as for TIM3. */
+void TIM4_IRQHandler(void)
+{
+    PROF_BEGIN(t);
+    uint32_t sr = htim4.Instance->SR & htim4.Instance->DIER;
+
+    if (sr & TIM_SR_CC3IF) {
+        uint32_t cap = htim4.Instance->CCR3;     /* clears CC3IF */
+        uint32_t hi  = g_tach_hi;
+        /* an overflow not yet counted came first if cap is in the low half */
+        if ((sr & TIM_SR_UIF) && cap < 0x8000u) hi += 0x10000u;
+        Tach_Edge(hi | cap);
+    }
+
+    if (sr & TIM_SR_UIF) {
+        /* the TIM3 ISR reads g_tach_hi and UIF as a pair (Tach_Now) */
+        __disable_irq();
+        g_tach_hi += 0x10000u;
+        htim4.Instance->SR = ~TIM_SR_UIF;
+        __enable_irq();
+    }
+    PROF_END(&g_prof, PZ_TIM4, t);
 }
 
 /* USER CODE END 0 */
@@ -648,13 +1950,39 @@ int main(void)
     SystemClock_Config();
 
     /* USER CODE BEGIN Init */
+    /* trace: DWT cycle counter for the execution time zones and the log
+     * timestamps, ITM port 0 for the zone dump, port 1 for the log */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    ITM->LAR = 0xC5ACCE55;
+    ITM->TCR = ITM_TCR_ITMENA_Msk;
+    ITM->TER = 1u | (1u << TRACE_ITM_PORT);
+    DWT->CYCCNT = 0u;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+
+#if TRACE_ENABLE
+    g_trace.ring  = g_trace_ring;
+    g_trace.count = TL_COUNT;
+    g_trace.level = Trace_Level;
+    g_trace.put   = Trace_ItmPut;
+    Trace_Init(&g_trace);
+#endif
+
+#if PROF_ENABLE
+    g_prof.zone    = g_prof_zone;
+    g_prof.names   = g_prof_name;
+    g_prof.count   = PZ_COUNT;
+    g_prof.tick_hz = SystemCoreClock;
+    Prof_Init(&g_prof);
+#endif
     /* USER CODE END Init */
 
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_I2C1_Init();
     MX_TIM1_Init();
     MX_TIM2_Init();
     MX_TIM3_Init();
+    MX_USART1_UART_Init();
 
     /* USER CODE BEGIN 2 */
 
@@ -704,25 +2032,51 @@ int main(void)
     HAL_TIM_Encoder_Start(&htim2, TIM_CHANNEL_ALL);
     ENC_RESET();
 
+#if STROBE_HW_GATE
+    /* TIM1 is enabled here but only counts while TIM3 opens the gate */
+    Strobe_HwInit();
+    HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1);
+#else
     HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1);
     __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, 0u);
+#endif
 
     HAL_NVIC_SetPriority(TIM3_IRQn, 2, 0);
     HAL_NVIC_EnableIRQ(TIM3_IRQn);
 
+    /* TIM4 first: in tach mode the TIM3 ISR reads its counter */
+    Tach_Init();
     Strobe_ApplyFreq();
+    if (g_tach_ratio != 0u) Tach_SetRatio(g_tach_ratio);
     Display_Update();
+    Console_Start();
 
     /* USER CODE END 2 */
 
     while (1)
     {
         /* USER CODE BEGIN WHILE */
+        PROF_BEGIN(t_loop);
 
         Button_Poll(&btn1);
         Button_Poll(&btn2);
         Button_Poll(&btn3);
 
+#if PROF_ENABLE
+        /* diag screen: BTN1 short=ITM dump, hold=clear; BTN2 short=back */
+        if (g_screen == SCREEN_DIAG) {
+            if (btn1.pressed) Diag_Dump();
+            if (btn1.held) {
+                Prof_Reset(&g_prof);
+                Notify("  CLEARED   ");
+            }
+            if (btn2.pressed) g_screen = SCREEN_MAIN;
+            btn1.pressed = btn1.held = btn2.pressed = 0u;
+        }
+        /* BTN2 hold: diag screen */
+        if (btn2.held) g_screen = SCREEN_DIAG;
+#endif
+
         /* BTN1 -- encoder push: short=cycle step, hold=save */
         if (btn1.pressed)
             g_step_idx = (uint8_t)((g_step_idx + 1u) % 3u);
@@ -743,14 +2097,35 @@ int main(void)
             Notify("   RESET    ");
         }
 
+        PROF_BEGIN(t_enc);
         Encoder_Process();
+        PROF_END(&g_prof, PZ_ENCODER, t_enc);
+        PROF_BEGIN(t_tach);
+        Tach_Poll();
+        PROF_END(&g_prof, PZ_TACH, t_tach);
+
+        /* command lines from USART1, answers out by TX DMA */
+        PROF_BEGIN(t_cmd);
+        Cmd_Poll(&g_cmd);
+        PROF_END(&g_prof, PZ_CMD, t_cmd);
+        Console_Flush();
 
         uint32_t now = HAL_GetTick();
         if ((now - last_display_tick) >= UPDATE_DELAY_MS) {
             last_display_tick = now;
+            PROF_BEGIN(t_disp);
             Display_Update();
+            PROF_END(&g_prof, PZ_DISPLAY, t_disp);
         }
 
+#if TRACE_ENABLE
+        /* idle time: the log, oldest record first */
+        PROF_BEGIN(t_trace);
+        Trace_Drain(&g_trace, TRACE_DRAIN_WORDS);
+        PROF_END(&g_prof, PZ_TRACE, t_trace);
+#endif
+        PROF_END(&g_prof, PZ_LOOP, t_loop);
+
         /* USER CODE END WHILE */
     }
 }
@@ -0,0 +1,127 @@
+/* Core/Src/strobe_calc.c */
+
+#include <stdint.h>
+
+#include "strobe_calc.h"
+
+/* PSC+1 candidates: divisors of the 10000-clock PWM period, ascending */
+static const uint16_t psc_div[] = {
+       1u,    2u,    4u,    5u,    8u,   10u,   16u,   20u,   25u,   40u,
+      50u,   80u,  100u,  125u,  200u,  250u,  400u,  500u,  625u, 1000u,
+    1250u, 2000u, 2500u, 5000u, 10000u
+};
+
+_Static_assert(STROBE_PWM_PERIOD_CLK == 10000u,
+               "psc_div[] lists the divisors of a 10000-clock PWM period");
+
+/* timer clocks per second, scaled by 1000 for millihertz input */
+#define CLK_MHZ_RATE  ((uint64_t)STROBE_TIM_CLK_HZ * 1000u)
+
+/* TIM3 setting for a period of num/den timer clocks */
+static void CalcTimingRatio(uint64_t num, uint64_t den_base,
+                            uint32_t duty_num, uint32_t duty_den, Strobe_Timing_t *t)
+{
+    uint32_t div = psc_div[0];
+    uint64_t den;
+    uint64_t q, r;
+
+    /* ideal period = num / (den_base * div) ticks; take the smallest
+     * divisor whose whole ticks leave room for a dithered ARR+1 */
+    for (uint32_t i = 0u; i < sizeof(psc_div) / sizeof(psc_div[0]); i++) {
+        div = psc_div[i];
+        if (num / (den_base * div) <= 65535u) break;
+    }
+
+    den = den_base * div;
+    q   = num / den;
+    r   = num % den;
+    if (q < 2u) { q = 2u; r = 0u; }
+    if (q > 65535u) { q = 65535u; r = 0u; }     /* below the range at PSC max */
+
+    t->psc    = (uint16_t)(div - 1u);
+    t->arr_lo = (uint16_t)(q - 1u);
+    t->arr    = (uint16_t)(q - 1u + ((2u * r >= den) ? 1u : 0u));
+
+    /* r/den as Q0.32 by long division, r < den < 2^34 */
+    t->frac = 0u;
+    for (uint32_t bit = 0u; bit < 32u; bit++) {
+        r <<= 1;
+        t->frac <<= 1;
+        if (r >= den) { r -= den; t->frac |= 1u; }
+    }
+
+    t->ccr = Strobe_CalcWindow(t->psc, t->arr_lo, duty_num, duty_den);
+}
+
+void Strobe_CalcTiming(uint32_t freq_mhz, uint32_t duty_num, uint32_t duty_den,
+                       Strobe_Timing_t *t)
+{
+    if (freq_mhz == 0u) freq_mhz = 1u;
+    CalcTimingRatio(CLK_MHZ_RATE, freq_mhz, duty_num, duty_den, t);
+}
+
+void Strobe_CalcTimingPeriod(uint64_t period_q8, uint32_t duty_num, uint32_t duty_den,
+                             Strobe_Timing_t *t)
+{
+    CalcTimingRatio(period_q8, 256u, duty_num, duty_den, t);
+}
+
+uint16_t Strobe_CalcWindow(uint16_t psc, uint16_t arr, uint32_t duty_num, uint32_t duty_den)
+{
+    uint32_t pwm_ticks = STROBE_PWM_PERIOD_CLK / ((uint32_t)psc + 1u);
+    uint32_t ccr       = ((uint32_t)arr + 1u) * duty_num / duty_den;
+
+    /* CCR1 > ARR would hold the gate open across the update event */
+    if (ccr > arr)       ccr = arr;
+    ccr -= ccr % pwm_ticks;
+    if (ccr < pwm_ticks) ccr = pwm_ticks;
+    return (uint16_t)ccr;
+}
+
+uint16_t Strobe_DitherARR(const Strobe_Timing_t *t, uint32_t *acc)
+{
+    uint32_t prev = *acc;
+    *acc += t->frac;
+    return (uint16_t)(t->arr_lo + ((*acc < prev) ? 1u : 0u));
+}
+
+int32_t Strobe_CalcPhaseTicks(const Strobe_Timing_t *t, int32_t deg)
+{
+    int32_t period = (int32_t)t->arr + 1;
+    int32_t ticks;
+
+    deg %= 360;
+    if (deg < 0) deg += 360;
+
+    ticks = (int32_t)(((int64_t)period * deg + 180) / 360);
+    if (ticks > period / 2) ticks -= period;
+    return ticks;
+}
+
+uint16_t Strobe_PhaseARR(uint16_t arr, uint16_t ccr, int32_t *pending)
+{
+    int32_t period = (int32_t)arr + 1;
+    int32_t up     = 65535 - (int32_t)arr;          /* most it can stretch */
+    int32_t down   = (int32_t)arr - (int32_t)ccr;   /* most it can shrink  */
+    int32_t p      = *pending % period;         /* whole periods: no shift */
+    int32_t step;
+
+    /* go the other way round when that takes fewer periods */
+    if (p > up && (int64_t)(period - p) * up < (int64_t)p * down)
+        p -= period;
+    else if (-p > down && (int64_t)(period + p) * down < (int64_t)(-p) * up)
+        p += period;
+
+    step = p;
+    if (step > up)    step = up;
+    if (step < -down) step = -down;
+    *pending = p - step;
+    return (uint16_t)((int32_t)arr + step);
+}
+
+uint16_t Strobe_CalcGatedCompare(uint32_t on_counts)
+{
+    if (on_counts == 0u)             on_counts = 1u;
+    if (on_counts > STROBE_TIM1_ARR) on_counts = STROBE_TIM1_ARR;
+    return (uint16_t)(STROBE_TIM1_ARR + 1u - on_counts);
+}
@@ -0,0 +1,91 @@
+/* Core/Src/strobe_pll.c */
+
+#include <stdint.h>
+
+#include "strobe_pll.h"
+
+void Strobe_TachReset(Strobe_Tach_t *t)
+{
+    t->count     = 0u;
+    t->pos       = 0u;
+    t->period_q8 = 0u;
+}
+
+uint64_t Strobe_TachFilter(Strobe_Tach_t *t, uint32_t period)
+{
+    uint32_t sorted[STROBE_TACH_MEDIAN];
+    uint32_t median;
+    int64_t  step;
+
+    t->hist[t->pos] = period;
+    t->pos = (uint8_t)((t->pos + 1u) % STROBE_TACH_MEDIAN);
+    if (t->count < STROBE_TACH_MEDIAN) t->count++;
+
+    /* insertion sort of at most 5 values */
+    for (uint32_t i = 0u; i < t->count; i++) {
+        uint32_t v = t->hist[i];
+        uint32_t j = i;
+        while (j > 0u && sorted[j - 1u] > v) { sorted[j] = sorted[j - 1u]; j--; }
+        sorted[j] = v;
+    }
+    median = sorted[(t->count - 1u) / 2u];
+
+    if (t->period_q8 == 0u) {
+        t->period_q8 = (uint64_t)median << 8;
+    } else {
+        step = ((int64_t)((uint64_t)median << 8) - (int64_t)t->period_q8) / (int64_t)STROBE_TACH_IIR;
+        t->period_q8 = (uint64_t)((int64_t)t->period_q8 + step);
+    }
+    return t->period_q8;
+}
+
+void Strobe_PllReset(Strobe_Pll_t *p)
+{
+    p->pulse    = 0u;
+    p->integ_q8 = 0;
+    p->error    = 0;
+    p->good     = 0u;
+    p->locked   = 0u;
+}
+
+uint8_t Strobe_PllEdge(Strobe_Pll_t *p, uint64_t tach_q8, int32_t to_flash,
+                       uint64_t *period_q8)
+{
+    int64_t ff_q8, ts, delay, e, corr_q8, lim_q8;
+
+    if (++p->pulse < p->div) return 0u;
+    p->pulse = 0u;
+
+    ff_q8 = (int64_t)(tach_q8 * p->div / p->mult);
+    ts    = ff_q8 >> 8;
+    if (ts < 2) return 0u;
+
+    /* phase error, + = the flash comes too late */
+    delay = ts * p->delay_deg / 360;
+    e     = ((int64_t)to_flash - delay) % ts;
+    if (e < 0)      e += ts;
+    if (e > ts / 2) e -= ts;
+    p->error = (int32_t)e;
+
+    if (e < ts / 64 && e > -ts / 64) {
+        if (p->good < STROBE_PLL_LOCK_IN) p->good++;
+        else                              p->locked = 1u;
+    } else if (e > ts / 16 || e < -ts / 16) {
+        p->good   = 0u;
+        p->locked = 0u;
+    }
+
+    /* PI, both terms limited so a bad reference cannot run away */
+    lim_q8 = ff_q8 / 8;
+    p->integ_q8 += (e * 256) / 4;
+    if (p->integ_q8 >  lim_q8) p->integ_q8 =  lim_q8;
+    if (p->integ_q8 < -lim_q8) p->integ_q8 = -lim_q8;
+
+    corr_q8 = (e * 256) / 2 + p->integ_q8;
+    lim_q8  = ff_q8 / 4;
+    if (corr_q8 >  lim_q8) corr_q8 =  lim_q8;
+    if (corr_q8 < -lim_q8) corr_q8 = -lim_q8;
+
+    *period_q8 = (uint64_t)(ff_q8 - corr_q8 / p->mult);
+    return 1u;
+}
@@ -0,0 +1,244 @@
+/*
+ * ads1220_acq_sim.c - host simulation of the 005-scale-ADS1220 DRDY/DMA
+ *                     acquisition and its sample ring (App/ADS1220)
+ *
+ * The event loop of tools/ads1220_bus_sim.c for one device: a virtual
+ * ADS1220 converts continuously at 2000 SPS (turbo, DR 6) on its own
+ * oscillator, and the firmware's ads1220_acq.c is driven the way main.c
+ * drives it:
+ *
+ *   - DRDY falls: ADS1220_AcqOnDrdy() from the EXTI handler;
+ *   - the read it starts completes 3 SPI bytes later (390.625 kHz) plus
+ *     the interrupt entry: ADS1220_AcqOnReadDone();
+ *   - the device hands out the result of its latest DRDY when CS goes low;
+ *   - the main loop takes batches of 16, a few us of work per sample, and
+ *     every 200 ms (UPDATE_DELAY_MS) blocks in the display flush for the
+ *     stall of the case. passes alternate between ADS1220_AcqRead (copy,
+ *     then work) and ADS1220_AcqPeek / ADS1220_AcqCommit as main.c does
+ *     (work on the samples in the ring, then hand the slots back), so a
+ *     slot reused before its commit shows as a wrong sample.
+ *
+ * ads1220_acq.c is included here with ADS1220_ACQ_BARRIER() pointing at
+ * the event loop, so the interrupts also preempt AcqRead and AcqPeek
+ * between their index reads, the copy and the tail update, at a random
+ * point of time.
+ *
+ * Every conversion carries a sequence number in its code, so the main
+ * loop sees a lost sample as a gap and a duplicate as a repeat; the
+ * timestamp of each sample must be the one of its DRDY edge. A stall
+ * longer than the ring (128 samples, 64 ms) must lose samples only
+ * through the dropped counter: the gaps seen equal `dropped`.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Wall -I005-scale-ADS1220/App/ADS1220 tools/ads1220_acq_sim.c \
+ *       005-scale-ADS1220/App/ADS1220/ads1220.c \
+ *       005-scale-ADS1220/App/ADS1220/ads1220_scan.c \
+ *       -o ads1220_acq_sim && ./ads1220_acq_sim
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void preempt(void);
+#define ADS1220_ACQ_BARRIER()   preempt()
+#include "../005-scale-ADS1220/App/ADS1220/ads1220_acq.c"
+
+#define SPI_US_PER_BYTE (8.0 / 0.390625)
+#define ISR_US          2.0             /* interrupt entry + handler      */
+#define TICKS_PER_US    100.0           /* DWT at 100 MHz                 */
+#define SPS             2000.0
+#define LOOP_US         300.0           /* main loop pass without samples */
+#define SAMPLE_US       4.0             /* main loop work per sample      */
+#define DISPLAY_US      200000.0        /* UPDATE_DELAY_MS                */
+#define NLOG            4096u           /* DRDY times kept for the check  */
+
+typedef struct {
+    const char *name;
+    double      ppm;            /* rate error of the oscillator      */
+    double      stall_us;       /* display flush                     */
+    double      secs;
+} Case_t;
+
+static double now;
+static int    in_isr;
+static uint32_t failed;
+
+/* the virtual device */
+static double   next_drdy, period;
+static uint32_t seq;                    /* sequence number of the latest result */
+static double   drdy_at[NLOG];          /* DRDY time per sequence number        */
+static int      selected;
+
+/* the read in flight */
+static uint8_t *dma_rx;
+static double   dma_done = -1.0;
+
+static ADS1220_Acq_t hacq;
+
+/* what the main loop has seen */
+static uint32_t last, got, gaps, dups, late;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+static void cs_low(void)  { selected = 1; }
+static void cs_high(void) { selected = 0; }
+
+static int read_start(uint8_t *rx, uint16_t len)
+{
+    check(selected, "CS low for the read");
+    rx[0] = (uint8_t)(seq >> 16) & 0x7Fu;
+    rx[1] = (uint8_t)(seq >> 8);
+    rx[2] = (uint8_t)seq;
+    dma_rx   = rx;
+    dma_done = now + len * SPI_US_PER_BYTE + ISR_US;
+    return 0;
+}
+
+static uint32_t ticks(void) { return (uint32_t)(now * TICKS_PER_US); }
+
+/* the interrupts due by t, in order, each ISR_US long */
+static void run_isrs(double t)
+{
+    in_isr = 1;
+    for (;;) {
+        if (dma_done >= 0.0 && dma_done <= next_drdy && dma_done <= t) {
+            if (now < dma_done) now = dma_done;
+            dma_done = -1.0;
+            ADS1220_AcqOnReadDone(&hacq, 0);
+        } else if (next_drdy <= t) {
+            if (now < next_drdy) now = next_drdy;
+            seq++;
+            drdy_at[seq % NLOG] = next_drdy;
+            next_drdy += period;
+            ADS1220_AcqOnDrdy(&hacq);
+            now += ISR_US;
+        } else {
+            break;
+        }
+    }
+    in_isr = 0;
+}
+
+/* main loop code for us microseconds, interrupted by whatever is due */
+static void busy(double us)
+{
+    double end = now + us;
+
+    run_isrs(end);
+    if (now < end) now = end;
+}
+
+/* an interrupt may hit AcqRead here, after up to 70 us of its work */
+static void preempt(void)
+{
+    if (in_isr) return;
+    busy(70.0 * rand() / RAND_MAX);
+}
+
+static void use(const ADS1220_Sample_t *sample)
+{
+    uint32_t s = (uint32_t)sample->code;
+
+    if (s <= last)          dups++;
+    else if (s != last + 1) gaps += s - last - 1u;
+    if (s > last) last = s;
+    got++;
+    if (sample->time != (uint32_t)(drdy_at[s % NLOG] * TICKS_PER_US)) late++;
+}
+
+/* one batch out of the ring and its work: a copy, or in place as main.c */
+static uint16_t take(void)
+{
+    static uint8_t          in_place;
+    ADS1220_Sample_t        copy[16];
+    const ADS1220_Sample_t *batch;
+    uint16_t                n;
+
+    in_place ^= 1u;
+    if (in_place) {
+        /* the work first, then the check: a slot the ISR reused
+         * meanwhile shows as a wrong sample */
+        n = ADS1220_AcqPeek(&hacq, &batch, 16);
+        busy(n * SAMPLE_US);
+        for (uint16_t i = 0; i < n; i++) use(&batch[i]);
+        ADS1220_AcqCommit(&hacq, n);
+    } else {
+        n = ADS1220_AcqRead(&hacq, copy, 16);
+        for (uint16_t i = 0; i < n; i++) use(&copy[i]);
+        busy(n * SAMPLE_US);
+    }
+    return n;
+}
+
+static void run(const Case_t *c)
+{
+    static ADS1220_Handle_t hads = { .csLow = cs_low, .csHigh = cs_high };
+    double   next_display = DISPLAY_US;
+    uint16_t fill_max = 0;
+
+    period    = 1e6 / SPS * (1.0 - c->ppm * 1e-6);
+    next_drdy = 1000.0 * rand() / RAND_MAX;
+    seq       = 0;
+    last = got = gaps = dups = late = 0u;
+    now       = 0.0;
+    dma_done  = -1.0;
+    hacq.hads      = &hads;
+    hacq.readStart = read_start;
+    hacq.timestamp = ticks;
+    check(ADS1220_AcqInit(&hacq) == ADS1220_OK, "AcqInit");
+    ADS1220_AcqStart(&hacq);
+
+    while (now < c->secs * 1e6) {
+        if (ADS1220_AcqPending(&hacq) > fill_max) fill_max = ADS1220_AcqPending(&hacq);
+        while (take() != 0) { }
+        busy(LOOP_US);
+        if (now >= next_display) {
+            next_display += DISPLAY_US;
+            busy(c->stall_us);
+        }
+    }
+    /* stop the device, the last read completes */
+    next_drdy = 1e300;
+    busy(1000.0);
+    ADS1220_AcqStop(&hacq);
+    while (take() != 0) { }
+    gaps += seq - last;                 /* lost at the very end */
+
+    printf("%-30s| %6u conv %6u read  gaps %u  dup %u  bad time %u  |"
+           "  dropped %u  overruns %u  errors %u  |  ring max %u of %u\n",
+           c->name, seq, got, gaps, dups, late, hacq.dropped, hacq.overruns, hacq.errors,
+           fill_max, ADS1220_ACQ_RING);
+
+    check(dups == 0u && late == 0u, "no duplicate, every sample with its DRDY time");
+    check(got == seq - gaps && hacq.count == got, "every sample read once");
+    check(gaps == hacq.dropped + hacq.overruns, "every lost sample counted");
+    if (c->stall_us < 1e6 * ADS1220_ACQ_RING / SPS * 0.9)
+        check(gaps == 0u && hacq.dropped == 0u && hacq.overruns == 0u, "stall within the ring loses nothing");
+    else
+        check(hacq.dropped > 0u, "stall past the ring shows in dropped");
+}
+
+int main(void)
+{
+    static const Case_t cases[] = {
+        { "25 ms flush",                    0.0, 25000.0, 10 },
+        { "25 ms flush, +2% oscillator", 20000.0, 25000.0, 10 },
+        { "25 ms flush, -2% oscillator",-20000.0, 25000.0, 10 },
+        { "55 ms flush",                    0.0, 55000.0, 10 },
+        { "80 ms flush (past the ring)",    0.0, 80000.0, 10 },
+    };
+
+    srand(11);
+    for (unsigned i = 0u; i < sizeof(cases) / sizeof(cases[0]); i++)
+        run(&cases[i]);
+
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * ads1220_bus_sim.c - host simulation of the 005-scale-ADS1220 bus manager
+ *
+ * Four virtual ADS1220 convert continuously at 1000 SPS, each on its own
+ * oscillator (rate error and start phase per case). Their DRDY edges and
+ * the DMA completions are fed as events through the firmware's own
+ * ads1220_bus.c the way main.c would drive it:
+ *
+ *   - DRDY i falls: ADS1220_BusOnDrdy(bus, i) from the EXTI handler;
+ *   - a read started by readStart() completes 3 SPI bytes later (390.625
+ *     kHz) plus the interrupt entry: ADS1220_BusOnReadDone();
+ *   - a device hands out the result of its latest DRDY when its CS goes
+ *     low, a result not read before the next DRDY is lost;
+ *   - the main loop takes frames every 20 ms.
+ *
+ * Every result carries a per-device sequence number, so a gap is a lost
+ * conversion. For each case it prints reads, losses, the longest DRDY to
+ * read-complete latency against the N * read time bound, and the frames.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/ADS1220 tools/ads1220_bus_sim.c \
+ *       005-scale-ADS1220/App/ADS1220/ads1220.c \
+ *       005-scale-ADS1220/App/ADS1220/ads1220_bus.c \
+ *       -o ads1220_bus_sim && ./ads1220_bus_sim
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ads1220_bus.h"
+
+#define NDEV            4
+#define SPI_US_PER_BYTE (8.0 / 0.390625)
+#define ISR_US          2.0             /* interrupt entry + handler      */
+#define READ_US         (3.0 * SPI_US_PER_BYTE + ISR_US)
+#define TICKS_PER_US    100.0           /* DWT at 100 MHz                 */
+#define DRAIN_US        20000.0
+
+typedef struct {
+    const char *name;
+    double      ppm[NDEV];      /* rate error of each oscillator      */
+    double      phase_us[NDEV]; /* first DRDY, < 0 = random           */
+    double      secs;
+} Case_t;
+
+static double now;
+
+/* virtual devices */
+static double   next_drdy[NDEV];
+static double   period[NDEV];
+static uint32_t seq[NDEV];      /* sequence number of the latest result */
+static int      selected = -1;
+
+/* the read in flight */
+static uint8_t *dma_rx;
+static double   dma_done = -1.0;
+
+static void cs_low(int d)  { selected = d; }
+static void cs_high(void)  { selected = -1; }
+static void cs0_low(void) { cs_low(0); }
+static void cs1_low(void) { cs_low(1); }
+static void cs2_low(void) { cs_low(2); }
+static void cs3_low(void) { cs_low(3); }
+
+static int      spi_none(const uint8_t *tx, uint8_t *rx, uint16_t len) { (void)tx; (void)rx; (void)len; return 0; }
+static uint8_t  drdy_none(void) { return 1; }
+
+static int read_start(uint8_t *rx, uint16_t len)
+{
+    uint32_t v = ((uint32_t)selected << 20) | (seq[selected] & 0xFFFFFu);
+
+    rx[0] = (uint8_t)(v >> 16);
+    rx[1] = (uint8_t)(v >> 8);
+    rx[2] = (uint8_t)v;
+    dma_rx   = rx;
+    dma_done = now + len * SPI_US_PER_BYTE + ISR_US;
+    return 0;
+}
+
+static uint32_t ticks(void) { return (uint32_t)(now * TICKS_PER_US); }
+
+static void run(const Case_t *c)
+{
+    static ADS1220_Handle_t hads[NDEV] = {
+        { .csLow = cs0_low, .csHigh = cs_high, .spiTxRx = spi_none, .drdyRead = drdy_none },
+        { .csLow = cs1_low, .csHigh = cs_high, .spiTxRx = spi_none, .drdyRead = drdy_none },
+        { .csLow = cs2_low, .csHigh = cs_high, .spiTxRx = spi_none, .drdyRead = drdy_none },
+        { .csLow = cs3_low, .csHigh = cs_high, .spiTxRx = spi_none, .drdyRead = drdy_none },
+    };
+    static ADS1220_Bus_t bus;
+    double   lat_max = 0.0, next_drain = DRAIN_US, t_drdy_pending[NDEV];
+    uint32_t last_seen[NDEV], conversions = 0;
+    long     gaps = 0, frames = 0;
+    int      d;
+
+    for (d = 0; d < NDEV; d++) {
+        bus.hads[d]       = &hads[d];
+        period[d]         = 1000.0 * (1.0 - c->ppm[d] * 1e-6);
+        next_drdy[d]      = c->phase_us[d] >= 0.0 ? c->phase_us[d] : 1000.0 * rand() / RAND_MAX;
+        seq[d]            = 0;
+        last_seen[d]      = 0;
+        t_drdy_pending[d] = 0.0;
+    }
+    bus.count     = NDEV;
+    bus.readStart = read_start;
+    bus.timestamp = ticks;
+    now           = 0.0;
+    dma_done      = -1.0;
+    ADS1220_BusInit(&bus);
+    ADS1220_BusStart(&bus);
+
+    while (now < c->secs * 1e6) {
+        int    first = 0;
+        double t     = next_drdy[0];
+
+        for (d = 1; d < NDEV; d++)
+            if (next_drdy[d] < t) { t = next_drdy[d]; first = d; }
+
+        if (dma_done >= 0.0 && dma_done <= t && dma_done <= next_drain) {
+            /* read complete: check the sequence, then chain the next read */
+            uint32_t v   = ((uint32_t)dma_rx[0] << 16) | ((uint32_t)dma_rx[1] << 8) | dma_rx[2];
+            int      dev = (int)(v >> 20);
+            uint32_t s   = v & 0xFFFFFu;
+
+            now      = dma_done;
+            dma_done = -1.0;
+            if (s != last_seen[dev] + 1u) gaps += (long)(s - last_seen[dev] - 1u);
+            last_seen[dev] = s;
+            if (now - t_drdy_pending[dev] > lat_max) lat_max = now - t_drdy_pending[dev];
+            ADS1220_BusOnReadDone(&bus, 0);
+        } else if (next_drain <= t) {
+            ADS1220_BusFrame_t f[8];
+            uint16_t           n;
+
+            now = next_drain;
+            while ((n = ADS1220_BusRead(&bus, f, 8)) != 0) frames += n;
+            next_drain += DRAIN_US;
+        } else {
+            /* conversion complete on device `first` */
+            now = t;
+            seq[first]++;
+            conversions++;
+            t_drdy_pending[first] = now;
+            next_drdy[first] += period[first];
+            ADS1220_BusOnDrdy(&bus, (uint8_t)first);
+            now += ISR_US;
+        }
+    }
+
+    printf("%-34s| %6lu conv %6lu read  lost %ld  overruns %lu  errors %lu  |"
+           "  latency max %5.1f us (bound %5.1f)  wait max %5.1f us  |"
+           "  frames %5ld  replaced %lu  dropped %lu\n",
+           c->name, (unsigned long)conversions, (unsigned long)bus.reads, gaps,
+           (unsigned long)bus.overruns, (unsigned long)bus.errors,
+           lat_max, NDEV * READ_US + ISR_US, bus.max_wait / TICKS_PER_US,
+           frames, (unsigned long)bus.replaced, (unsigned long)bus.dropped);
+}
+
+static void corners(const char *name, int32_t fl, int32_t fr, int32_t rl, int32_t rr)
+{
+    const int32_t w[4] = { fl, fr, rl, rr };
+    int16_t       x, y;
+    int32_t       total = ADS1220_BusCorners(w, &x, &y);
+
+    printf("%-34s| total %7ld  x %5d  y %5d\n", name, (long)total, x, y);
+}
+
+int main(void)
+{
+    static const Case_t cases[] = {
+        { "same clock, DRDY aligned",     {    0,    0,    0,    0 }, { 0,  0,  0,  0 }, 10 },
+        { "same clock, random phase",     {    0,    0,    0,    0 }, { -1, -1, -1, -1 }, 10 },
+        { "+-0.5% oscillators",           { 5000, -5000, 2000, -1000 }, { -1, -1, -1, -1 }, 10 },
+        { "+-2% oscillators (datasheet)", { 20000, -20000, 10000, -15000 }, { 0, 0, 0, 0 }, 10 },
+    };
+
+    srand(3);
+    for (unsigned i = 0u; i < sizeof(cases) / sizeof(cases[0]); i++)
+        run(&cases[i]);
+
+    corners("load centered",        2500, 2500, 2500, 2500);
+    corners("load front-left cell", 10000,   0,    0,    0);
+    corners("load halfway right",   1250, 3750, 1250, 3750);
+    corners("empty platform",          0,    0,    0,    0);
+    return 0;
+}
@@ -0,0 +1,569 @@
+/*
+ * ads1220_reg_model.c - host test of the ADS1220 typed configuration
+ *                       (005-scale-ADS1220 App/ADS1220/ads1220.c)
+ *
+ * A register model of the ADS1220 sits behind the driver's callbacks: it
+ * decodes the byte stream of each CS frame (RESET, START, WREG, RREG) into
+ * CONFIG0-3 and answers RREG from them, and it can be told to fail:
+ *   stuck bit   a register bit that reads back 0 whatever is written,
+ *   lost write  the device ignores one WREG (CS glitch, no clock),
+ *   SPI error   the spiTxRx callback reports an error on one transfer.
+ *
+ * Checks:
+ *   - ADS1220_ConfigToRegs against a field table written from the data
+ *     sheet (CONFIG0 MUX/GAIN/PGA_BYPASS, CONFIG1 DR/MODE/CM/TS/BCS,
+ *     CONFIG2 VREF/50-60/PSW/IDAC, CONFIG3 I1MUX/I2MUX/DRDYM): every value
+ *     of every field lands in its bits and nowhere else, also in random
+ *     combinations;
+ *   - invalid settings are refused, and only those: out of range values,
+ *     a gain that is not a power of two, pga_bypass with a gain above 4,
+ *     50/60 Hz rejection at any rate but 20 SPS normal (or 5 SPS
+ *     duty-cycle, which the data sheet allows too), and a refused
+ *     ADS1220_Configure sends nothing;
+ *   - ADS1220_Configure leaves the device registers equal to the packed
+ *     setting and the shadow equal to the device;
+ *   - a read-back that differs returns ADS1220_VERIFY_FAIL and clears
+ *     regs_valid, an SPI error returns ADS1220_ERROR and clears it too,
+ *     and the next Configure writes all four registers again;
+ *   - the bytes each call puts on the bus, through the register shadow:
+ *     a setter that changes nothing sends nothing, a gain change is one
+ *     2-byte WREG, an IDAC change of CONFIG2 and CONFIG3 one 3-byte WREG,
+ *     a failed write invalidates the shadow and the next setter reads all
+ *     four registers first; random setter sequences send exactly one WREG
+ *     over the changed registers, never a read.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Wall -I005-scale-ADS1220/App/ADS1220 tools/ads1220_reg_model.c \
+ *       005-scale-ADS1220/App/ADS1220/ads1220.c \
+ *       -o ads1220_reg_model && ./ads1220_reg_model
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ads1220.h"
+
+/* ---- device model --------------------------------------------------------- */
+
+static struct {
+    uint8_t  regs[4];
+    int      cs;
+    uint8_t  cmd;               /* command of this frame, 0 none yet   */
+    uint8_t  pos;               /* register bytes so far               */
+    uint8_t  stuck[4];          /* bits that read back 0               */
+    int      lose_wreg;         /* next WREG is ignored                */
+    int      spi_fail;          /* transfer number to fail, 0 none     */
+    uint32_t xfers;             /* spiTxRx calls                       */
+    uint32_t frames, wregs, rregs, bytes;
+} dev;
+
+static uint64_t rng = 88172645463325252ull;
+static uint32_t failed;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+static uint32_t rnd(uint32_t n)
+{
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (uint32_t)((rng >> 11) % n);
+}
+
+static void cs_low(void)
+{
+    check(!dev.cs, "CS low once per frame");
+    dev.cs  = 1;
+    dev.cmd = 0;
+    dev.pos = 0;
+    dev.frames++;
+}
+
+static void cs_high(void) { dev.cs = 0; }
+
+static uint8_t dev_byte(uint8_t in)
+{
+    uint8_t out = 0xFF;
+
+    dev.bytes++;
+    if (!dev.cmd) {
+        dev.cmd = in;
+        if ((in & 0xF0) == ADS1220_CMD_WREG) {
+            dev.wregs++;
+            if (dev.lose_wreg) { dev.lose_wreg = 0; dev.cmd = 0xFF; }
+        }
+        if ((in & 0xF0) == ADS1220_CMD_RREG) dev.rregs++;
+        if (in == ADS1220_CMD_RESET) memset(dev.regs, 0, sizeof(dev.regs));
+        return out;
+    }
+
+    uint8_t reg = (uint8_t)(((dev.cmd >> 2) & 3u) + dev.pos);
+    uint8_t n   = (uint8_t)((dev.cmd & 3u) + 1u);
+
+    if (dev.pos < n && reg < 4u) {
+        if ((dev.cmd & 0xF0) == ADS1220_CMD_WREG) dev.regs[reg] = in;
+        if ((dev.cmd & 0xF0) == ADS1220_CMD_RREG) out = (uint8_t)(dev.regs[reg] & ~dev.stuck[reg]);
+    }
+    dev.pos++;
+    return out;
+}
+
+static int spi_txrx(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    check(dev.cs, "SPI only with CS low");
+    if (++dev.xfers == (uint32_t)dev.spi_fail) return -1;
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t o = dev_byte(tx ? tx[i] : 0x00);
+        if (rx) rx[i] = o;
+    }
+    return 0;
+}
+
+static uint8_t drdy_read(void) { return 1; }
+
+static ADS1220_Handle_t hads = {
+    .csLow = cs_low, .csHigh = cs_high, .spiTxRx = spi_txrx, .drdyRead = drdy_read
+};
+
+static void dev_counts_reset(void)
+{
+    dev.frames = dev.wregs = dev.rregs = dev.bytes = 0u;
+}
+
+/* ---- data sheet field table --------------------------------------------------- */
+
+enum {
+    F_INPUT, F_GAIN, F_BYPASS, F_DR, F_MODE, F_CM, F_TS, F_BCS,
+    F_REF, F_REJECT, F_PSW, F_IDAC, F_I1MUX, F_I2MUX, F_DRDYM, F_COUNT
+};
+
+static const struct {
+    const char *name;
+    uint8_t     reg, shift, width;
+    uint8_t     values;         /* valid field values 0 .. values-1 */
+} field[F_COUNT] = {
+    { "MUX",        0, 4, 4, 15 },
+    { "GAIN",       0, 1, 3,  8 },
+    { "PGA_BYPASS", 0, 0, 1,  2 },
+    { "DR",         1, 5, 3,  7 },
+    { "MODE",       1, 3, 2,  3 },
+    { "CM",         1, 2, 1,  2 },
+    { "TS",         1, 1, 1,  2 },
+    { "BCS",        1, 0, 1,  2 },
+    { "VREF",       2, 6, 2,  4 },
+    { "50/60",      2, 4, 2,  4 },
+    { "PSW",        2, 3, 1,  2 },
+    { "IDAC",       2, 0, 3,  8 },
+    { "I1MUX",      3, 5, 3,  7 },
+    { "I2MUX",      3, 2, 3,  7 },
+    { "DRDYM",      3, 1, 1,  2 },
+};
+
+/* field values (gain as its code) into a config */
+static void set_field(ADS1220_Config_t *c, int f, uint8_t v)
+{
+    switch (f) {
+    case F_INPUT:  c->input           = (ADS1220_Input_t)v;   break;
+    case F_GAIN:   c->gain            = (uint8_t)(1u << v);   break;
+    case F_BYPASS: c->pga_bypass      = v;                    break;
+    case F_DR:     c->dr              = v;                    break;
+    case F_MODE:   c->mode            = (ADS1220_OpMode_t)v;  break;
+    case F_CM:     c->continuous      = v;                    break;
+    case F_TS:     c->temp_sensor     = v;                    break;
+    case F_BCS:    c->burnout         = v;                    break;
+    case F_REF:    c->ref             = (ADS1220_Ref_t)v;     break;
+    case F_REJECT: c->reject          = (ADS1220_Reject_t)v;  break;
+    case F_PSW:    c->low_side_switch = v;                    break;
+    case F_IDAC:   c->idac            = (ADS1220_Idac_t)v;    break;
+    case F_I1MUX:  c->idac1           = (ADS1220_IdacMux_t)v; break;
+    case F_I2MUX:  c->idac2           = (ADS1220_IdacMux_t)v; break;
+    default:       c->drdy_on_dout    = v;                    break;
+    }
+}
+
+/* the registers from field values, by the table */
+static void pack_ref(const uint8_t v[F_COUNT], uint8_t regs[4])
+{
+    memset(regs, 0, 4);
+    for (int f = 0; f < F_COUNT; f++)
+        regs[field[f].reg] |= (uint8_t)(v[f] << field[f].shift);
+}
+
+static int valid_ref(const uint8_t v[F_COUNT])
+{
+    if (v[F_BYPASS] && v[F_GAIN] > 2u) return 0;                        /* gain > 4 */
+    if (v[F_REJECT] && !(v[F_DR] == 0u && v[F_MODE] != 2u)) return 0;   /* 20 SPS normal, 5 SPS duty */
+    return 1;
+}
+
+static void random_fields(uint8_t v[F_COUNT], ADS1220_Config_t *c)
+{
+    memset(c, 0, sizeof(*c));
+    for (int f = 0; f < F_COUNT; f++) {
+        v[f] = (uint8_t)rnd(field[f].values);
+        set_field(c, f, v[f]);
+    }
+}
+
+/* ---- checks ---------------------------------------------------------------------- */
+
+static void encode_fields(void)
+{
+    uint32_t bad = 0, tried = 0;
+
+    /* every value of every field, the others at 0 (a valid setting) */
+    for (int f = 0; f < F_COUNT; f++) {
+        for (uint8_t x = 0; x < field[f].values; x++) {
+            ADS1220_Config_t c;
+            uint8_t          v[F_COUNT] = { 0 }, want[4], regs[4];
+
+            memset(&c, 0, sizeof(c));
+            for (int g = 0; g < F_COUNT; g++) set_field(&c, g, 0);
+            v[f] = x;
+            set_field(&c, f, x);
+            if (!valid_ref(v)) continue;
+            pack_ref(v, want);
+            tried++;
+            if (ADS1220_ConfigToRegs(&c, regs) != ADS1220_OK || memcmp(regs, want, 4) != 0) {
+                printf("  %s = %u: %02X %02X %02X %02X, want %02X %02X %02X %02X\n",
+                       field[f].name, x, regs[0], regs[1], regs[2], regs[3],
+                       want[0], want[1], want[2], want[3]);
+                bad++;
+            }
+        }
+    }
+    printf("every field value alone:    %4u settings, %u wrong\n", tried, bad);
+    check(bad == 0u, "every field value encodes into its bits only");
+
+    /* random combinations, valid and invalid */
+    {
+        uint32_t ok = 0, refused = 0, wrong = 0;
+        for (uint32_t i = 0; i < 200000u; i++) {
+            ADS1220_Config_t c;
+            uint8_t          v[F_COUNT], want[4], regs[4];
+            ADS1220_Status_t st;
+
+            random_fields(v, &c);
+            st = ADS1220_ConfigToRegs(&c, regs);
+            if (valid_ref(v)) {
+                pack_ref(v, want);
+                if (st != ADS1220_OK || memcmp(regs, want, 4) != 0) wrong++;
+                ok++;
+            } else {
+                if (st != ADS1220_ERROR) wrong++;
+                refused++;
+            }
+        }
+        printf("random combinations:      %6u valid, %u invalid, %u wrong\n", ok, refused, wrong);
+        check(wrong == 0u, "random settings pack by the table, invalid ones are refused");
+    }
+}
+
+static void refuse(const char *what, void (*edit)(ADS1220_Config_t *), int expect_ok)
+{
+    ADS1220_Config_t c;
+    uint8_t          regs[4];
+    ADS1220_Status_t st;
+
+    ADS1220_DefaultConfig(&c);
+    edit(&c);
+    st = ADS1220_ConfigToRegs(&c, regs);
+    dev_counts_reset();
+    if (!expect_ok) {
+        check(st == ADS1220_ERROR, what);
+        check(ADS1220_Configure(&hads, &c) == ADS1220_ERROR && dev.bytes == 0u,
+              "refused setting sends nothing");
+    } else {
+        check(st == ADS1220_OK, what);
+    }
+}
+
+static void e_gain3(ADS1220_Config_t *c)      { c->gain = 3; }
+static void e_gain0(ADS1220_Config_t *c)      { c->gain = 0; }
+static void e_gain256(ADS1220_Config_t *c)    { c->gain = 255; }
+static void e_input(ADS1220_Config_t *c)      { c->input = (ADS1220_Input_t)15; }
+static void e_mode(ADS1220_Config_t *c)       { c->mode = (ADS1220_OpMode_t)3; }
+static void e_dr(ADS1220_Config_t *c)         { c->dr = ADS1220_DR_COUNT; }
+static void e_ref(ADS1220_Config_t *c)        { c->ref = (ADS1220_Ref_t)4; }
+static void e_reject(ADS1220_Config_t *c)     { c->reject = (ADS1220_Reject_t)4; }
+static void e_idac(ADS1220_Config_t *c)       { c->idac = (ADS1220_Idac_t)8; }
+static void e_idac1(ADS1220_Config_t *c)      { c->idac1 = (ADS1220_IdacMux_t)7; }
+static void e_idac2(ADS1220_Config_t *c)      { c->idac2 = (ADS1220_IdacMux_t)7; }
+static void e_byp8(ADS1220_Config_t *c)       { c->gain = 8;   c->pga_bypass = 1; }
+static void e_byp128(ADS1220_Config_t *c)     { c->gain = 128; c->pga_bypass = 1; }
+static void e_byp4(ADS1220_Config_t *c)       { c->gain = 4;   c->pga_bypass = 1; }
+static void e_rej_45(ADS1220_Config_t *c)     { c->reject = ADS1220_REJECT_50;    c->dr = 1; }
+static void e_rej_turbo(ADS1220_Config_t *c)  { c->reject = ADS1220_REJECT_50_60; c->mode = ADS1220_OPMODE_TURBO; }
+static void e_rej_1000(ADS1220_Config_t *c)   { c->reject = ADS1220_REJECT_60;    c->dr = 6; }
+static void e_rej_20(ADS1220_Config_t *c)     { c->reject = ADS1220_REJECT_50_60; }
+static void e_rej_5duty(ADS1220_Config_t *c)  { c->reject = ADS1220_REJECT_50;    c->mode = ADS1220_OPMODE_DUTY; }
+
+static void invalid_settings(void)
+{
+    uint32_t before = failed;
+
+    refuse("gain 3 refused",                          e_gain3, 0);
+    refuse("gain 0 refused",                          e_gain0, 0);
+    refuse("gain 255 refused",                        e_gain256, 0);
+    refuse("input past SHORTED refused",              e_input, 0);
+    refuse("mode past TURBO refused",                 e_mode, 0);
+    refuse("DR 7 refused",                            e_dr, 0);
+    refuse("VREF past AVDD refused",                  e_ref, 0);
+    refuse("50/60 past 60 Hz refused",                e_reject, 0);
+    refuse("IDAC past 1500 uA refused",               e_idac, 0);
+    refuse("I1MUX past REFN0 refused",                e_idac1, 0);
+    refuse("I2MUX past REFN0 refused",                e_idac2, 0);
+    refuse("pga_bypass at gain 8 refused",            e_byp8, 0);
+    refuse("pga_bypass at gain 128 refused",          e_byp128, 0);
+    refuse("pga_bypass at gain 4 allowed",            e_byp4, 1);
+    refuse("50 Hz rejection at 45 SPS refused",       e_rej_45, 0);
+    refuse("50/60 Hz rejection in turbo refused",     e_rej_turbo, 0);
+    refuse("60 Hz rejection at 1000 SPS refused",     e_rej_1000, 0);
+    refuse("50/60 Hz rejection at 20 SPS allowed",    e_rej_20, 1);
+    refuse("50 Hz rejection at 5 SPS duty allowed",   e_rej_5duty, 1);
+
+    /* every gain with the bypass, every rate with each rejection */
+    for (uint8_t code = 0; code < 8u; code++) {
+        ADS1220_Config_t c;
+        uint8_t          regs[4];
+        ADS1220_DefaultConfig(&c);
+        c.gain = (uint8_t)(1u << code);
+        c.pga_bypass = 1;
+        check((ADS1220_ConfigToRegs(&c, regs) == ADS1220_OK) == (c.gain <= 4u),
+              "pga_bypass only at gain 1, 2, 4");
+    }
+    for (uint8_t m = 0; m < 3u; m++)
+        for (uint8_t dr = 0; dr < ADS1220_DR_COUNT; dr++)
+            for (uint8_t r = 1; r < 4u; r++) {
+                ADS1220_Config_t c;
+                uint8_t          regs[4];
+                ADS1220_DefaultConfig(&c);
+                c.mode = (ADS1220_OpMode_t)m;
+                c.dr = dr;
+                c.reject = (ADS1220_Reject_t)r;
+                check((ADS1220_ConfigToRegs(&c, regs) == ADS1220_OK) ==
+                      (dr == 0u && m != ADS1220_OPMODE_TURBO),
+                      "50/60 Hz rejection only at 20 SPS normal / 5 SPS duty");
+            }
+    printf("invalid settings:           %s\n", failed == before ? "all refused, nothing sent" : "FAILED");
+}
+
+static void configure_device(void)
+{
+    uint32_t mismatch = 0, n = 0, multi = 0;
+
+    memset(&dev, 0, sizeof(dev));
+    memset(&hads.regs, 0, sizeof(hads.regs));
+    hads.regs_valid = 0;
+    check(ADS1220_Init(&hads) == ADS1220_OK, "init");
+    {
+        ADS1220_Config_t c;
+        uint8_t          want[4];
+        ADS1220_DefaultConfig(&c);
+        ADS1220_ConfigToRegs(&c, want);
+        check(memcmp(dev.regs, want, 4) == 0 && hads.regs_valid, "init leaves the default setting");
+        printf("ADS1220_Init:               CONFIG0..3 = %02X %02X %02X %02X\n",
+               dev.regs[0], dev.regs[1], dev.regs[2], dev.regs[3]);
+        check(dev.regs[0] == 0x6E && dev.regs[1] == 0x04 && dev.regs[2] == 0 && dev.regs[3] == 0,
+              "init: AIN1-AIN0, gain 128, 20 SPS, continuous");
+    }
+
+    for (uint32_t i = 0; i < 20000u; i++) {
+        ADS1220_Config_t c;
+        uint8_t          v[F_COUNT], want[4];
+
+        random_fields(v, &c);
+        if (!valid_ref(v)) continue;
+        pack_ref(v, want);
+        dev_counts_reset();
+        n++;
+        if (ADS1220_Configure(&hads, &c) != ADS1220_OK ||
+            memcmp(dev.regs, want, 4) != 0 || memcmp(hads.regs, dev.regs, 4) != 0 || !hads.regs_valid)
+            mismatch++;
+        if (dev.wregs > 1u || dev.rregs > 1u) multi++;
+    }
+    printf("Configure on the model:   %6u settings, %u wrong, %u with more than one WREG/RREG\n",
+           n, mismatch, multi);
+    check(mismatch == 0u, "device and shadow hold the packed setting");
+    check(multi == 0u, "one WREG and one read back per Configure");
+}
+
+static void readback_failures(void)
+{
+    ADS1220_Config_t c;
+    ADS1220_Status_t st;
+
+    /* a bit that does not stick: the read back differs */
+    ADS1220_DefaultConfig(&c);
+    check(ADS1220_Configure(&hads, &c) == ADS1220_OK, "default setting");
+    dev.stuck[0] = 0x01;
+    c.gain = 4; c.pga_bypass = 1;
+    st = ADS1220_Configure(&hads, &c);
+    printf("stuck PGA_BYPASS bit:       status %d, regs_valid %u\n", st, hads.regs_valid);
+    check(st == ADS1220_VERIFY_FAIL, "read back differs: VERIFY_FAIL");
+    check(!hads.regs_valid, "read back differs: shadow invalid");
+    dev.stuck[0] = 0;
+    dev_counts_reset();
+    check(ADS1220_Configure(&hads, &c) == ADS1220_OK && hads.regs_valid, "next Configure succeeds");
+    check(dev.wregs == 1u && dev.bytes == 1u + 4u + 1u + 4u, "with the shadow unknown all four registers go out");
+
+    /* the device ignores the WREG: the read back shows the old value */
+    dev.lose_wreg = 1;
+    c.gain = 128; c.pga_bypass = 0; c.dr = 3;
+    st = ADS1220_Configure(&hads, &c);
+    printf("lost WREG:                  status %d, regs_valid %u\n", st, hads.regs_valid);
+    check(st == ADS1220_VERIFY_FAIL && !hads.regs_valid, "lost write: VERIFY_FAIL, shadow invalid");
+    check(ADS1220_Configure(&hads, &c) == ADS1220_OK && hads.regs_valid, "lost write: recovers");
+
+    /* SPI error on the write and on the read back */
+    for (int k = 1; k <= 3; k++) {
+        c.idac = (ADS1220_Idac_t)k;
+        dev.spi_fail = (int)dev.xfers + k;
+        st = ADS1220_Configure(&hads, &c);
+        printf("SPI error on transfer %d:    status %d, regs_valid %u\n", k, st, hads.regs_valid);
+        check(st == ADS1220_ERROR, "SPI error: ERROR");
+        check(!hads.regs_valid, "SPI error: shadow invalid");
+        dev.spi_fail = 0;
+        check(ADS1220_Configure(&hads, &c) == ADS1220_OK && hads.regs_valid &&
+              memcmp(hads.regs, dev.regs, 4) == 0, "SPI error: recovers");
+    }
+}
+
+/* ---- shadow writes: bytes on the bus ------------------------------------------------ */
+
+#define SPI_US_PER_BYTE (8.0 / 0.390625)
+
+static void traffic(const char *what, uint32_t frames, uint32_t bytes)
+{
+    printf("  %-36s %u transactions, %2u bytes, %3.0f us\n", what, dev.frames, dev.bytes,
+           dev.bytes * SPI_US_PER_BYTE);
+    if (dev.frames != frames || dev.bytes != bytes) {
+        printf("FAIL %s: %u transactions, %u bytes, want %u, %u\n", what, dev.frames, dev.bytes,
+               frames, bytes);
+        failed++;
+    }
+    dev_counts_reset();
+}
+
+/* bytes of one WREG over the registers that differ, 0 if none */
+static uint32_t wreg_bytes(const uint8_t a[4], const uint8_t b[4])
+{
+    int first = 0, last = 3;
+    while (first < 4 && a[first] == b[first]) first++;
+    if (first == 4) return 0u;
+    while (a[last] == b[last]) last--;
+    return (uint32_t)(last - first + 2);
+}
+
+static void shadow_writes(void)
+{
+    ADS1220_Config_t c;
+    uint8_t          regs[4];
+
+    printf("SPI traffic at 390 kHz:\n");
+    memset(&dev, 0, sizeof(dev));
+    memset(&hads.regs, 0, sizeof(hads.regs));
+    hads.regs_valid = 0;
+    hads.gain = 0;
+
+    check(ADS1220_Init(&hads) == ADS1220_OK, "init");
+    traffic("ADS1220_Init", 4u, 1u + 3u + 3u + 1u);     /* RESET, WREG 0-1, RREG 0-1, START */
+    ADS1220_DefaultConfig(&c);
+    check(ADS1220_Configure(&hads, &c) == ADS1220_OK, "same setting");
+    traffic("Configure, same setting", 0u, 0u);
+
+    /* unchanged setters */
+    check(ADS1220_SetInput(&hads, ADS1220_IN_AIN1_AIN0) == ADS1220_OK, "SetInput");
+    check(ADS1220_SetGain(&hads, 128) == ADS1220_OK, "SetGain");
+    check(ADS1220_SetInputGain(&hads, ADS1220_IN_AIN1_AIN0, 128) == ADS1220_OK, "SetInputGain");
+    check(ADS1220_SetDataRate(&hads, ADS1220_OPMODE_NORMAL, 0) == ADS1220_OK, "SetDataRate");
+    check(ADS1220_SetIdac(&hads, ADS1220_IDAC_0UA, ADS1220_IDAC_TO_NONE, ADS1220_IDAC_TO_NONE) == ADS1220_OK,
+          "SetIdac");
+    traffic("five setters, nothing changed", 0u, 0u);
+
+    /* one field, one register */
+    check(ADS1220_SetGain(&hads, 64) == ADS1220_OK && hads.gain == 64, "gain 64");
+    traffic("SetGain 128 -> 64", 1u, 2u);
+    check(ADS1220_SetInputGain(&hads, ADS1220_IN_AIN2_AIN3, 128) == ADS1220_OK, "MUX and gain");
+    traffic("SetInputGain, MUX and gain", 1u, 2u);
+    check(ADS1220_SetInputGain(&hads, ADS1220_IN_AIN2_AIN3, 128) == ADS1220_OK, "MUX and gain again");
+    traffic("SetInputGain, same again", 0u, 0u);
+    check(ADS1220_SetDataRate(&hads, ADS1220_OPMODE_TURBO, 6) == ADS1220_OK, "2000 SPS");
+    traffic("SetDataRate 20 -> 2000 SPS", 1u, 2u);
+
+    /* IDAC: CONFIG2 and CONFIG3 in one WREG, or the one that changed */
+    check(ADS1220_SetIdac(&hads, ADS1220_IDAC_250UA, ADS1220_IDAC_TO_AIN0, ADS1220_IDAC_TO_AIN3) == ADS1220_OK,
+          "IDAC on");
+    traffic("SetIdac, CONFIG2 and CONFIG3", 1u, 3u);
+    check(ADS1220_SetIdac(&hads, ADS1220_IDAC_500UA, ADS1220_IDAC_TO_AIN0, ADS1220_IDAC_TO_AIN3) == ADS1220_OK,
+          "IDAC current");
+    traffic("SetIdac, current only (CONFIG2)", 1u, 2u);
+    check(ADS1220_SetIdac(&hads, ADS1220_IDAC_500UA, ADS1220_IDAC_TO_AIN1, ADS1220_IDAC_TO_AIN3) == ADS1220_OK,
+          "IDAC route");
+    traffic("SetIdac, route only (CONFIG3)", 1u, 2u);
+    check(memcmp(hads.regs, dev.regs, 4) == 0, "shadow equals the device");
+
+    /* CONFIG0 and CONFIG3 differ: one WREG over all four */
+    memcpy(regs, hads.regs, 4);
+    regs[0] ^= 0x10;
+    regs[3] ^= 0x20;
+    check(ADS1220_ApplyRegisters(&hads, regs, 0) == ADS1220_OK, "apply 0 and 3");
+    traffic("ApplyRegisters, CONFIG0 and CONFIG3", 1u, 5u);
+
+    check(ADS1220_SyncRegisters(&hads) == ADS1220_OK, "sync");
+    traffic("SyncRegisters (RREG 0-3)", 1u, 5u);
+
+    /* a failed write leaves the shadow invalid; the next setter reads first */
+    dev.spi_fail = (int)dev.xfers + 1;
+    check(ADS1220_SetGain(&hads, 8) == ADS1220_ERROR, "failed write: ERROR");
+    check(!hads.regs_valid, "failed write: shadow invalid");
+    dev_counts_reset();
+    check(ADS1220_SetGain(&hads, 8) == ADS1220_OK && hads.regs_valid, "after a failed write");
+    traffic("SetGain after a failed write", 2u, 5u + 2u);
+    check(memcmp(hads.regs, dev.regs, 4) == 0, "shadow equals the device after the recovery");
+
+    /* random setter sequences: bytes = one WREG over what changed */
+    {
+        uint32_t calls = 0, wrong = 0, sent = 0;
+        for (uint32_t i = 0; i < 100000u; i++) {
+            uint8_t          before[4];
+            ADS1220_Status_t st;
+
+            memcpy(before, dev.regs, 4);
+            dev_counts_reset();
+            switch (rnd(5u)) {
+            case 0:  st = ADS1220_SetInput(&hads, (ADS1220_Input_t)rnd(15u)); break;
+            case 1:  st = ADS1220_SetGain(&hads, (uint8_t)(1u << rnd(8u))); break;
+            case 2:  st = ADS1220_SetInputGain(&hads, (ADS1220_Input_t)rnd(15u), (uint8_t)(1u << rnd(8u))); break;
+            case 3:  st = ADS1220_SetDataRate(&hads, (ADS1220_OpMode_t)rnd(3u), (uint8_t)rnd(7u)); break;
+            default: st = ADS1220_SetIdac(&hads, (ADS1220_Idac_t)rnd(8u),
+                                          (ADS1220_IdacMux_t)rnd(7u), (ADS1220_IdacMux_t)rnd(7u)); break;
+            }
+            calls++;
+            sent += dev.bytes;
+            if (st != ADS1220_OK || dev.rregs != 0u || dev.wregs > 1u ||
+                dev.bytes != wreg_bytes(before, dev.regs) || memcmp(hads.regs, dev.regs, 4) != 0)
+                wrong++;
+        }
+        printf("  %u random setter calls: %.2f bytes per call, %u wrong\n", calls, (double)sent / calls, wrong);
+        check(wrong == 0u, "every setter sends one WREG over what changed, or nothing");
+    }
+}
+
+int main(void)
+{
+    encode_fields();
+    invalid_settings();
+    configure_device();
+    readback_failures();
+    shadow_writes();
+
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
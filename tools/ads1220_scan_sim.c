@@ -0,0 +1,353 @@
+/*
+ * ads1220_scan_sim.c - host simulation of the 005-scale-ADS1220 MUX scan
+ *                      list (App/ADS1220/ads1220_scan.c)
+ *
+ * The event loop of tools/ads1220_bus_sim.c and tools/ads1220_acq_sim.c,
+ * with a virtual ADS1220 that also takes register writes: the scan list
+ * of main.c (bridge, temperature sensor, AVDD/4, shorted input) runs
+ * through the firmware's ads1220.c, ads1220_scan.c and ads1220_acq.c:
+ *
+ *   - the device converts continuously; a WREG restarts the conversion
+ *     in progress with the new registers, and the first conversion after
+ *     the restart takes one period + 2% + 50 us;
+ *   - DRDY falls: ADS1220_AcqOnDrdy() from the EXTI handler, which starts
+ *     the 3-byte read; the device hands out its latest result at CS low;
+ *   - the read completes 3 SPI bytes later (390.625 kHz) plus the
+ *     interrupt entry: ADS1220_AcqOnReadDone(), which calls
+ *     ADS1220_ScanOnConversion and, at the end of a visit, writes the
+ *     next entry through the blocking spiTxRx (its bytes take bus time);
+ *   - each interrupt takes 2 us; both are priority 1, and when both are
+ *     pending EXTI1 goes first (lower IRQ number); in the "held off" cases
+ *     priority 0 work holds both off for up to 600 us at random moments;
+ *   - the scan's drdyClear clears the latched DRDY edge the way main.c's
+ *     adsDrdyClear clears the EXTI pending bit; one case runs without
+ *     it and must show the race it closes;
+ *   - in the "write fails" case one switch WREG in 20 breaks off after
+ *     its first data byte and reports an SPI error: the device keeps
+ *     the old entry or a mix of both until the scan's retry goes through;
+ *   - the main loop drains the ring every 1 ms.
+ *
+ * Every result carries the register image it was converted with: the
+ * device puts the index of the scan entry whose CONFIG0-3 it was running
+ * into the code, next to a sequence number. Checked for every sample:
+ * its `channel` is the entry it was converted with, and no conversion
+ * from registers of no entry is published; without the hold-off nothing
+ * overruns and no edge is stale; only the failing case has failed
+ * writes.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Wall -I005-scale-ADS1220/App/ADS1220 tools/ads1220_scan_sim.c \
+ *       005-scale-ADS1220/App/ADS1220/ads1220.c \
+ *       005-scale-ADS1220/App/ADS1220/ads1220_scan.c \
+ *       005-scale-ADS1220/App/ADS1220/ads1220_acq.c \
+ *       -o ads1220_scan_sim && ./ads1220_scan_sim
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ads1220_acq.h"
+
+#define SPI_US_PER_BYTE (8.0 / 0.390625)
+#define ISR_US          2.0             /* interrupt entry + handler      */
+#define TICKS_PER_US    100.0           /* DWT at 100 MHz                 */
+#define LOOP_US         1000.0
+#define NENTRY          4
+#define NO_ENTRY        0x7u            /* registers of no scan entry     */
+
+typedef struct {
+    const char *name;
+    double      sps;
+    uint8_t     mode, dr;
+    uint8_t     samples;        /* bridge conversions per visit       */
+    uint8_t     discard;        /* on every entry                     */
+    uint8_t     offset_every;   /* entry 3                            */
+    double      block_us;       /* priority 0 interrupt, 0 none       */
+    int         clear;          /* scan drdyClear set, as main.c does */
+    double      secs;
+    double      fail;           /* share of WREGs that break off      */
+} Case_t;
+
+static double   now;
+static uint32_t failed;
+static double   wreg_fail;          /* set once the scan runs            */
+
+/* the virtual device */
+static struct {
+    uint8_t  regs[4];
+    int      cs;
+    uint8_t  cmd, pos;
+    double   conv_start, conv_end;  /* conversion in progress           */
+    uint32_t conv_tag;              /* entry of its registers           */
+    int      restarted;             /* first conversion after a restart */
+    uint32_t result;                /* latest result: tag << 16 | seq   */
+    uint32_t seq;
+    double   period;
+} dev;
+
+/* interrupts */
+static double   drdy_pend = -1.0;   /* DRDY edge waiting for its ISR     */
+static double   dma_done  = -1.0;
+static double   blocked_until;
+static double   next_block;
+static uint8_t *dma_rx;
+
+static ADS1220_Handle_t     hads;
+static ADS1220_Scan_t       hscan;
+static ADS1220_ScanEntry_t  list[NENTRY];
+static ADS1220_Acq_t        hacq;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+static double urand(void) { return (double)rand() / RAND_MAX; }
+
+/* ---- device ---------------------------------------------------------------------- */
+
+static uint32_t regs_tag(void)
+{
+    for (uint32_t i = 0; i < NENTRY; i++)
+        if (memcmp(dev.regs, hscan.regs[i], 4) == 0) return i;
+    return NO_ENTRY;
+}
+
+static void conv_begin(double t, int restart)
+{
+    dev.conv_start = t;
+    dev.conv_tag   = regs_tag();
+    dev.restarted  = restart;
+    dev.conv_end   = t + (restart ? dev.period * 1.02 + 50.0 : dev.period);
+}
+
+/* conversions that complete by t */
+static void dev_run(double t)
+{
+    while (dev.conv_end <= t) {
+        dev.seq++;
+        dev.result = (dev.conv_tag << 16) | (dev.seq & 0xFFFFu);
+        if (drdy_pend < 0.0) drdy_pend = dev.conv_end;     /* EXTI pending */
+        conv_begin(dev.conv_end, 0);
+    }
+}
+
+static void cs_low(void)  { dev.cs = 1; dev.cmd = 0; dev.pos = 0; }
+static void cs_high(void) { dev.cs = 0; }
+
+static int spi_txrx(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    int err = 0;
+
+    check(dev.cs, "SPI only with CS low");
+    /* a WREG that breaks off after its first data byte */
+    if (tx && (tx[0] & 0xF0) == ADS1220_CMD_WREG && len > 2u && wreg_fail > 0.0 && urand() < wreg_fail) {
+        len = 2u;
+        err = -1;
+    }
+    now += len * SPI_US_PER_BYTE;               /* blocking: the ISR waits */
+    dev_run(now);
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t in = tx ? tx[i] : 0x00, out = 0xFF;
+        if (!dev.cmd) {
+            dev.cmd = in;
+            if (in == ADS1220_CMD_RESET) memset(dev.regs, 0, 4);
+            if (in == ADS1220_CMD_START) conv_begin(now, 1);
+        } else {
+            uint8_t reg = (uint8_t)(((dev.cmd >> 2) & 3u) + dev.pos);
+            if (dev.pos <= (dev.cmd & 3u) && reg < 4u) {
+                if ((dev.cmd & 0xF0) == ADS1220_CMD_WREG) dev.regs[reg] = in;
+                if ((dev.cmd & 0xF0) == ADS1220_CMD_RREG) out = dev.regs[reg];
+            }
+            dev.pos++;
+        }
+        if (rx) rx[i] = out;
+    }
+    /* a register write restarts the conversion in progress */
+    if ((dev.cmd & 0xF0) == ADS1220_CMD_WREG) conv_begin(now, 1);
+    return err;
+}
+
+static uint8_t drdy_read(void) { return 1; }
+
+/* the EXTI pending bit */
+static uint8_t drdy_clear(void)
+{
+    if (drdy_pend < 0.0) return 0;
+    drdy_pend = -1.0;
+    return 1;
+}
+
+static int read_start(uint8_t *rx, uint16_t len)
+{
+    uint32_t v = dev.result;
+
+    rx[0] = (uint8_t)(v >> 16);
+    rx[1] = (uint8_t)(v >> 8);
+    rx[2] = (uint8_t)v;
+    dma_rx   = rx;
+    dma_done = now + len * SPI_US_PER_BYTE;
+    return 0;
+}
+
+static uint32_t ticks(void) { return (uint32_t)(now * TICKS_PER_US); }
+
+/* ---- event loop ------------------------------------------------------------------ */
+
+/* run the interrupts due by t, in order; the priority 0 bursts hold off
+   both priority 1 handlers (EXTI1 and DMA2 stream 0) */
+static void run_until(double t, double block_us)
+{
+    for (;;) {
+        double next;
+        int    what;
+
+        dev_run(now);
+        if (block_us > 0.0 && next_block <= now) {
+            blocked_until = next_block + urand() * block_us;
+            next_block   += 1000.0 + urand() * 20000.0;
+        }
+        /* both pending at the same priority: the lower IRQ number (EXTI1)
+           goes first */
+        if (drdy_pend >= 0.0 && (dma_done < 0.0 || drdy_pend <= dma_done ||
+                                 drdy_pend <= blocked_until))  { next = drdy_pend; what = 1; }
+        else if (dma_done >= 0.0)                              { next = dma_done; what = 2; }
+        else                                                   { next = dev.conv_end; what = 0; }
+        if (next < blocked_until) next = blocked_until;
+        if (next < now) next = now;
+        if (block_us > 0.0 && next_block < next) next = next_block, what = 0;
+        if (next > t) { now = t; dev_run(now); return; }
+        now = next;
+        if (what == 0) continue;
+        dev_run(now);
+
+        now += ISR_US / 2.0;
+        if (what == 1) {
+            drdy_pend = -1.0;
+            ADS1220_AcqOnDrdy(&hacq);
+        } else {
+            dma_done = -1.0;
+            ADS1220_AcqOnReadDone(&hacq, 0);
+        }
+        now += ISR_US / 2.0;
+    }
+}
+
+static void run(const Case_t *c)
+{
+    uint32_t got[NENTRY] = { 0 }, wrong = 0, straddled = 0, total = 0;
+    double   last_bridge = -1.0, gap_max = 0.0;
+    ADS1220_Sample_t batch[16];
+    uint16_t n;
+
+    memset(&dev, 0, sizeof(dev));
+    memset(&hacq, 0, sizeof(hacq));
+    memset(&hscan, 0, sizeof(hscan));
+    memset(&hads, 0, sizeof(hads));
+    now = 0.0;
+    drdy_pend = dma_done = -1.0;
+    blocked_until = 0.0;
+    next_block = urand() * 5000.0;
+    dev.period = 1e6 / c->sps;
+    dev.conv_end = 1e300;
+    wreg_fail = 0.0;
+
+    hads.csLow = cs_low; hads.csHigh = cs_high; hads.spiTxRx = spi_txrx; hads.drdyRead = drdy_read;
+    check(ADS1220_Init(&hads) == ADS1220_OK, "init");
+
+    /* the list of main.c */
+    {
+        ADS1220_Config_t adc;
+        ADS1220_DefaultConfig(&adc);
+        adc.mode = (ADS1220_OpMode_t)c->mode;
+        adc.dr   = c->dr;
+        adc.continuous = 1;
+        for (int i = 0; i < NENTRY; i++) {
+            list[i].cfg     = adc;
+            list[i].samples = 1;
+            list[i].discard = c->discard;
+            list[i].every   = 0;
+        }
+        list[0].samples         = c->samples;
+        list[1].cfg.temp_sensor = 1;
+        list[1].cfg.gain        = 1;
+        list[2].cfg.input       = ADS1220_IN_AVDD_DIV4;
+        list[2].cfg.gain        = 1;
+        list[2].cfg.pga_bypass  = 1;
+        list[3].cfg.input       = ADS1220_IN_SHORTED;
+        list[3].every           = c->offset_every;
+    }
+    hscan.hads = &hads; hscan.list = list; hscan.count = NENTRY;
+    hscan.drdyClear = c->clear ? drdy_clear : NULL;
+    hacq.hads = &hads; hacq.readStart = read_start; hacq.timestamp = ticks; hacq.scan = &hscan;
+    check(ADS1220_ScanInit(&hscan) == ADS1220_OK, "scan init");
+    check(ADS1220_AcqInit(&hacq) == ADS1220_OK, "acq init");
+    conv_begin(now, 1);
+    ADS1220_AcqStart(&hacq);
+    wreg_fail = c->fail;
+
+    while (now < c->secs * 1e6) {
+        run_until(now + LOOP_US, c->block_us);
+        while ((n = ADS1220_AcqRead(&hacq, batch, 16)) != 0) {
+            for (uint16_t i = 0; i < n; i++) {
+                uint32_t tag = ((uint32_t)batch[i].code >> 16) & 0x7Fu;
+                total++;
+                if (tag == NO_ENTRY) straddled++;
+                else if (tag != batch[i].channel) wrong++;
+                if (batch[i].channel < NENTRY) got[batch[i].channel]++;
+                if (batch[i].channel == 0) {
+                    double t = batch[i].time / TICKS_PER_US;
+                    if (last_bridge >= 0.0 && t - last_bridge > gap_max) gap_max = t - last_bridge;
+                    last_bridge = t;
+                }
+            }
+        }
+    }
+
+    printf("%-40s| %7.1f %6.1f %6.1f %6.1f SPS | %6.1f ms | %5u sw %5u disc %3u stale %3u err |"
+           " wrong %2u  mixed %u  ovr %u  drop %u\n",
+           c->name, got[0] / c->secs, got[1] / c->secs, got[2] / c->secs, got[3] / c->secs,
+           gap_max / 1000.0, hscan.switches, hscan.discarded, hscan.stale, hscan.errors,
+           wrong, straddled, hacq.overruns, hacq.dropped);
+    if (c->clear)
+        check(wrong == 0u, "every sample carries the entry it was converted with");
+    else
+        check(wrong > 0u, "without drdyClear the held off case shows the race");
+    check(straddled == 0u, "no sample from registers of no entry");
+    check(hacq.dropped == 0u, "the main loop keeps up");
+    if (c->block_us == 0.0)
+        check(hacq.overruns == 0u && hscan.stale == 0u, "no overrun, no stale edge on time");
+    if (c->fail > 0.0)
+        check(hscan.errors > 0u, "the failing case has failed writes");
+    else
+        check(hscan.errors == 0u, "no failed write");
+    check(hacq.errors == 0u, "no failed read");
+}
+
+int main(void)
+{
+    static const Case_t cases[] = {
+        { "2000 SPS turbo, discard 0",              2000.0, 2, 6, 8, 0, 0,   0.0, 1, 10 },
+        { "2000 SPS turbo, discard 1",              2000.0, 2, 6, 8, 1, 0,   0.0, 1, 10 },
+        { "2000 SPS turbo, 1 sample per visit",     2000.0, 2, 6, 1, 0, 0,   0.0, 1, 10 },
+        { "2000 SPS turbo, offset every 4th",       2000.0, 2, 6, 8, 0, 4,   0.0, 1, 10 },
+        { "20 SPS normal, offset every 4th",          20.0, 0, 0, 8, 0, 4,   0.0, 1, 60 },
+        { "2000 SPS, ISRs held off up to 600 us",   2000.0, 2, 6, 8, 0, 4, 600.0, 1, 10 },
+        { "2000 SPS, 1 per visit, held off 600 us", 2000.0, 2, 6, 1, 0, 0, 600.0, 1, 10 },
+        { "same, without drdyClear",                2000.0, 2, 6, 1, 0, 0, 600.0, 0, 10 },
+        { "2000 SPS, 1 per visit, 5% writes fail",  2000.0, 2, 6, 1, 0, 0,   0.0, 1, 10, 0.05 },
+    };
+
+    srand(14);
+    printf("%-40s| %7s %6s %6s %6s     | bridge gap |\n", "", "bridge", "temp", "AVDD", "offset");
+    for (unsigned i = 0u; i < sizeof(cases) / sizeof(cases[0]); i++)
+        run(&cases[i]);
+
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * calib_bench.c - host check of the 005-scale-ADS1220 calibration engine
+ *
+ * A synthetic load cell (4 kg, 1724 codes per gram, a bowed curve with a
+ * cubic term, zero and span drift with temperature) is calibrated and
+ * read through the firmware's own calib.c:
+ *
+ *   - the former single divisor, set with a 2 kg reference mass
+ *     (weight = (code - tare) * 10 / divisor),
+ *   - piecewise-linear tables of 2, 3 and 5 points,
+ *   - the 5 point table with zero and span drift learned by weighing
+ *     the empty platform and 2 kg once more at 35 degC.
+ *
+ * For each it prints the largest error over 0..4 kg at the calibration
+ * temperature (25 degC) and between 10 and 40 degC, without re-taring.
+ *
+ * Cost: cycles of one reading against the integer divide it replaces
+ * (rdtsc on x86, else ns), the minimum over 10000 batches of 4096
+ * readings. These are host cycles, not Cortex-M4 cycles.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/Calib tools/calib_bench.c \
+ *       005-scale-ADS1220/App/Calib/calib.c -lm -o calib_bench \
+ *       && ./calib_bench
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "calib.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES()        __rdtsc()
+#define CYCLES_UNIT     "cycles"
+#else
+static uint64_t ns_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#define CYCLES()        ns_now()
+#define CYCLES_UNIT     "ns"
+#endif
+
+#define FS_G        4000.0
+#define CPG         1724.0      /* codes per gram                       */
+#define ZERO        150000.0    /* code of the empty platform at 25 degC */
+#define T_CAL       25.0
+
+typedef struct {
+    const char *name;
+    double      bow;            /* nonlinearity, fraction of full scale  */
+    double      cubic;          /* S-shaped part, fraction of full scale */
+    double      tc_zero;        /* codes per degC                        */
+    double      tc_span;        /* ppm per degC                          */
+} Cell_t;
+
+static int32_t cell(const Cell_t *c, double g, double t)
+{
+    double x    = g / FS_G;
+    double nl   = c->bow * 4.0 * x * (1.0 - x) + c->cubic * 10.4 * x * (x - 0.5) * (x - 1.0);
+    double span = 1.0 + c->tc_span * 1e-6 * (t - T_CAL);
+    return (int32_t)lround(ZERO + c->tc_zero * (t - T_CAL) + CPG * span * (g + nl * FS_G));
+}
+
+static int16_t temp_q5(double t) { return (int16_t)lround(t * 32.0); }
+
+/* largest |error| in grams over the range, temperatures t0..t1 */
+static double max_err(const Cell_t *c, const Calib_t *cal, int32_t div, double t0, double t1)
+{
+    double e = 0.0;
+    for (double t = t0; t <= t1 + 1e-9; t += 5.0) {
+        Calib_t k = *cal;
+        if (!div) Calib_SetTemperature(&k, temp_q5(t));
+        for (double g = 0.0; g <= FS_G + 1e-9; g += 50.0) {
+            int32_t code = cell(c, g, t);
+            double  w    = div ? ((double)((code - cell(c, 0.0, T_CAL)) * 10 / div)) / 10.0
+                               : Calib_Weight(&k, code) / 10.0;
+            if (fabs(w - g) > e) e = fabs(w - g);
+        }
+    }
+    return e;
+}
+
+static void table(Calib_t *cal, const Cell_t *c, const double *g, int n)
+{
+    cal->temp = temp_q5(T_CAL);
+    Calib_Clear(cal);
+    for (int i = 0; i < n; i++) Calib_AddPoint(cal, cell(c, g[i], T_CAL), (int32_t)lround(g[i] * 10.0));
+    if (Calib_Fit(cal) != CALIB_OK) printf("fit failed\n");
+}
+
+static void run(const Cell_t *c)
+{
+    static const double p2[] = { 0, 4000 }, p3[] = { 0, 2000, 4000 }, p5[] = { 0, 1000, 2000, 3000, 4000 };
+    Calib_t cal = { 0 };
+    int32_t div = (int32_t)lround((cell(c, 2000.0, T_CAL) - cell(c, 0.0, T_CAL)) / 2000.0);
+
+    printf("%s\n", c->name);
+    printf("  single divisor (2 kg)  %7.2f g at 25 degC  %7.2f g at 10..40 degC\n",
+           max_err(c, &cal, div, T_CAL, T_CAL), max_err(c, &cal, div, 10.0, 40.0));
+
+    table(&cal, c, p2, 2);
+    printf("  2 points               %7.2f g             %7.2f g\n",
+           max_err(c, &cal, 0, T_CAL, T_CAL), max_err(c, &cal, 0, 10.0, 40.0));
+    table(&cal, c, p3, 3);
+    printf("  3 points               %7.2f g             %7.2f g\n",
+           max_err(c, &cal, 0, T_CAL, T_CAL), max_err(c, &cal, 0, 10.0, 40.0));
+    table(&cal, c, p5, 5);
+    printf("  5 points               %7.2f g             %7.2f g\n",
+           max_err(c, &cal, 0, T_CAL, T_CAL), max_err(c, &cal, 0, 10.0, 40.0));
+
+    /* learn the drift at 35 degC */
+    Calib_SetTemperature(&cal, temp_q5(35.0));
+    Calib_LearnZeroTc(&cal, cell(c, 0.0, 35.0));
+    Calib_LearnSpanTc(&cal, cell(c, 2000.0, 35.0), 20000);
+    Calib_SetTemperature(&cal, temp_q5(T_CAL));
+    printf("  5 points + temperature %7.2f g             %7.2f g   (learned %.1f codes/degC, %.1f ppm/degC)\n",
+           max_err(c, &cal, 0, T_CAL, T_CAL), max_err(c, &cal, 0, 10.0, 40.0),
+           cal.tab.tc_zero / 256.0, cal.tab.tc_span / 256.0);
+}
+
+/* min over batches of the mean per reading: the figure without the
+ * interruptions of the host */
+static double cycles_per_reading(int engine)
+{
+    static const Cell_t c = { "", 0.0005, 0.0003, 30.0, 20.0 };
+    static const double p5[] = { 0, 1000, 2000, 3000, 4000 };
+    static int32_t in[4096];
+    Calib_t  cal = { 0 };
+    volatile int32_t sink = 0;
+    volatile int32_t div  = 1724;
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < 4096; i++) in[i] = cell(&c, (i * 977) % 4000, T_CAL);
+    table(&cal, &c, p5, 5);
+    cal.tab.tc_span = 20 * 256;
+    Calib_SetTemperature(&cal, temp_q5(30.0));
+
+    for (int r = 0; r < 10000; r++) {
+        uint64_t c0 = CYCLES();
+        for (int i = 0; i < 4096; i++) {
+            int32_t code = in[i];
+            if (engine) sink = Calib_Weight(&cal, code);
+            else        sink = ((code - 150000) * 10) / div;
+        }
+        uint64_t c = CYCLES() - c0;
+        if (c < best) best = c;
+    }
+    (void)sink;
+    return (double)best / 4096;
+}
+
+int main(void)
+{
+    static const Cell_t cells[] = {
+        { "good cell (0.05% bow, 0.03% S, 30 codes/degC, +20 ppm/degC)",     0.0005, 0.0003, 30.0,  20.0 },
+        { "cheap cell (0.3% bow, 0.1% S, 120 codes/degC, -80 ppm/degC)",     0.0030, 0.0010, 120.0, -80.0 },
+    };
+
+    for (unsigned i = 0u; i < sizeof(cells) / sizeof(cells[0]); i++)
+        run(&cells[i]);
+    printf("host " CYCLES_UNIT " per reading: divide %.1f, Calib_Weight (5 points, temperature) %.1f\n",
+           cycles_per_reading(0), cycles_per_reading(1));
+    return 0;
+}
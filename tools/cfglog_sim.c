@@ -0,0 +1,451 @@
+/*
+ * cfglog_sim.c - power cuts against the settings log (App/CfgLog)
+ *
+ * Runs the firmware's cfg_log.c (006-stroboscope; the 005-scale-ADS1220
+ * copy is the same file) against two emulated NOR flash areas: a program
+ * only clears bits, an erase sets 0xFF, both go one byte at a time, and
+ * the power can go after any byte. The byte the power dies on is left
+ * either untouched or half done (some of its bits switched), the way a
+ * cell that was being programmed or erased ends up. After a cut nothing
+ * else reaches the flash until the "restart": a fresh handle, CfgLog_Init
+ * and CfgLog_Load, as Flash_LoadConfig does at power on.
+ *
+ * For both geometries of the firmware (006: 64-byte slots, 32-byte
+ * FlashConfig_t; 005: 128-byte slots, 60-byte table), with areas of four
+ * slots so the log switches areas every few saves:
+ *   1. every cut: for each of the first saves, through three area
+ *      switches, the power goes after every byte it writes or erases
+ *      (the erase of the other area, its header, the record), with the
+ *      erase running up and running down the area;
+ *   2. a random run of 200000 saves, a cut in one of four at a random
+ *      byte, so cuts also land in the saves that follow a cut;
+ *   3. a record program that fails (an error from the flash, no power
+ *      cut) in the first save after an area switch, and in a save inside
+ *      an area: the previous record must still load from the same handle,
+ *      without a restart, and the next save must go through;
+ *   4. the upgrade from the firmware before the log, which kept a single
+ *      record at the start of sector 7 (area 1): Flash_LoadConfig finds
+ *      the log empty and saves the old settings as its first record. The
+ *      power goes after every byte of that save, and the old record must
+ *      still be intact after each cut, so the next power on converts it
+ *      again.
+ *
+ * After every restart it checks that
+ *   - the loaded record is the newest one that was fully written (the
+ *     save that was cut counts when its slot holds the whole record),
+ *   - nothing else is loaded: no torn record, no bad CRC, no older copy,
+ *   - the sequence number keeps counting up across cuts and switches,
+ *   - the next save after the restart loads back.
+ *
+ * Save latency: with the real 128 KB sectors it counts the words
+ * programmed and the sector erases of every save through two area
+ * switches, and turns them into time with the STM32F411 data sheet
+ * figures for x32 parallelism (2.7 - 3.6 V): a word takes 16 us typical
+ * and 100 us at most, a 128 KB sector erase 1 s typical and 2 s at most.
+ * A save that erased its sector first, as the firmware did before the
+ * log, is shown for comparison.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Wall -I006-stroboscope/App/CfgLog tools/cfglog_sim.c \
+ *       006-stroboscope/App/CfgLog/cfg_log.c -o cfglog_sim && ./cfglog_sim
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg_log.h"
+
+#define SLOTS       4u              /* slots per area                      */
+#define AREA_MAX    (128u * 1024u)  /* a sector of the firmware            */
+#define VERSION     11u
+#define EVERY_SAVES 14u             /* three area switches                 */
+#define RAND_SAVES  200000u
+
+/* STM32F411 data sheet, x32 parallelism */
+#define T_WORD_TYP_US   16.0
+#define T_WORD_MAX_US   100.0
+#define T_ERASE_TYP_US  1000000.0   /* 128 KB sector                       */
+#define T_ERASE_MAX_US  2000000.0
+
+typedef struct {
+    const char *name;
+    uint16_t    slot, len;
+} Geom_t;
+
+/* the flash */
+static uint32_t area_mem[2][AREA_MAX / 4u];
+static uint32_t area_size;
+static long     budget = -1;        /* bytes before the power goes, -1 never */
+static int      half_byte, erase_down;
+static uint32_t cut_bytes;          /* bytes written or erased this save   */
+static int      fail_record;        /* the next record program fails       */
+static uint32_t prog_words, erase_count;
+
+/* the record being saved, to tell a cut in its last erased bytes */
+static uint8_t  prog_area;
+static uint32_t prog_off, prog_n;
+static uint32_t prog_img[CFGLOG_SLOT_MAX / 4u];
+
+static uint64_t rng = 88172645463325252ull;
+static uint32_t failed, cuts, torn, restarts;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+static uint32_t rnd(uint32_t n)
+{
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (uint32_t)((rng >> 11) % n);
+}
+
+/* one byte towards v; 0 when the power has gone */
+static int put_byte(uint8_t *b, uint8_t v)
+{
+    cut_bytes++;
+    if (budget == 0) return 0;
+    if (budget > 0 && --budget == 0) {
+        if (half_byte) *b = (uint8_t)((*b & 0x0Fu) | (v & 0xF0u));   /* half the bits */
+        return 0;
+    }
+    *b = v;
+    return 1;
+}
+
+static int emu_program(uint8_t a, uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    uint8_t *mem = (uint8_t *)area_mem[a] + offset;
+
+    if (offset + 4u * count > area_size) { check(0, "program inside the area"); return -1; }
+    prog_words += count;
+    prog_area = a; prog_off = offset; prog_n = count;
+    memcpy(prog_img, words, 4u * (count < CFGLOG_SLOT_MAX / 4u ? count : CFGLOG_SLOT_MAX / 4u));
+
+    for (uint32_t i = 0u; i < 4u * count; i++) {
+        uint8_t v = ((const uint8_t *)words)[i];
+        if ((mem[i] & v) != v) { check(0, "program only over erased bits"); return -1; }
+        if (!put_byte(&mem[i], (uint8_t)(mem[i] & v))) return -1;
+        /* a flash error: the sequence word gets through, nothing else */
+        if (fail_record && count > 2u && i == 3u) { fail_record = 0; return -1; }
+    }
+    return 0;
+}
+
+static int emu_erase(uint8_t a)
+{
+    uint8_t *mem = (uint8_t *)area_mem[a];
+
+    erase_count++;
+    for (uint32_t i = 0u; i < area_size; i++) {
+        uint32_t k = erase_down ? area_size - 1u - i : i;
+        if (!put_byte(&mem[k], 0xFFu)) return -1;
+    }
+    return 0;
+}
+
+static void handle_init(CfgLog_Handle_t *h, uint16_t slot)
+{
+    memset(h, 0, sizeof(*h));
+    h->area[0]   = area_mem[0];
+    h->area[1]   = area_mem[1];
+    h->area_size = area_size;
+    h->slot_size = slot;
+    h->program   = emu_program;
+    h->erase     = emu_erase;
+}
+
+static void payload(uint8_t *d, uint16_t len, uint32_t n)
+{
+    for (uint16_t i = 0u; i < len; i++) d[i] = (uint8_t)(n * 7u + i * 13u + (n >> 8));
+}
+
+/* the log as the firmware sees it, and what it must load */
+typedef struct {
+    CfgLog_Handle_t h;
+    const Geom_t   *g;
+    uint32_t        saved;      /* payload number of the newest full record, 0 none */
+    uint32_t        seq;        /* its sequence number                         */
+    uint32_t        next;       /* payload number of the next save             */
+} Log_t;
+
+static void log_start(Log_t *l, const Geom_t *g, uint32_t size)
+{
+    area_size = size ? size : CFGLOG_AREA_HDR + SLOTS * g->slot;
+    memset(area_mem[0], 0, area_size);          /* a fresh part is not erased */
+    memset(area_mem[1], 0, area_size);
+    budget = -1;
+    memset(l, 0, sizeof(*l));
+    l->g    = g;
+    l->next = 1u;
+    handle_init(&l->h, g->slot);
+    check(CfgLog_Init(&l->h) == CFGLOG_EMPTY, "blank flash is empty");
+}
+
+/* power on: the firmware's Flash_LoadConfig */
+static void log_restart(Log_t *l)
+{
+    uint8_t         data[CFGLOG_SLOT_MAX], want[CFGLOG_SLOT_MAX];
+    CfgLog_Status_t rc;
+    int             seen = 0;
+
+    budget = -1;
+    restarts++;
+    handle_init(&l->h, l->g->slot);
+    rc = CfgLog_Init(&l->h);
+    if (l->saved == 0u) {
+        check(rc == CFGLOG_EMPTY, "nothing saved: log empty");
+        check(CfgLog_Load(&l->h, VERSION, data, l->g->len) == CFGLOG_EMPTY, "nothing saved: no load");
+        return;
+    }
+    check(rc == CFGLOG_OK, "init finds a record");
+    check(l->h.seq == l->seq, "the newest full record has the highest seq");
+    rc = CfgLog_Load(&l->h, VERSION, data, l->g->len);
+    payload(want, l->g->len, l->saved);
+    check(rc == CFGLOG_OK && memcmp(data, want, l->g->len) == 0,
+          "loads the newest fully written record");
+
+    /* restarts where the scan had to step over a torn slot */
+    for (uint8_t a = 0u; a < 2u; a++)
+        for (uint32_t off = CFGLOG_AREA_HDR; off + l->g->slot <= area_size; off += l->g->slot) {
+            uint32_t n = (CFGLOG_REC_HDR + ((l->g->len + 3u) & ~3u)) / 4u, crc = 0u;
+            const uint32_t *w = &area_mem[a][off / 4u];
+            int erased = 1;
+            for (uint32_t i = 0u; i < l->g->slot / 4u; i++) if (w[i] != 0xFFFFFFFFu) erased = 0;
+            for (uint32_t i = 0u; i < n; i++) crc = CfgLog_Crc32(crc, &w[i], 4u);
+            if (!erased && area_mem[a][0] == CFGLOG_AREA_MAGIC && w[n] != crc) seen = 1;
+        }
+    torn += (uint32_t)seen;
+}
+
+/* one save; budget < 0 runs it to the end */
+static void log_save(Log_t *l, long cut, int half, int down)
+{
+    uint8_t         data[CFGLOG_SLOT_MAX];
+    CfgLog_Status_t rc;
+    uint32_t        before = l->h.seq;
+
+    budget     = cut;
+    half_byte  = half;
+    erase_down = down;
+    cut_bytes  = 0u;
+    prog_n     = 0u;
+    payload(data, l->g->len, l->next);
+    rc = CfgLog_Save(&l->h, VERSION, data, l->g->len);
+
+    if (rc == CFGLOG_OK) {
+        check(budget != 0, "no save reports success after the power went");
+        check(l->h.seq == before + 1u && l->h.seq > l->seq, "seq counts up");
+        l->saved = l->next;
+        l->seq   = l->h.seq;
+    } else {
+        uint32_t rec = (CFGLOG_REC_EXTRA + ((l->g->len + 3u) & ~3u)) / 4u;
+        check(budget == 0, "a save fails only on a cut");
+        cuts++;
+        /* cut in bytes the record leaves erased: it is written all the same */
+        if (prog_n == rec && memcmp((uint8_t *)area_mem[prog_area] + prog_off, prog_img, 4u * rec) == 0) {
+            check(prog_img[0] > l->seq, "seq counts up");
+            l->saved = l->next;
+            l->seq   = prog_img[0];
+        }
+        log_restart(l);
+    }
+    l->next++;
+}
+
+/* save, restart, the record must be back */
+static void save_and_check(Log_t *l)
+{
+    uint32_t seq = l->seq;
+
+    log_save(l, -1, 0, 0);
+    check(l->seq > seq, "save after a restart counts up");
+    log_restart(l);
+}
+
+static void every_cut(const Geom_t *g, int half, int down, uint32_t *runs)
+{
+    for (uint32_t k = 0u; k < EVERY_SAVES; k++) {
+        uint32_t bytes;
+        Log_t    l;
+
+        /* the length of save k */
+        log_start(&l, g, 0u);
+        for (uint32_t i = 0u; i < k; i++) log_save(&l, -1, 0, 0);
+        log_save(&l, -1, 0, 0);
+        bytes = cut_bytes;
+
+        for (uint32_t c = 1u; c <= bytes; c++) {
+            log_start(&l, g, 0u);
+            for (uint32_t i = 0u; i < k; i++) log_save(&l, -1, 0, 0);
+            log_save(&l, (long)c, half, down);
+            save_and_check(&l);
+            save_and_check(&l);
+            (*runs)++;
+        }
+    }
+}
+
+static void random_run(const Geom_t *g, uint32_t saves)
+{
+    Log_t l;
+
+    log_start(&l, g, 0u);
+    for (uint32_t i = 0u; i < saves; i++) {
+        long cut = -1;
+        if (rnd(4u) == 0u) cut = 1 + (long)rnd(area_size + 2u * g->slot);
+        log_save(&l, cut, (int)rnd(2u), (int)rnd(2u));
+        if (cut > 0 && budget != 0) log_restart(&l);    /* cut after the end */
+    }
+    log_restart(&l);
+    check(l.seq > saves - saves / 3u, "random run: the log keeps going");
+}
+
+/* a record program fails without a power cut: after an area switch (the
+   other area is erased, the record goes to its first slot) and inside
+   an area */
+static void record_failure(const Geom_t *g, uint32_t before)
+{
+    uint8_t data[CFGLOG_SLOT_MAX], want[CFGLOG_SLOT_MAX];
+    Log_t   l;
+
+    log_start(&l, g, 0u);
+    for (uint32_t i = 0u; i < before; i++) log_save(&l, -1, 0, 0);
+
+    fail_record = 1;
+    payload(data, g->len, l.next);
+    check(CfgLog_Save(&l.h, VERSION, data, g->len) == CFGLOG_ERROR, "a failed record program fails the save");
+    check(fail_record == 0, "the record program was reached");
+    l.next++;
+
+    /* same handle, no restart: the record before is still there */
+    payload(want, g->len, l.saved);
+    check(CfgLog_Load(&l.h, VERSION, data, g->len) == CFGLOG_OK && memcmp(data, want, g->len) == 0,
+          "after a failed save the previous record loads without a restart");
+    log_save(&l, -1, 0, 0);
+    payload(want, g->len, l.saved);
+    check(CfgLog_Load(&l.h, VERSION, data, g->len) == CFGLOG_OK && memcmp(data, want, g->len) == 0,
+          "the save after a failed one loads back");
+    log_restart(&l);
+}
+
+/* first power on after the upgrade: area 0 as the old program left it,
+   area 1 erased but for the old record (005: magic, divisor, XOR) */
+static void legacy_record(const Geom_t *g, uint32_t *runs)
+{
+    static const uint32_t old[3] = { 0xA55A1234u, 1724u, 0xA55A1234u ^ 1724u };
+    uint8_t         data[CFGLOG_SLOT_MAX], want[CFGLOG_SLOT_MAX];
+    static uint8_t  area1[AREA_MAX];
+    CfgLog_Status_t rc;
+    Log_t           l;
+
+    for (long cut = 1; ; cut++) {
+        log_start(&l, g, 0u);
+        memset(area_mem[1], 0xFF, area_size);
+        memcpy(area_mem[1], old, sizeof(old));
+        memcpy(area1, area_mem[1], area_size);
+        handle_init(&l.h, g->slot);
+        check(CfgLog_Init(&l.h) == CFGLOG_EMPTY, "an old record is not a log record");
+
+        budget     = cut;
+        half_byte  = (int)(cut & 1);
+        erase_down = 0;
+        payload(want, g->len, 1u);
+        rc = CfgLog_Save(&l.h, VERSION, want, g->len);
+        check(memcmp(area_mem[1], area1, area_size) == 0, "the first save leaves the old record alone");
+        (*runs)++;
+        if (rc == CFGLOG_OK) break;
+
+        /* restart: either the converted record or still nothing */
+        handle_init(&l.h, g->slot);
+        budget = -1;
+        rc = CfgLog_Init(&l.h);
+        check(rc == CFGLOG_EMPTY ||
+              (CfgLog_Load(&l.h, VERSION, data, g->len) == CFGLOG_OK && memcmp(data, want, g->len) == 0),
+              "a cut first save leaves the log empty or holding it");
+    }
+    budget = -1;
+    check(CfgLog_Load(&l.h, VERSION, data, g->len) == CFGLOG_OK && memcmp(data, want, g->len) == 0,
+          "the converted record loads");
+}
+
+/* words and erases per save with the real sectors */
+static void latency(const Geom_t *g)
+{
+    uint32_t slots = (AREA_MAX - CFGLOG_AREA_HDR) / g->slot;
+    uint32_t words_min = UINT32_MAX, words_max = 0u, sw_words = 0u, sw_n = 0u;
+    uint64_t words_all = 0u;
+    uint32_t saves = 2u * slots + 1u;
+    Log_t    l;
+
+    log_start(&l, g, AREA_MAX);
+    log_save(&l, -1, 0, 0);                     /* the first save formats */
+    erase_count = 0u;
+    for (uint32_t i = 0u; i < saves; i++) {
+        uint32_t e = erase_count;
+        prog_words = 0u;
+        log_save(&l, -1, 0, 0);
+        words_all += prog_words;
+        if (erase_count != e) {
+            sw_n++;
+            sw_words = prog_words;
+        } else {
+            if (prog_words < words_min) words_min = prog_words;
+            if (prog_words > words_max) words_max = prog_words;
+        }
+    }
+    check(words_min == words_max, "every save programs the same words");
+    check(sw_n == 2u, "two area switches");
+
+    printf("%-24s save %u words, %.0f us typ, %.0f us max\n", g->name,
+           words_min, words_min * T_WORD_TYP_US, words_min * T_WORD_MAX_US);
+    printf("%-24s switch 1 erase + %u words, %.1f s typ, %.1f s max, 1 in %u saves\n", "",
+           sw_words, (T_ERASE_TYP_US + sw_words * T_WORD_TYP_US) / 1e6,
+           (T_ERASE_MAX_US + sw_words * T_WORD_MAX_US) / 1e6, saves / sw_n);
+    printf("%-24s mean %.0f us typ per save; erasing the sector every save: %.2f s typ\n", "",
+           ((double)words_all * T_WORD_TYP_US + erase_count * T_ERASE_TYP_US) / saves,
+           (T_ERASE_TYP_US + words_min * T_WORD_TYP_US) / 1e6);
+}
+
+int main(void)
+{
+    static const Geom_t geom[] = {
+        { "006 (64 B slots, 32 B)",  64u, 32u },
+        { "005 (128 B slots, 60 B)", 128u, 60u },
+    };
+
+    printf("%-24s %-14s %8s %7s %7s %9s\n", "geometry", "run", "runs", "cuts", "torn", "restarts");
+    for (unsigned i = 0u; i < sizeof(geom) / sizeof(geom[0]); i++) {
+        for (int v = 0; v < 4; v++) {
+            static const char *const name[4] = {
+                "every byte", "every half", "erase down", "half, down"
+            };
+            uint32_t runs = 0u;
+            cuts = torn = restarts = 0u;
+            every_cut(&geom[i], v & 1, v >> 1, &runs);
+            printf("%-24s %-14s %8u %7u %7u %9u\n", geom[i].name, name[v], runs, cuts, torn, restarts);
+        }
+        cuts = torn = restarts = 0u;
+        random_run(&geom[i], RAND_SAVES);
+        printf("%-24s %-14s %8u %7u %7u %9u\n", geom[i].name, "random", RAND_SAVES, cuts, torn, restarts);
+        record_failure(&geom[i], SLOTS);        /* first record of the new area */
+        record_failure(&geom[i], 1u);           /* inside the area */
+        {
+            uint32_t runs = 0u;
+            legacy_record(&geom[i], &runs);
+            printf("%-24s %-14s %8u\n", geom[i].name, "old record", runs);
+        }
+    }
+
+    printf("\nsave latency, 128 KB sectors, STM32F411 x32 program / erase times:\n");
+    for (unsigned i = 0u; i < sizeof(geom) / sizeof(geom[0]); i++)
+        latency(&geom[i]);
+
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+/*
+ * checkw_replay.c - host replay of the 005-scale-ADS1220 checkweigher
+ *
+ * Synthetic conveyor traces at 2000 SPS (turbo mode) go through the
+ * firmware's own decim.c (CIC 10x3 + FIR 21 -> 200 Hz, as in main.c with
+ * ADC_DECIM) and checkw.c, set up as in main.c (1724 codes per gram):
+ *
+ *   - 250 mm platform, 100 mm items on a 400 mm pitch, so one item at a
+ *     time; the load ramps on and off as the item crosses the edges,
+ *   - items of 100 g +- 1 g, every 20th 5 g light (a reject),
+ *   - the platform rings at 40 Hz (damping 0.1) on every load change,
+ *     the belt drive shakes it at 37 Hz (0.3 g), mains pickup at 50 Hz,
+ *     white noise of 30 codes rms, the zero creeps 100 codes per minute.
+ *
+ * For every belt speed it replays 500 items and prints the items found,
+ * the error of the plateau estimate (rms and largest) against the true
+ * mass, next to the peak and the mean over the whole loaded span, the
+ * items graded wrongly against 100 g -2/+3 g, the items flagged as
+ * not weighed reliably, and the throughput measured by the batch: the
+ * graded items per minute (CheckW_BatchRate) next to all items
+ * (CheckW_BatchRateAll). It then prints the fastest belt speed at which
+ * every item was graded. The last line times CheckW_Process on the host.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/Filter -I005-scale-ADS1220/App/Check \
+ *       tools/checkw_replay.c 005-scale-ADS1220/App/Filter/decim.c \
+ *       005-scale-ADS1220/App/Check/checkw.c -lm -o checkw_replay \
+ *       && ./checkw_replay
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "checkw.h"
+#include "decim.h"
+
+#define FS          2000.0
+#define CPG         1724.0          /* codes per gram                      */
+#define ZERO        150000.0
+#define PLATFORM    0.250           /* m                                   */
+#define ITEM        0.100
+#define PITCH       0.400
+#define ITEMS       500
+#define NOMINAL     100.0           /* g                                   */
+#define F_RING      40.0
+#define ZETA        0.10
+
+static double urand(void) { return (rand() + 0.5) / ((double)RAND_MAX + 1.0); }
+static double gauss(void) { return sqrt(-2.0 * log(urand())) * cos(2.0 * M_PI * urand()); }
+
+static void chain_setup(Decim_t *d)
+{
+    d->count              = 1;
+    d->stage[0].r         = 10;
+    d->stage[0].n         = 3;
+    d->stage[0].taps      = Decim_Taps200Hz;
+    d->stage[0].ntaps     = 21;
+    d->stage[0].fir_decim = 1;
+    if (Decim_Init(d) != 0) { printf("Decim_Init failed\n"); exit(1); }
+}
+
+/* main.c: Scale_CheckSetup at 1724 codes per gram, Q6 codes */
+static void checkw_setup(CheckW_t *c, CheckW_Batch_t *b)
+{
+    const int32_t g = (int32_t)(CPG * 64.0);
+
+    c->on_level    = 5 * g;
+    c->off_level   = 5 * g / 2;
+    c->noise       = g / 2;
+    c->zero_band   = g;
+    c->plateau_min = 10;
+    c->confirm     = 3;
+    c->zero_shift  = 6;
+    CheckW_Reset(c);
+    b->nominal = 1000;
+    b->under   = 20;
+    b->over    = 30;
+    CheckW_BatchReset(b);
+}
+
+/* fraction of an item (front edge at position p) on the platform */
+static double on_platform(double p)
+{
+    double a = p - ITEM, lo = a > 0.0 ? a : 0.0, hi = p < PLATFORM ? p : PLATFORM;
+    return hi > lo ? (hi - lo) / ITEM : 0.0;
+}
+
+typedef struct {
+    double e2, emax, p2, pmax, m2, mmax;
+    int    found, misgraded, flagged;
+    double ipm, ipm_all;
+} Result_t;
+
+static void track(double *e2, double *emax, double e)
+{
+    *e2 += e * e;
+    if (fabs(e) > *emax) *emax = fabs(e);
+}
+
+static void run(double v, Result_t *r)
+{
+    static double mass[ITEMS];
+    Decim_t        d;
+    CheckW_t       c = { 0 };
+    CheckW_Batch_t b = { 0 };
+    double         y = 0.0, yd = 0.0, w0 = 2.0 * M_PI * F_RING;
+    double         t_end = (ITEMS * PITCH + PLATFORM + 2.0) / v;
+    double         span_sum = 0.0;
+    long           span_n = 0, n = (long)(t_end * FS);
+    int            next = 0;
+
+    for (int i = 0; i < ITEMS; i++) mass[i] = NOMINAL + gauss() - ((i % 20) == 7 ? 5.0 : 0.0);
+    chain_setup(&d);
+    checkw_setup(&c, &b);
+    *r = (Result_t){ 0 };
+
+    for (long i = 0; i < n; i++) {
+        double t = i / FS, load = 0.0, dt = 1.0 / FS;
+        int    k;
+
+        /* items enter at the left edge one pitch apart, 1 s in */
+        for (k = 0; k < ITEMS; k++) {
+            double p = v * (t - 1.0) - k * PITCH;
+            if (p < 0.0) break;
+            if (p < PLATFORM + ITEM) load += mass[k] * on_platform(p);
+        }
+
+        /* platform: second order, rings at F_RING */
+        yd += (w0 * w0 * (load - y) - 2.0 * ZETA * w0 * yd) * dt;
+        y  += yd * dt;
+
+        double  g    = y + 0.3 * sin(2 * M_PI * 37.0 * t) + 0.2 * sin(2 * M_PI * 50.0 * t + 1.0);
+        int32_t code = (int32_t)lround(ZERO + 100.0 * t / 60.0 + g * CPG + 30.0 * gauss());
+
+        if (!(Decim_Process(&d, code) & 1u) || t < 0.5) continue;    /* chain start-up */
+        {
+            int32_t x = d.stage[0].out;
+            if (c.loaded) { span_sum += x - c.zero; span_n++; }
+            if (!CheckW_Process(&c, x, (uint32_t)(t * 1000.0))) continue;
+        }
+
+        /* item found: match it with the one that just left */
+        {
+            double  w    = c.item.plateau / 64.0 / CPG;
+            double  m    = (next < ITEMS) ? mass[next] : 0.0;
+            int32_t w10  = (int32_t)lround(w * 10.0);
+            int     good = (m * 10.0 >= b.nominal - b.under) && (m * 10.0 <= b.nominal + b.over);
+            CheckW_Class_t cls = CheckW_BatchAdd(&b, w10, c.item.flags, c.item.time);
+
+            r->found++;
+            if (c.item.flags) r->flagged++;
+            else if ((cls == CHECKW_OK) != good) r->misgraded++;
+            track(&r->e2, &r->emax, w - m);
+            track(&r->p2, &r->pmax, c.item.peak / 64.0 / CPG - m);
+            track(&r->m2, &r->mmax, span_sum / span_n / 64.0 / CPG - m);
+            span_sum = 0.0;
+            span_n   = 0;
+            next++;
+        }
+    }
+    r->ipm     = CheckW_BatchRate(&b) / 10.0;
+    r->ipm_all = CheckW_BatchRateAll(&b) / 10.0;
+}
+
+static double ns_per_sample(void)
+{
+    CheckW_t        c = { 0 };
+    CheckW_Batch_t  b;
+    static int32_t  in[4096];
+    volatile uint32_t sink = 0;
+    struct timespec a, e;
+    const long N = 20000000L;
+
+    /* an item every 200 samples, 100 of them on the platform */
+    for (int i = 0; i < 4096; i++)
+        in[i] = (int32_t)((ZERO + ((i % 200) >= 50 && (i % 200) < 150 ? NOMINAL * CPG : 0.0)) * 64.0
+                          + 300.0 * gauss());
+    checkw_setup(&c, &b);
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (long i = 0; i < N; i++) sink += CheckW_Process(&c, in[i & 4095], (uint32_t)i);
+    clock_gettime(CLOCK_MONOTONIC, &e);
+    (void)sink;
+    return ((e.tv_sec - a.tv_sec) * 1e9 + (e.tv_nsec - a.tv_nsec)) / (double)N;
+}
+
+int main(void)
+{
+    static const double speeds[] = { 0.3, 0.5, 0.8, 1.2, 1.3, 1.4, 1.5, 1.6, 2.0 };
+    double graded_max = 0.0;
+    int    all_graded = 1;
+
+    srand(20);
+    printf("belt     found  plateau rms/max   peak rms/max    span mean rms/max  misgraded flagged"
+           "  graded/min  all/min\n");
+    for (unsigned i = 0u; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        Result_t r;
+        run(speeds[i], &r);
+        printf("%.1f m/s  %4d   %5.2f / %5.2f g   %5.2f / %5.2f g  %6.2f / %6.2f g    %4d    %4d"
+               "    %6.1f   %6.1f\n",
+               speeds[i], r.found,
+               sqrt(r.e2 / r.found), r.emax, sqrt(r.p2 / r.found), r.pmax,
+               sqrt(r.m2 / r.found), r.mmax, r.misgraded, r.flagged, r.ipm, r.ipm_all);
+        /* the fastest speed below which every item was graded */
+        if (r.found != ITEMS || r.flagged != 0) all_graded = 0;
+        if (all_graded) graded_max = speeds[i];
+    }
+    printf("every item graded up to %.1f m/s\n", graded_max);
+    printf("host time per 200 Hz sample: CheckW_Process %.1f ns (an item every 200 samples)\n",
+           ns_per_sample());
+    return 0;
+}
@@ -0,0 +1,551 @@
+/*
+ * cmd_bench.c - command channel test for 005-scale-ADS1220 and
+ *               006-stroboscope (App/Cmd)
+ *
+ * Runs cmd.c against an emulated UART RX DMA in circular mode: bytes land
+ * in the ring at the line rate (10 bit times each), the receive event
+ * callback fires at the half and full buffer and when the line goes idle
+ * for one character, and the main loop calls Cmd_Poll every 1 ms. The
+ * sender writes random commands (freq, duty, phase, tare, get, some
+ * invalid ones, random case and blanks, LF or CR LF) and remembers where
+ * each one starts in the stream; the handlers check every parsed value
+ * and every OK/ERR answer against that.
+ *
+ * Reported per run: commands sent, answered, lost in RX overruns, wrong
+ * (must be 0), and the latency from the end of the line on the wire to
+ * its answer (mean, 99th percentile, max). One "ERR overrun" stands for
+ * every line from the one being read up to the line the parser resumes
+ * in (cmd.h); the bench takes the resume point of each ERR overrun from
+ * the handle and checks that every lost command is one of the lines it
+ * covers, and that each ERR overrun covers at least one. The runs:
+ *   - the strobe: 115200 baud, 256 byte ring, a command every 20 ms and
+ *     back to back at the line rate, and back to back again without the
+ *     rx_head callback (half ring window, see cmd.h),
+ *   - the scale: 921600 baud, 1024 byte ring, a main loop that stalls
+ *     25 ms every 200 ms for the display, request/response and back to
+ *     back (which overruns: every loss must be reported),
+ *   - the scale without the idle line event, to show what it is for.
+ * Before that, unit checks of the tokenizer and the number parser, and
+ * after it, the host time per command.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/Cmd tools/cmd_bench.c \
+ *       005-scale-ADS1220/App/Cmd/cmd.c -o cmd_bench && ./cmd_bench
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmd.h"
+
+#define RING_MAX    1024u
+#define EXPECT_MAX  200000u
+#define RUN_S       20u
+
+enum { T_FREQ, T_DUTY, T_PHASE, T_TARE, T_GET, T_BAD };
+
+typedef struct {
+    uint32_t     offset;            /* stream position of the line     */
+    uint8_t      type;
+    int32_t      value;
+    Cmd_Status_t st;                /* expected answer                 */
+    int64_t      eol_ns;            /* end of the line on the wire     */
+    uint8_t      done;
+    uint8_t      covered;           /* by an ERR overrun               */
+} Expect_t;
+
+static uint8_t      ring[RING_MAX];
+static Cmd_Handle_t hcmd;
+static Expect_t     exp_q[EXPECT_MAX];
+static uint32_t     exp_n, exp_i;
+static int64_t      now_ns;
+static uint32_t     wrong, answered, get_lines, overrun_replies, reply_bytes;
+static Expect_t    *last_done;
+static int64_t      lat[EXPECT_MAX];
+static uint32_t     lat_n;
+static uint32_t     dma_wr;         /* DMA write index                 */
+static uint32_t     cover_i, covered, cover_max, cover_empty;
+
+static uint16_t rx_head(void)
+{
+    return (uint16_t)dma_wr;
+}
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* the expected entry of the line being dispatched, by its start */
+static Expect_t *current(void)
+{
+    while (exp_i < exp_n && exp_q[exp_i].offset < hcmd.line) exp_i++;
+    if (exp_i < exp_n && exp_q[exp_i].offset == hcmd.line) return &exp_q[exp_i];
+    return NULL;
+}
+
+static void check(uint8_t type, int32_t value)
+{
+    Expect_t *e = current();
+    if (!e || e->type != type || e->value != value) wrong++;
+}
+
+/* ---- firmware side: the dispatch table ---- */
+
+static Cmd_Status_t do_freq(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v;
+    Cmd_Status_t st = Cmd_ArgNum(h, 0, 3, 153, 1000000, &v);
+    (void)argc;
+    if (st == CMD_OK) check(T_FREQ, v);
+    return st;
+}
+
+static Cmd_Status_t do_duty(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v;
+    Cmd_Status_t st = Cmd_ArgNum(h, 0, 0, 5, 50, &v);
+    (void)argc;
+    if (st == CMD_OK) check(T_DUTY, v);
+    return st;
+}
+
+static Cmd_Status_t do_phase(Cmd_Handle_t *h, uint8_t argc)
+{
+    int32_t      v;
+    Cmd_Status_t st = Cmd_ArgNum(h, 0, 0, -359, 359, &v);
+    (void)argc;
+    if (st == CMD_OK) check(T_PHASE, v);
+    return st;
+}
+
+static Cmd_Status_t do_tare(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)h; (void)argc;
+    check(T_TARE, 0);
+    return CMD_OK;
+}
+
+static Cmd_Status_t do_get(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)argc;
+    check(T_GET, 0);
+    Cmd_Reply(h, "freq 30.000 duty 5 bright 75 drift 0.000 tach 0 run 1");
+    return CMD_OK;
+}
+
+static const Cmd_Entry_t table[] = {
+    { "freq",  "<Hz>",        1, 1, do_freq  },
+    { "duty",  "<%>",         1, 1, do_duty  },
+    { "phase", "<deg>",       1, 1, do_phase },
+    { "tare",  "",            0, 0, do_tare  },
+    { "get",   "",            0, 0, do_get   },
+};
+
+static const char *const answer_text[] = {
+    "OK", "ERR unknown command", "ERR arguments", "ERR range", "ERR state", "ERR failed",
+    "ERR line too long", "ERR overrun",
+};
+
+static void reply(const char *s, uint16_t len)
+{
+    Expect_t *e;
+
+    reply_bytes += len + 2u;
+    if (!strcmp(s, "ERR overrun")) {
+        /* the parser resumes at hcmd.line and skips the line holding it:
+           every line up to there not answered is lost */
+        uint32_t n = 0;
+        overrun_replies++;
+        while (cover_i < exp_n && exp_q[cover_i].offset <= hcmd.line) {
+            if (!exp_q[cover_i].done) { exp_q[cover_i].covered = 1; n++; }
+            cover_i++;
+        }
+        covered += n;
+        if (n > cover_max) cover_max = n;
+        if (n == 0) cover_empty++;
+        return;
+    }
+    if (strncmp(s, "OK", 2) && strncmp(s, "ERR", 3)) { get_lines++; return; }
+
+    answered++;
+    e = current();
+    if (!e || e->done || strcmp(s, answer_text[e->st])) {
+        wrong++;
+        return;
+    }
+    e->done   = 1;
+    last_done = e;
+    if (lat_n < EXPECT_MAX) lat[lat_n++] = now_ns - e->eol_ns;
+}
+
+static void cmd_setup(uint16_t size, uint8_t head)
+{
+    memset(&hcmd, 0, sizeof(hcmd));
+    hcmd.rx        = ring;
+    hcmd.rx_size   = size;
+    hcmd.table     = table;
+    hcmd.table_len = sizeof(table) / sizeof(table[0]);
+    hcmd.reply     = reply;
+    hcmd.rx_head   = head ? rx_head : NULL;
+    Cmd_Init(&hcmd);
+}
+
+/* ---- the sender ---- */
+
+static void mixed_case(char *s)
+{
+    for (; *s && *s != ' '; s++) if (rnd() % 4u == 0u && *s >= 'a' && *s <= 'z') *s -= 'a' - 'A';
+}
+
+/* one random command line into buf, its expectation into e */
+static int gen_cmd(char *buf, Expect_t *e)
+{
+    char        body[64];
+    const char *pre = (rnd() % 8u == 0u) ? "  " : "";
+    const char *gap = (rnd() % 8u == 0u) ? " \t " : " ";
+    const char *eol = (rnd() % 2u) ? "\r\n" : "\n";
+    uint32_t    r   = rnd() % 100u;
+
+    e->st    = CMD_OK;
+    e->value = 0;
+    if (r < 30) {
+        uint32_t mhz = 153u + rnd() % 999848u;
+        e->type  = T_FREQ;
+        e->value = (int32_t)mhz;
+        if (mhz % 1000u == 0u && rnd() % 2u) sprintf(body, "freq%s%u", gap, mhz / 1000u);
+        else                                 sprintf(body, "freq%s%u.%03u", gap, mhz / 1000u, mhz % 1000u);
+    } else if (r < 50) {
+        e->type  = T_DUTY;
+        e->value = 5 + (int32_t)(rnd() % 46u);
+        sprintf(body, "duty%s%d", gap, e->value);
+    } else if (r < 70) {
+        e->type  = T_PHASE;
+        e->value = (int32_t)(rnd() % 719u) - 359;
+        sprintf(body, "phase%s%+d", gap, e->value);
+    } else if (r < 85) {
+        e->type = T_TARE;
+        sprintf(body, "tare");
+    } else if (r < 95) {
+        e->type = T_GET;
+        sprintf(body, "get");
+    } else {
+        static const char *const bad[] = { "duty 99", "freq 1.2345", "bogus 1", "duty", "phase x", "tare 1",
+                                           "a b c d e f g" };
+        static const Cmd_Status_t bad_st[] = { CMD_ERR_RANGE, CMD_ERR_ARGS, CMD_ERR_UNKNOWN, CMD_ERR_ARGS,
+                                               CMD_ERR_ARGS, CMD_ERR_ARGS, CMD_ERR_ARGS };
+        uint32_t k = rnd() % 7u;
+        e->type = T_BAD;
+        e->st   = bad_st[k];
+        sprintf(body, "%s", bad[k]);
+    }
+    mixed_case(body);
+    return sprintf(buf, "%s%s%s", pre, body, eol);
+}
+
+typedef enum { SEND_EVERY, SEND_B2B, SEND_REQRESP } Send_t;
+
+typedef struct {
+    const char *name;
+    uint32_t    baud;
+    uint16_t    ring;
+    Send_t      send;
+    uint32_t    every_us;
+    uint8_t     stall;              /* 25 ms every 200 ms              */
+    uint8_t     idle;               /* idle line event                 */
+    uint8_t     head;               /* rx_head provided                */
+    uint8_t     may_lose;
+} Run_t;
+
+static int cmp64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int run(const Run_t *r)
+{
+    static char line[128];
+    int64_t  char_ns  = 10LL * 1000000000LL / r->baud;
+    int64_t  end_ns   = (int64_t)RUN_S * 1000000000LL;
+    int64_t  next_cmd = 0, next_byte = -1, next_loop = 0, last_rx = 0;
+    uint32_t sent = 0, loops = 0, lost;
+    int      len = 0, k = 0, idle_armed = 0;
+    double   mean = 0;
+
+    cmd_setup(r->ring, r->head);
+    dma_wr = 0;
+    exp_n = exp_i = 0;
+    wrong = answered = get_lines = overrun_replies = lat_n = 0;
+    cover_i = covered = cover_max = cover_empty = 0;
+    last_done = NULL;
+    memset(ring, 0, sizeof(ring));
+
+    for (now_ns = 0; now_ns < end_ns; now_ns += 1000) {
+        /* sender: start a line */
+        if (k == len && exp_n < EXPECT_MAX) {
+            uint8_t go = 0;
+            if (r->send == SEND_B2B) go = 1;
+            else if (r->send == SEND_EVERY) go = now_ns >= next_cmd;
+            else go = (exp_n == 0 || (exp_q[exp_n - 1].done && now_ns >= next_cmd) ||
+                       now_ns - exp_q[exp_n - 1].eol_ns > 100000000LL);        /* 100 ms timeout */
+            if (go) {
+                Expect_t *e = &exp_q[exp_n];
+                memset(e, 0, sizeof(*e));
+                len = gen_cmd(line, e);
+                k   = 0;
+                e->offset = sent;
+                e->eol_ns = now_ns + (int64_t)len * char_ns;
+                exp_n++;
+                next_byte = now_ns + char_ns;
+                next_cmd += (int64_t)r->every_us * 1000;
+            }
+        }
+        /* the UART: one byte per character time into the DMA ring */
+        while (k < len && next_byte <= now_ns) {
+            ring[dma_wr] = (uint8_t)line[k++];
+            sent++;
+            dma_wr = (dma_wr + 1u) % r->ring;
+            last_rx    = next_byte;
+            next_byte += char_ns;
+            idle_armed = 1;
+            if (dma_wr == r->ring / 2u) Cmd_RxEvent(&hcmd, (uint16_t)(r->ring / 2u));    /* half */
+            if (dma_wr == 0u)           Cmd_RxEvent(&hcmd, r->ring);                     /* full */
+        }
+        if (r->idle && idle_armed && k == len && now_ns - last_rx >= char_ns) {
+            idle_armed = 0;
+            Cmd_RxEvent(&hcmd, (uint16_t)dma_wr);
+        }
+        /* the main loop */
+        if (now_ns >= next_loop) {
+            uint32_t before = reply_bytes;
+            Cmd_Poll(&hcmd);
+            next_loop = now_ns + 1000000;
+            if (r->stall && ++loops % 200u == 0u) next_loop += 25000000;
+            if (r->send == SEND_REQRESP && reply_bytes != before)
+                next_cmd = now_ns + (int64_t)(reply_bytes - before) * char_ns;   /* answer sent */
+        }
+    }
+    /* commands the parser has not reached at the end are not counted */
+    while (exp_n && !exp_q[exp_n - 1].done && exp_q[exp_n - 1].offset >= hcmd.line) {
+        exp_n--;
+    }
+    lost = 0;
+    for (uint32_t i = 0; i < exp_n; i++) {
+        lost += !exp_q[i].done;
+        if (!exp_q[i].done && !exp_q[i].covered) wrong++;       /* lost silently */
+    }
+
+    qsort(lat, lat_n, sizeof(lat[0]), cmp64);
+    for (uint32_t i = 0; i < lat_n; i++) mean += (double)lat[i];
+    if (lat_n) mean /= lat_n;
+
+    int ok = !wrong && answered == exp_n - lost && (r->may_lose || !lost) &&
+             lost == covered && !cover_empty;
+    printf("%-26s %7u %5u %7u %7u %6u %5u %5u %4u %8.2f %8.2f %8.2f  %s\n",
+           r->name, r->baud, r->ring, exp_n, answered, lost, overrun_replies, cover_max, wrong,
+           mean / 1e6, lat_n ? (double)lat[lat_n * 99u / 100u] / 1e6 : 0.0,
+           lat_n ? (double)lat[lat_n - 1u] / 1e6 : 0.0, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+/* ---- unit checks ---- */
+
+static int fails;
+
+static void feed(const char *s)
+{
+    uint32_t pos = hcmd.rx_pos;
+    while (*s) { ring[pos] = (uint8_t)*s++; pos = (pos + 1u) % hcmd.rx_size; }
+    Cmd_RxEvent(&hcmd, (uint16_t)pos);
+}
+
+static char last_reply[128];
+static uint32_t reply_count;
+
+static void unit_reply(const char *s, uint16_t len)
+{
+    (void)len;
+    snprintf(last_reply, sizeof(last_reply), "%s", s);
+    reply_count++;
+}
+
+static int32_t num_value;
+static Cmd_Status_t num_st;
+static uint8_t num_dec;
+
+static Cmd_Status_t do_num(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)argc;
+    num_st = Cmd_ArgNum(h, 0, num_dec, -1000000, 1000000, &num_value);
+    return num_st;
+}
+
+static Cmd_Status_t do_mode(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)argc;
+    return Cmd_ArgIs(h, 0, "scale") ? CMD_OK : CMD_ERR_ARGS;
+}
+
+static void expect(const char *what, int cond)
+{
+    if (!cond) { printf("unit check failed: %s (last reply \"%s\")\n", what, last_reply); fails++; }
+}
+
+static void num_case(const char *arg, uint8_t dec, Cmd_Status_t st, int32_t v)
+{
+    char line[64];
+    num_dec = dec;
+    num_st  = (Cmd_Status_t)-1;
+    snprintf(line, sizeof(line), "num %s\n", arg);
+    feed(line);
+    Cmd_Poll(&hcmd);
+    if (num_st != st || (st == CMD_OK && num_value != v)) {
+        printf("unit check failed: \"%s\" dec %u -> status %d value %d, expected %d %d\n",
+               arg, dec, num_st, num_value, st, v);
+        fails++;
+    }
+}
+
+static void unit_checks(void)
+{
+    static const Cmd_Entry_t t[] = {
+        { "num",  "<n>",           1, 1, do_num  },
+        { "mode", "scale|cal",     1, 1, do_mode },
+    };
+    char long_line[200];
+
+    memset(&hcmd, 0, sizeof(hcmd));
+    hcmd.rx = ring; hcmd.rx_size = 256; hcmd.table = t; hcmd.table_len = 2; hcmd.reply = unit_reply;
+    hcmd.rx_head = NULL;
+    Cmd_Init(&hcmd);
+
+    num_case("12.5", 3, CMD_OK, 12500);
+    num_case("-0.001", 3, CMD_OK, -1);
+    num_case("+7", 0, CMD_OK, 7);
+    num_case("7.", 2, CMD_OK, 700);
+    num_case(".5", 1, CMD_OK, 5);
+    num_case("1.234", 2, CMD_ERR_ARGS, 0);
+    num_case("1e3", 0, CMD_ERR_ARGS, 0);
+    num_case("-", 0, CMD_ERR_ARGS, 0);
+    num_case("1.2.3", 3, CMD_ERR_ARGS, 0);
+    num_case("1000001", 0, CMD_ERR_RANGE, 0);
+    num_case("99999999999", 0, CMD_ERR_RANGE, 0);
+    num_case("1000.001", 3, CMD_ERR_RANGE, 0);
+
+    /* tokens across the end of the ring: 256 byte ring, many lines */
+    for (int i = 0; i < 100; i++) num_case("123.456", 3, CMD_OK, 123456);
+
+    feed("MoDe ScAlE\r\n");
+    reply_count = 0;
+    Cmd_Poll(&hcmd);
+    expect("case insensitive name and argument", !strcmp(last_reply, "OK") && reply_count == 1);
+
+    feed("mode scaled\n");
+    Cmd_Poll(&hcmd);
+    expect("argument prefix is no match", !strcmp(last_reply, "ERR arguments"));
+
+    feed("mod scale\n");
+    Cmd_Poll(&hcmd);
+    expect("name prefix is no match", !strcmp(last_reply, "ERR unknown command"));
+
+    reply_count = 0;
+    feed("help\n");
+    Cmd_Poll(&hcmd);
+    expect("help lists the table", reply_count == 3 && !strcmp(last_reply, "OK"));
+
+    /* a line split across receive events is dispatched once complete */
+    feed("num 4");
+    reply_count = 0;
+    Cmd_Poll(&hcmd);
+    expect("no answer before the line end", reply_count == 0);
+    num_dec = 0;
+    feed("2\n");
+    Cmd_Poll(&hcmd);
+    expect("split line", num_st == CMD_OK && num_value == 42);
+
+    /* too long: one ERR, then the rest of the line is skipped */
+    memset(long_line, 'x', 100);
+    long_line[100] = '\0';
+    reply_count = 0;
+    feed(long_line + 50);
+    Cmd_Poll(&hcmd);
+    feed(long_line + 50);
+    Cmd_Poll(&hcmd);
+    feed("\nmode scale\n");
+    Cmd_Poll(&hcmd);
+    expect("too long", reply_count == 2 && !strcmp(last_reply, "OK") && hcmd.overruns == 0);
+
+    /* DMA restarted after a UART error: overrun, then back in sync */
+    feed("num 1");
+    Cmd_Poll(&hcmd);
+    Cmd_RxRestart(&hcmd);
+    reply_count = 0;
+    feed("2\nmode scale\n");
+    Cmd_Poll(&hcmd);
+    expect("restart", reply_count == 2 && !strcmp(last_reply, "OK") && hcmd.overruns == 1);
+
+    printf("unit checks: %s\n", fails ? "FAIL" : "ok");
+}
+
+/* ---- host time per command ---- */
+
+static void host_time(void)
+{
+    static char     stream[1u << 20];
+    size_t          n = 0, off = 0;
+    uint32_t        cmds = 0;
+    struct timespec t0, t1;
+    Expect_t        e;
+
+    while (n < sizeof(stream) - 64u) {
+        n += (size_t)gen_cmd(stream + n, &e);
+        cmds++;
+    }
+    cmd_setup(1024, 0);
+    exp_n = exp_i = 0;              /* no expectations: values not checked */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (off < n) {
+        size_t k = (n - off < 256u) ? n - off : 256u;
+        for (size_t i = 0; i < k; i++) ring[(hcmd.rx_pos + i) & 1023u] = (uint8_t)stream[off + i];
+        Cmd_RxEvent(&hcmd, (uint16_t)((hcmd.rx_pos + k) & 1023u));
+        Cmd_Poll(&hcmd);
+        off += k;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("host time per command: %.1f ns (%u commands, %u answered)\n",
+           ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / cmds, cmds, hcmd.lines);
+}
+
+int main(void)
+{
+    static const Run_t runs[] = {
+        { "strobe, every 20 ms",      115200,  256, SEND_EVERY,   20000, 0, 1, 1, 0 },
+        { "strobe, back to back",     115200,  256, SEND_B2B,         0, 0, 1, 1, 0 },
+        { "strobe, b2b, no rx_head",  115200,  256, SEND_B2B,         0, 0, 1, 0, 1 },
+        { "scale, request/response",  921600, 1024, SEND_REQRESP,     0, 1, 1, 1, 0 },
+        { "scale, every 20 ms",       921600, 1024, SEND_EVERY,   20000, 1, 1, 1, 0 },
+        { "scale, back to back",      921600, 1024, SEND_B2B,         0, 1, 1, 1, 1 },
+        { "scale, no idle event",     921600, 1024, SEND_EVERY,   20000, 1, 0, 1, 0 },
+    };
+    int ok = 1;
+
+    unit_checks();
+    ok = !fails;
+
+    printf("\n%u s per run, main loop every 1 ms, latency from the line end to the answer (ms)\n", RUN_S);
+    printf("%-26s %7s %5s %7s %7s %6s %5s %5s %4s %8s %8s %8s\n",
+           "run", "baud", "ring", "sent", "answer", "lost", "ovr", "/ovr", "bad", "mean", "p99", "max");
+    for (unsigned i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) ok &= run(&runs[i]);
+
+    host_time();
+    return ok ? 0 : 1;
+}
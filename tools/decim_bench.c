@@ -0,0 +1,196 @@
+/*
+ * decim_bench.c - host benchmark of the 005-scale-ADS1220 decimation chain
+ *
+ * Synthetic ADS1220 stream at 2000 SPS (turbo mode) through the
+ * firmware's own decim.c, set up as in main.c (ADC_DECIM):
+ *
+ *   2000 SPS -> CIC 10x3 + FIR 21 -> 200 Hz -> CIC 5x3 + FIR 31 /4 -> 10 Hz
+ *
+ * against the plain moving average at the same output rates (mean of 10
+ * and of 200 inputs, one output per block). Per input trace it prints the
+ * rms error of every output against the true load, in ADC codes, and
+ * the gain in resolution over the raw input. Traces:
+ *
+ *   - white noise only (turbo mode noise of the ADS1220 at gain 128),
+ *   - plus mains pickup (50 Hz) and platform vibration (23 Hz, 137 Hz),
+ *   - a load step, for the settling time to within 0.1 % of the step.
+ *
+ * Cost: cycles per input sample of both (rdtsc on x86, else ns), the
+ * minimum over 5000 batches of 4096 samples. These are host cycles, not
+ * Cortex-M4 cycles.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/Filter tools/decim_bench.c \
+ *       005-scale-ADS1220/App/Filter/decim.c -lm -o decim_bench \
+ *       && ./decim_bench
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "decim.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES()        __rdtsc()
+#define CYCLES_UNIT     "cycles"
+#else
+static uint64_t ns_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#define CYCLES()        ns_now()
+#define CYCLES_UNIT     "ns"
+#endif
+
+#define FS          2000.0
+#define SECS        60.0
+#define LOAD        1000000.0       /* codes */
+
+typedef struct {
+    const char *name;
+    double      noise;              /* codes rms                          */
+    double      a50, a23, a137;     /* tone amplitudes, codes             */
+} Trace_t;
+
+typedef struct {
+    int64_t  sum;
+    uint16_t n, len;
+    int32_t  out;                   /* codes << DECIM_FRAC                */
+} Block_t;
+
+static uint8_t block_process(Block_t *b, int32_t x)
+{
+    b->sum += x;
+    if (++b->n < b->len) return 0;
+    b->out = (int32_t)((b->sum * (1 << DECIM_FRAC)) / b->len);
+    b->sum = 0;
+    b->n   = 0;
+    return 1;
+}
+
+static void chain_setup(Decim_t *d)
+{
+    d->count              = 2;
+    d->stage[0].r         = 10;
+    d->stage[0].n         = 3;
+    d->stage[0].taps      = Decim_Taps200Hz;
+    d->stage[0].ntaps     = 21;
+    d->stage[0].fir_decim = 1;
+    d->stage[1].r         = 5;
+    d->stage[1].n         = 3;
+    d->stage[1].taps      = Decim_Taps10Hz;
+    d->stage[1].ntaps     = 31;
+    d->stage[1].fir_decim = 4;
+    if (Decim_Init(d) != 0) { printf("Decim_Init failed\n"); exit(1); }
+}
+
+static double urand(void) { return (rand() + 0.5) / ((double)RAND_MAX + 1.0); }
+static double gauss(void) { return sqrt(-2.0 * log(urand())) * cos(2.0 * M_PI * urand()); }
+
+static void run(const Trace_t *tr)
+{
+    Decim_t d;
+    Block_t b10 = { 0, 0, 10, 0 }, b200 = { 0, 0, 200, 0 };
+    double  e[4] = { 0 }, in2 = 0.0;
+    long    c[4] = { 0 }, n = (long)(SECS * FS);
+
+    chain_setup(&d);
+    for (long i = 0; i < n; i++) {
+        double  t = i / FS;
+        double  v = LOAD + tr->noise * gauss() + tr->a50 * sin(2 * M_PI * 50.0 * t)
+                  + tr->a23 * sin(2 * M_PI * 23.0 * t + 1.0) + tr->a137 * sin(2 * M_PI * 137.0 * t + 2.0);
+        int32_t x = (int32_t)lround(v);
+        uint8_t r = Decim_Process(&d, x);
+        int     settled = t > 2.0;      /* skip the filters' start-up */
+
+        if (settled) in2 += (x - LOAD) * (x - LOAD);
+        if (settled && (r & 1u)) { double q = d.stage[0].out / 64.0 - LOAD; e[0] += q * q; c[0]++; }
+        if (settled && (r & 2u)) { double q = d.stage[1].out / 64.0 - LOAD; e[1] += q * q; c[1]++; }
+        if (block_process(&b10, x)  && settled) { double q = b10.out / 64.0 - LOAD;  e[2] += q * q; c[2]++; }
+        if (block_process(&b200, x) && settled) { double q = b200.out / 64.0 - LOAD; e[3] += q * q; c[3]++; }
+    }
+
+    double rin = sqrt(in2 / (n - 2.0 * FS));
+    printf("%s: input %.1f codes rms\n", tr->name, rin);
+    printf("  200 Hz  CIC+FIR %7.2f codes (%4.1f bits)   moving average 10  %7.2f codes (%4.1f bits)\n",
+           sqrt(e[0] / c[0]), log2(rin / sqrt(e[0] / c[0])), sqrt(e[2] / c[2]), log2(rin / sqrt(e[2] / c[2])));
+    printf("   10 Hz  CIC+FIR %7.2f codes (%4.1f bits)   moving average 200 %7.2f codes (%4.1f bits)\n",
+           sqrt(e[1] / c[1]), log2(rin / sqrt(e[1] / c[1])), sqrt(e[3] / c[3]), log2(rin / sqrt(e[3] / c[3])));
+}
+
+static void step(void)
+{
+    Decim_t d;
+    Block_t b10 = { 0, 0, 10, 0 }, b200 = { 0, 0, 200, 0 };
+    double  t_set[4] = { -1, -1, -1, -1 };
+    long    n = (long)(4.0 * FS);
+
+    chain_setup(&d);
+    for (long i = 0; i < n; i++) {
+        double  t = i / FS;
+        int32_t x = (t >= 1.0) ? (int32_t)LOAD : 0;
+        uint8_t r = Decim_Process(&d, x);
+        double  y[4] = { NAN, NAN, NAN, NAN };
+
+        if (r & 1u) y[0] = d.stage[0].out / 64.0;
+        if (r & 2u) y[1] = d.stage[1].out / 64.0;
+        if (block_process(&b10, x))  y[2] = b10.out / 64.0;
+        if (block_process(&b200, x)) y[3] = b200.out / 64.0;
+        for (int k = 0; k < 4; k++) {
+            if (isnan(y[k]) || t < 1.0) continue;
+            if (fabs(y[k] - LOAD) > LOAD * 1e-3) t_set[k] = -1.0;
+            else if (t_set[k] < 0.0) t_set[k] = t - 1.0;
+        }
+    }
+    printf("step settling (0.1%%): 200 Hz CIC+FIR %.1f ms, moving average 10 %.1f ms; "
+           "10 Hz CIC+FIR %.0f ms, moving average 200 %.0f ms\n",
+           t_set[0] * 1e3, t_set[2] * 1e3, t_set[1] * 1e3, t_set[3] * 1e3);
+}
+
+/* min over batches of the mean per input sample: the figure without the
+ * interruptions of the host */
+static double cycles_per_sample(int chain)
+{
+    static int32_t in[4096];
+    Decim_t  d;
+    Block_t  b10 = { 0, 0, 10, 0 }, b200 = { 0, 0, 200, 0 };
+    volatile uint32_t sink = 0;
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < 4096; i++) in[i] = (int32_t)(LOAD + 30.0 * gauss());
+    chain_setup(&d);
+    for (int r = 0; r < 5000; r++) {
+        uint64_t c0 = CYCLES();
+        for (int i = 0; i < 4096; i++) {
+            int32_t x = in[i];
+            if (chain) sink += Decim_Process(&d, x);
+            else       sink += block_process(&b10, x) + block_process(&b200, x);
+        }
+        uint64_t c = CYCLES() - c0;
+        if (c < best) best = c;
+    }
+    (void)sink;
+    return (double)best / 4096;
+}
+
+int main(void)
+{
+    static const Trace_t traces[] = {
+        { "white noise",                     30.0,   0.0,   0.0,   0.0 },
+        { "white noise + 50/23/137 Hz tones", 30.0, 100.0, 200.0, 200.0 },
+    };
+
+    srand(5);
+    for (unsigned i = 0u; i < sizeof(traces) / sizeof(traces[0]); i++)
+        run(&traces[i]);
+    step();
+    printf("host " CYCLES_UNIT " per input sample: CIC+FIR chain %.1f, both moving averages %.1f\n",
+           cycles_per_sample(1), cycles_per_sample(0));
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * main.h - host stand-in for the CubeMX main.h, for the tools that build
+ *          the SH1106 driver on a PC (tools/sh1106_*.c)
+ *
+ * Declares only the HAL types and calls the driver uses. The tool that
+ * links the driver provides hi2c1 and the HAL functions: they record the
+ * bus traffic instead of driving an I2C peripheral.
+ */
+
+#ifndef __MAIN_H__
+#define __MAIN_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+    HAL_I2C_STATE_RESET   = 0x00U,
+    HAL_I2C_STATE_READY   = 0x20U,
+    HAL_I2C_STATE_BUSY    = 0x24U,
+    HAL_I2C_STATE_BUSY_TX = 0x21U
+} HAL_I2C_StateTypeDef;
+
+typedef struct {
+    void                          *Instance;
+    volatile HAL_I2C_StateTypeDef  State;
+    volatile uint32_t              ErrorCode;
+} I2C_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                          uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                              uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                    uint16_t MemAddress, uint16_t MemAddSize,
+                                    uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                        uint16_t MemAddress, uint16_t MemAddSize,
+                                        uint8_t *pData, uint16_t Size);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+
+void     HAL_Delay(uint32_t Delay);
+uint32_t HAL_GetTick(void);
+
+/* CMSIS intrinsic used by the glyph blitter, value is never 0 there */
+#define __CLZ(x)    ((uint8_t)__builtin_clz((uint32_t)(x)))
+
+#endif /* __MAIN_H__ */
@@ -0,0 +1,43 @@
+/*
+ * sh1106_blocking.c - the 005-scale-ADS1220 SH1106 driver (blocking I2C,
+ *                     no SH1106_USE_DMA) renamed to blk_SH1106_*, so a
+ *                     tool can link it next to the 006-stroboscope driver
+ *                     (DMA) and compare the bus traffic of the two paths
+ *
+ * The driver sources of the two projects are the same file, only
+ * sh1106_conf.h differs. The quoted includes of the driver resolve in its
+ * own directory, so this build picks up the 005 configuration; main.h
+ * comes from tools/host.
+ */
+
+#define SH1106_Init              blk_SH1106_Init
+#define SH1106_ON                blk_SH1106_ON
+#define SH1106_OFF               blk_SH1106_OFF
+#define SH1106_ToggleInvert      blk_SH1106_ToggleInvert
+#define SH1106_SetBrightness     blk_SH1106_SetBrightness
+#define SH1106_Fill              blk_SH1106_Fill
+#define SH1106_Clear             blk_SH1106_Clear
+#define SH1106_GetBuffer         blk_SH1106_GetBuffer
+#define SH1106_Invalidate        blk_SH1106_Invalidate
+#define SH1106_UpdateScreen      blk_SH1106_UpdateScreen
+#define SH1106_UpdateScreenAsync blk_SH1106_UpdateScreenAsync
+#define SH1106_IsBusy            blk_SH1106_IsBusy
+#define SH1106_UpdateScreenChunk blk_SH1106_UpdateScreenChunk
+#define SH1106_GetTotalChunks    blk_SH1106_GetTotalChunks
+#define SH1106_DrawPixel         blk_SH1106_DrawPixel
+#define SH1106_DrawLine          blk_SH1106_DrawLine
+#define SH1106_DrawRectangle     blk_SH1106_DrawRectangle
+#define SH1106_FillRectangle     blk_SH1106_FillRectangle
+#define SH1106_DrawCircle        blk_SH1106_DrawCircle
+#define SH1106_FillCircle        blk_SH1106_FillCircle
+#define SH1106_DrawBitmap        blk_SH1106_DrawBitmap
+#define SH1106_SetCursor         blk_SH1106_SetCursor
+#define SH1106_GetCursor         blk_SH1106_GetCursor
+#define SH1106_WriteChar         blk_SH1106_WriteChar
+#define SH1106_WriteString       blk_SH1106_WriteString
+#define SH1106_WriteStringAt     blk_SH1106_WriteStringAt
+#define SH1106_GetStringWidth    blk_SH1106_GetStringWidth
+#define SH1106_WriteCommand      blk_SH1106_WriteCommand
+#define SH1106_WriteData         blk_SH1106_WriteData
+
+#include "../../005-scale-ADS1220/App/SH1106/sh1106.c"
@@ -0,0 +1,271 @@
+/*
+ * prof_bench.c - execution time zones on the host (App/Prof) for
+ *                005-scale-ADS1220 and 006-stroboscope
+ *
+ * prof.c on a host times with CLOCK_MONOTONIC in nanoseconds instead of
+ * the DWT cycle counter, so the zones of the firmware that do not touch
+ * the hardware run here with the same PROF_BEGIN / PROF_END:
+ *
+ *   - acq: one batch of 16 ADC results through the scale's ADC_DECIM
+ *     chain as in main.c: decim.c (2000 SPS -> 200 Hz -> 10 Hz), then
+ *     Calib_Weight on both outputs and WFilter_Process on the 10 Hz one,
+ *   - cmd: one command line through Cmd_Poll, from the RX event to the
+ *     handler and its OK (cmd.c, a "freq <Hz>" handler as in 006),
+ *   - empty: an empty zone, what is left after Prof_Init has measured
+ *     the overhead (the shortest clock read pair) and removed it: the
+ *     jitter above that minimum, a few ns.
+ *
+ * Before that, unit checks of the statistics: bins, min/max/mean, the
+ * percentile bound, the clamp of the overhead, and the report format.
+ * The report is printed as the firmware sends it ("prof hist" or the
+ * ITM dump), in microseconds with tick_hz = 1e9.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -DPROF_ENABLE=1 -I005-scale-ADS1220/App/Prof \
+ *       -I005-scale-ADS1220/App/Filter -I005-scale-ADS1220/App/Calib \
+ *       -I005-scale-ADS1220/App/Cmd tools/prof_bench.c \
+ *       005-scale-ADS1220/App/Prof/prof.c 005-scale-ADS1220/App/Filter/decim.c \
+ *       005-scale-ADS1220/App/Filter/wfilter.c 005-scale-ADS1220/App/Calib/calib.c \
+ *       005-scale-ADS1220/App/Cmd/cmd.c -o prof_bench && ./prof_bench
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "prof.h"
+#include "decim.h"
+#include "wfilter.h"
+#include "calib.h"
+#include "cmd.h"
+
+#if !PROF_ENABLE
+#error "build with -DPROF_ENABLE=1"
+#endif
+
+#define RUNS        200000u
+#define RING        256u
+
+enum { PZ_ACQ = 0, PZ_CMD, PZ_EMPTY, PZ_COUNT };
+
+static const char *const names[PZ_COUNT] = { "acq", "cmd", "empty" };
+static Prof_Zone_t       zone[PZ_COUNT];
+static Prof_Handle_t     hprof;
+static uint32_t          failed;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+static void print_line(const char *s, uint16_t len)
+{
+    printf("%.*s\n", (int)len, s);
+}
+
+/* ---- unit checks ---- */
+
+static char     last_line[128];
+static uint32_t report_lines;
+
+static void keep_line(const char *s, uint16_t len)
+{
+    memcpy(last_line, s, len);
+    last_line[len] = '\0';
+    report_lines++;
+}
+
+static void unit_checks(void)
+{
+    Prof_Zone_t   z[1];
+    const char   *n[1] = { "t" };
+    Prof_Handle_t h    = { z, n, 1, 1000000000u, 0 };
+
+    Prof_Init(&h);
+    h.overhead = 0;
+
+    check(Prof_Percentile(&z[0], 99) == 0 && Prof_Mean(&z[0]) == 0, "empty zone reads 0");
+
+    /* bins: 0 -> 0, 1 -> 1, 2..3 -> 2, 4..7 -> 3, 2^27 and up -> last */
+    Prof_Add(&h, 0, 0);
+    Prof_Add(&h, 0, 1);
+    Prof_Add(&h, 0, 3);
+    Prof_Add(&h, 0, 4);
+    Prof_Add(&h, 0, 7);
+    Prof_Add(&h, 0, 0xFFFFFFFFu);
+    check(z[0].hist[0] == 1 && z[0].hist[1] == 1 && z[0].hist[2] == 1 && z[0].hist[3] == 2 &&
+          z[0].hist[PROF_BINS - 1] == 1, "log2 bins");
+    check(z[0].count == 6 && z[0].min == 0 && z[0].max == 0xFFFFFFFFu, "count, min, max");
+    check(z[0].sum == 15ull + 0xFFFFFFFFull, "64-bit sum");
+    check(Prof_Percentile(&z[0], 50) == 3, "p50 upper bin end");
+    check(Prof_Percentile(&z[0], 100) == 0xFFFFFFFFu, "p100 = max");
+
+    /* 1000 samples 100..199 and 10 at 5000: p99 in the bin of 199,
+     * p100 reaches the outliers, the bound never above max */
+    Prof_Reset(&h);
+    for (uint32_t i = 0; i < 1000; i++) Prof_Add(&h, 0, 100 + i % 100);
+    for (uint32_t i = 0; i < 10; i++)   Prof_Add(&h, 0, 5000);
+    check(Prof_Mean(&z[0]) == (uint32_t)((1000ull * 149.5 + 50000 + 505) / 1010), "mean rounded");
+    check(Prof_Percentile(&z[0], 99) == 255, "p99 within a factor 2");
+    check(Prof_Percentile(&z[0], 100) == 5000, "percentile clamped to max");
+
+    /* the overhead is removed and clamped at 0 */
+    Prof_Reset(&h);
+    h.overhead = 20;
+    Prof_Add(&h, 0, 15);
+    Prof_Add(&h, 0, 120);
+    check(z[0].min == 0 && z[0].max == 100, "overhead removed, clamped");
+
+    /* report: header + one line per zone (+ histogram) */
+    report_lines = 0;
+    Prof_Report(&h, 0, keep_line);
+    check(report_lines == 2 && strstr(last_line, "0.10") != NULL, "report in us, two decimals");
+    report_lines = 0;
+    Prof_Report(&h, 1, keep_line);
+    check(report_lines == 3 && strcmp(last_line, "  hist 0:1 7:1") == 0, "report histogram");
+    check(Prof_Us(&h, 1500) == 2, "ticks to us, rounded");
+}
+
+/* ---- zones ---- */
+
+static Decim_t   hdecim;
+static Calib_t   hcal;
+static WFilter_t wfilter;
+static int32_t   sink;
+
+static void acq_setup(void)
+{
+    /* as main.c with ADC_DECIM */
+    hdecim.count              = 2;
+    hdecim.stage[0].r         = 10;
+    hdecim.stage[0].n         = 3;
+    hdecim.stage[0].taps      = Decim_Taps200Hz;
+    hdecim.stage[0].ntaps     = 21;
+    hdecim.stage[0].fir_decim = 1;
+    hdecim.stage[1].r         = 5;
+    hdecim.stage[1].n         = 3;
+    hdecim.stage[1].taps      = Decim_Taps10Hz;
+    hdecim.stage[1].ntaps     = 31;
+    hdecim.stage[1].fir_decim = 4;
+    if (Decim_Init(&hdecim) != 0) { printf("Decim_Init failed\n"); exit(1); }
+
+    Calib_Clear(&hcal);
+    Calib_AddPoint(&hcal, 100000, 0);
+    Calib_AddPoint(&hcal, 100000 + 1724 * 500, 5000);
+    Calib_AddPoint(&hcal, 100000 + 1724 * 2000, 20000);
+    if (Calib_Fit(&hcal) != CALIB_OK) { printf("Calib_Fit failed\n"); exit(1); }
+
+    wfilter.len_max      = 32;
+    wfilter.stable_len   = 10;
+    wfilter.step         = 2 * 1724;
+    wfilter.step_confirm = 2;
+    wfilter.noise        = 172;
+    WFilter_Reset(&wfilter);
+}
+
+/* the body of the ADC batch loop in main.c, ADC_DECIM */
+static void acq_batch(const int32_t *code, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        uint8_t ready = Decim_Process(&hdecim, code[i]);
+        if (ready & 1u) {
+            int32_t c = (hdecim.stage[0].out + (1 << (DECIM_FRAC - 1))) >> DECIM_FRAC;
+            sink += Calib_Weight(&hcal, c);
+        }
+        if (ready & 2u) {
+            int32_t c = (hdecim.stage[1].out + (1 << (DECIM_FRAC - 1))) >> DECIM_FRAC;
+            sink += Calib_Weight(&hcal, WFilter_Process(&wfilter, c));
+        }
+    }
+}
+
+static uint8_t      ring[RING];
+static Cmd_Handle_t hcmd;
+static uint16_t     ring_pos;
+static int32_t      freq_mhz;
+
+static Cmd_Status_t Con_Freq(Cmd_Handle_t *h, uint8_t argc)
+{
+    (void)argc;
+    return Cmd_ArgNum(h, 0, 3, 153, 1000000, &freq_mhz);
+}
+
+static const Cmd_Entry_t table[] = {
+    { "freq", "<Hz>", 1, 1, Con_Freq },
+};
+
+static void no_reply(const char *s, uint16_t len)
+{
+    (void)s;
+    sink += len;
+}
+
+static void cmd_setup(void)
+{
+    hcmd.rx        = ring;
+    hcmd.rx_size   = RING;
+    hcmd.table     = table;
+    hcmd.table_len = 1;
+    hcmd.reply     = no_reply;
+    hcmd.rx_head   = NULL;
+    Cmd_Init(&hcmd);
+}
+
+/* a line as the DMA would leave it, then its idle line event */
+static void cmd_receive(const char *line)
+{
+    for (const char *p = line; *p; p++) ring[ring_pos++ & (RING - 1u)] = (uint8_t)*p;
+    ring_pos &= RING - 1u;
+    Cmd_RxEvent(&hcmd, ring_pos);
+}
+
+int main(void)
+{
+    static int32_t code[16];
+    char           line[32];
+
+    unit_checks();
+    printf("unit checks: %s\n\n", failed ? "FAILED" : "passed");
+
+    hprof.zone    = zone;
+    hprof.names   = names;
+    hprof.count   = PZ_COUNT;
+    hprof.tick_hz = 1000000000u;
+    Prof_Init(&hprof);
+    printf("clock read overhead removed: %u ns\n\n", hprof.overhead);
+
+    acq_setup();
+    cmd_setup();
+    srand(1);
+
+    for (uint32_t r = 0; r < RUNS; r++) {
+        for (int i = 0; i < 16; i++) code[i] = 100000 + 1724 * 120 + rand() % 64 - 32;
+        {
+            PROF_BEGIN(t);
+            acq_batch(code, 16);
+            PROF_END(&hprof, PZ_ACQ, t);
+        }
+
+        snprintf(line, sizeof(line), "freq %u.%03u\n", 1u + r % 999u, r % 1000u);
+        cmd_receive(line);
+        {
+            PROF_BEGIN(t);
+            Cmd_Poll(&hcmd);
+            PROF_END(&hprof, PZ_CMD, t);
+        }
+
+        {
+            PROF_BEGIN(t);
+            PROF_END(&hprof, PZ_EMPTY, t);
+        }
+    }
+    check(hcmd.lines == RUNS && hcmd.errors == 0, "every command parsed");
+
+    Prof_Report(&hprof, 1, print_line);
+    printf("\n(sink %d)\n", (int)(sink & 1));
+    return failed ? 1 : 0;
+}
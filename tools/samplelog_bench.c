@@ -0,0 +1,288 @@
+/*
+ * samplelog_bench.c - host test of the 005-scale-ADS1220 sample logger
+ *
+ * Runs the firmware's sample_log.c against an emulated flash sector
+ * (128 KB, programs only clear bits, 16 us per word as the F411 at 3.3 V)
+ * with the settings of main.c: 512-byte blocks, time in 2^10 cycles of
+ * the 100 MHz DWT counter (10.24 us), SampleLog_Poll(8) once per 1 ms
+ * main loop pass.
+ *
+ * Traces, with the DRDY timestamp jittering by up to +-3 us:
+ *   - 20 SPS, one channel: load steps of 100 g every 10 s, 25 codes rms,
+ *   - 20 SPS, MUX scan: bridge, two references, the offset every 4th,
+ *   - 2000 SPS turbo, one channel: the same load, 150 codes rms,
+ *   - 2000 SPS with 600 codes rms (a vibrating platform).
+ *
+ * For each it logs until the sector is full and prints bytes per sample,
+ * the compression against 8 bytes raw (time + code), the words and the
+ * emulated program time per second of logging, the longest stall of a
+ * single Poll, the time the sector lasts, the samples dropped, and checks
+ * that every sample decodes back exactly.
+ *
+ * Then a power loss in the middle of a block: the block is torn, Init
+ * must continue after it, the decoder must skip it; and a flipped bit in
+ * a full block must fail its crc.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/SampleLog -I005-scale-ADS1220/App/CfgLog \
+ *       tools/samplelog_bench.c 005-scale-ADS1220/App/SampleLog/sample_log.c \
+ *       005-scale-ADS1220/App/CfgLog/cfg_log.c -lm -o samplelog_bench \
+ *       && ./samplelog_bench [dump.bin]
+ * dump.bin gets the sector of the first trace, for samplelog_decode.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sample_log.h"
+
+#define SECTOR      (128u * 1024u)
+#define BLOCK       512u
+#define SHIFT       10u
+#define TICK_HZ     100000000.0
+#define WORD_US     16.0
+#define LOOP_MS     1.0
+#define POLL_WORDS  8u
+#define CPG         1724.0          /* codes per gram                      */
+#define MAX_SAMPLES 200000
+
+static uint32_t flash[SECTOR / 4u];
+static long     prog_words, prog_fail_after = -1;
+static uint32_t poll_max;
+
+static int emu_program(uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        if (prog_fail_after == 0) return -1;            /* power gone */
+        if (prog_fail_after > 0) prog_fail_after--;
+        if ((flash[offset / 4u + i] & words[i]) != words[i]) {
+            printf("program over a non-erased word at %u\n", offset + 4u * i);
+            exit(1);
+        }
+        flash[offset / 4u + i] &= words[i];
+        prog_words++;
+    }
+    if (count > poll_max) poll_max = count;
+    return 0;
+}
+
+static int emu_erase(void)
+{
+    memset(flash, 0xFF, sizeof(flash));
+    return 0;
+}
+
+static double urand(void) { return (rand() + 0.5) / ((double)RAND_MAX + 1.0); }
+static double gauss(void) { return sqrt(-2.0 * log(urand())) * cos(2.0 * M_PI * urand()); }
+
+static void log_setup(SampleLog_Handle_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->area       = flash;
+    h->area_size  = SECTOR;
+    h->block_size = BLOCK;
+    h->time_shift = SHIFT;
+    h->tick_hz    = (uint32_t)TICK_HZ;
+    h->program    = emu_program;
+    h->erase      = emu_erase;
+}
+
+typedef struct {
+    const char *name;
+    double      sps, noise;
+    int         scan;
+} Trace_t;
+
+static SampleLog_Sample_t sent[MAX_SAMPLES], got[MAX_SAMPLES];
+
+/* the code for sample i at time t (s) */
+static int32_t code_at(const Trace_t *tr, long i, double t)
+{
+    static const double ref[4] = { 0.0, 5.2e6, -3.1e6, 0.0 };
+    int ch = tr->scan ? (int)(i % 4) : 0;
+    double load = 100.0 * ((long)(t / 10.0) % 4);
+
+    if (ch == 0) return (int32_t)lround(150000.0 + load * CPG + tr->noise * gauss());
+    return (int32_t)lround(ref[ch] + (ch == 3 ? 40.0 : 8.0) * gauss());
+}
+
+/* decode the whole sector into got[], 0 on a mismatch with sent[] */
+static long decode_all(uint8_t shift, long *bad)
+{
+    const uint8_t *base = (const uint8_t *)flash;
+    long n = 0;
+
+    *bad = 0;
+    for (uint32_t off = SAMPLELOG_AREA_HDR; off + BLOCK <= SECTOR; off += BLOCK) {
+        long room = MAX_SAMPLES - n;
+        int  k    = SampleLog_Decode(base + off, BLOCK, shift, NULL, got + n, (uint16_t)(room > 1000 ? 1000 : room));
+        if (k < 0) {
+            uint32_t w = 0;
+            for (uint32_t i = 0; i < BLOCK / 4u; i++) w |= ~flash[off / 4u + i];
+            if (!w) break;                      /* end of the log */
+            (*bad)++;
+            continue;
+        }
+        n += k;
+    }
+    return n;
+}
+
+static void run(const Trace_t *tr, const char *dump)
+{
+    SampleLog_Handle_t h;
+    double   t = 0.0, next_loop = 0.0, period = 1.0 / tr->sps;
+    long     n = 0, i, decoded, bad, ok = 1;
+
+    log_setup(&h);
+    SampleLog_Erase(&h);
+    SampleLog_Start(&h);
+    prog_words = 0;
+    poll_max = 0;
+
+    for (i = 0; ; i++) {
+        uint32_t cyc;
+        int32_t  code;
+        uint8_t  ch = tr->scan ? (uint8_t)(i % 4) : 0;
+
+        t   = i * period + 0.5;
+        cyc = (uint32_t)(uint64_t)llround((t + 3e-6 * (2.0 * urand() - 1.0)) * TICK_HZ);
+        code = code_at(tr, i, t);
+
+        /* main loop passes up to this sample */
+        while (next_loop <= t) {
+            SampleLog_Poll(&h, POLL_WORDS);
+            next_loop  += LOOP_MS * 1e-3;
+        }
+        if (SampleLog_Put(&h, ch, cyc, code)) {
+            if (n < MAX_SAMPLES) {
+                sent[n].time    = cyc & ~((1u << SHIFT) - 1u);
+                sent[n].value   = code;
+                sent[n].channel = ch;
+            }
+            n++;
+        } else if (SampleLog_Used(&h) + BLOCK > SECTOR) {
+            break;                              /* sector full, not counted */
+        }
+    }
+    SampleLog_Stop(&h);
+    while (SampleLog_Poll(&h, POLL_WORDS)) {}
+
+    decoded = decode_all(SHIFT, &bad);
+    if (decoded != n || bad) ok = 0;
+    for (long k = 0; ok && k < n && k < MAX_SAMPLES; k++)
+        if (got[k].time != sent[k].time || got[k].value != sent[k].value || got[k].channel != sent[k].channel)
+            ok = 0;
+
+    {
+        double secs  = t - 0.5;
+        double bps   = (double)(SECTOR - SAMPLELOG_AREA_HDR) / n;
+        printf("%-28s %7ld  %5.2f B  %4.1fx  %7.0f w/s %5.1f ms/s  %4u us  %8.0f s  %4u  %s\n",
+               tr->name, n, bps, 8.0 / bps, prog_words / secs, prog_words * WORD_US * 1e-3 / secs,
+               (unsigned)(poll_max * WORD_US), secs, h.dropped - 1u, ok ? "ok" : "MISMATCH");
+    }
+
+    if (dump) {
+        FILE *f = fopen(dump, "wb");
+        if (f) { fwrite(flash, 1, SECTOR, f); fclose(f); }
+    }
+}
+
+/* power loss while a block is programmed, then a bit flip */
+static void torn(void)
+{
+    SampleLog_Handle_t h;
+    long     decoded, bad, before = 0;
+    uint32_t cyc = 0;
+
+    log_setup(&h);
+    SampleLog_Erase(&h);
+    SampleLog_Start(&h);
+    /* fill 3 blocks, then lose the power 40 words into the 4th */
+    while (h.blocks < 3u) {
+        cyc += 5000000u;
+        SampleLog_Put(&h, 0, cyc, 150000 + (int32_t)(25.0 * gauss()));
+        SampleLog_Poll(&h, POLL_WORDS);
+    }
+    before = decode_all(SHIFT, &bad);
+    prog_fail_after = 40;
+    while (h.errors == 0u) {
+        cyc += 5000000u;
+        SampleLog_Put(&h, 0, cyc, 150000);
+        SampleLog_Poll(&h, POLL_WORDS);
+    }
+    prog_fail_after = -1;
+
+    /* reset: find the end, append a session after the torn block */
+    log_setup(&h);
+    if (SampleLog_Init(&h) != SAMPLELOG_OK || h.alloc != SAMPLELOG_AREA_HDR + 4u * BLOCK) {
+        printf("torn block: Init ends the log at %u, expected %u  FAIL\n",
+               h.alloc, SAMPLELOG_AREA_HDR + 4u * BLOCK);
+        return;
+    }
+    SampleLog_Start(&h);
+    for (int k = 0; k < 100; k++) {
+        cyc += 5000000u;
+        SampleLog_Put(&h, 0, cyc, 150000 + k);
+    }
+    SampleLog_Stop(&h);
+    while (SampleLog_Poll(&h, POLL_WORDS)) {}
+
+    decoded = decode_all(SHIFT, &bad);
+    printf("torn block: %ld bad block(s), %ld of %ld samples in the good blocks decode, "
+           "next seq %u  %s\n",
+           bad, decoded, before + 100, h.seq, (bad == 1 && decoded == before + 100) ? "ok" : "FAIL");
+
+    /* flip one bit in the first block */
+    flash[SAMPLELOG_AREA_HDR / 4u + 20u] ^= 0x00010000u;
+    decode_all(SHIFT, &bad);
+    printf("bit flip: %ld bad block(s)  %s\n", bad, bad == 2 ? "ok" : "FAIL");
+}
+
+static double ns_per_put(void)
+{
+    static SampleLog_Handle_t h;
+    static int32_t in[4096];
+    struct timespec a, e;
+    const long N = 20000000L;
+    uint32_t cyc = 0;
+
+    for (int i = 0; i < 4096; i++) in[i] = 150000 + (int32_t)(150.0 * gauss());
+    log_setup(&h);
+    SampleLog_Erase(&h);
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (long i = 0; i < N; i++) {
+        if (!h.running || SampleLog_Used(&h) + 2u * BLOCK > SECTOR) {
+            /* keep it encoding: start over without programming */
+            SampleLog_Init(&h);
+            SampleLog_Start(&h);
+        }
+        cyc += 50000u + (uint32_t)(in[i & 4095] & 255);
+        SampleLog_Put(&h, 0, cyc, in[i & 4095]);
+        h.full[0] = h.full[1] = 0;              /* blocks "written" at once */
+    }
+    clock_gettime(CLOCK_MONOTONIC, &e);
+    return ((e.tv_sec - a.tv_sec) * 1e9 + (e.tv_nsec - a.tv_nsec)) / (double)N;
+}
+
+int main(int argc, char **argv)
+{
+    static const Trace_t traces[] = {
+        { "20 SPS, bridge",             20.0,   25.0, 0 },
+        { "20 SPS, MUX scan (4 ch)",    20.0,   25.0, 1 },
+        { "2000 SPS turbo",           2000.0,  150.0, 0 },
+        { "2000 SPS, vibration",      2000.0,  600.0, 0 },
+    };
+
+    srand(21);
+    printf("trace                        samples  B/smp  ratio  programmed  flash     stall  sector lasts  drop\n");
+    for (unsigned i = 0u; i < sizeof(traces) / sizeof(traces[0]); i++)
+        run(&traces[i], (i == 0 && argc > 1) ? argv[1] : NULL);
+    torn();
+    printf("host time per SampleLog_Put: %.1f ns\n", ns_per_put());
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * samplelog_decode.c - sample log dump of 005-scale-ADS1220 -> CSV
+ *
+ * Reads an image of the sample log sector and prints every sample as
+ *
+ *   session,seq,time_s,channel,code
+ *
+ * time_s counts from the first sample of each session (a power-up that
+ * appended to the log): the 32-bit cycle counter wraps every 43 s at
+ * 100 MHz, so consecutive samples are unwrapped into seconds with the
+ * tick rate from the sector header. Torn or corrupt blocks are reported
+ * on stderr and skipped; the time keeps counting across them as long as
+ * the gap is shorter than one wrap.
+ *
+ * Read the sector with the board halted, e.g.
+ *   st-flash read dump.bin 0x08020000 0x20000
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/SampleLog -I005-scale-ADS1220/App/CfgLog \
+ *       tools/samplelog_decode.c 005-scale-ADS1220/App/SampleLog/sample_log.c \
+ *       005-scale-ADS1220/App/CfgLog/cfg_log.c -o samplelog_decode \
+ *       && ./samplelog_decode dump.bin > samples.csv
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sample_log.h"
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int erased(const uint8_t *p, uint32_t n)
+{
+    while (n--) if (*p++ != 0xFFu) return 0;
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t     img[4u * 1024u * 1024u];
+    SampleLog_Sample_t s[SAMPLELOG_BLOCK_MAX];
+    SampleLog_Block_t  info;
+    FILE    *f;
+    size_t   size;
+    uint32_t hdr, tick_hz, block, blocks = 0, bad = 0, samples = 0;
+    uint8_t  shift;
+    int      session = -1;
+    uint32_t last = 0;
+    uint64_t ticks = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s dump.bin > samples.csv\n", argv[0]);
+        return 1;
+    }
+    f = fopen(argv[1], "rb");
+    if (!f) { perror(argv[1]); return 1; }
+    size = fread(img, 1, sizeof(img), f);
+    fclose(f);
+
+    if (size < SAMPLELOG_AREA_HDR || get32(img) != SAMPLELOG_MAGIC) {
+        fprintf(stderr, "%s: no sample log header\n", argv[1]);
+        return 1;
+    }
+    hdr     = get32(img + 4);
+    shift   = (uint8_t)(hdr >> 8);
+    block   = hdr >> 16;
+    tick_hz = get32(img + 8);
+    if ((hdr & 0xFFu) != SAMPLELOG_VERSION || block > SAMPLELOG_BLOCK_MAX || !tick_hz) {
+        fprintf(stderr, "%s: version %u, block %u, %u Hz not supported\n",
+                argv[1], hdr & 0xFFu, block, tick_hz);
+        return 1;
+    }
+
+    printf("session,seq,time_s,channel,code\n");
+    for (uint32_t off = SAMPLELOG_AREA_HDR; off + block <= size; off += block) {
+        int n;
+
+        if (erased(img + off, block)) break;
+        n = SampleLog_Decode(img + off, (uint16_t)block, shift, &info, s, SAMPLELOG_BLOCK_MAX);
+        if (n < 0) {
+            fprintf(stderr, "block at 0x%05x: bad crc or torn, skipped\n", off);
+            bad++;
+            continue;
+        }
+        if (info.start || session < 0) {
+            session++;
+            ticks = 0;
+            last  = info.t0 >> shift << shift;
+        }
+        for (int i = 0; i < n; i++) {
+            ticks += (uint32_t)(s[i].time - last);
+            last   = s[i].time;
+            printf("%d,%u,%.6f,%u,%d\n", session, info.seq, (double)ticks / tick_hz,
+                   s[i].channel, s[i].value);
+        }
+        blocks++;
+        samples += (uint32_t)n;
+    }
+    fprintf(stderr, "%u samples in %u blocks, %d session(s), %u bad block(s); %.2f bytes per sample\n",
+            samples, blocks, session + 1, bad,
+            samples ? (double)(blocks + bad) * block / samples : 0.0);
+    return bad ? 2 : 0;
+}
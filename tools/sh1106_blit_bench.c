@@ -0,0 +1,274 @@
+/*
+ * sh1106_blit_bench.c - the SH1106 glyph blitters against the per-pixel
+ *                       renderer (App/SH1106, SH1106_WriteChar)
+ *
+ * SH1106_WriteChar draws a glyph with one of three renderers:
+ *   - packed fonts (SH1106_FONT_PAGES): SH1106_DrawGlyphColumns, page bytes
+ *     shifted into the buffer,
+ *   - row-major fonts up to SH1106_BLIT_MAX_HEIGHT (25) rows: rows
+ *     transposed into 32-bit column masks, ORed / ANDed per page,
+ *   - taller row-major fonts: SH1106_DrawGlyphPixels, one DrawPixel per
+ *     set pixel, the renderer all text used before the blitters.
+ *
+ * The driver is included in this file, so the static DrawGlyphPixels and
+ * the frame buffer are reachable. Each font of sh1106_fonts_packed.c is
+ * drawn as it is (packed) and as row-major rows unpacked from it, and two
+ * synthetic fonts with random pixels check the limits: 16 x 25 (the
+ * tallest for the column blitter, 4 pages) and 16 x 26 (per-pixel path).
+ * Every glyph of every font is drawn in both colours over a random
+ * background, at y = 0..7 (every bit shift), at the bottom edge, and at
+ * x positions clipped on the left and on the right. The buffer must be
+ * the one DrawGlyphPixels makes from the same rows, and every changed
+ * byte must be inside the dirty span marked for the next update.
+ *
+ * The time per glyph (host ns, white over a cleared buffer, y = 3) is
+ * then printed for the three renderers.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Itools/host -I006-stroboscope/App/SH1106 tools/sh1106_blit_bench.c \
+ *       006-stroboscope/App/SH1106/sh1106_fonts_packed.c \
+ *       -o sh1106_blit_bench && ./sh1106_blit_bench
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sh1106.c"
+#include "sh1106_fonts.h"
+
+/* the driver's I2C code is linked but not used here */
+I2C_HandleTypeDef hi2c1;
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *h, uint16_t a, uint8_t *p,
+                                          uint16_t n, uint32_t t)
+{ (void)h; (void)a; (void)p; (void)n; (void)t; return HAL_ERROR; }
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *h, uint16_t a, uint8_t *p,
+                                              uint16_t n)
+{ (void)h; (void)a; (void)p; (void)n; return HAL_ERROR; }
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *h, uint16_t a, uint16_t m, uint16_t ms,
+                                    uint8_t *p, uint16_t n, uint32_t t)
+{ (void)h; (void)a; (void)m; (void)ms; (void)p; (void)n; (void)t; return HAL_ERROR; }
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *h, uint16_t a, uint16_t m,
+                                        uint16_t ms, uint8_t *p, uint16_t n)
+{ (void)h; (void)a; (void)m; (void)ms; (void)p; (void)n; return HAL_ERROR; }
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *h) { (void)h; return HAL_I2C_STATE_READY; }
+void     HAL_Delay(uint32_t d) { (void)d; }
+uint32_t HAL_GetTick(void) { return 0; }
+
+#define GLYPHS      95u
+#define TIME_RUNS   200u
+
+static uint32_t failed, cases;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+/* one font drawn both ways: packed columns, and rows (one uint16_t per
+ * row, MSB = left column) */
+typedef struct {
+    const char    *name;
+    SH1106_Font_t  packed;          /* SH1106_FONT_PAGES, zeroed if none   */
+    SH1106_Font_t  rows;            /* SH1106_FONT_ROWS, data set         */
+} Case_t;
+
+static uint8_t glyph_width(const SH1106_Font_t *f, uint8_t c)
+{
+    return f->char_width ? f->char_width[c] : f->width;
+}
+
+static uint16_t *unpack(const SH1106_Font_t *f)
+{
+    uint8_t   pages = (uint8_t)((f->height + 7u) / 8u);
+    uint16_t *rows  = calloc(GLYPHS * f->height, sizeof(uint16_t));
+
+    for (uint8_t c = 0; c < GLYPHS; c++) {
+        uint8_t  w   = glyph_width(f, c);
+        uint16_t off = f->offsets ? f->offsets[c] : (uint16_t)(c * w * pages);
+
+        for (uint8_t r = 0; r < f->height; r++)
+            for (uint8_t x = 0; x < w; x++)
+                if ((f->cols[off + (r / 8u) * w + x] >> (r % 8u)) & 1u)
+                    rows[c * f->height + r] |= (uint16_t)(0x8000u >> x);
+    }
+    return rows;
+}
+
+/* random fixed-width font: rows, and the packed form of the same pixels */
+static void synth(Case_t *k, const char *name, uint8_t height, int with_packed)
+{
+    uint8_t   pages = (uint8_t)((height + 7u) / 8u);
+    uint16_t *rows  = malloc(GLYPHS * height * sizeof(uint16_t));
+    uint8_t  *cols  = calloc(GLYPHS * 16u * pages, 1);
+
+    for (uint32_t i = 0; i < GLYPHS * height; i++) rows[i] = (uint16_t)rand();
+    for (uint8_t c = 0; c < GLYPHS; c++)
+        for (uint8_t r = 0; r < height; r++)
+            for (uint8_t x = 0; x < 16u; x++)
+                if (rows[c * height + r] & (0x8000u >> x))
+                    cols[c * 16u * pages + (r / 8u) * 16u + x] |= (uint8_t)(1u << (r % 8u));
+
+    memset(k, 0, sizeof(*k));
+    k->name = name;
+    k->rows.width = 16;
+    k->rows.height = height;
+    k->rows.data = rows;
+    if (with_packed) {
+        k->packed = k->rows;
+        k->packed.data = NULL;
+        k->packed.cols = cols;
+        k->packed.format = SH1106_FONT_PAGES;
+    }
+}
+
+static void font_case(Case_t *k, const char *name, const SH1106_Font_t *f)
+{
+    k->name = name;
+    k->packed = *f;
+    k->rows = *f;
+    k->rows.cols = NULL;
+    k->rows.offsets = NULL;
+    k->rows.data = unpack(f);
+    k->rows.format = SH1106_FONT_ROWS;
+}
+
+static void clean_dirty(void)
+{
+    memset(sh1106_dirty_x0, SH1106_WIDTH, sizeof(sh1106_dirty_x0));
+    memset(sh1106_dirty_x1, 0, sizeof(sh1106_dirty_x1));
+}
+
+static uint8_t background[SH1106_BUFFER_SIZE];
+static uint8_t expect[SH1106_BUFFER_SIZE];
+
+/* draw glyph c of f at (x, y) with WriteChar and compare with the
+ * per-pixel renderer over the same background */
+static void one(const Case_t *k, const SH1106_Font_t *f, const char *path,
+                uint8_t c, int16_t x, uint8_t y, SH1106_COLOR_t color)
+{
+    const SH1106_Font_t *r  = &k->rows;
+    uint8_t              w  = glyph_width(r, c);
+    int16_t              top = (int16_t)y + (r->y_offset ? r->y_offset[c] : 0);
+
+    memcpy(sh1106_buffer, background, SH1106_BUFFER_SIZE);
+    clean_dirty();
+    SH1106_DrawGlyphPixels(&r->data[c * r->height], r->height, x, top, 0, w, color);
+    memcpy(expect, sh1106_buffer, SH1106_BUFFER_SIZE);
+
+    memcpy(sh1106_buffer, background, SH1106_BUFFER_SIZE);
+    clean_dirty();
+    SH1106_SetCursor(x, y);
+    SH1106_WriteChar((char)(c + 32u), *f, color);
+    cases++;
+
+    if (memcmp(sh1106_buffer, expect, SH1106_BUFFER_SIZE) != 0) {
+        if (failed < 20u)
+            printf("FAIL %s %s '%c' at (%d, %u) %s: buffer differs\n", k->name, path,
+                   (char)(c + 32u), x, y, color == SH1106_COLOR_WHITE ? "white" : "black");
+        failed++;
+        return;
+    }
+    for (uint16_t i = 0; i < SH1106_BUFFER_SIZE; i++) {
+        uint8_t p = (uint8_t)(i / SH1106_WIDTH), col = (uint8_t)(i % SH1106_WIDTH);
+        if (sh1106_buffer[i] != background[i] &&
+            (col < sh1106_dirty_x0[p] || col > sh1106_dirty_x1[p])) {
+            if (failed < 20u)
+                printf("FAIL %s %s '%c' at (%d, %u): change outside the dirty span\n",
+                       k->name, path, (char)(c + 32u), x, y);
+            failed++;
+            return;
+        }
+    }
+}
+
+static void sweep(const Case_t *k, const SH1106_Font_t *f, const char *path)
+{
+    for (uint8_t c = 0; c < GLYPHS; c++) {
+        int16_t w = glyph_width(&k->rows, c);
+
+        for (int color = 0; color < 2; color++) {
+            SH1106_COLOR_t col = color ? SH1106_COLOR_WHITE : SH1106_COLOR_BLACK;
+
+            for (uint8_t y = 0; y < 8u; y++) one(k, f, path, c, 37, y, col);
+            for (uint8_t y = (uint8_t)(SH1106_HEIGHT - k->rows.height);
+                 y < SH1106_HEIGHT; y++) one(k, f, path, c, 60, y, col);
+            for (int16_t x = (int16_t)(-w); x <= 0; x++) one(k, f, path, c, x, 5, col);
+            for (int16_t x = (int16_t)(SH1106_WIDTH - w); x <= SH1106_WIDTH; x++)
+                one(k, f, path, c, x, 30, col);
+        }
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ns per glyph; per_pixel: the DrawGlyphPixels path itself */
+static double time_glyphs(const SH1106_Font_t *f, int per_pixel)
+{
+    double t0 = now_ns();
+
+    for (uint32_t run = 0; run < TIME_RUNS; run++) {
+        memset(sh1106_buffer, 0, SH1106_BUFFER_SIZE);
+        for (uint8_t c = 0; c < GLYPHS; c++) {
+            if (per_pixel) {
+                SH1106_DrawGlyphPixels(&f->data[c * f->height], f->height,
+                                       (int16_t)(c % 8u * 14u), 3, 0, glyph_width(f, c),
+                                       SH1106_COLOR_WHITE);
+            } else {
+                SH1106_SetCursor((int16_t)(c % 8u * 14u), 3);
+                SH1106_WriteChar((char)(c + 32u), *f, SH1106_COLOR_WHITE);
+            }
+        }
+    }
+    return (now_ns() - t0) / (TIME_RUNS * GLYPHS);
+}
+
+int main(void)
+{
+    Case_t k[6];
+    int    n = 0;
+
+    srand(1);
+    for (uint32_t i = 0; i < SH1106_BUFFER_SIZE; i++) background[i] = (uint8_t)rand();
+
+    font_case(&k[n++], "Font_6x8", &Font_6x8);
+    font_case(&k[n++], "Font_7x10", &Font_7x10);
+    font_case(&k[n++], "Font_11x18", &Font_11x18);
+    font_case(&k[n++], "Font_8H", &Font_8H);
+    synth(&k[n++], "synthetic 16x25", 25, 1);
+    synth(&k[n++], "synthetic 16x26", 26, 0);
+
+    check(SH1106_BLIT_MAX_HEIGHT == 25, "SH1106_BLIT_MAX_HEIGHT is 25");
+
+    for (int i = 0; i < n; i++) {
+        if (k[i].packed.cols) sweep(&k[i], &k[i].packed, "packed");
+        sweep(&k[i], &k[i].rows, "rows");
+    }
+    printf("%lu glyph draws compared\n\n", (unsigned long)cases);
+
+    printf("%-16s %12s %12s %12s   (ns per glyph)\n", "font", "per-pixel", "row blit", "packed");
+    for (int i = 0; i < n; i++) {
+        double px = time_glyphs(&k[i].rows, 1);
+        double rb = time_glyphs(&k[i].rows, 0);
+
+        printf("%-16s %12.1f ", k[i].name, px);
+        if (k[i].rows.height <= SH1106_BLIT_MAX_HEIGHT) printf("%12.1f ", rb);
+        else                                            printf("%12s ", "-");
+        if (k[i].packed.cols) printf("%12.1f\n", time_glyphs(&k[i].packed, 0));
+        else                  printf("%12s\n", "-");
+    }
+
+    printf("\nunit checks: %s\n", failed ? "FAILED" : "passed");
+    return failed ? 1 : 0;
+}
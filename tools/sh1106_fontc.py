@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""
+sh1106_fontc.py - SH1106 font compiler
+
+Converts row-major font tables (one uint16_t per row, MSB = leftmost pixel,
+the format used by ssd1306_fonts.c, sh1106_fonts.c and font_visualizer.html)
+into the column-major, page-packed layout the SH1106 frame buffer uses.
+
+Each glyph is stored as ceil(height / 8) pages of `width` bytes,
+page 0 first; in every byte bit 0 is the top row of that page.
+The renderer can then OR/AND the bytes straight into the buffer, with a
+single shift when the cursor is not on a page boundary.
+
+Usage:
+    python3 tools/sh1106_fontc.py                  # regenerate both projects
+    python3 tools/sh1106_fontc.py -o out.c         # write a single file
+    python3 tools/sh1106_fontc.py --preview Font_8H A g
+
+The script only needs the Python 3 standard library, so it can also be
+hooked in as a CubeIDE pre-build step.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+
+FIRST_CHAR = 32
+LAST_CHAR = 126
+NUM_CHARS = LAST_CHAR - FIRST_CHAR + 1
+
+# Output files, one per project using the SH1106 driver
+OUTPUTS = [
+    '005-scale-ADS1220/App/SH1106/sh1106_fonts_packed.c',
+    '006-stroboscope/App/SH1106/sh1106_fonts_packed.c',
+]
+
+# name, include macro, source file, row table, width table, y offset table, height, width, baseline
+FONTS = [
+    dict(name='Font_6x8', macro='SH1106_INCLUDE_FONT_6x8',
+         source='003-display-i2c/Src/ssd1306_fonts.c', rows='Font6x8',
+         height=8, width=6, baseline=6),
+    dict(name='Font_7x10', macro='SH1106_INCLUDE_FONT_7x10',
+         source='003-display-i2c/Src/ssd1306_fonts.c', rows='Font7x10',
+         height=10, width=7, baseline=7),
+    dict(name='Font_11x18', macro='SH1106_INCLUDE_FONT_11x18',
+         source='003-display-i2c/Src/ssd1306_fonts.c', rows='Font11x18',
+         height=18, width=11, baseline=14),
+    dict(name='Font_8H', macro='SH1106_INCLUDE_FONT_8H',
+         source='006-stroboscope/App/SH1106/sh1106_fonts.c', rows='Font8H_data',
+         widths='Font8H_width', y_offset='Font8H_y_offset',
+         height=8, width=8, baseline=5),
+]
+
+
+# ------------------------------------------------------------------------
+# C source parsing
+# ------------------------------------------------------------------------
+
+def strip_comments(text):
+    text = re.sub(r'/\*.*?\*/', '', text, flags=re.S)
+    return re.sub(r'//[^\n]*', '', text)
+
+
+def read_arrays(path):
+    """Return {name: [int, ...]} for every const integer array in a C file"""
+    with open(path, encoding='utf-8', errors='replace') as f:
+        text = strip_comments(f.read())
+
+    arrays = {}
+    pattern = r'const\s+u?int(?:8|16|32)_t\s+(\w+)\s*\[\s*\w*\s*\]\s*=\s*\{(.*?)\}\s*;'
+    for m in re.finditer(pattern, text, flags=re.S):
+        values = [v.strip() for v in m.group(2).split(',') if v.strip()]
+        arrays[m.group(1)] = [int(v, 0) for v in values]
+    return arrays
+
+
+def load_font(spec):
+    arrays = read_arrays(os.path.join(ROOT, spec['source']))
+    height = spec['height']
+
+    rows = arrays[spec['rows']]
+    if len(rows) != NUM_CHARS * height:
+        sys.exit('%s: %s has %d rows, expected %d'
+                 % (spec['source'], spec['rows'], len(rows), NUM_CHARS * height))
+
+    widths = arrays[spec['widths']] if 'widths' in spec else None
+    y_offset = arrays[spec['y_offset']] if 'y_offset' in spec else None
+
+    # per-character tables may be padded past the last character
+    for key, table in (('widths', widths), ('y_offset', y_offset)):
+        if table is not None and len(table) < NUM_CHARS:
+            sys.exit('%s: %s has %d entries, expected %d'
+                     % (spec['source'], spec[key], len(table), NUM_CHARS))
+    widths = widths[:NUM_CHARS] if widths else None
+    y_offset = y_offset[:NUM_CHARS] if y_offset else None
+
+    glyphs = [rows[i * height:(i + 1) * height] for i in range(NUM_CHARS)]
+    return glyphs, widths, y_offset
+
+
+# ------------------------------------------------------------------------
+# Conversion
+# ------------------------------------------------------------------------
+
+def pack_glyph(rows, width, height):
+    """Row-major uint16 rows -> page-major list of column bytes"""
+    pages = (height + 7) // 8
+    out = []
+    for page in range(pages):
+        for col in range(width):
+            byte = 0
+            for bit in range(8):
+                row = page * 8 + bit
+                if row < height and rows[row] & (0x8000 >> col):
+                    byte |= 1 << bit
+            out.append(byte)
+    return out
+
+
+def char_comment(code):
+    # quoted, so that '\\' does not end the line with a line continuation
+    return "'%s'" % chr(code)
+
+
+def compile_font(spec):
+    glyphs, widths, y_offset = load_font(spec)
+    height = spec['height']
+    pages = (height + 7) // 8
+
+    blobs = []
+    for i, rows in enumerate(glyphs):
+        width = widths[i] if widths else spec['width']
+        blobs.append(pack_glyph(rows, width, height))
+
+    return dict(spec, pages=pages, blobs=blobs, widths=widths, y_offset=y_offset,
+                row_bytes=2 * height * NUM_CHARS)
+
+
+def c_ident(name):
+    return name.replace('Font_', 'Font')
+
+
+def emit_font(font):
+    ident = c_ident(font['name'])
+    proportional = font['widths'] is not None
+    packed_bytes = sum(len(b) for b in font['blobs'])
+    table_bytes = (3 if proportional else 0) * NUM_CHARS + \
+                  (NUM_CHARS if font['y_offset'] else 0)
+
+    lines = []
+    lines.append('/* ' + '=' * 72)
+    lines.append(' * %s - %s, %d byte%s per column'
+                 % (font['name'], 'proportional' if proportional else 'monospace',
+                    font['pages'], '' if font['pages'] == 1 else 's'))
+    lines.append(' * Source: %s (%s)' % (font['source'], font['rows']))
+    lines.append(' * Size: %d bytes (row-major source: %d bytes)'
+                 % (packed_bytes + table_bytes, font['row_bytes']))
+    lines.append(' * ' + '=' * 72 + ' */')
+    lines.append('')
+    lines.append('#ifdef %s' % font['macro'])
+    lines.append('')
+    lines.append('static const uint8_t %s_cols[] = {' % ident)
+
+    for i, blob in enumerate(font['blobs']):
+        text = ', '.join('0x%02X' % b for b in blob)
+        lines.append('    %s%s  // %s' % (text, ',' if blob else '', char_comment(FIRST_CHAR + i)))
+    lines.append('};')
+    lines.append('')
+
+    if proportional:
+        offsets, pos = [], 0
+        for blob in font['blobs']:
+            offsets.append(pos)
+            pos += len(blob)
+        if pos > 0xFFFF:
+            sys.exit('%s: packed data exceeds 64 KiB' % font['name'])
+
+        lines.append('static const uint16_t %s_offsets[] = {' % ident)
+        for i in range(0, NUM_CHARS, 12):
+            lines.append('    ' + ', '.join('%4d' % o for o in offsets[i:i + 12]) + ',')
+        lines.append('};')
+        lines.append('')
+
+        lines.append('static const uint8_t %s_width[] = {' % ident)
+        for i in range(0, NUM_CHARS, 16):
+            lines.append('    ' + ', '.join('%d' % w for w in font['widths'][i:i + 16]) + ',')
+        lines.append('};')
+        lines.append('')
+
+    if font['y_offset']:
+        lines.append('static const int8_t %s_y_offset[] = {' % ident)
+        for i in range(0, NUM_CHARS, 16):
+            lines.append('    ' + ', '.join('%d' % v for v in font['y_offset'][i:i + 16]) + ',')
+        lines.append('};')
+        lines.append('')
+
+    lines.append('const SH1106_Font_t %s = {' % font['name'])
+    lines.append('    .width = %d,' % font['width'])
+    lines.append('    .height = %d,' % font['height'])
+    lines.append('    .data = NULL,')
+    lines.append('    .char_width = %s,' % ('%s_width' % ident if proportional else 'NULL'))
+    lines.append('    .y_offset = %s,' % ('%s_y_offset' % ident if font['y_offset'] else 'NULL'))
+    lines.append('    .baseline = %d,' % font['baseline'])
+    lines.append('    .cols = %s_cols,' % ident)
+    lines.append('    .offsets = %s,' % ('%s_offsets' % ident if proportional else 'NULL'))
+    lines.append('    .format = SH1106_FONT_PAGES')
+    lines.append('};')
+    lines.append('')
+    lines.append('#endif /* %s */' % font['macro'])
+    lines.append('')
+    return lines
+
+
+def emit_file(fonts):
+    lines = [
+        '/**',
+        ' * @file    sh1106_fonts_packed.c',
+        ' * @brief   Column-major page-packed fonts for SH1106 OLED Display Driver',
+        ' * @note    GENERATED by tools/sh1106_fontc.py - do not edit by hand.',
+        ' *          Edit the row-major source tables and rerun the script.',
+        ' *',
+        ' * Glyph layout: ceil(height/8) pages of char_width bytes, page 0 first.',
+        ' * Bit 0 of each byte is the top pixel of that page, as in the frame buffer.',
+        ' */',
+        '',
+        '#include "sh1106_fonts.h"',
+        '',
+        '#ifdef SH1106_PACKED_FONTS',
+        '',
+    ]
+    for font in fonts:
+        lines.extend(emit_font(font))
+    lines.append('#endif /* SH1106_PACKED_FONTS */')
+    return '\n'.join(lines) + '\n'
+
+
+def preview(font, chars):
+    for ch in chars:
+        index = ord(ch) - FIRST_CHAR
+        blob = font['blobs'][index]
+        width = len(blob) // font['pages']
+        print("'%s' width %d" % (ch, width))
+        for row in range(font['height']):
+            page, bit = divmod(row, 8)
+            print('  ' + ''.join('#' if blob[page * width + col] >> bit & 1 else '.'
+                                 for col in range(width)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    parser.add_argument('-o', '--output', help='write a single file instead of the project copies')
+    parser.add_argument('--preview', nargs='+', metavar=('FONT', 'CHAR'),
+                        help='print glyphs of a font as ASCII art')
+    args = parser.parse_args()
+
+    fonts = [compile_font(spec) for spec in FONTS]
+
+    if args.preview:
+        font = next((f for f in fonts if f['name'] == args.preview[0]), None)
+        if font is None:
+            sys.exit('unknown font %s' % args.preview[0])
+        preview(font, ''.join(args.preview[1:]) or 'Ag')
+        return
+
+    text = emit_file(fonts)
+    targets = [args.output] if args.output else [os.path.join(ROOT, p) for p in OUTPUTS]
+    for path in targets:
+        with open(path, 'w', encoding='utf-8', newline='\n') as f:
+            f.write(text)
+        print('wrote %s' % os.path.relpath(path, ROOT))
+
+    for font in fonts:
+        packed = sum(len(b) for b in font['blobs'])
+        print('  %-11s %5d bytes packed, %5d bytes row-major'
+              % (font['name'], packed, font['row_bytes']))
+
+
+if __name__ == '__main__':
+    main()
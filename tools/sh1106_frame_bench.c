@@ -0,0 +1,262 @@
+/*
+ * sh1106_frame_bench.c - bytes per frame of the SH1106 delta update
+ *                        (App/SH1106) on the 006-stroboscope screens
+ *
+ * Uses the bus and panel model of tools/sh1106_i2c_mock.c: the driver
+ * sends its frames with SH1106_UpdateScreenAsync and the fake event loop,
+ * and the recorded transfers are counted as bytes on the wire (address
+ * bytes included). The screens are drawn as Display_Update in 006 main.c
+ * draws them, with Src/big_freq.c for the big digits.
+ *
+ * For every screen: the frame when switching to it from the previous
+ * screen (BTN2 order), a steady redraw with nothing changed, and one
+ * encoder step of its value. "before" is what the driver sent before the
+ * dirty tracking, the whole frame every time: it is measured, the same
+ * frame sent again after SH1106_Invalidate(), to a second panel model.
+ * After every delta frame both panels must hold the same image, and it
+ * must equal the frame buffer.
+ *
+ * Then an encoder sequence (frequency 30.0 -> 40.0 Hz by 0.1 Hz, duty
+ * 5 -> 50 %, phase 0 -> 90 deg, brightness 75 -> 100 %, one frame per
+ * step) gives the total and the mean bytes per frame, the number to
+ * compare when tuning SH1106_DIFF_MERGE_GAP and SH1106_RUNS_PER_PAGE:
+ * both are #ifndef in sh1106_conf.h, add -DSH1106_DIFF_MERGE_GAP=<n>
+ * -DSH1106_RUNS_PER_PAGE=<n> to the build line to try other values.
+ * Times are for the 400 kHz bus of 006 (9 bit times per byte, plus start
+ * and stop per transfer).
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Itools/host -I006-stroboscope/App/SH1106 -I006-stroboscope/Inc \
+ *       tools/sh1106_frame_bench.c 006-stroboscope/App/SH1106/sh1106.c \
+ *       006-stroboscope/App/SH1106/sh1106_fonts_packed.c \
+ *       006-stroboscope/Src/big_freq.c -o sh1106_frame_bench && ./sh1106_frame_bench
+ */
+
+#define SH1106_MOCK_NO_MAIN
+#include "sh1106_i2c_mock.c"
+
+#include "big_freq.h"
+
+#define ROW_TOP_Y            11
+#define ROW_BIG_Y            18
+#define STATUSBAR_Y          53
+#define STATUSBAR_H          11
+#define STATUSBAR_TEXT_Y     55
+
+#define I2C_HZ               400000u
+
+enum { SCR_MAIN = 0, SCR_DUTY, SCR_PHASE, SCR_DRIFT, SCR_TACH, SCR_BRIGHT, SCR_COUNT };
+
+static const char *const scr_name[SCR_COUNT] = {
+    "Main (30.0 Hz)", "Duty", "Phase", "Drift", "Tach (1/1 lock)", "Brightness"
+};
+static const char *const scr_step[SCR_COUNT] = {
+    "30.0 -> 30.1 Hz", "5 -> 6 %", "0 -> 1 deg", "+0.00 -> +0.01 Hz",
+    "err +0.3 -> +0.4 deg", "75 -> 76 %"
+};
+
+/* the values the screens show */
+typedef struct {
+    uint32_t freq_mhz;
+    uint32_t duty;              /* percent mode */
+    int32_t  phase_deg;
+    int32_t  drift_mhz;
+    uint32_t tach_mhz;
+    int32_t  err_d10;
+    uint32_t brig;              /* percent mode */
+} Ui_t;
+
+static Bus_t    panel, full;
+static uint32_t failed;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+static void text(int16_t x, uint8_t y, const char *s)
+{
+    SH1106_WriteStringAt(x, y, s, Font_8H, SH1106_COLOR_WHITE);
+}
+
+/* Display_Update of 006 main.c, step x1, strobe running, no notification */
+static void draw_screen(int scr, const Ui_t *u)
+{
+    char buf[32];
+
+    SH1106_Fill(SH1106_COLOR_BLACK);
+
+    switch (scr) {
+    case SCR_MAIN: {
+        uint8_t fw = Big_FreqWidth(u->freq_mhz);
+        text(0, ROW_TOP_Y, "STEP 0.1 Hz");
+        Draw_BigFreq(u->freq_mhz, (fw < 128u) ? (uint8_t)((128u - fw) / 2u) : 0u, ROW_BIG_Y);
+        break;
+    }
+    case SCR_DUTY:
+        text(24, ROW_TOP_Y, "DUTY CYCLE");
+        snprintf(buf, sizeof(buf), "%lu%%   1/%lu", (unsigned long)u->duty,
+                 (unsigned long)((100u + u->duty / 2u) / u->duty));
+        text(8, 23, buf);
+        text(0, 35, "STEP 1");
+        text(20, 44, "BTN2: next");
+        break;
+    case SCR_PHASE:
+        text(20, ROW_TOP_Y, "PHASE SHIFT");
+        snprintf(buf, sizeof(buf), "%ld deg", (long)u->phase_deg);
+        text(8, 23, buf);
+        text(0, 35, "STEP 1 deg");
+        text(20, 44, "BTN2: next");
+        break;
+    case SCR_DRIFT: {
+        uint32_t d = (uint32_t)((u->drift_mhz < 0) ? -u->drift_mhz : u->drift_mhz);
+        uint32_t f = (uint32_t)((int32_t)u->freq_mhz + u->drift_mhz);
+        text(12, ROW_TOP_Y, "DRIFT (SLOW)");
+        snprintf(buf, sizeof(buf), "%c%lu.%02lu Hz", (u->drift_mhz < 0) ? '-' : '+',
+                 (unsigned long)(d / 1000u), (unsigned long)((d % 1000u) / 10u));
+        text(8, 23, buf);
+        snprintf(buf, sizeof(buf), "RUN %lu.%02lu Hz",
+                 (unsigned long)(f / 1000u), (unsigned long)((f % 1000u) / 10u));
+        text(0, 44, buf);
+        text(0, 35, "STEP 0.01 Hz");
+        break;
+    }
+    case SCR_TACH: {
+        uint32_t ea = (uint32_t)((u->err_d10 < 0) ? -u->err_d10 : u->err_d10);
+        text(24, ROW_TOP_Y, "TACH INPUT");
+        text(8, 23, "RATIO 1/1");
+        snprintf(buf, sizeof(buf), "IN %lu.%02lu Hz", (unsigned long)(u->tach_mhz / 1000u),
+                 (unsigned long)((u->tach_mhz % 1000u) / 10u));
+        text(0, 35, buf);
+        snprintf(buf, sizeof(buf), "LOCK %c%lu.%lu deg", (u->err_d10 < 0) ? '-' : '+',
+                 (unsigned long)(ea / 10u), (unsigned long)(ea % 10u));
+        text(0, 44, buf);
+        break;
+    }
+    default:
+        text(24, ROW_TOP_Y, "BRIGHTNESS");
+        snprintf(buf, sizeof(buf), "%lu%%   1/%lu", (unsigned long)u->brig,
+                 (unsigned long)((100u + u->brig / 2u) / u->brig));
+        text(8, 23, buf);
+        text(0, 35, "STEP 1");
+        text(20, 44, "BTN2: next");
+        break;
+    }
+
+    SH1106_FillRectangle(0, STATUSBAR_Y, 128, STATUSBAR_H, SH1106_COLOR_WHITE);
+    SH1106_WriteStringAt(4, STATUSBAR_TEXT_Y, "[ ON ] BTN3=off ", Font_8H, SH1106_COLOR_BLACK);
+}
+
+static uint32_t bus_us(const Bus_t *b)
+{
+    return (uint32_t)(((uint64_t)b->wire * 9u + b->transfers * 2u) * 1000000u / I2C_HZ);
+}
+
+/* one frame: delta to panel, then the whole frame to the reference.
+ * returns the delta bytes, *before the whole frame bytes */
+static uint32_t frame(int scr, const Ui_t *u, uint32_t *before, uint32_t *us)
+{
+    uint32_t n;
+
+    draw_screen(scr, u);
+
+    bus = &panel;
+    bus_reset(&panel);
+    check(SH1106_UpdateScreenAsync() == SH1106_OK, "delta frame starts");
+    bus_run();
+    n = panel.wire;
+    if (us) *us = bus_us(&panel);
+
+    bus = &full;
+    bus_reset(&full);
+    SH1106_Invalidate();
+    check(SH1106_UpdateScreenAsync() == SH1106_OK, "full frame starts");
+    bus_run();
+    if (before) *before = full.wire;
+    check(full.full_pages == SH1106_PAGES, "full frame sends every page");
+
+    if (memcmp(panel.ram, full.ram, sizeof(panel.ram)) != 0) {
+        printf("FAIL %s: delta panel differs from a full redraw\n", scr_name[scr]);
+        failed++;
+    }
+    check(panel_matches(&panel, SH1106_GetBuffer()), "panel equals the frame buffer");
+    return n;
+}
+
+int main(void)
+{
+    const Ui_t ui0 = { 30000u, 5u, 0, 0, 30000u, 3, 75u };
+    Ui_t       u;
+    uint32_t   full_bytes = 0, full_us = 0;
+
+    bus = &panel;
+    irq_enable(1);
+    check(SH1106_Init() == SH1106_OK, "init");
+    irq_enable(0);
+    memcpy(full.ram, panel.ram, sizeof(full.ram));
+
+    printf("SH1106_DIFF_MERGE_GAP %u, SH1106_RUNS_PER_PAGE %u, I2C %u kHz\n\n",
+           SH1106_DIFF_MERGE_GAP, SH1106_RUNS_PER_PAGE, I2C_HZ / 1000u);
+    printf("%-16s %8s %8s %7s   %-28s %s\n",
+           "screen", "before", "switch", "steady", "one step", "time");
+
+    u = ui0;
+    frame(SCR_BRIGHT, &u, NULL, NULL);      /* BTN2 order wraps to main */
+    for (int s = 0; s < SCR_COUNT; s++) {
+        uint32_t before, sw, steady, step, us;
+
+        u  = ui0;
+        sw = frame(s, &u, &before, NULL);
+        steady = frame(s, &u, NULL, NULL);
+        switch (s) {
+        case SCR_MAIN:  u.freq_mhz  += 100u; break;
+        case SCR_DUTY:  u.duty      += 1u;   break;
+        case SCR_PHASE: u.phase_deg += 1;    break;
+        case SCR_DRIFT: u.drift_mhz += 10;   break;
+        case SCR_TACH:  u.err_d10   += 1;    break;
+        default:        u.brig      += 1u;   break;
+        }
+        step = frame(s, &u, NULL, &us);
+        check(steady == 0u, "steady redraw sends nothing");
+        check(step > 0u && step < before, "one step sends less than a frame");
+
+        printf("%-16s %6lu B %6lu B %5lu B   %4lu B %-21s %5lu us\n", scr_name[s],
+               (unsigned long)before, (unsigned long)sw, (unsigned long)steady,
+               (unsigned long)step, scr_step[s], (unsigned long)us);
+        full_bytes = before;
+        full_us    = bus_us(&full);
+    }
+    printf("\nwhole frame %lu B, %lu us\n", (unsigned long)full_bytes, (unsigned long)full_us);
+
+    /* encoder sequence */
+    {
+        uint32_t frames = 0, bytes = 0, before = 0, b, worst = 0;
+
+        u = ui0;
+        for (u.freq_mhz = 30000u; u.freq_mhz <= 40000u; u.freq_mhz += 100u, frames++) {
+            uint32_t n = frame(SCR_MAIN, &u, &b, NULL);
+            bytes += n; before += b; if (n > worst) worst = n;
+        }
+        for (u.duty = 5u; u.duty <= 50u; u.duty++, frames++) {
+            uint32_t n = frame(SCR_DUTY, &u, &b, NULL);
+            bytes += n; before += b; if (n > worst) worst = n;
+        }
+        for (u.phase_deg = 0; u.phase_deg <= 90; u.phase_deg++, frames++) {
+            uint32_t n = frame(SCR_PHASE, &u, &b, NULL);
+            bytes += n; before += b; if (n > worst) worst = n;
+        }
+        for (u.brig = 75u; u.brig <= 100u; u.brig++, frames++) {
+            uint32_t n = frame(SCR_BRIGHT, &u, &b, NULL);
+            bytes += n; before += b; if (n > worst) worst = n;
+        }
+        printf("encoder sequence: %lu frames, before %lu B, after %lu B (%.1f B/frame, worst %lu B)\n",
+               (unsigned long)frames, (unsigned long)before, (unsigned long)bytes,
+               (double)bytes / frames, (unsigned long)worst);
+    }
+
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,539 @@
+/*
+ * sh1106_i2c_mock.c - host test of the SH1106 I2C frame paths (App/SH1106)
+ *                     of 005-scale-ADS1220 and 006-stroboscope
+ *
+ * The driver is built on the host against tools/host/main.h. The HAL I2C
+ * calls it makes are implemented here and record every transfer as it
+ * appears on the wire (address, then the control or memory address byte,
+ * then the data). The bytes of a DMA transfer are read when the transfer
+ * completes, as the DMA would, so a buffer the driver reuses too early
+ * shows up in the stream. A panel model interprets the stream (page and
+ * column commands, data writes into 132 x 8 pages of display RAM).
+ *
+ * The two configurations are linked side by side: the 005 driver
+ * (blocking HAL_I2C_Master_Transmit / HAL_I2C_Mem_Write) under blk_ names
+ * from tools/host/sh1106_blocking.c, and the 006 driver (SH1106_USE_DMA).
+ * DMA transfers complete from a fake event loop, bus_step(), which calls
+ * HAL_I2C_MemTxCpltCallback / HAL_I2C_MasterTxCpltCallback /
+ * HAL_I2C_ErrorCallback like the I2C interrupt, forwarded to the driver
+ * as in 006 main.c. Where the DMA driver itself waits for the bus (init,
+ * blocking SH1106_UpdateScreen) the loop runs from SIGALRM instead, an
+ * interrupt that preempts the polling code.
+ *
+ * Checks:
+ *   - init and a sequence of frames (text in all fonts, shapes, frames
+ *     with no change) produce the same byte stream with the blocking
+ *     SH1106_UpdateScreen (005) and with SH1106_UpdateScreenAsync (006),
+ *     also when the next frame is drawn while the previous one is still
+ *     being sent (double buffer snapshot), and with the DMA driver's own
+ *     blocking SH1106_UpdateScreen,
+ *   - the panel RAM equals the frame buffer after every frame,
+ *   - an UpdateScreenAsync issued while a frame is in flight returns
+ *     SH1106_BUSY and does not touch the bus,
+ *   - SH1106_I2C_ErrorCallback mid-frame stops the pipeline, and the next
+ *     frame resends every page; a DMA start refused by the HAL (first
+ *     transfer or chained from the callback) does the same; callbacks of
+ *     another I2C handle are ignored,
+ *   - a frame sent with SH1106_UpdateScreenChunk keeps the delta update
+ *     in step, in both drivers: the next update with nothing drawn sends
+ *     nothing, and drawing the previous frame back reaches the panel
+ *     (the back buffer is not left stale).
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Wall -Itools/host -I006-stroboscope/App/SH1106 \
+ *       tools/sh1106_i2c_mock.c tools/host/sh1106_blocking.c \
+ *       006-stroboscope/App/SH1106/sh1106.c \
+ *       006-stroboscope/App/SH1106/sh1106_fonts_packed.c \
+ *       -o sh1106_i2c_mock && ./sh1106_i2c_mock
+ *
+ * tools/sh1106_frame_bench.c includes this file with SH1106_MOCK_NO_MAIN
+ * for the bus model only.
+ */
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "sh1106.h"
+#include "sh1106_fonts.h"
+
+#ifndef SH1106_USE_DMA
+#error "build against the 006-stroboscope driver (SH1106_USE_DMA)"
+#endif
+
+/* ---- bus and panel model ---- */
+
+#define BUS_LOG_MAX     8192u
+#define PANEL_COLS      132u
+#define PANEL_PAGES     8u
+
+typedef struct {
+    uint8_t  log[BUS_LOG_MAX];      /* per transfer: addr, len lo, len hi, bytes */
+    uint32_t len;
+    uint32_t transfers;
+    uint32_t wire;                  /* bytes on the bus, address bytes included */
+    uint32_t data_runs;             /* data transfers */
+    uint32_t full_pages;            /* data transfers of a whole page */
+
+    uint8_t  ram[PANEL_PAGES][PANEL_COLS];
+    uint8_t  page, col, arg;        /* arg: command bytes still expected as argument */
+} Bus_t;
+
+I2C_HandleTypeDef hi2c1 = { .Instance = (void *)0x40005400u, .State = HAL_I2C_STATE_READY };
+
+static Bus_t *bus;                  /* display the transfers go to */
+
+/* DMA transfer in flight */
+static I2C_HandleTypeDef *volatile dma_h;
+static const uint8_t             *dma_data;
+static uint16_t                   dma_addr, dma_len;
+static int                        dma_mem;      /* memory address byte, -1: none */
+
+/* fault injection, counted in DMA transfers started / completed */
+static volatile int32_t bus_refuse_in = -1;     /* HAL refuses the n-th start  */
+static volatile int32_t bus_error_in  = -1;     /* n-th completion is an error */
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    SH1106_I2C_TxCpltCallback(hi2c);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    SH1106_I2C_TxCpltCallback(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    SH1106_I2C_ErrorCallback(hi2c);
+}
+
+static void bus_reset(Bus_t *b)
+{
+    b->len = b->transfers = b->wire = b->data_runs = b->full_pages = 0;
+}
+
+static void panel_byte(Bus_t *b, uint8_t ctrl, uint8_t v)
+{
+    if (ctrl == 0x40u) {
+        if (b->col < PANEL_COLS) b->ram[b->page & 7u][b->col++] = v;
+        return;
+    }
+    if (b->arg) { b->arg--; return; }
+    if (v >= 0xB0u && v <= 0xB7u)       b->page = v & 7u;
+    else if (v <= 0x0Fu)                b->col = (uint8_t)((b->col & 0xF0u) | v);
+    else if (v >= 0x10u && v <= 0x1Fu)  b->col = (uint8_t)((b->col & 0x0Fu) | ((v & 0x0Fu) << 4));
+    else if (v == 0x81u || v == 0xA8u || v == 0xD3u || v == 0xADu ||
+             v == 0xDAu || v == 0xD9u || v == 0xDBu || v == 0xD5u) b->arg = 1;
+}
+
+static void bus_record(uint16_t addr, int mem, const uint8_t *p, uint16_t n)
+{
+    Bus_t   *b = bus;
+    uint32_t w = n + (mem >= 0 ? 1u : 0u);
+    uint8_t  ctrl;
+
+    if (!b) return;
+    if (b->len + 3u + w <= BUS_LOG_MAX) {
+        b->log[b->len++] = (uint8_t)(addr >> 1);
+        b->log[b->len++] = (uint8_t)w;
+        b->log[b->len++] = (uint8_t)(w >> 8);
+        if (mem >= 0) b->log[b->len++] = (uint8_t)mem;
+        memcpy(&b->log[b->len], p, n);
+        b->len += n;
+    } else {
+        b->len = BUS_LOG_MAX + 1u;      /* overflow, never equal to a good log */
+    }
+    b->transfers++;
+    b->wire += 1u + w;
+
+    /* first byte is the control byte: 0x00 commands, 0x40 data */
+    ctrl = (mem >= 0) ? (uint8_t)mem : (n ? p[0] : 0u);
+    if (mem < 0) { p++; n--; }
+    if (ctrl == 0x40u) {
+        b->data_runs++;
+        if (n == SH1106_WIDTH) b->full_pages++;
+    }
+    for (uint16_t i = 0; i < n; i++) panel_byte(b, ctrl, p[i]);
+}
+
+static HAL_StatusTypeDef dma_start(I2C_HandleTypeDef *h, uint16_t addr, int mem,
+                                   uint8_t *p, uint16_t n)
+{
+    if (h->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    if (bus_refuse_in >= 0 && bus_refuse_in-- == 0) return HAL_ERROR;
+    h->State = HAL_I2C_STATE_BUSY_TX;
+    dma_data = p;
+    dma_addr = addr;
+    dma_len  = n;
+    dma_mem  = mem;
+    dma_h    = h;                   /* last: the interrupt may look now */
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                          uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+    if (hi2c->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    bus_record(DevAddress, -1, pData, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                    uint16_t MemAddress, uint16_t MemAddSize,
+                                    uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+    if (hi2c->State != HAL_I2C_STATE_READY || MemAddSize != 1u) return HAL_ERROR;
+    bus_record(DevAddress, MemAddress, pData, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                              uint8_t *pData, uint16_t Size)
+{
+    return dma_start(hi2c, DevAddress, -1, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                        uint16_t MemAddress, uint16_t MemAddSize,
+                                        uint8_t *pData, uint16_t Size)
+{
+    if (MemAddSize != 1u) return HAL_ERROR;
+    return dma_start(hi2c, DevAddress, MemAddress, pData, Size);
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c)
+{
+    return hi2c->State;
+}
+
+static uint32_t tick;
+
+void HAL_Delay(uint32_t Delay)
+{
+    tick += Delay;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return tick;
+}
+
+/* the I2C interrupt: completes the transfer in flight and calls back,
+ * which chains the next one. returns 0 if the bus was idle */
+static int bus_step(void)
+{
+    I2C_HandleTypeDef *h = dma_h;
+
+    if (!h) return 0;
+    dma_h = NULL;
+    h->State = HAL_I2C_STATE_READY;
+    if (bus_error_in >= 0 && bus_error_in-- == 0) {
+        HAL_I2C_ErrorCallback(h);
+        return 1;
+    }
+    bus_record(dma_addr, dma_mem, dma_data, dma_len);
+    if (dma_mem >= 0) HAL_I2C_MemTxCpltCallback(h);
+    else              HAL_I2C_MasterTxCpltCallback(h);
+    return 1;
+}
+
+/* event loop until the bus is idle, returns the transfers completed */
+static uint32_t bus_run(void)
+{
+    uint32_t n = 0;
+    while (bus_step()) n++;
+    return n;
+}
+
+/* SIGALRM as the interrupt, for driver code that waits for the bus */
+static void irq_handler(int sig)
+{
+    (void)sig;
+    bus_step();
+}
+
+static void irq_enable(int on)
+{
+    struct itimerval t = { { 0, on ? 20 : 0 }, { 0, on ? 20 : 0 } };
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = irq_handler;
+    sigaction(SIGALRM, &sa, NULL);
+    setitimer(ITIMER_REAL, &t, NULL);
+}
+
+/* the visible part of the panel RAM (SH1106_X_OFFSET) against a frame */
+static int panel_matches(const Bus_t *b, const uint8_t *frame)
+{
+    for (uint8_t p = 0; p < PANEL_PAGES; p++)
+        if (memcmp(&b->ram[p][SH1106_X_OFFSET], &frame[p * SH1106_WIDTH], SH1106_WIDTH) != 0)
+            return 0;
+    return 1;
+}
+
+#ifndef SH1106_MOCK_NO_MAIN
+
+/* the 005 driver, tools/host/sh1106_blocking.c */
+SH1106_Status_t blk_SH1106_Init(void);
+void            blk_SH1106_Fill(SH1106_COLOR_t color);
+void            blk_SH1106_UpdateScreen(void);
+bool            blk_SH1106_UpdateScreenChunk(uint16_t chunk);
+uint8_t        *blk_SH1106_GetBuffer(void);
+void            blk_SH1106_DrawLine(int16_t x0, uint8_t y0, int16_t x1, uint8_t y1, SH1106_COLOR_t color);
+void            blk_SH1106_FillRectangle(int16_t x, uint8_t y, uint8_t w, uint8_t h, SH1106_COLOR_t color);
+void            blk_SH1106_DrawCircle(int16_t x0, uint8_t y0, uint8_t r, SH1106_COLOR_t color);
+uint16_t        blk_SH1106_WriteStringAt(int16_t x, uint8_t y, const char *str,
+                                         SH1106_Font_t font, SH1106_COLOR_t color);
+
+typedef struct {
+    void     (*fill)(SH1106_COLOR_t color);
+    void     (*line)(int16_t x0, uint8_t y0, int16_t x1, uint8_t y1, SH1106_COLOR_t color);
+    void     (*rect)(int16_t x, uint8_t y, uint8_t w, uint8_t h, SH1106_COLOR_t color);
+    void     (*circle)(int16_t x0, uint8_t y0, uint8_t r, SH1106_COLOR_t color);
+    uint16_t (*text)(int16_t x, uint8_t y, const char *str, SH1106_Font_t font, SH1106_COLOR_t color);
+    uint8_t *(*buffer)(void);
+} Draw_t;
+
+static const Draw_t drv_blk = {
+    blk_SH1106_Fill, blk_SH1106_DrawLine, blk_SH1106_FillRectangle,
+    blk_SH1106_DrawCircle, blk_SH1106_WriteStringAt, blk_SH1106_GetBuffer
+};
+static const Draw_t drv_dma = {
+    SH1106_Fill, SH1106_DrawLine, SH1106_FillRectangle,
+    SH1106_DrawCircle, SH1106_WriteStringAt, SH1106_GetBuffer
+};
+
+#define FRAMES  40u
+
+static Bus_t    bus_blk, bus_dma;
+static uint32_t failed;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+/* frame f of the sequence: changes every frame, except every 5th is a
+ * repeat of the one before (nothing to send) */
+static void draw_scene(const Draw_t *d, uint32_t f)
+{
+    char     s[24];
+    uint32_t v = (f % 5u == 4u) ? f - 1u : f;
+
+    d->fill(SH1106_COLOR_BLACK);
+    snprintf(s, sizeof(s), "%lu.%lu Hz", (unsigned long)(30u + v / 3u), (unsigned long)(v % 10u));
+    d->text(0, 0, "STEP 1 Hz", Font_8H, SH1106_COLOR_WHITE);
+    d->text(10, 11, s, Font_11x18, SH1106_COLOR_WHITE);
+    d->text((int16_t)(v % 7u) - 3, 30, "abc XYZ 0123", Font_7x10, SH1106_COLOR_WHITE);
+    d->text(100, (uint8_t)(30u + v % 4u), "%$#", Font_6x8, SH1106_COLOR_WHITE);
+    d->line(0, 42, (int16_t)(20u + v * 3u % 100u), 49, SH1106_COLOR_WHITE);
+    d->circle((int16_t)(64u + v % 9u), 46, 5, SH1106_COLOR_WHITE);
+    d->rect(0, 53, 128, 11, SH1106_COLOR_WHITE);
+    d->text((int16_t)(4u + v % 3u), 55, "[ ON ] BTN3=off", Font_8H, SH1106_COLOR_BLACK);
+}
+
+/* the DMA driver's delta update, run to the end */
+static void dma_update(void)
+{
+    check(SH1106_UpdateScreenAsync() == SH1106_OK, "async frame starts");
+    bus_run();
+}
+
+/* the DMA driver's chunk waits for the bus: SIGALRM completes it */
+static bool dma_chunk(uint16_t chunk)
+{
+    bool more;
+
+    irq_enable(1);
+    more = SH1106_UpdateScreenChunk(chunk);
+    irq_enable(0);
+    return more;
+}
+
+/* a chunked frame between two delta updates */
+static void chunk_case(const char *name, const Draw_t *d, Bus_t *b,
+                       bool (*chunk)(uint16_t), void (*update)(void))
+{
+    char     what[80];
+    uint16_t c = 0;
+
+    bus = b;
+    draw_scene(d, 200);
+    update();
+
+    /* chunks, then the previous frame drawn back: equal to a stale back
+       buffer, so it would be skipped */
+    draw_scene(d, 201);
+    while (chunk(c++)) {}
+    snprintf(what, sizeof(what), "%s: chunks bring the panel to the frame", name);
+    check(panel_matches(b, d->buffer()), what);
+    draw_scene(d, 200);
+    update();
+    snprintf(what, sizeof(what), "%s: previous frame drawn back reaches the panel", name);
+    check(panel_matches(b, d->buffer()), what);
+
+    /* chunks, then an update with nothing drawn */
+    draw_scene(d, 201);
+    for (c = 0; chunk(c); c++) {}
+    bus_reset(b);
+    update();
+    snprintf(what, sizeof(what), "%s: update after the chunks sends nothing", name);
+    check(b->transfers == 0u && panel_matches(b, d->buffer()), what);
+}
+
+static int same_stream(void)
+{
+    return bus_blk.len <= BUS_LOG_MAX && bus_blk.len == bus_dma.len &&
+           bus_blk.transfers == bus_dma.transfers &&
+           memcmp(bus_blk.log, bus_dma.log, bus_blk.len) == 0;
+}
+
+int main(void)
+{
+    uint32_t total_blk = 0, total_dma = 0, idle_frames = 0;
+
+    /* ---- init: blocking commands from both drivers ---- */
+    bus = &bus_blk;
+    check(blk_SH1106_Init() == SH1106_OK, "005 init");
+    bus = &bus_dma;
+    irq_enable(1);
+    check(SH1106_Init() == SH1106_OK, "006 init");
+    irq_enable(0);
+    check(!SH1106_IsBusy() && dma_h == NULL, "006 init leaves the bus idle");
+    check(bus_blk.full_pages == PANEL_PAGES, "init sends a full frame");
+    check(same_stream(), "init: same stream, blocking and DMA");
+    check(panel_matches(&bus_dma, drv_dma.buffer()), "init: panel cleared");
+
+    /* ---- frames: blocking vs async, next frame drawn during the transfer ---- */
+    draw_scene(&drv_dma, 0);
+    for (uint32_t f = 0; f < FRAMES; f++) {
+        uint32_t n;
+
+        bus_reset(&bus_blk);
+        bus_reset(&bus_dma);
+
+        bus = &bus_blk;
+        draw_scene(&drv_blk, f);
+        blk_SH1106_UpdateScreen();
+
+        bus = &bus_dma;
+        check(SH1106_UpdateScreenAsync() == SH1106_OK, "async frame starts");
+        n = 0;
+        if (SH1106_IsBusy()) {
+            /* three transfers in: redraw for the next frame, and try to
+             * start it while this one is still going out */
+            for (; n < 3u && bus_step(); n++) { }
+            draw_scene(&drv_dma, f + 1u);
+            if (SH1106_IsBusy()) {
+                uint32_t before = bus_dma.transfers;
+                check(SH1106_UpdateScreenAsync() == SH1106_BUSY, "second async call while busy returns BUSY");
+                check(bus_dma.transfers == before && dma_h != NULL, "BUSY call leaves the frame in flight");
+            }
+            n += bus_run();
+        } else {
+            draw_scene(&drv_dma, f + 1u);
+        }
+        check(!SH1106_IsBusy(), "async frame completes");
+        check(n == bus_dma.transfers, "every transfer of the frame went through the event loop");
+        if (bus_blk.transfers == 0) idle_frames++;
+
+        if (!same_stream()) {
+            printf("FAIL frame %lu: blocking %lu transfers / %lu bytes, async %lu / %lu\n",
+                   (unsigned long)f, (unsigned long)bus_blk.transfers, (unsigned long)bus_blk.len,
+                   (unsigned long)bus_dma.transfers, (unsigned long)bus_dma.len);
+            failed++;
+        }
+        check(panel_matches(&bus_blk, drv_blk.buffer()), "blocking: panel equals the frame");
+        total_blk += bus_blk.wire;
+        total_dma += bus_dma.wire;
+    }
+    check(idle_frames == FRAMES / 5u, "repeated frames send nothing");
+
+    /* ---- the DMA driver's own blocking SH1106_UpdateScreen ---- */
+    for (uint32_t f = FRAMES; f < FRAMES + 4u; f++) {
+        bus_reset(&bus_blk);
+        bus_reset(&bus_dma);
+        bus = &bus_blk;
+        draw_scene(&drv_blk, f);
+        blk_SH1106_UpdateScreen();
+        bus = &bus_dma;
+        draw_scene(&drv_dma, f);
+        irq_enable(1);
+        SH1106_UpdateScreen();
+        irq_enable(0);
+        check(!SH1106_IsBusy() && dma_h == NULL, "DMA UpdateScreen returns with the bus idle");
+        check(same_stream(), "DMA UpdateScreen: same stream as the blocking driver");
+    }
+    check(panel_matches(&bus_dma, drv_dma.buffer()), "DMA UpdateScreen: panel equals the frame");
+
+    /* ---- I2C error mid-frame: stop, resend everything next time ---- */
+    bus = &bus_dma;
+    draw_scene(&drv_dma, 100);
+    bus_error_in = 5;
+    check(SH1106_UpdateScreenAsync() == SH1106_OK, "error case: frame starts");
+    bus_run();
+    check(bus_error_in < 0 && !SH1106_IsBusy() && dma_h == NULL, "ErrorCallback stops the pipeline");
+    check(bus_dma.transfers > 0 && !panel_matches(&bus_dma, drv_dma.buffer()),
+          "error case: panel left half drawn");
+    bus_reset(&bus_dma);
+    check(SH1106_UpdateScreenAsync() == SH1106_OK, "frame after the error starts");
+    bus_run();
+    check(bus_dma.full_pages == PANEL_PAGES && bus_dma.transfers == 4u * PANEL_PAGES,
+          "frame after the error resends every page");
+    check(panel_matches(&bus_dma, drv_dma.buffer()), "frame after the error: panel repaired");
+
+    /* ---- another I2C handle's callbacks are not ours ---- */
+    {
+        I2C_HandleTypeDef other = { .Instance = (void *)0x40005800u, .State = HAL_I2C_STATE_READY };
+
+        draw_scene(&drv_dma, 101);
+        check(SH1106_UpdateScreenAsync() == SH1106_OK && SH1106_IsBusy(), "frame starts");
+        HAL_I2C_ErrorCallback(&other);
+        HAL_I2C_MemTxCpltCallback(&other);
+        check(SH1106_IsBusy(), "callbacks of another handle are ignored");
+        bus_run();
+        check(panel_matches(&bus_dma, drv_dma.buffer()), "frame completes normally");
+    }
+
+    /* ---- DMA start refused: first transfer, and chained from the callback ---- */
+    draw_scene(&drv_dma, 102);
+    bus_refuse_in = 0;
+    check(SH1106_UpdateScreenAsync() == SH1106_ERROR, "refused first transfer returns ERROR");
+    check(!SH1106_IsBusy() && dma_h == NULL, "refused first transfer leaves the driver idle");
+    bus_reset(&bus_dma);
+    check(SH1106_UpdateScreenAsync() == SH1106_OK, "retry starts");
+    bus_run();
+    check(bus_dma.full_pages == PANEL_PAGES, "retry after a refused start resends every page");
+
+    draw_scene(&drv_dma, 103);
+    bus_refuse_in = 6;
+    check(SH1106_UpdateScreenAsync() == SH1106_OK, "frame starts");
+    bus_run();
+    check(bus_refuse_in < 0 && !SH1106_IsBusy(), "refused chained transfer stops the pipeline");
+    bus_reset(&bus_dma);
+    check(SH1106_UpdateScreenAsync() == SH1106_OK, "retry starts");
+    bus_run();
+    check(bus_dma.full_pages == PANEL_PAGES, "retry after a refused chain resends every page");
+    check(panel_matches(&bus_dma, drv_dma.buffer()), "retry: panel repaired");
+
+    /* ---- chunked updates ---- */
+    chunk_case("005 blocking", &drv_blk, &bus_blk, blk_SH1106_UpdateScreenChunk, blk_SH1106_UpdateScreen);
+    chunk_case("006 DMA", &drv_dma, &bus_dma, dma_chunk, dma_update);
+
+    printf("%u frames, blocking %lu bytes, async %lu bytes on the bus, %lu idle frames\n",
+           FRAMES, (unsigned long)total_blk, (unsigned long)total_dma, (unsigned long)idle_frames);
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
+
+#endif /* SH1106_MOCK_NO_MAIN */
@@ -0,0 +1,812 @@
+/*
+ * strobe_commit_sim.c - clock level model of the 006-stroboscope strobe
+ *                       timers while the setting changes under them
+ *
+ * TIM3 (PSC/ARR/CCR1 preloaded, UDIS, UG, update and CC1 flags) gates
+ * TIM1 (gated slave, CH1 PWM2, CCR1 preloaded, UG) as Strobe_HwInit sets
+ * them up; the LED is TIM1 OC1. The CPU runs the strobe code of 006
+ * main.c written out against the model: Strobe_Commit, Strobe_ApplyDuty,
+ * Strobe_ApplyBright, Strobe_PhaseShift, Strobe_UpdateEvent, the TIM3 ISR
+ * and Tach_Edge from the TIM4 ISR. The register math is the firmware's
+ * own strobe_calc.c. Every register access costs a few clocks and the
+ * code can be interrupted between any two of them, with the NVIC
+ * priorities of main.c (TIM3 2, TIM4 3, thread last), PRIMASK, and an
+ * interrupt latency of 12-300 clocks.
+ *
+ * Counted on the LED and the gate:
+ *   truncated pulse  an LED pulse that is not (1000 - CCR1) TIM1 counts
+ *   mixed flash      a flash with LED pulses of two brightnesses
+ *   cut window       a gate window that is not CCR1 x (PSC+1) clocks or
+ *                    leaves TIM1 off CNT = 0
+ *   doubled window   a gate window held open across an update event
+ *   mixed setting    an update event that loads PSC/ARR/CCR1 written by
+ *                    two different commits
+ *   lost commit      a commit that puts back a setting older than one a
+ *                    tach commit made meanwhile
+ *
+ * 1. 30 s with a change every 0.2-3 ms (frequency 5-1000 Hz, duty,
+ *    brightness, phase, tach commit from the TIM4 ISR), through the
+ *    preload commit of main.c and through stop/restart per change
+ *    (Strobe_ApplyFreq), which is what the preloads replaced.
+ * 2. Sweeps of the two races at every clock offset, each with the guard
+ *    of main.c and without it, to show the model sees the race:
+ *    Strobe_Commit against the TIM3 update event (UDIS), and Tach_Edge
+ *    committing from the TIM4 ISR against Strobe_ApplyDuty reading
+ *    g_timing (__disable_irq).
+ * 3. The brightness hand-over of the TIM3 CC1 ISR against a period that
+ *    a phase shift has shortened down to the window, for every gap and
+ *    interrupt latency: with the STROBE_UG_MARGIN_TICKS check of main.c
+ *    and with the update flag check only, where the update event can
+ *    land between the check and the TIM1 UG.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Wall -I006-stroboscope/Inc tools/strobe_commit_sim.c \
+ *       006-stroboscope/Src/strobe_calc.c -lm -o strobe_commit_sim && ./strobe_commit_sim
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "strobe_calc.h"
+
+#define TIM1_DIV     (STROBE_TIM1_PSC + 1u)
+#define TIM1_TOP     (STROBE_TIM1_ARR + 1u)
+#define PWM_CLK      STROBE_PWM_PERIOD_CLK
+
+/* NVIC priorities of main.c, the thread below all of them */
+#define PRIO_TIM3    2
+#define PRIO_TIM4    3
+#define PRIO_THREAD  16
+
+#define NEVER        UINT64_MAX
+
+#define STROBE_UG_MARGIN_TICKS 32u                  /* main.c */
+#define CLK_MHZ_Q8   ((uint64_t)STROBE_TIM_CLK_HZ * 1000u * 256u)
+
+typedef struct {
+    const char *name;
+    int restart;        /* every change stops and restarts TIM3       */
+    int udis;           /* Strobe_Commit sets UDIS around the writes  */
+    int duty_guard;     /* Strobe_ApplyDuty holds interrupts off      */
+    int ug_guard;       /* CC1 ISR leaves the UG when the UEV is near */
+} Path_t;
+
+typedef struct {
+    uint32_t changes, flashes;
+    uint64_t pulses;
+    uint32_t truncated, mixed_bright, cut, doubled, mixed_set, lost;
+} Stats_t;
+
+typedef struct { uint32_t val, gen; } Reg_t;    /* value, commit it came from */
+
+static const Path_t *path;
+static Stats_t       st;
+static uint64_t      now;
+static int           primask, prio = PRIO_THREAD;
+static uint32_t      lat_min = 12u, lat_max = 300u;
+static uint64_t      rng = 88172645463325252ull;
+static uint32_t      failed;
+
+/* TIM3 */
+static struct {
+    int      cen, udis, uie, cc1ie, pwm;        /* pwm = 0: OC1M forced inactive */
+    Reg_t    psc, arr, ccr;                     /* preload */
+    Reg_t    psc_sh, arr_sh, ccr_sh;            /* active  */
+    uint32_t cnt, pc;
+    int      uif, cc1if;
+    uint64_t uif_at, cc1_at;                    /* ISR entry time per flag */
+    int      gate;                              /* OC1REF = TRGO */
+} t3;
+
+/* TIM1 and the LED */
+static struct {
+    uint32_t cnt, pc, cmp, cmp_pre;
+    int      led;
+    uint64_t led_rise;
+    uint32_t led_cmp;
+} t1;
+
+/* the gate window open now */
+static struct { int open, mixed; int32_t cmp; uint64_t at, len; } fl;
+
+/* TIM4 (tach) interrupt */
+static int      tach_pend;
+static uint64_t tach_at, tach_next = NEVER;
+static uint32_t tach_mhz;
+
+/* strobe state of main.c */
+typedef struct { Strobe_Timing_t t; uint32_t fgen; } Setting_t;
+
+static Setting_t g_timing;
+static uint32_t  g_gen, g_fgen;
+static uint32_t  g_dither_acc, g_bright_cmp;
+static int32_t   g_phase_pending, g_phase_in_arr;
+static uint32_t  g_arr_run;
+static int       g_arr_run_set, g_wrap_hidden;
+static uint32_t  g_duty_num = 5u, g_duty_den = 100u, g_freq_mhz = 50000u, g_brig = 750u;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+static uint32_t rnd(uint32_t n)
+{
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (uint32_t)((rng >> 11) % n);
+}
+
+static uint64_t latency(void) { return lat_min + rnd(lat_max - lat_min + 1u); }
+
+/* ---- TIM1 ------------------------------------------------------------------- */
+
+static void led_rise(uint64_t t)
+{
+    t1.led      = 1;
+    t1.led_rise = t;
+    t1.led_cmp  = t1.cmp;
+    if (fl.open) {
+        if (fl.cmp < 0) fl.cmp = (int32_t)t1.cmp;
+        else if (fl.cmp != (int32_t)t1.cmp) fl.mixed = 1;
+    }
+}
+
+static void led_fall(uint64_t t)
+{
+    if (!t1.led) return;
+    t1.led = 0;
+    st.pulses++;
+    if (t - t1.led_rise != (uint64_t)(TIM1_TOP - t1.led_cmp) * TIM1_DIV) st.truncated++;
+}
+
+/* span clocks with the gate open, from now */
+static void tim1_run(uint64_t span)
+{
+    uint64_t t = now;
+
+    while (span > 0u) {
+        if (t1.cnt == 0u && t1.pc == 0u && !t1.led && t1.cmp == t1.cmp_pre && span >= PWM_CLK) {
+            uint64_t k = span / PWM_CLK;            /* whole PWM periods */
+            led_rise(t);
+            t1.led = 0;
+            st.pulses += k;
+            t    += k * PWM_CLK;
+            span -= k * PWM_CLK;
+            continue;
+        }
+        if (t1.pc == 0u && span >= TIM1_DIV) {
+            uint32_t next = (t1.cnt < t1.cmp) ? t1.cmp : TIM1_TOP;
+            uint64_t c    = span / TIM1_DIV;
+            if (c > next - t1.cnt) c = next - t1.cnt;
+            t1.cnt += (uint32_t)c;
+            t      += c * TIM1_DIV;
+            span   -= c * TIM1_DIV;
+        } else {
+            uint64_t take = TIM1_DIV - t1.pc;
+            if (take > span) take = span;
+            t1.pc += (uint32_t)take;
+            t     += take;
+            span  -= take;
+            if (t1.pc < TIM1_DIV) continue;
+            t1.pc = 0u;
+            t1.cnt++;
+        }
+        if (t1.cnt == TIM1_TOP) {                   /* update event */
+            t1.cnt = 0u;
+            led_fall(t);
+            t1.cmp = t1.cmp_pre;
+        }
+        if (!t1.led && t1.cnt >= t1.cmp) led_rise(t);
+    }
+}
+
+static void tim1_ug(void)
+{
+    led_fall(now);
+    t1.cnt = 0u;
+    t1.pc  = 0u;
+    t1.cmp = t1.cmp_pre;
+    if (t1.cnt >= t1.cmp) led_rise(now);
+}
+
+/* ---- TIM3 ------------------------------------------------------------------- */
+
+static void gate_update(int wrap)
+{
+    int g = t3.cen && t3.pwm && t3.cnt < t3.ccr_sh.val;
+
+    if (g && !t3.gate) {
+        fl.open  = 1;
+        fl.mixed = 0;
+        fl.cmp   = -1;
+        fl.at    = now;
+        fl.len   = (uint64_t)t3.ccr_sh.val * (t3.psc_sh.val + 1u);
+        if (t1.led) fl.cmp = (int32_t)t1.led_cmp;
+    } else if (!g && t3.gate) {
+        st.flashes++;
+        if (now - fl.at != fl.len || t1.cnt != 0u || t1.pc != 0u) st.cut++;
+        if (fl.mixed) st.mixed_bright++;
+        fl.open = 0;
+    } else if (g && wrap) {
+        st.doubled++;
+    }
+    t3.gate = g;
+}
+
+static void set_flag(int *flag, uint64_t *at)
+{
+    if (!*flag) *at = now + latency();
+    *flag = 1;
+}
+
+static void tim3_load(void)
+{
+    if (t3.psc.gen != t3.arr.gen || t3.arr.gen != t3.ccr.gen) st.mixed_set++;
+    t3.psc_sh = t3.psc;
+    t3.arr_sh = t3.arr;
+    t3.ccr_sh = t3.ccr;
+}
+
+static void tim3_ug(void)
+{
+    tim3_load();
+    t3.cnt = 0u;
+    t3.pc  = 0u;
+    set_flag(&t3.uif, &t3.uif_at);
+    gate_update(0);
+}
+
+/* clocks to the next compare match or overflow */
+static uint64_t tim3_to_event(uint32_t *target)
+{
+    uint32_t tg = (t3.cnt < t3.ccr_sh.val && t3.ccr_sh.val <= t3.arr_sh.val)
+                  ? t3.ccr_sh.val : t3.arr_sh.val + 1u;
+    if (target) *target = tg;
+    return (uint64_t)(tg - t3.cnt) * (t3.psc_sh.val + 1u) - t3.pc;
+}
+
+static uint64_t tim3_to_overflow(void)
+{
+    return (uint64_t)(t3.arr_sh.val + 1u - t3.cnt) * (t3.psc_sh.val + 1u) - t3.pc;
+}
+
+/* run the timers towards to; returns early after an event */
+static void advance(uint64_t to)
+{
+    while (now < to) {
+        uint64_t span = to - now, need;
+        uint32_t target, div;
+
+        if (tach_next <= now) {
+            tach_next = NEVER;
+            if (!tach_pend) { tach_pend = 1; tach_at = now + latency(); }
+            return;
+        }
+        if (tach_next - now < span) span = tach_next - now;
+
+        if (!t3.cen) { now += span; continue; }
+
+        need = tim3_to_event(&target);
+        if (need < span) span = need;
+        if (t3.gate) tim1_run(span);
+        div    = t3.psc_sh.val + 1u;
+        now   += span;
+        span  += t3.pc;
+        t3.cnt += (uint32_t)(span / div);
+        t3.pc   = (uint32_t)(span % div);
+
+        if (t3.cnt != target || t3.pc != 0u) continue;
+        if (target == t3.arr_sh.val + 1u) {         /* overflow */
+            t3.cnt = 0u;
+            if (!t3.udis) {
+                tim3_load();
+                set_flag(&t3.uif, &t3.uif_at);
+            }
+            gate_update(1);
+        } else {                                    /* CNT = CCR1 */
+            set_flag(&t3.cc1if, &t3.cc1_at);
+            gate_update(0);
+        }
+        return;
+    }
+}
+
+/* ---- CPU -------------------------------------------------------------------- */
+
+static void tim3_isr(void);
+static void tim4_isr(void);
+
+static int tim3_ready(void)
+{
+    return (t3.uif && t3.uie && t3.uif_at <= now) || (t3.cc1if && t3.cc1ie && t3.cc1_at <= now);
+}
+
+static uint64_t next_ready(void)
+{
+    uint64_t r = NEVER;
+    if (t3.uif && t3.uie && t3.uif_at < r)     r = t3.uif_at;
+    if (t3.cc1if && t3.cc1ie && t3.cc1_at < r) r = t3.cc1_at;
+    if (tach_pend && tach_at < r)              r = tach_at;
+    return r;
+}
+
+static void dispatch(void)
+{
+    for (;;) {
+        int saved = prio;
+
+        if (primask) return;
+        if (prio > PRIO_TIM3 && tim3_ready()) {
+            prio = PRIO_TIM3;
+            tim3_isr();
+        } else if (prio > PRIO_TIM4 && tach_pend && tach_at <= now) {
+            tach_pend = 0;
+            prio = PRIO_TIM4;
+            tim4_isr();
+        } else {
+            return;
+        }
+        prio = saved;
+    }
+}
+
+/* n clocks of code, then whatever interrupt is due */
+static void cpu(uint32_t n)
+{
+    uint64_t to = now + n;
+    while (now < to) advance(to);
+    dispatch();
+}
+
+/* ---- strobe code of main.c ---------------------------------------------------- */
+
+static uint16_t Strobe_StartARR(void)
+{
+    return (g_timing.t.frac != 0u) ? g_timing.t.arr_lo : g_timing.t.arr;
+}
+
+static void Strobe_UpdateEvent(void)
+{
+    uint16_t arr, base;
+    int32_t  phase;
+
+    if (!g_arr_run_set) g_arr_run = t3.arr.val;
+    g_arr_run_set = g_wrap_hidden = 0;
+    cpu(12);
+
+    arr = g_timing.t.arr;
+    if (g_timing.t.frac != 0u) arr = Strobe_DitherARR(&g_timing.t, &g_dither_acc);
+    base  = arr;
+    phase = g_phase_pending;
+    if (phase != 0) {
+        arr = Strobe_PhaseARR(arr, g_timing.t.ccr, &phase);
+        g_phase_pending = phase;
+    }
+    g_phase_in_arr = (int32_t)arr - (int32_t)base;
+    cpu(40);
+    t3.arr = (Reg_t){ arr, g_gen };
+    cpu(4);
+}
+
+static void tim3_isr(void)
+{
+    cpu(6);
+    if (t3.cc1if && t3.cc1ie) {
+        uint32_t cnt;
+        int      ok;
+
+        t3.cc1if = 0;
+        cpu(4);
+        if (path->ug_guard) {
+            primask = 1;
+            cnt = t3.cnt;
+            cpu(4);
+            ok = !t3.uif && !g_wrap_hidden && g_arr_run >= cnt + STROBE_UG_MARGIN_TICKS;
+        } else {
+            ok = !t3.uif;
+        }
+        if (ok) {
+            cpu(4);
+            t1.cmp_pre = g_bright_cmp;
+            cpu(4);
+            tim1_ug();
+            cpu(4);
+            t3.cc1ie = 0;
+        }
+        primask = 0;
+        cpu(4);
+    }
+    if (t3.uif && t3.uie) {
+        t3.uif = 0;
+        cpu(4);
+        Strobe_UpdateEvent();
+    }
+}
+
+static void Strobe_HwStop(void)
+{
+    t3.pwm = 0;
+    gate_update(0);
+    cpu(4);
+    t3.cen = 0;
+    cpu(4);
+    t3.uie = t3.cc1ie = 0;
+    cpu(4);
+    led_fall(now);                                  /* TIM1 CNT = 0 */
+    t1.cnt = 0u;
+    cpu(4);
+}
+
+static void Strobe_HwStart(void)
+{
+    uint16_t arr = Strobe_StartARR();
+
+    t3.psc = (Reg_t){ g_timing.t.psc, g_gen }; cpu(4);
+    t3.arr = (Reg_t){ arr, g_gen };            cpu(4);
+    t3.ccr = (Reg_t){ g_timing.t.ccr, g_gen }; cpu(8);
+    tim3_ug();                                 cpu(4);
+    t3.cnt = arr;                              cpu(4);
+    t3.uif = t3.cc1if = 0;                     cpu(4);
+    g_arr_run = arr;
+    g_arr_run_set = g_wrap_hidden = 0;         cpu(4);
+    t3.uie = 1;                                cpu(4);
+    t3.pwm = 1; gate_update(0);                cpu(8);
+    t3.cen = 1; gate_update(0);                cpu(4);
+}
+
+static void Strobe_ApplyBright(void)
+{
+    g_bright_cmp = Strobe_CalcGatedCompare(g_brig);
+    cpu(20);
+    if (!t3.cen) {
+        t1.cmp_pre = g_bright_cmp; cpu(4);
+        tim1_ug();                 cpu(4);
+        return;
+    }
+    t3.cc1if = 0; cpu(4);
+    t3.cc1ie = 1; cpu(4);
+}
+
+/* stop, new setting, restart: on/reset in main.c, every change before */
+static void Strobe_ApplyFreq(const Setting_t *s)
+{
+    Strobe_HwStop();
+    g_timing = *s;
+    g_gen++;
+    g_dither_acc = 0u;
+    g_phase_pending = g_phase_in_arr = 0;
+    cpu(300);
+    Strobe_ApplyBright();
+    Strobe_HwStart();
+    st.changes++;
+}
+
+static void Strobe_Commit(const Setting_t *s, int new_freq)
+{
+    int      pm = primask;
+    uint16_t arr;
+    uint32_t cnt0;
+
+    primask = 1;
+    cpu(4);
+    if (path->udis) { t3.udis = 1; cpu(4); }
+    cnt0 = t3.cnt; cpu(4);
+    if (t3.uif && !g_arr_run_set) { g_arr_run = t3.arr.val; g_arr_run_set = 1; }
+    cpu(8);
+
+    if (!new_freq && s->fgen != g_fgen) st.lost++;
+    g_phase_pending = (int32_t)((int64_t)(g_phase_pending + g_phase_in_arr) *
+                                ((int32_t)g_timing.t.psc + 1) / ((int32_t)s->t.psc + 1));
+    g_phase_in_arr  = 0;
+    g_timing        = *s;
+    if (new_freq) g_timing.fgen = ++g_fgen;
+    g_gen++;
+    g_dither_acc    = 0u;
+    arr             = Strobe_StartARR();
+    cpu(30);
+
+    t3.psc = (Reg_t){ g_timing.t.psc, g_gen }; cpu(4);
+    t3.arr = (Reg_t){ arr, g_gen };            cpu(4);
+    t3.ccr = (Reg_t){ g_timing.t.ccr, g_gen }; cpu(4);
+    cpu(12);                                   /* CCR3, g_period_next */
+
+    if (path->udis) { t3.udis = 0; cpu(4); }
+    if (t3.cnt < cnt0) g_wrap_hidden = 1;
+    cpu(4);
+    primask = pm;
+    st.changes++;
+    cpu(2);
+}
+
+static void Strobe_Retune(void)
+{
+    Setting_t s;
+
+    Strobe_CalcTiming(g_freq_mhz, g_duty_num, g_duty_den, &s.t);
+    s.fgen = 0u;
+    cpu(300);
+    if (path->restart) { Strobe_ApplyFreq(&s); return; }
+    Strobe_Commit(&s, 1);
+}
+
+static void Strobe_ApplyDuty(void)
+{
+    Setting_t s;
+
+    cpu(20);
+    if (path->restart) {
+        s = g_timing;
+        s.t.ccr = Strobe_CalcWindow(s.t.psc, s.t.arr_lo, g_duty_num, g_duty_den);
+        Strobe_ApplyFreq(&s);
+        return;
+    }
+    if (path->duty_guard) primask = 1;
+    s = g_timing;
+    cpu(8);
+    s.t.ccr = Strobe_CalcWindow(s.t.psc, s.t.arr_lo, g_duty_num, g_duty_den);
+    cpu(60);
+    Strobe_Commit(&s, 0);
+    if (path->duty_guard) { primask = 0; cpu(2); }
+}
+
+static void Strobe_PhaseShift(int32_t deg)
+{
+    int32_t ticks = Strobe_CalcPhaseTicks(&g_timing.t, deg);
+
+    cpu(60);
+    if (path->restart) { Setting_t s = g_timing; Strobe_ApplyFreq(&s); return; }
+    primask = 1;
+    g_phase_pending += ticks;
+    cpu(8);
+    primask = 0;
+    cpu(2);
+}
+
+/* TIM4 capture: Tach_Edge with the PLL giving tach_mhz */
+static void tim4_isr(void)
+{
+    Setting_t s;
+
+    cpu(200);                                       /* filter, PLL */
+    Strobe_CalcTimingPeriod(CLK_MHZ_Q8 / tach_mhz, g_duty_num, g_duty_den, &s.t);
+    s.fgen = 0u;
+    cpu(300);
+    if (path->restart) { Strobe_ApplyFreq(&s); return; }
+    Strobe_Commit(&s, 1);
+}
+
+/* ---- runs ----------------------------------------------------------------------- */
+
+static void sim_reset(const Path_t *p, uint32_t freq_mhz)
+{
+    Setting_t s;
+
+    memset(&t3, 0, sizeof(t3));
+    memset(&t1, 0, sizeof(t1));
+    memset(&fl, 0, sizeof(fl));
+    memset(&st, 0, sizeof(st));
+    path = p;
+    now = 0u;
+    primask = 0;
+    prio = PRIO_THREAD;
+    tach_pend = 0;
+    tach_next = NEVER;
+    g_gen = g_fgen = 0u;
+    g_freq_mhz = freq_mhz;
+    g_duty_num = 5u; g_duty_den = 100u;
+    g_brig = 750u;
+
+    /* Strobe_HwInit: PWM2 compare loaded with UG */
+    t1.cmp_pre = Strobe_CalcGatedCompare(g_brig);
+    tim1_ug();
+
+    Strobe_CalcTiming(g_freq_mhz, g_duty_num, g_duty_den, &s.t);
+    s.fgen = g_fgen;
+    {
+        static const Path_t start = { "start", 1, 1, 1, 1 };
+        path = &start;
+        Strobe_ApplyFreq(&s);
+        path = p;
+    }
+    st.changes = 0u;
+}
+
+/* idle until t, the interrupts running */
+static void run_until(uint64_t t)
+{
+    while (now < t) {
+        uint64_t to = t, r;
+        dispatch();
+        r = next_ready();
+        if (r > now && r < to) to = r;
+        advance(to);
+        dispatch();
+    }
+}
+
+static uint32_t log_freq(void)
+{
+    /* 5 Hz .. 1000 Hz, log uniform */
+    double k = (double)rnd(1u << 20) / (double)(1u << 20);
+    return (uint32_t)(5000.0 * pow(200.0, k));
+}
+
+static void random_run(const Path_t *p, double secs)
+{
+    uint64_t end = (uint64_t)(secs * STROBE_TIM_CLK_HZ);
+
+    sim_reset(p, 50000u);
+    while (now < end) {
+        run_until(now + 20000u + rnd(280000u));     /* 0.2 .. 3 ms */
+
+        switch (rnd(6u)) {
+        case 0:
+            g_freq_mhz = log_freq();
+            Strobe_Retune();
+            break;
+        case 1:
+            if (rnd(2u)) { g_duty_num = 5u + rnd(46u); g_duty_den = 100u; }
+            else         { g_duty_num = 1u; g_duty_den = 25u + 5u * rnd(36u); }
+            Strobe_ApplyDuty();
+            break;
+        case 2:
+            g_brig = rnd(2u) ? 100u + 10u * rnd(91u) : 1000u / (10u + rnd(191u));
+            if (p->restart) { Setting_t s = g_timing; cpu(20); Strobe_ApplyFreq(&s); }
+            else Strobe_ApplyBright();
+            break;
+        case 3:
+            Strobe_PhaseShift((int32_t)rnd(719u) - 359);
+            break;
+        default:
+            /* a tach reference pulse a little later */
+            tach_mhz  = log_freq();
+            tach_next = now + rnd(20000u);
+            break;
+        }
+    }
+    run_until(now + 2u * STROBE_TIM_CLK_HZ / 5u);   /* last changes settle */
+}
+
+static void print_stats(const char *name)
+{
+    printf("%-26s %6u %7u %9llu %6u %6u %6u %6u %6u %6u\n", name, st.changes, st.flashes,
+           (unsigned long long)st.pulses, st.truncated, st.mixed_bright, st.cut, st.doubled,
+           st.mixed_set, st.lost);
+}
+
+static int stats_clean(void)
+{
+    return st.truncated == 0u && st.mixed_bright == 0u && st.cut == 0u &&
+           st.doubled == 0u && st.mixed_set == 0u && st.lost == 0u;
+}
+
+/* Strobe_Commit started at off clocks from the next TIM3 update event,
+ * 1 kHz (PSC 1) -> 700 Hz (PSC 3) */
+static void sweep_commit(const Path_t *p, int32_t off, Stats_t *sum)
+{
+    Setting_t s;
+    uint64_t  uev;
+
+    lat_min = lat_max = 12u;
+    sim_reset(p, 1000000u);
+    run_until(now + 3u * 100000u + 50000u);
+    uev = now + tim3_to_overflow();
+    run_until((uint64_t)((int64_t)uev + off));
+
+    Strobe_CalcTiming(700000u, g_duty_num, g_duty_den, &s.t);
+    s.fgen = 0u;
+    Strobe_Commit(&s, 1);
+    run_until(now + 4u * 150000u);
+
+    sum->changes += st.changes; sum->flashes += st.flashes; sum->pulses += st.pulses;
+    sum->truncated += st.truncated; sum->mixed_bright += st.mixed_bright; sum->cut += st.cut;
+    sum->doubled += st.doubled; sum->mixed_set += (st.mixed_set != 0u); sum->lost += st.lost;
+}
+
+/* Tach_Edge (TIM4 ISR) due off clocks after Strobe_ApplyDuty starts */
+static void sweep_duty(const Path_t *p, int32_t off, Stats_t *sum)
+{
+    lat_min = lat_max = 12u;
+    sim_reset(p, 1000000u);
+    run_until(now + 250000u);
+
+    tach_mhz  = 900000u;
+    tach_next = (uint64_t)((int64_t)now + off);
+    g_duty_num = 20u;
+    Strobe_ApplyDuty();
+    run_until(now + 4u * 120000u);
+
+    check(g_timing.t.ccr == Strobe_CalcWindow(g_timing.t.psc, g_timing.t.arr_lo, 20u, 100u),
+          "duty change applied");
+    sum->changes += st.changes; sum->flashes += st.flashes; sum->pulses += st.pulses;
+    sum->truncated += st.truncated; sum->mixed_bright += st.mixed_bright; sum->cut += st.cut;
+    sum->doubled += st.doubled; sum->mixed_set += st.mixed_set; sum->lost += (st.lost != 0u);
+}
+
+/* brightness change while a phase shift shortens periods to the window:
+ * gap ticks between the window end and the update event, CC1 latency */
+static void sweep_bright(const Path_t *p, uint32_t gap, uint32_t lat, Stats_t *sum)
+{
+    lat_min = lat_max = lat;
+    sim_reset(p, 1000000u);
+    run_until(now + 150000u);
+
+    /* the period after next down to window + gap: ARR = CCR1 + gap. the
+     * change waits for a window in the gate-closed part of the next one */
+    g_phase_pending = -(int32_t)(g_timing.t.arr - g_timing.t.ccr - gap);
+    run_until(now + tim3_to_overflow() + 2000u);
+    run_until(now + tim3_to_overflow() - 1000u);
+    g_brig = (g_brig == 750u) ? 300u : 750u;
+    Strobe_ApplyBright();
+    run_until(now + 4u * 110000u);
+
+    check(t1.cmp == Strobe_CalcGatedCompare(g_brig), "brightness applied");
+    sum->changes++;
+    sum->flashes += st.flashes; sum->pulses += st.pulses;
+    sum->truncated += st.truncated; sum->mixed_bright += st.mixed_bright; sum->cut += st.cut;
+    sum->doubled += st.doubled; sum->mixed_set += st.mixed_set; sum->lost += st.lost;
+}
+
+int main(void)
+{
+    static const Path_t restart   = { "stop/restart",   1, 1, 1, 1 };
+    static const Path_t commit    = { "preload commit", 0, 1, 1, 1 };
+    static const Path_t no_udis   = { "commit without UDIS", 0, 0, 1, 1 };
+    static const Path_t no_guard  = { "duty without irq off", 0, 1, 0, 1 };
+    static const Path_t uif_only  = { "CC1 checks UIF only", 0, 1, 1, 0 };
+    Stats_t s;
+
+    printf("%-26s %6s %7s %9s %6s %6s %6s %6s %6s %6s\n", "", "change", "flashes", "pulses",
+           "trunc", "mixed", "cut", "double", "mixset", "lost");
+
+    printf("30 s, a change every 0.2-3 ms, ISR latency 12-300 clocks:\n");
+    random_run(&restart, 30.0);
+    print_stats("  stop/restart");
+    check(st.truncated > 0u && st.cut > 0u, "model sees stop/restart cut flashes");
+    random_run(&commit, 30.0);
+    print_stats("  preload commit");
+    check(stats_clean(), "preload commit: no truncated, mixed, cut or doubled flash");
+
+    printf("Strobe_Commit at every clock -400..+400 from the update event (runs hit):\n");
+    memset(&s, 0, sizeof(s));
+    for (int32_t off = -400; off <= 400; off++) sweep_commit(&commit, off, &s);
+    st = s; print_stats("  with UDIS");
+    check(stats_clean(), "UDIS: every update event loads one commit");
+    memset(&s, 0, sizeof(s));
+    for (int32_t off = -400; off <= 400; off++) sweep_commit(&no_udis, off, &s);
+    st = s; print_stats("  without UDIS");
+    check(s.mixed_set > 0u, "model sees a half loaded commit without UDIS");
+
+    printf("Tach_Edge at every clock -50..+400 from Strobe_ApplyDuty (runs hit):\n");
+    memset(&s, 0, sizeof(s));
+    for (int32_t off = -50; off <= 400; off++) sweep_duty(&commit, off, &s);
+    st = s; print_stats("  interrupts off");
+    check(stats_clean(), "ApplyDuty under __disable_irq loses no tach commit");
+    memset(&s, 0, sizeof(s));
+    for (int32_t off = -50; off <= 400; off++) sweep_duty(&no_guard, off, &s);
+    st = s; print_stats("  interrupts on");
+    check(s.lost > 0u, "model sees the tach commit lost without __disable_irq");
+
+    printf("brightness on periods shortened to window + 0..400 ticks, latency 12..300:\n");
+    memset(&s, 0, sizeof(s));
+    for (uint32_t gap = 0u; gap <= 400u; gap += 1u)
+        for (uint32_t lat = 12u; lat <= 300u; lat += 24u)
+            sweep_bright(&commit, gap, lat, &s);
+    st = s; print_stats("  CC1 ISR, UEV margin");
+    check(stats_clean(), "brightness hand-over never cuts a flash");
+    memset(&s, 0, sizeof(s));
+    for (uint32_t gap = 0u; gap <= 400u; gap += 1u)
+        for (uint32_t lat = 12u; lat <= 300u; lat += 24u)
+            sweep_bright(&uif_only, gap, lat, &s);
+    st = s; print_stats("  CC1 ISR, UIF only");
+    check(s.cut > 0u, "model sees the UG race with the UIF check only");
+
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * strobe_pll_sim.c - host simulation of the 006-stroboscope tach PLL
+ *
+ * Feeds synthetic tach pulses (speed wander, capture jitter, missed
+ * pulses) through the firmware's own strobe_pll.c and strobe_calc.c and
+ * models TIM3 per update event the way main.c drives it:
+ *
+ *   - at every update event the preloaded PSC/ARR become active and the
+ *     ISR writes the next ARR (dither step);
+ *   - a tach pulse reads the time to the next flash, and on a reference
+ *     pulse the new setting is committed into the preloads at once
+ *     (Strobe_Commit), so the running period ends unchanged.
+ *
+ * The strobe starts 7% off the target. For each case it prints the time
+ * to lock and the rms/max phase error (degrees of the strobe period) of
+ * the references from one second after lock on.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I006-stroboscope/Inc tools/strobe_pll_sim.c \
+ *       006-stroboscope/Src/strobe_pll.c 006-stroboscope/Src/strobe_calc.c \
+ *       -lm -o strobe_pll_sim && ./strobe_pll_sim
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "strobe_calc.h"
+#include "strobe_pll.h"
+
+/* same limits as TACH_PERIOD_Q8_MIN/MAX in main.c */
+#define CLK_MHZ_Q8      ((uint64_t)STROBE_TIM_CLK_HZ * 1000u * 256u)
+#define PERIOD_Q8_MIN   (CLK_MHZ_Q8 / 1000000u)
+#define PERIOD_Q8_MAX   (CLK_MHZ_Q8 / 153u)
+
+#define DUTY_NUM        5u
+#define DUTY_DEN      100u
+
+typedef struct {
+    double   hz;            /* mean tach frequency                 */
+    double   wander;        /* speed wander, fraction of hz        */
+    double   wander_hz;     /* ... as a sine of this frequency     */
+    double   jitter_us;     /* capture jitter, 1 sigma             */
+    double   missing;       /* probability of a lost pulse         */
+    uint16_t mult, div;     /* mult flashes per div pulses         */
+    uint16_t deg;           /* delay after the reference           */
+    double   secs;
+} Case_t;
+
+static double urand(void) { return (rand() + 0.5) / ((double)RAND_MAX + 1.0); }
+static double gauss(void) { return sqrt(-2.0 * log(urand())) * cos(2.0 * M_PI * urand()); }
+
+static void run(const Case_t *c)
+{
+    Strobe_Tach_t   tach;
+    Strobe_Pll_t    pll;
+    Strobe_Timing_t tim;
+    uint32_t        acc = 0u;
+    uint64_t        arr_pre, psc_pre, arr_act, psc_act;
+    double          t_ideal = 0.0, next_flash = 0.0, last_cap = 0.0;
+    double          lock_t = -1.0, sum2 = 0.0, emax = 0.0;
+    long            refs = 0;
+    int             first = 1, unlocks = 0;
+
+    Strobe_TachReset(&tach);
+    pll.mult      = c->mult;
+    pll.div       = c->div;
+    pll.delay_deg = c->deg;
+    Strobe_PllReset(&pll);
+
+    Strobe_CalcTiming((uint32_t)(c->hz * 1000.0 * c->mult / c->div * 1.07),
+                      DUTY_NUM, DUTY_DEN, &tim);
+    arr_pre = (tim.frac != 0u) ? tim.arr_lo : tim.arr;
+    psc_pre = tim.psc;
+
+    while (t_ideal < c->secs * 1e8) {
+        double   f = c->hz * (1.0 + c->wander * sin(2.0 * M_PI * c->wander_hz * t_ideal / 1e8));
+        double   cap;
+        uint64_t tach_q8, period_q8;
+        uint8_t  was_locked;
+
+        t_ideal += 1e8 / f;
+        if (urand() < c->missing) continue;
+        cap = floor(t_ideal + c->jitter_us * 100.0 * gauss());
+
+        /* TIM3 update events up to the pulse: preloads go active, the ISR
+         * writes the next ARR */
+        while (next_flash <= cap) {
+            arr_act = arr_pre;
+            psc_act = psc_pre;
+            arr_pre = (tim.frac != 0u) ? Strobe_DitherARR(&tim, &acc) : tim.arr;
+            psc_pre = tim.psc;
+            next_flash += (double)(arr_act + 1u) * (double)(psc_act + 1u);
+        }
+
+        if (first) { first = 0; last_cap = cap; continue; }
+        tach_q8  = Strobe_TachFilter(&tach, (uint32_t)(cap - last_cap));
+        last_cap = cap;
+
+        was_locked = pll.locked;
+        if (!Strobe_PllEdge(&pll, tach_q8, (int32_t)(next_flash - cap), &period_q8))
+            continue;
+
+        if (period_q8 < PERIOD_Q8_MIN) period_q8 = PERIOD_Q8_MIN;
+        if (period_q8 > PERIOD_Q8_MAX) period_q8 = PERIOD_Q8_MAX;
+
+        /* Strobe_Commit: the running period ends as loaded */
+        Strobe_CalcTimingPeriod(period_q8, DUTY_NUM, DUTY_DEN, &tim);
+        acc     = 0u;
+        arr_pre = (tim.frac != 0u) ? tim.arr_lo : tim.arr;
+        psc_pre = tim.psc;
+
+        if (pll.locked && lock_t < 0.0) lock_t = cap / 1e8;
+        if (was_locked && !pll.locked) unlocks++;
+        if (lock_t >= 0.0 && cap / 1e8 > lock_t + 1.0) {
+            double e = pll.error * 360.0 / ((double)period_q8 / 256.0);
+            sum2 += e * e;
+            if (fabs(e) > emax) emax = fabs(e);
+            refs++;
+        }
+    }
+
+    printf("%7.1f Hz %u/%u %3u deg  jitter %5.1f us  wander %4.1f%% @%4.2f Hz  miss %2.0f%%  |"
+           "  lock %6.2f s  rms %6.2f  max %6.2f deg  unlocks %d\n",
+           c->hz, c->mult, c->div, c->deg, c->jitter_us, c->wander * 100.0, c->wander_hz,
+           c->missing * 100.0, lock_t, refs ? sqrt(sum2 / (double)refs) : 0.0, emax, unlocks);
+}
+
+int main(void)
+{
+    static const Case_t cases[] = {
+        /*  hz  wander  w_hz  jit   miss  m  d  deg   secs */
+        {   30, 0.00,   0.00,   0, 0.00, 1, 1,   0,   30 },
+        {   30, 0.00,   0.00,  20, 0.00, 1, 1,  90,   30 },
+        {   30, 0.05,   0.20,  20, 0.00, 1, 1,  90,   60 },
+        {   30, 0.05,   0.20,  20, 0.02, 1, 1,  90,   60 },
+        {    1, 0.02,   0.05, 100, 0.00, 1, 1,   0,  200 },
+        {  200, 0.05,   0.50,   5, 0.00, 1, 1,  45,   30 },
+        {  200, 0.05,   0.50,   5, 0.00, 4, 1,  45,   30 },
+        {  500, 0.02,   0.50,   2, 0.00, 1, 2, 180,   30 },
+        {  120, 0.05,   0.30,  10, 0.00, 1, 8,  30,   60 },
+        {   10, 0.10,   0.10,  50, 0.01, 3, 1, 270,  100 },
+    };
+
+    srand(7);
+    for (unsigned i = 0u; i < sizeof(cases) / sizeof(cases[0]); i++)
+        run(&cases[i]);
+    return 0;
+}
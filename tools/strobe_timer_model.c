@@ -0,0 +1,491 @@
+/*
+ * strobe_timer_model.c - host model of the 006-stroboscope TIM3/TIM1
+ *                        registers against Src/strobe_calc.c
+ *
+ * Every millihertz step of 0.153 - 1000 Hz goes through Strobe_CalcTiming
+ * for the duty limits of main.c (5 %, 50 %, 1/25, 1/200):
+ *
+ *   - PSC+1 divides the 10000-clock TIM1 PWM period and is the smallest
+ *     one that keeps the period in 16-bit ARR;
+ *   - ARR+1 is the nearest tick: the period is off by half a tick at most
+ *     (the worst case is printed in ppm, next to the old PSC = 9999);
+ *   - CCR1 is a whole number of PWM periods, at least one, at most ARR_lo,
+ *     and the flash is never longer than asked for and at most one PWM
+ *     period (plus one tick of the rounded period) shorter.
+ *
+ * With dithering (Strobe_DitherARR, STROBE_DITHER) the mean period of
+ * ARR_lo + frac/2^32 must be short of the ideal by less than 2^-32 tick
+ * at every mHz step, from a frequency and from a Q24.8 tach period
+ * (Strobe_CalcTimingPeriod). At every 61st mHz step 4096 periods are run
+ * through Strobe_DitherARR the way the update ISR calls it: ARR stays
+ * ARR_lo or ARR_lo+1, the summed periods stay within one tick of N times
+ * the mean, and the frequency error over the run is printed.
+ *
+ * Phase: Strobe_CalcPhaseTicks for -720..+720 degrees at the lowest and
+ * highest frequency, on both sides of every PSC step and across the range
+ * is the same for deg and deg +- 360, 0 at +-360, within half a tick of
+ * deg/360 of the period and folded into +-period/2. Every result, and
+ * shifts of up to three periods either way (phase queued faster than the
+ * ISR takes it, or rescaled to a smaller prescaler by Strobe_Commit), is
+ * then fed to Strobe_PhaseARR once per period, on a dithered ARR as well:
+ * each ARR stays between the window and 65535, the shift ends, and the
+ * flashes move by the shift modulo one period. The ranges one period can
+ * take at the lowest and highest frequency are printed.
+ *
+ * Then the registers run in a tick level model of the timers as
+ * Strobe_HwInit sets them up: TIM3 upcounting in PWM1, OC1REF high while
+ * CNT < CCR1 and routed to TRGO; TIM1 (PSC 9, ARR 999) a gated slave on
+ * ITR2, CH1 in PWM2 with Strobe_CalcGatedCompare() of the brightness.
+ * The TRGO to ITR resynchronisation delays both gate edges alike and is
+ * left out. For frequencies on both sides of every PSC step and spread
+ * over the range, each duty and four brightnesses (5, 100, 750 and 1000
+ * of 1000 counts, the last clamped to 999), two periods are run:
+ *
+ *   - the gate period is (ARR+1)(PSC+1) clocks, the window CCR1(PSC+1);
+ *   - every LED pulse is on_counts TIM1 counts long, none is cut, the
+ *     number of pulses per flash is the window in PWM periods;
+ *   - TIM1 stops at CNT = 0 (prescaler at 0) when the gate closes and the
+ *     LED is off while it is closed.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -Wall -I006-stroboscope/Inc tools/strobe_timer_model.c \
+ *       006-stroboscope/Src/strobe_calc.c -lm -o strobe_timer_model && ./strobe_timer_model
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "strobe_calc.h"
+
+#define F_MIN_MHZ       153u
+#define F_MAX_MHZ   1000000u
+#define CLK_MHZ     ((uint64_t)STROBE_TIM_CLK_HZ * 1000u)   /* clocks x mHz per period */
+#define TIM1_DIV    (STROBE_TIM1_PSC + 1u)
+#define TIM1_TOP    (STROBE_TIM1_ARR + 1u)
+
+typedef struct { uint32_t num, den; } Duty_t;
+
+static const Duty_t   duty[]   = { { 5u, 100u }, { 50u, 100u }, { 1u, 25u }, { 1u, 200u } };
+static const uint32_t bright[] = { 5u, 100u, 750u, 1000u };
+
+#define N_DUTY    (sizeof(duty) / sizeof(duty[0]))
+#define N_BRIGHT  (sizeof(bright) / sizeof(bright[0]))
+
+static uint32_t failed;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        if (failed < 20u) printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+/* ---- register math, every mHz ------------------------------------------ */
+
+static double   worst_ppm, worst_ppm_old, worst_width_us;
+static uint32_t worst_f, worst_f_old;
+
+static void calc_one(uint32_t f, const Duty_t *d)
+{
+    Strobe_Timing_t t;
+    uint64_t div, pwm_ticks, per, err, req, win;
+    double   ppm;
+
+    Strobe_CalcTiming(f, d->num, d->den, &t);
+    div       = (uint64_t)t.psc + 1u;
+    pwm_ticks = STROBE_PWM_PERIOD_CLK / div;
+
+    check(STROBE_PWM_PERIOD_CLK % div == 0u, "PSC+1 divides the PWM period");
+    check(CLK_MHZ / (div * f) <= 65535u, "period fits 16-bit ARR");
+    if (div > 1u) {
+        uint64_t k = div - 1u;                  /* next smaller divisor */
+        while (STROBE_PWM_PERIOD_CLK % k != 0u) k--;
+        check(CLK_MHZ / (k * f) > 65535u, "no smaller prescaler fits ARR");
+    }
+    check(t.arr_lo >= 1u && (t.arr == t.arr_lo || t.arr == t.arr_lo + 1u), "ARR_lo <= ARR <= ARR_lo+1");
+
+    /* |(ARR+1)(PSC+1) - 1e11/f| <= (PSC+1)/2, in clocks x mHz */
+    per = ((uint64_t)t.arr + 1u) * div * f;
+    err = (per > CLK_MHZ) ? per - CLK_MHZ : CLK_MHZ - per;
+    check(2u * err <= div * f, "ARR is the nearest tick");
+    ppm = (double)err * 1e6 / (double)CLK_MHZ;
+    if (ppm > worst_ppm) { worst_ppm = ppm; worst_f = f; }
+
+    /* what a fixed 0.1 ms tick did */
+    {
+        uint64_t q = (CLK_MHZ / f + 5000u) / 10000u, e;
+        if (q < 2u) q = 2u;
+        per = q * 10000u * f;
+        e   = (per > CLK_MHZ) ? per - CLK_MHZ : CLK_MHZ - per;
+        ppm = (double)e * 1e6 / (double)CLK_MHZ;
+        if (ppm > worst_ppm_old) { worst_ppm_old = ppm; worst_f_old = f; }
+    }
+
+    /* the window, against duty x the ideal period (clocks x mHz x den) */
+    check(t.ccr % pwm_ticks == 0u, "window is whole PWM periods");
+    check(t.ccr >= pwm_ticks, "window is at least one PWM period");
+    check(t.ccr <= t.arr_lo, "window ends within ARR_lo");
+    req = CLK_MHZ * d->num;
+    win = (uint64_t)t.ccr * div * f * d->den;
+    if (req >= (uint64_t)STROBE_PWM_PERIOD_CLK * f * d->den) {
+        check(win <= req, "window not longer than asked");
+        check(req - win < (STROBE_PWM_PERIOD_CLK + div) * f * d->den,
+              "window short by less than a PWM period and a tick");
+        if ((double)(req - win) / ((double)f * d->den * 100.0) > worst_width_us)
+            worst_width_us = (double)(req - win) / ((double)f * d->den * 100.0);
+    } else {
+        check(t.ccr == pwm_ticks, "short window is one PWM period");
+    }
+}
+
+/* ---- dithering ------------------------------------------------------------ */
+
+#define DITHER_STEP      61u        /* every 61st mHz step is run...  */
+#define DITHER_PERIODS 4096u        /* ...for this many periods       */
+
+typedef unsigned __int128 u128;
+
+static double   worst_mean_ppm, worst_run_ppm;
+static uint32_t worst_run_f, dither_runs;
+
+/* mean period (ARR_lo + 1 + frac/2^32) x div against num/den clocks:
+ * never longer, and short by less than 2^-32 tick */
+static double dither_mean(const Strobe_Timing_t *t, uint64_t num, uint64_t den)
+{
+    uint64_t div  = (uint64_t)t->psc + 1u;
+    u128     mean = ((u128)((uint64_t)t->arr_lo + 1u) << 32) + t->frac;
+    u128     ideal = (u128)num << 32, got = mean * div * den;
+
+    check(got <= ideal, "dithered mean not longer than ideal");
+    check(ideal - got < (u128)div * den, "dithered mean short by < 2^-32 tick");
+    return (double)(ideal - got) * 1e6 / (double)ideal;
+}
+
+/* the update ISR: ARR_lo or ARR_lo+1 per period */
+static void dither_run(uint32_t f)
+{
+    Strobe_Timing_t t;
+    uint32_t acc = 0u;
+    uint64_t div, sum = 0u, carries = 0u, err;
+    double   ppm;
+
+    Strobe_CalcTiming(f, 1u, 2u, &t);
+    div = (uint64_t)t.psc + 1u;
+
+    for (uint32_t k = 1u; k <= DITHER_PERIODS; k++) {
+        uint16_t arr = (t.frac != 0u) ? Strobe_DitherARR(&t, &acc) : t.arr;
+        int64_t  lag;
+
+        check(arr == t.arr_lo || (t.frac != 0u && arr == t.arr_lo + 1u), "ARR in {ARR_lo, ARR_lo+1}");
+        check(t.frac != 0u || arr == t.arr, "no fraction: nearest tick, no ISR");
+        sum     += (uint64_t)arr + 1u;
+        carries += (arr != t.arr_lo);
+        /* k periods against k x mean, in 2^-32 ticks: within one tick */
+        lag = (int64_t)((carries << 32) - (uint64_t)k * t.frac);
+        check(t.frac == 0u || (lag > -(int64_t)((uint64_t)1u << 32) && lag <= 0),
+              "dithered time within one tick of the mean");
+    }
+
+    /* frequency error over the run */
+    sum *= div * f;
+    err  = (sum > DITHER_PERIODS * CLK_MHZ) ? sum - DITHER_PERIODS * CLK_MHZ
+                                            : DITHER_PERIODS * CLK_MHZ - sum;
+    if (t.frac != 0u)
+        check(((u128)err << 32) < (u128)div * f * (((u128)1u << 32) + DITHER_PERIODS),
+              "run of N periods within a tick (+ N x 2^-32) of N ideal periods");
+    ppm = (double)err * 1e6 / ((double)DITHER_PERIODS * (double)CLK_MHZ);
+    if (t.frac != 0u && ppm > worst_run_ppm) { worst_run_ppm = ppm; worst_run_f = f; }
+    dither_runs++;
+}
+
+/* ---- phase shift ---------------------------------------------------------- */
+
+static uint32_t phase_worst_periods, long_worst_periods, phase_cases;
+
+/* the update ISR: pending ticks folded into ARR period by period.
+ * returns the periods taken, *moved the ticks the flashes moved by */
+static uint32_t phase_run(const Strobe_Timing_t *t, int32_t ticks, int dither, int64_t *moved)
+{
+    uint32_t acc = 0u, n = 0u;
+    int32_t  pending = ticks;
+
+    *moved = 0;
+    while (pending != 0 && n < 64u) {
+        uint16_t base = (dither && t->frac != 0u) ? Strobe_DitherARR(t, &acc) : t->arr;
+        uint16_t arr  = Strobe_PhaseARR(base, t->ccr, &pending);
+
+        check(arr >= t->ccr, "shortened period keeps the window");
+        *moved += (int32_t)arr - (int32_t)base;
+        n++;
+    }
+    check(pending == 0, "phase shift ends");
+    return n;
+}
+
+static void phase_one(uint32_t f, const Duty_t *d)
+{
+    Strobe_Timing_t t;
+    int32_t         period, half;
+
+    Strobe_CalcTiming(f, d->num, d->den, &t);
+    period = (int32_t)t.arr + 1;
+    half   = period / 2;
+
+    check(Strobe_CalcPhaseTicks(&t, 360) == 0 && Strobe_CalcPhaseTicks(&t, -360) == 0 &&
+          Strobe_CalcPhaseTicks(&t, 0) == 0, "+-360 deg is no shift");
+
+    for (int32_t deg = -720; deg <= 720; deg++) {
+        int32_t ticks = Strobe_CalcPhaseTicks(&t, deg);
+        int32_t m     = ((deg % 360) + 360) % 360;
+        int64_t moved, exact2, e;
+
+        check(ticks == Strobe_CalcPhaseTicks(&t, deg + 360) &&
+              ticks == Strobe_CalcPhaseTicks(&t, deg - 360), "deg wraps at 360");
+        check(ticks >= -half && ticks <= half, "folded into +-period/2");
+        /* 720 x (ticks - period x m / 360), modulo the period */
+        exact2 = (int64_t)ticks * 720 - (int64_t)period * m * 2;
+        e      = ((exact2 % ((int64_t)period * 720)) + (int64_t)period * 720) % ((int64_t)period * 720);
+        if (e > (int64_t)period * 360) e -= (int64_t)period * 720;
+        check(e >= -360 && e <= 360, "within half a tick of deg/360 of the period");
+
+        if (deg < 0 || deg >= 360) continue;
+        for (int dither = 0; dither < 2; dither++) {
+            uint32_t n = phase_run(&t, ticks, dither, &moved);
+            check((moved - ticks) % period == 0 ||
+                  (dither && llabs((moved - ticks) % period) <= 1) ||
+                  (dither && llabs((moved - ticks) % period) >= period - 1),
+                  "flashes move by the shift modulo a period");
+            if (!dither && n > phase_worst_periods) phase_worst_periods = n;
+            phase_cases++;
+        }
+    }
+
+    /* more than one period queued */
+    for (int32_t k = -3; k <= 3; k++) {
+        for (int32_t x = -half; x <= half; x += (half / 7 > 0) ? half / 7 : 1) {
+            int32_t ticks = k * period + x;
+            int64_t moved;
+
+            uint32_t n = phase_run(&t, ticks, 0, &moved);
+            if (n > long_worst_periods) long_worst_periods = n;
+            check((moved - ticks) % period == 0, "long shift moves by itself modulo a period");
+            check(llabs(moved) < period, "long shift drops the whole periods");
+            phase_cases++;
+        }
+    }
+}
+
+/* shifts one period takes at a frequency and duty */
+static void phase_range(uint32_t f, const Duty_t *d)
+{
+    Strobe_Timing_t t;
+    int32_t         one = 0, two = 0;
+    int64_t         moved;
+
+    Strobe_CalcTiming(f, d->num, d->den, &t);
+    for (int32_t deg = 1; deg < 360; deg++) {
+        int32_t  ticks = Strobe_CalcPhaseTicks(&t, deg);
+        uint32_t n     = phase_run(&t, ticks, 0, &moved);
+        int32_t  up    = 65535 - (int32_t)t.arr, down = (int32_t)t.arr - (int32_t)t.ccr;
+
+        /* one period iff the shift, or the other way round, fits in ARR */
+        check((n == 1u) == ((ticks <= up && ticks >= -down) ||
+                            (ticks - (int32_t)t.arr - 1 >= -down) ||
+                            (ticks + (int32_t)t.arr + 1 <= up)),
+              "single period when the shift fits in ARR");
+        if (n == 1u) one++;
+        if (n <= 2u) two++;
+    }
+    printf("  %8u mHz, duty %2u/%-3u  up %5u down %5u ticks: %3d of 359 deg in one period, %3d in two\n",
+           f, d->num, d->den, 65535u - t.arr, (uint32_t)t.arr - t.ccr, one, two);
+}
+
+/* ---- tick level timer model --------------------------------------------- */
+
+typedef struct {
+    /* TIM1 gated slave, CH1 PWM2 */
+    uint32_t cnt1, psc1, cmp;
+    uint32_t pulse;             /* clocks of the LED pulse running, 0 = off */
+    uint32_t pulses, bad_pulses;
+    uint64_t on_clk;
+} Tim1_t;
+
+/* n clocks with the gate open */
+static void tim1_run(Tim1_t *m, uint64_t n)
+{
+    uint32_t on_len = (TIM1_TOP - m->cmp) * TIM1_DIV;
+
+    while (n > 0u) {
+        uint64_t take;
+
+        /* whole PWM periods from CNT = 0 */
+        if (m->cnt1 == 0u && m->psc1 == 0u && n >= STROBE_PWM_PERIOD_CLK) {
+            uint64_t k = n / STROBE_PWM_PERIOD_CLK;
+            m->pulses += (uint32_t)k;
+            m->on_clk += k * on_len;
+            n -= k * STROBE_PWM_PERIOD_CLK;
+            continue;
+        }
+
+        if (m->psc1 == 0u && n >= TIM1_DIV) {
+            /* whole counts, up to the update event */
+            uint32_t c  = (uint32_t)(n / TIM1_DIV), lit;
+            uint32_t lo = (m->cnt1 > m->cmp) ? m->cnt1 : m->cmp;
+            if (c > TIM1_TOP - m->cnt1) c = TIM1_TOP - m->cnt1;
+            lit = (m->cnt1 + c > lo) ? (m->cnt1 + c - lo) * TIM1_DIV : 0u;
+            m->pulse  += lit;
+            m->on_clk += lit;
+            m->cnt1   += c - 1u;                    /* the last count below */
+            m->psc1    = TIM1_DIV;
+            n         -= (uint64_t)c * TIM1_DIV;
+        } else {
+            take = TIM1_DIV - m->psc1;
+            if (take > n) take = n;
+            if (m->cnt1 >= m->cmp) { m->pulse += (uint32_t)take; m->on_clk += take; }
+            m->psc1 += (uint32_t)take;
+            n       -= take;
+            if (m->psc1 < TIM1_DIV) continue;
+        }
+
+        m->psc1 = 0u;
+        if (++m->cnt1 == TIM1_TOP) {            /* update: PWM2 goes inactive */
+            m->cnt1 = 0u;
+            if (m->pulse != 0u) {
+                m->pulses++;
+                if (m->pulse != on_len) m->bad_pulses++;
+            }
+            m->pulse = 0u;
+        }
+    }
+}
+
+static uint32_t sim_settings, sim_flashes;
+static uint64_t sim_pulses;
+
+static void gate_one(uint32_t f, const Duty_t *d, uint32_t on)
+{
+    Strobe_Timing_t t;
+    Tim1_t          m = { 0 };
+    uint64_t        clk = 0u, rise = 0u, last_rise = 0u;
+    uint32_t        div, lit;
+
+    Strobe_CalcTiming(f, d->num, d->den, &t);
+    div   = (uint32_t)t.psc + 1u;
+    m.cmp = Strobe_CalcGatedCompare(on);
+    lit   = TIM1_TOP - m.cmp;
+    check(m.cmp >= 1u && m.cmp <= STROBE_TIM1_ARR, "compare inside the TIM1 period");
+    check(lit == ((on < 1u) ? 1u : (on > STROBE_TIM1_ARR) ? STROBE_TIM1_ARR : on),
+          "PWM2 lights on_counts, clamped to 1..ARR");
+
+    for (uint32_t p = 0u; p < 2u; p++) {
+        uint32_t pulses0 = m.pulses;
+        uint64_t on0     = m.on_clk;
+
+        for (uint32_t cnt = 0u; cnt <= t.arr; cnt++) {
+            int gate = cnt < t.ccr;                     /* PWM1: OC1REF = TRGO */
+
+            if (cnt == 0u) { last_rise = rise; rise = clk; }
+            if (cnt == t.ccr) {                         /* gate closes */
+                check(clk - rise == (uint64_t)t.ccr * div, "window is CCR1 ticks");
+                check(m.cnt1 == 0u && m.psc1 == 0u, "TIM1 parked at CNT = 0");
+                check(m.pulse == 0u, "no LED pulse cut by the gate");
+                check(m.pulses - pulses0 == (uint64_t)t.ccr * div / STROBE_PWM_PERIOD_CLK,
+                      "one LED pulse per PWM period of the window");
+                check(m.on_clk - on0 == (uint64_t)(m.pulses - pulses0) * lit * TIM1_DIV,
+                      "LED on for on_counts per pulse");
+            }
+            if (gate) {
+                tim1_run(&m, div);
+                clk += div;
+                continue;
+            }
+            /* closed: TIM1 holds, nothing changes up to the update event */
+            check(m.cnt1 == 0u && m.cnt1 < m.cmp, "LED off with the gate closed");
+            clk += ((uint64_t)t.arr + 1u - cnt) * div;
+            break;
+        }
+        if (p == 1u)
+            check(rise - last_rise == ((uint64_t)t.arr + 1u) * div, "gate period is (ARR+1)(PSC+1)");
+        sim_flashes++;
+    }
+    check(m.bad_pulses == 0u, "every LED pulse whole");
+    sim_pulses += m.pulses;
+    sim_settings++;
+}
+
+int main(void)
+{
+    uint32_t sample[512];
+    uint32_t n_sample = 0u;
+    uint32_t prev_psc = 0xFFFFFFFFu, steps = 0u;
+
+    for (uint32_t f = F_MIN_MHZ; f <= F_MAX_MHZ; f++) {
+        Strobe_Timing_t t;
+
+        Strobe_CalcTiming(f, 1u, 2u, &t);
+        if (t.psc != prev_psc) {
+            /* both sides of a PSC step go to the timer model */
+            if (prev_psc != 0xFFFFFFFFu && n_sample + 2u <= 512u) {
+                sample[n_sample++] = f - 1u;
+                sample[n_sample++] = f;
+            }
+            prev_psc = t.psc;
+            steps++;
+        }
+        for (uint32_t i = 0u; i < N_DUTY; i++) calc_one(f, &duty[i]);
+
+        /* dithered mean, from the frequency and from a tach period */
+        {
+            uint64_t q8 = (CLK_MHZ * 256u + f / 2u) / f;
+            double   ppm = dither_mean(&t, CLK_MHZ, f);
+            if (ppm > worst_mean_ppm) worst_mean_ppm = ppm;
+
+            Strobe_CalcTimingPeriod(q8, 1u, 2u, &t);
+            ppm = dither_mean(&t, q8, 256u);
+            if (ppm > worst_mean_ppm) worst_mean_ppm = ppm;
+        }
+        if ((f - F_MIN_MHZ) % DITHER_STEP == 0u || f == F_MAX_MHZ) dither_run(f);
+    }
+
+    printf("every mHz step %u.%03u - %u Hz, %u prescalers:\n", F_MIN_MHZ / 1000u,
+           F_MIN_MHZ % 1000u, F_MAX_MHZ / 1000u, steps);
+    printf("  worst period error, PSC = 9999        %9.1f ppm at %u mHz\n", worst_ppm_old, worst_f_old);
+    printf("  worst period error, PSC per frequency %9.1f ppm at %u mHz\n", worst_ppm, worst_f);
+    printf("  worst mean period error, dithered     %9.1e ppm\n", worst_mean_ppm);
+    printf("  worst error over %u dithered periods %7.4f ppm at %u mHz (%u runs)\n",
+           DITHER_PERIODS, worst_run_ppm, worst_run_f, dither_runs);
+    printf("  worst flash width error               %9.1f us (rounded down to 0.1 ms)\n",
+           worst_width_us);
+
+    /* log spaced over the range as well */
+    for (uint32_t i = 0u; i <= 100u && n_sample < 512u; i++) {
+        double k = (double)i / 100.0;
+        sample[n_sample++] = (uint32_t)((double)F_MIN_MHZ *
+                             pow((double)F_MAX_MHZ / F_MIN_MHZ, k) + 0.5);
+    }
+    if (sample[n_sample - 1u] > F_MAX_MHZ) sample[n_sample - 1u] = F_MAX_MHZ;
+
+    printf("phase shift, single period at the ends of the range:\n");
+    for (uint32_t i = 0u; i < N_DUTY; i++) {
+        phase_range(F_MIN_MHZ, &duty[i]);
+        phase_range(F_MAX_MHZ, &duty[i]);
+    }
+    for (uint32_t s = 0u; s < n_sample; s++)
+        for (uint32_t i = 0u; i < N_DUTY; i++)
+            phase_one(sample[s], &duty[i]);
+    printf("  %u shifts: 1..359 deg done within %u periods, up to 3 periods queued within %u\n",
+           phase_cases, phase_worst_periods, long_worst_periods);
+
+    for (uint32_t s = 0u; s < n_sample; s++)
+        for (uint32_t i = 0u; i < N_DUTY; i++)
+            for (uint32_t b = 0u; b < N_BRIGHT; b++)
+                gate_one(sample[s], &duty[i], bright[b]);
+
+    printf("gate model: %u settings, %u flashes, %llu LED pulses\n",
+           sim_settings, sim_flashes, (unsigned long long)sim_pulses);
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
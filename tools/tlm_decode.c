@@ -0,0 +1,190 @@
+/*
+ * tlm_decode.c - telemetry recorder / decoder for 005-scale-ADS1220
+ *
+ * Reads the COBS framed telemetry (see App/Telemetry/telemetry.h) from
+ * a serial port, a file or stdin, checks every frame's crc and seq, and
+ * writes one CSV line per record:
+ *
+ *   S,seq,index,time,code,channel           one per ADC sample
+ *   E,seq,time_ms,id,arg                    event
+ *   T,seq,time_ms,samples,sps,acq_dropped,acq_overruns,tlm_dropped,
+ *     weight_x10,filtered,temp,stable,mode  stats, once a second
+ *   R,seq,text                              answer line to a command
+ *
+ * -c sends a command line to the port before reading (repeatable, see
+ * the Commands section of the readme), e.g. -c "cal point 500".
+ * time is the raw DWT count (100 MHz, wraps every 43 s). With -w the
+ * raw stream is also recorded, to be decoded again later. A summary
+ * (frames, bad frames, frames and samples lost) goes to stderr at the
+ * end of the input, or on Ctrl-C.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/Telemetry -I005-scale-ADS1220/App/CfgLog \
+ *       tools/tlm_decode.c 005-scale-ADS1220/App/Telemetry/telemetry.c \
+ *       005-scale-ADS1220/App/CfgLog/cfg_log.c -o tlm_decode
+ *   ./tlm_decode [-b 921600] [-w raw.bin] [-c "get"] /dev/ttyUSB0 > telemetry.csv
+ *   ./tlm_decode raw.bin > telemetry.csv
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+static volatile sig_atomic_t stop;
+
+static void on_sigint(int sig) { (void)sig; stop = 1; }
+
+static uint32_t le(const uint8_t *p, unsigned n)
+{
+    uint32_t v = 0;
+    while (n--) v = (v << 8) | p[n];
+    return v;
+}
+
+static speed_t baud_flag(long b)
+{
+    switch (b) {
+    case 115200:  return B115200;
+    case 230400:  return B230400;
+    case 460800:  return B460800;
+    case 921600:  return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    default:      return 0;
+    }
+}
+
+static int open_input(const char *path, long baud, int rw)
+{
+    int fd = strcmp(path, "-") ? open(path, (rw ? O_RDWR : O_RDONLY) | O_NOCTTY) : 0;
+
+    if (fd < 0) { perror(path); exit(1); }
+    if (isatty(fd)) {
+        struct termios t;
+        speed_t        sp = baud_flag(baud);
+        if (!sp) { fprintf(stderr, "baud rate %ld not supported\n", baud); exit(1); }
+        tcgetattr(fd, &t);
+        cfmakeraw(&t);
+        cfsetispeed(&t, sp);
+        cfsetospeed(&t, sp);
+        t.c_cc[VMIN]  = 1;
+        t.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &t);
+        tcflush(fd, TCIFLUSH);
+    }
+    return fd;
+}
+
+typedef struct {
+    uint32_t frames, bad, seq_lost, samples, samples_lost;
+    int      seq_prev;
+    int64_t  idx_next;
+} Totals_t;
+
+static void record(const uint8_t *f, int n, Totals_t *t)
+{
+    uint16_t seq = (uint16_t)le(f + 1, 2);
+    const uint8_t *r = f + TLM_HDR;
+
+    t->frames++;
+    if (t->seq_prev >= 0) t->seq_lost += (uint16_t)(seq - t->seq_prev - 1);
+    t->seq_prev = seq;
+
+    switch (f[0]) {
+    case TLM_T_SAMPLES: {
+        uint32_t idx = le(r, 4), cnt = r[4];
+        if (n != (int)(TLM_HDR + 5u + cnt * TLM_SAMPLE_SIZE)) break;
+        if (t->idx_next >= 0 && idx > (uint32_t)t->idx_next) t->samples_lost += idx - (uint32_t)t->idx_next;
+        for (uint32_t k = 0; k < cnt; k++) {
+            const uint8_t *s = r + 5 + k * TLM_SAMPLE_SIZE;
+            printf("S,%u,%u,%u,%d,%u\n", seq, idx + k, le(s, 4), (int32_t)(le(s + 4, 3) << 8) >> 8, s[7]);
+        }
+        t->samples += cnt;
+        t->idx_next = (int64_t)idx + cnt;
+        break;
+    }
+    case TLM_T_EVENT:
+        if (n == (int)TLM_HDR + 9)
+            printf("E,%u,%u,%u,%d\n", seq, le(r, 4), r[4], (int32_t)le(r + 5, 4));
+        break;
+    case TLM_T_REPLY:
+        printf("R,%u,%.*s\n", seq, n - (int)TLM_HDR, (const char *)r);
+        break;
+    case TLM_T_STATS:
+        if (n == (int)(TLM_HDR + TLM_STATS_SIZE))
+            printf("T,%u,%u,%u,%u,%u,%u,%u,%d,%d,%d,%u,%u\n", seq, le(r, 4), le(r + 4, 4),
+                   le(r + 8, 2), le(r + 10, 2), le(r + 12, 2), le(r + 14, 2),
+                   (int32_t)le(r + 16, 4), (int32_t)le(r + 20, 4), (int16_t)le(r + 24, 2), r[26], r[27]);
+        break;
+    default:
+        fprintf(stderr, "frame %u: unknown type 0x%02x\n", seq, f[0]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t frame[1024], dec[1024];
+    uint8_t  buf[4096];
+    uint32_t fn = 0;
+    long     baud = 921600;
+    FILE    *raw = NULL;
+    int      opt, fd, ncmd = 0;
+    char    *cmd[16];
+    Totals_t t = { 0 };
+
+    while ((opt = getopt(argc, argv, "b:w:c:")) != -1) {
+        if (opt == 'b') baud = strtol(optarg, NULL, 10);
+        else if (opt == 'c' && ncmd < 16) cmd[ncmd++] = optarg;
+        else if (opt == 'w') {
+            raw = fopen(optarg, "wb");
+            if (!raw) { perror(optarg); return 1; }
+        } else {
+            fprintf(stderr, "usage: %s [-b baud] [-w raw.bin] [-c cmd] <tty|file|->\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-b baud] [-w raw.bin] [-c cmd] <tty|file|->\n", argv[0]);
+        return 1;
+    }
+    fd = open_input(argv[optind], baud, ncmd > 0);
+    for (int i = 0; i < ncmd; i++) {
+        if (write(fd, cmd[i], strlen(cmd[i])) < 0 || write(fd, "\n", 1) < 0) { perror("write"); return 1; }
+    }
+    signal(SIGINT, on_sigint);
+    t.seq_prev = -1;
+    t.idx_next = -1;
+
+    while (!stop) {
+        ssize_t k = read(fd, buf, sizeof(buf));
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) break;
+        if (raw) fwrite(buf, 1, (size_t)k, raw);
+        for (ssize_t i = 0; i < k; i++) {
+            if (buf[i] != 0) {
+                if (fn < sizeof(frame)) frame[fn++] = buf[i];
+                continue;
+            }
+            /* the first frame of a live port may be cut: a bad crc */
+            if (fn) {
+                int n = Tlm_Unframe(frame, (uint16_t)(fn < sizeof(frame) ? fn : 0), dec, sizeof(dec));
+                if (n < 0) t.bad++;
+                else       record(dec, n, &t);
+            }
+            fn = 0;
+        }
+    }
+    if (raw) fclose(raw);
+    fflush(stdout);
+    fprintf(stderr, "%u frames, %u bad, %u lost (seq); %u samples, %u lost (index)\n",
+            t.frames, t.bad, t.seq_lost, t.samples, t.samples_lost);
+    return 0;
+}
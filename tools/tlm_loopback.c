@@ -0,0 +1,361 @@
+/*
+ * tlm_loopback.c - end-to-end test of the 005-scale-ADS1220 telemetry
+ *
+ * Runs the firmware's telemetry.c as main.c drives it, against an
+ * emulated UART TX DMA, and sends the bytes through a pseudo terminal
+ * (default) or into a file; the receiving side splits the stream on 0x00,
+ * decodes it with Tlm_Unframe and checks every record against what was
+ * sent.
+ *
+ * The firmware side, in emulated time:
+ *   - the ADC at 2000 SPS (turbo), DRDY time stamps on the 100 MHz DWT,
+ *   - a main loop pass every 1 ms that takes up to 16 samples from the
+ *     acquisition ring and sends them as one samples frame, stalled for
+ *     25 ms every 200 ms by the display update (the ring catches up),
+ *   - a stats frame every second and an event every 0.7 s,
+ *   - the UART: one byte per 10 bit times, the next DMA span starts when
+ *     the last one completes (Tlm_TxDone from the "interrupt").
+ *
+ * It runs 60 s of data at 921600 baud, where nothing may be lost, and at
+ * 230400 and 115200 baud, where the ring overflows: there every dropped
+ * frame must show as a seq gap and every lost sample as an index gap,
+ * and everything received must still be exact. Then it times the
+ * encoder on the host.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/Telemetry -I005-scale-ADS1220/App/CfgLog \
+ *       tools/tlm_loopback.c 005-scale-ADS1220/App/Telemetry/telemetry.c \
+ *       005-scale-ADS1220/App/CfgLog/cfg_log.c -lutil -o tlm_loopback \
+ *       && ./tlm_loopback [stream.bin]
+ * with a file name the 921600 baud stream goes to that file instead of
+ * the pty; tlm_decode turns it into CSV.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+#define SPS         2000u
+#define SECONDS     60u
+#define TICKS_US    100u            /* DWT cycles per us                   */
+#define BATCH       16u
+#define LOOP_US     1000u
+#define STALL_EVERY 200000u
+#define STALL_US    25000u
+
+/* ---- the test pattern, known to both sides ---- */
+
+static uint32_t mix(uint32_t x)
+{
+    x ^= x >> 16; x *= 0x7FEB352Du;
+    x ^= x >> 15; x *= 0x846CA68Bu;
+    return x ^ (x >> 16);
+}
+
+static uint32_t sample_time(uint32_t i)
+{
+    return i * (1000000u / SPS) * TICKS_US + mix(i) % 300u;   /* +- jitter */
+}
+
+static int32_t sample_code(uint32_t i)
+{
+    int32_t c = 150000 + (int32_t)(mix(i ^ 0x5A5A5A5Au) % 4001u) - 2000;
+    if ((i / 20000u) & 1u) c += 172400;                           /* 100 g on */
+    if ((i % 7919u) == 0u) c = (i & 1u) ? 8388607 : -8388608;       /* rails    */
+    return c;
+}
+
+/* ---- firmware side ---- */
+
+static Tlm_Handle_t htlm;
+static int          out_fd;
+static uint64_t     now_us, tx_done_us;
+static const uint8_t *tx_ptr;
+static uint16_t     tx_len;
+static uint32_t     baud;
+
+static int uart_tx_start(const uint8_t *data, uint16_t len)
+{
+    tx_ptr     = data;
+    tx_len     = len;
+    tx_done_us = now_us + (uint64_t)len * 10u * 1000000u / baud;
+    return 0;
+}
+
+static void write_all(int fd, const uint8_t *p, size_t n)
+{
+    while (n) {
+        ssize_t k = write(fd, p, n);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            perror("write");
+            exit(1);
+        }
+        p += k;
+        n -= (size_t)k;
+    }
+}
+
+/* run the UART up to time t */
+static void uart_run(uint64_t t)
+{
+    while (htlm.busy && tx_done_us <= t) {
+        now_us = tx_done_us;
+        write_all(out_fd, tx_ptr, tx_len);
+        Tlm_TxDone(&htlm);          /* may start the next span at now_us */
+    }
+}
+
+typedef struct {
+    uint32_t sent_samples, frames, dropped, ring_max;
+} Sent_t;
+
+static void firmware(uint32_t rate, Sent_t *r)
+{
+    uint64_t end_us = (uint64_t)SECONDS * 1000000u;
+    uint32_t next = 0, events = 0, stats_s = 1;
+    uint64_t loop_us;
+
+    memset(&htlm, 0, sizeof(htlm));
+    htlm.tx_start = uart_tx_start;
+    Tlm_Init(&htlm);
+    baud   = rate;
+    now_us = 0;
+    *r = (Sent_t){ 0 };
+
+    for (loop_us = 0; loop_us < end_us; loop_us += LOOP_US) {
+        uint32_t avail;
+
+        if (loop_us % STALL_EVERY == 0 && loop_us) loop_us += STALL_US;   /* display */
+        uart_run(loop_us);
+        now_us = loop_us;
+
+        /* samples whose DRDY came before now, in batches of 16 */
+        avail = (uint32_t)((loop_us * SPS) / 1000000u);
+        while (next < avail) {
+            uint32_t n = avail - next;
+            if (n > BATCH) n = BATCH;
+            if (Tlm_Begin(&htlm, TLM_T_SAMPLES, (uint16_t)(5u + n * TLM_SAMPLE_SIZE))) {
+                uint8_t cnt = (uint8_t)n;
+                Tlm_PutU32(&htlm, next);
+                Tlm_Put(&htlm, &cnt, 1);
+                for (uint32_t k = 0; k < n; k++)
+                    Tlm_PutSample(&htlm, sample_time(next + k), sample_code(next + k), (uint8_t)((next + k) & 3u));
+                Tlm_End(&htlm);
+                r->sent_samples += n;
+            }
+            next += n;
+        }
+        if (loop_us >= 700000u * (events + 1u)) {
+            Tlm_Event(&htlm, (uint32_t)(loop_us / 1000u), (uint8_t)(events % 5u), -(int32_t)events * 1000);
+            events++;
+        }
+        if (loop_us >= 1000000u * stats_s) {
+            Tlm_Stats_t s = { 0 };
+            s.time_ms     = (uint32_t)(loop_us / 1000u);
+            s.samples     = next;
+            s.sps         = SPS;
+            s.tlm_dropped = (uint16_t)htlm.dropped;
+            s.weight_x10  = -12345;
+            s.filtered    = sample_code(next);
+            s.temp        = -160;
+            s.stable      = 1;
+            s.mode        = 2;
+            Tlm_Stats(&htlm, &s);
+            stats_s++;
+        }
+        if (Tlm_Pending(&htlm) > r->ring_max) r->ring_max = Tlm_Pending(&htlm);
+    }
+    /* once drained, one more frame shows the drops at the very end */
+    uart_run(UINT64_MAX);
+    Tlm_Event(&htlm, (uint32_t)(loop_us / 1000u), (uint8_t)(events % 5u), -(int32_t)events * 1000);
+    uart_run(UINT64_MAX);
+    r->frames  = htlm.frames;
+    r->dropped = htlm.dropped;
+}
+
+/* ---- receiving side ---- */
+
+typedef struct {
+    uint32_t frames, bad, seq_gaps, samples, sample_gaps, idx_end, events, stats, wrong;
+    uint64_t bytes;
+} Got_t;
+
+static uint32_t le(const uint8_t *p, unsigned n)
+{
+    uint32_t v = 0;
+    while (n--) v = (v << 8) | p[n];
+    return v;
+}
+
+static void check_frame(const uint8_t *f, int n, Got_t *g, int *seq_prev, uint32_t *idx_next)
+{
+    uint16_t seq = (uint16_t)le(f + 1, 2);
+
+    g->frames++;
+    if (*seq_prev >= 0 && seq != (uint16_t)(*seq_prev + 1)) g->seq_gaps += (uint16_t)(seq - *seq_prev - 1);
+    *seq_prev = seq;
+
+    switch (f[0]) {
+    case TLM_T_SAMPLES: {
+        uint32_t idx = le(f + 3, 4), cnt = f[7];
+        if (n != (int)(8u + cnt * TLM_SAMPLE_SIZE)) { g->wrong++; break; }
+        if (idx != *idx_next) g->sample_gaps += idx - *idx_next;
+        for (uint32_t k = 0; k < cnt; k++) {
+            const uint8_t *s = f + 8 + k * TLM_SAMPLE_SIZE;
+            int32_t code = (int32_t)(le(s + 4, 3) << 8) >> 8;
+            if (le(s, 4) != sample_time(idx + k) || code != sample_code(idx + k) || s[7] != ((idx + k) & 3u))
+                g->wrong++;
+        }
+        g->samples += cnt;
+        *idx_next = idx + cnt;
+        break;
+    }
+    case TLM_T_EVENT:
+        /* id = number % 5, arg = -number * 1000 */
+        if (n != 3 + 9 || (uint32_t)(-(int32_t)le(f + 8, 4) / 1000) % 5u != f[7]) g->wrong++;
+        g->events++;
+        break;
+    case TLM_T_STATS:
+        if (n != 3 + (int)TLM_STATS_SIZE || (int32_t)le(f + 19, 4) != -12345 || (int16_t)le(f + 27, 2) != -160)
+            g->wrong++;
+        g->stats++;
+        break;
+    default:
+        g->wrong++;
+    }
+}
+
+/* until EOF, or until the line stays quiet for 0.5 s (pty) */
+static void receive(int fd, Got_t *g)
+{
+    static uint8_t frame[1024], dec[1024];
+    uint8_t  buf[4096];
+    uint32_t fn = 0, idx_next = 0;
+    int      seq_prev = -1;
+    ssize_t  k;
+
+    *g = (Got_t){ 0 };
+    for (;;) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        if (poll(&p, 1, 500) <= 0) break;
+        k = read(fd, buf, sizeof(buf));
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) break;
+        g->bytes += (uint64_t)k;
+        for (ssize_t i = 0; i < k; i++) {
+            if (buf[i] != 0) {
+                if (fn < sizeof(frame)) frame[fn++] = buf[i];
+                continue;
+            }
+            if (fn) {
+                int n = Tlm_Unframe(frame, (uint16_t)fn, dec, sizeof(dec));
+                if (n < 0) g->bad++;
+                else       check_frame(dec, n, g, &seq_prev, &idx_next);
+            }
+            fn = 0;
+        }
+    }
+    g->idx_end = idx_next;
+}
+
+/* ---- driver ---- */
+
+static int run(uint32_t rate, const char *file)
+{
+    Sent_t s;
+    Got_t  g;
+    int    ok;
+
+    if (file) {
+        out_fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out_fd < 0) { perror(file); exit(1); }
+        firmware(rate, &s);
+        close(out_fd);
+        out_fd = open(file, O_RDONLY);
+        receive(out_fd, &g);
+        close(out_fd);
+    } else {
+        int            master, slave, pipefd[2];
+        struct termios raw;
+        pid_t          pid;
+
+        memset(&raw, 0, sizeof(raw));
+        cfmakeraw(&raw);
+        if (openpty(&master, &slave, NULL, &raw, NULL) < 0 || pipe(pipefd) < 0) { perror("openpty"); exit(1); }
+        pid = fork();
+        if (pid == 0) {
+            close(master);
+            close(pipefd[0]);
+            receive(slave, &g);
+            write_all(pipefd[1], (const uint8_t *)&g, sizeof(g));
+            _exit(0);
+        }
+        close(slave);
+        close(pipefd[1]);
+        out_fd = master;
+        firmware(rate, &s);
+        /* the reader stops once the line is quiet */
+        if (read(pipefd[0], &g, sizeof(g)) != (ssize_t)sizeof(g)) { printf("reader failed\n"); exit(1); }
+        waitpid(pid, NULL, 0);
+        close(master);
+        close(pipefd[0]);
+    }
+
+    ok = g.bad == 0 && g.wrong == 0 && g.frames == s.frames && g.seq_gaps == s.dropped &&
+         g.samples == s.sent_samples && g.samples + g.sample_gaps == g.idx_end;
+    printf("%7u baud  %6.1f KB/s  %5u frames  %5u dropped / %5u seq gaps  %7u samples  %6u missing  "
+           "ring %4u B  %s\n",
+           rate, g.bytes / 1024.0 / SECONDS, g.frames, s.dropped, g.seq_gaps, g.samples,
+           SPS * SECONDS - SPS / 1000u - g.samples,
+           s.ring_max, ok && (rate < 921600u || (s.dropped == 0 && g.sample_gaps == 0)) ? "ok" : "FAIL");
+    return ok;
+}
+
+static double ns_per_sample(void)
+{
+    struct timespec a, e;
+    const uint32_t  N = 2000000u;
+
+    memset(&htlm, 0, sizeof(htlm));
+    htlm.tx_start = uart_tx_start;
+    Tlm_Init(&htlm);
+    baud = 921600u;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (uint32_t i = 0; i < N; i += BATCH) {
+        uint8_t cnt = BATCH;
+        Tlm_Begin(&htlm, TLM_T_SAMPLES, 5u + BATCH * TLM_SAMPLE_SIZE);
+        Tlm_PutU32(&htlm, i);
+        Tlm_Put(&htlm, &cnt, 1);
+        for (uint32_t k = 0; k < BATCH; k++) Tlm_PutSample(&htlm, i * 5000u, (int32_t)(i * 77u), 0);
+        Tlm_End(&htlm);
+        htlm.tail = htlm.head;              /* sent at once */
+        htlm.busy = 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &e);
+    return ((e.tv_sec - a.tv_sec) * 1e9 + (e.tv_nsec - a.tv_nsec)) / (double)N;
+}
+
+int main(int argc, char **argv)
+{
+    int ok = 1;
+
+    printf("%u SPS for %u s, %u samples per frame at most, %s\n", SPS, SECONDS, BATCH,
+           argc > 1 ? argv[1] : "through a pty");
+    ok &= run(921600u, argc > 1 ? argv[1] : NULL);
+    ok &= run(230400u, NULL);
+    ok &= run(115200u, NULL);
+    printf("host time per sample (frame of %u): %.1f ns\n", BATCH, ns_per_sample());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,371 @@
+/*
+ * trace_bench.c - deferred binary logging on the host (App/Trace) for
+ *                 005-scale-ADS1220 and 006-stroboscope
+ *
+ * trace.c builds on a host with two hooks of the bench:
+ *   - TRACE_CLOCK=bench_clock: a counter that steps on every read, as
+ *     the DWT cycle counter would between two trace points, so that two
+ *     records never share a time and the order is exact,
+ *   - TRACE_PREEMPT_POINT=bench_preempt: called inside Trace_Log (between
+ *     the clock read and the commit) and inside Trace_Drain (between the
+ *     choice of a record and its removal), the places where a real
+ *     interrupt does the most harm. There the bench "takes an interrupt"
+ *     of a random higher level, whose handler logs in turn and can be
+ *     interrupted again up to the highest level.
+ *
+ * Checks:
+ *   - unit: record layout, the format id resolves to the string in the
+ *     trace_fmt section, a context above the rings is not traced, put
+ *     busy at the start of a record keeps it, busy inside counts it lost,
+ *   - nested: 4 levels (thread + 3 interrupt priorities), every record
+ *     carries a serial taken just before its Trace_Log. The drained
+ *     stream must hold the serials in increasing order (the merge by
+ *     time gives the order of the calls), each exactly once, with
+ *     strictly increasing times, and the level in each header must be
+ *     the one that logged it,
+ *   - overflow: the same with rings too small for the bursts: records
+ *     drained + counts in drop records + drops not yet reported must be
+ *     all the serials, and the drop records must come in time order.
+ *
+ * Cost: cycles of one TRACE call with 0 to 4 arguments (rdtsc on x86,
+ * else ns), against snprintf of the same text into a buffer. The preempt
+ * hook is still called, and returns at once, in those runs. These are
+ * host cycles: on the target the "trace" zone of App/Prof times the
+ * drain, the calls themselves are too short for a zone.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -DTRACE_CLOCK=bench_clock -DTRACE_PREEMPT_POINT=bench_preempt \
+ *       -I005-scale-ADS1220/App/Trace tools/trace_bench.c \
+ *       005-scale-ADS1220/App/Trace/trace.c -o trace_bench && ./trace_bench
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "trace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES()        __rdtsc()
+#define CYCLES_UNIT     "cycles"
+#else
+static uint64_t ns_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#define CYCLES()        ns_now()
+#define CYCLES_UNIT     "ns"
+#endif
+
+#define LEVELS          4u
+#define STREAM_WORDS    (1u << 23)
+
+static uint32_t failed;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failed++;
+    }
+}
+
+/* ---- hooks ---- */
+
+static uint32_t bench_ticks;
+static uint8_t  cur_level;
+static int      nesting;            /* preempt with probability 1/nesting */
+static uint32_t serial;
+static uint32_t preemptions;
+
+static Trace_Handle_t htrace;
+
+uint32_t bench_clock(void)
+{
+    return bench_ticks += 3u;
+}
+
+static uint8_t bench_level(void)
+{
+    return cur_level;
+}
+
+static void isr_body(uint8_t level);
+
+void bench_preempt(void)
+{
+    uint8_t saved;
+
+    if (!nesting || cur_level >= LEVELS - 1u || rand() % nesting) return;
+    saved     = cur_level;
+    cur_level = (uint8_t)(saved + 1 + rand() % (int)(LEVELS - 1u - saved));
+    preemptions++;
+    isr_body(cur_level);
+    cur_level = saved;
+}
+
+/* ---- drained stream ---- */
+
+static uint32_t *stream;
+static uint32_t  stream_len;
+static int       put_busy;          /* -1: always free, else fail at word n */
+
+static int put_stream(uint32_t w)
+{
+    if (put_busy >= 0 && (uint32_t)put_busy == stream_len) return 1;
+    if (stream_len >= STREAM_WORDS) return 1;
+    stream[stream_len++] = w;
+    return 0;
+}
+
+static int put_nothing(uint32_t w)
+{
+    (void)w;
+    return 0;
+}
+
+/* ---- unit checks ---- */
+
+static uint32_t buf_a[64], buf_b[64];
+static Trace_Ring_t ring_unit[2] = { { .buf = buf_a, .size = 64 }, { .buf = buf_b, .size = 64 } };
+
+static void unit_checks(void)
+{
+    const char *fmt;
+
+    htrace.ring  = ring_unit;
+    htrace.count = 2;
+    htrace.level = bench_level;
+    htrace.put   = put_stream;
+    Trace_Init(&htrace);
+    nesting    = 0;
+    put_busy   = -1;
+    stream_len = 0;
+
+    cur_level = 1;
+    TRACE(&htrace, "unit %d %u", -5, 7u);
+    cur_level = 0;
+    TRACE(&htrace, "unit none");
+    cur_level = 2;
+    TRACE(&htrace, "above the rings %x", 1);
+    cur_level = 0;
+    check(ring_unit[0].head == 2 && ring_unit[1].head == 4, "record sizes");
+
+    check(Trace_Drain(&htrace, 1000) == 6 && stream_len == 6, "drain all");
+    check((stream[0] & 0xFFu) == TRACE_SYNC && ((stream[0] >> 8) & 0xFu) == 2 &&
+          ((stream[0] >> 12) & 0xFu) == 1, "header sync, args, level");
+    fmt = __start_trace_fmt + (stream[0] >> 16);
+    check(strcmp(fmt, "unit %d %u") == 0, "format id resolves in trace_fmt");
+    check((int32_t)stream[2] == -5 && stream[3] == 7, "raw arguments");
+    check(strcmp(__start_trace_fmt + (stream[4] >> 16), "unit none") == 0 &&
+          ((stream[4] >> 8) & 0xFu) == 0, "no argument record");
+    check((int32_t)(stream[5] - stream[1]) > 0, "time order");
+
+    /* put busy at the first word: the record stays for the next drain */
+    stream_len = 0;
+    TRACE(&htrace, "busy %u", 1u);
+    put_busy = 0;
+    check(Trace_Drain(&htrace, 1000) == 0 && ring_unit[0].head != ring_unit[0].tail,
+          "busy at start keeps the record");
+    put_busy = -1;
+    check(Trace_Drain(&htrace, 1000) == 3 && stream_len == 3, "kept record sent later");
+
+    /* busy inside a record: taken, counted lost */
+    stream_len = 0;
+    TRACE(&htrace, "cut %u %u", 1u, 2u);
+    put_busy = 2;
+    Trace_Drain(&htrace, 1000);
+    check(htrace.lost == 1 && ring_unit[0].head == ring_unit[0].tail, "busy inside counts lost");
+    put_busy = -1;
+
+    /* budget: whole records only */
+    stream_len = 0;
+    TRACE(&htrace, "b %u %u", 1u, 2u);
+    TRACE(&htrace, "b %u %u", 3u, 4u);
+    check(Trace_Drain(&htrace, 7) == 4 && Trace_Drain(&htrace, 7) == 4, "budget in records");
+}
+
+/* ---- nested interrupts ---- */
+
+static uint32_t buf_ring[LEVELS][4096];
+static Trace_Ring_t ring_sim[LEVELS];
+
+static void isr_body(uint8_t level)
+{
+    /* one to three records, the serial taken right before the call */
+    int n = 1 + rand() % 3;
+
+    for (int i = 0; i < n; i++) {
+        uint32_t s = serial++;
+        switch (s % 3u) {
+        case 0:  TRACE(&htrace, "isr L%u serial %u", level, s); break;
+        case 1:  TRACE(&htrace, "isr L%u serial %u check %x", level, s, s ^ 0x5A5A5A5Au); break;
+        default: TRACE(&htrace, "isr L%u serial %u check %x %x", level, s, s ^ 0x5A5A5A5Au, ~s); break;
+        }
+    }
+}
+
+typedef struct {
+    uint32_t records, drop_records, dropped, order_err, time_err, level_err, arg_err;
+} Verify_t;
+
+/* walk the drained stream: records as the decoder sees them */
+static void verify(Verify_t *v)
+{
+    uint32_t i = 0, next = 0, last_t = 0;
+    int      first = 1;
+
+    memset(v, 0, sizeof(*v));
+    while (i < stream_len) {
+        uint32_t hdr = stream[i], t = stream[i + 1], n = (hdr >> 8) & 0xFu;
+        uint32_t id = hdr >> 16, lvl = (hdr >> 12) & 0xFu;
+        const uint32_t *a = &stream[i + 2];
+
+        if ((hdr & 0xFFu) != TRACE_SYNC || n > TRACE_MAX_ARGS) { v->order_err++; break; }
+        i += 2 + n;
+
+        /* a drop record has the time of the record after it */
+        if (id == TRACE_ID_DROP) {
+            if (!first && (int32_t)(t - last_t) <= 0) v->time_err++;
+            v->drop_records++;
+            v->dropped += a[0];
+            continue;
+        }
+        if (!first && (int32_t)(t - last_t) <= 0) v->time_err++;
+        last_t = t;
+        first  = 0;
+        v->records++;
+
+        /* "isr L<level> serial <s> ..." or "thread serial <s>" */
+        {
+            uint32_t s  = (lvl == 0) ? a[0] : a[1];
+            uint32_t lv = (lvl == 0) ? 0u : a[0];
+            if (lv != lvl) v->level_err++;
+            if (s < next) v->order_err++;
+            next = s + 1;
+            if (lvl != 0 && n >= 3 && a[2] != (s ^ 0x5A5A5A5Au)) v->arg_err++;
+            if (lvl != 0 && n == 4 && a[3] != ~s) v->arg_err++;
+            if (lvl == 0 && n == 2 && a[1] != (s ^ 0x5A5A5A5Au)) v->arg_err++;
+        }
+    }
+}
+
+static uint32_t pending_drops(void)
+{
+    uint32_t d = 0;
+    for (uint8_t i = 0; i < LEVELS; i++) d += ring_sim[i].dropped - ring_sim[i].dropped_told;
+    return d;
+}
+
+static void nested_run(const char *name, uint32_t ring_words, uint32_t iters, int drain_every)
+{
+    Verify_t v;
+
+    for (uint8_t i = 0; i < LEVELS; i++) {
+        ring_sim[i].buf  = buf_ring[i];
+        ring_sim[i].size = ring_words;
+    }
+    htrace.ring  = ring_sim;
+    htrace.count = LEVELS;
+    htrace.level = bench_level;
+    htrace.put   = put_stream;
+    Trace_Init(&htrace);
+    put_busy    = -1;
+    stream_len  = 0;
+    serial      = 0;
+    preemptions = 0;
+    cur_level   = 0;
+    nesting     = 6;
+
+    for (uint32_t k = 0; k < iters; k++) {
+        uint32_t s = serial++;
+        if (s & 1u) TRACE(&htrace, "thread serial %u", s);
+        else        TRACE(&htrace, "thread serial %u check %x", s, s ^ 0x5A5A5A5Au);
+        if (rand() % drain_every == 0) Trace_Drain(&htrace, 1u + (uint32_t)rand() % 256u);
+    }
+    /* idle: all drained, drops not yet followed by a record stay
+     * pending in their ring */
+    nesting = 0;
+    while (Trace_Drain(&htrace, 1000)) { }
+
+    verify(&v);
+    printf("%-9s %8u serials  %7u preemptions  %8u records  %5u drop records (%u dropped, %u pending)\n",
+           name, serial, preemptions, v.records, v.drop_records, v.dropped, pending_drops());
+    check(v.order_err == 0, "serials in call order, no duplicates");
+    check(v.time_err == 0, "times increase through the stream");
+    check(v.level_err == 0, "level in the header");
+    check(v.arg_err == 0, "arguments intact");
+    check(v.records + v.dropped + pending_drops() == serial, "every serial drained or counted dropped");
+    check(htrace.lost == 0, "nothing lost to put");
+}
+
+/* ---- cost ---- */
+
+static uint32_t buf_cost[1u << 12];
+static Trace_Ring_t ring_cost[1] = { { .buf = buf_cost, .size = 1u << 12 } };
+static volatile uint32_t arg_src = 12345;
+static char text[96];
+
+#define BATCH   256u
+#define BATCHES 4000u
+
+/* min over batches of the mean per call: the figure without the
+ * interruptions of the host */
+#define COST(label, stmt)                                                   \
+    do {                                                                    \
+        uint64_t best = UINT64_MAX;                                         \
+        for (uint32_t b_ = 0; b_ < BATCHES; b_++) {                         \
+            uint32_t x = arg_src;                                           \
+            uint64_t c0 = CYCLES();                                         \
+            for (uint32_t i_ = 0; i_ < BATCH; i_++) { stmt; x++; }          \
+            uint64_t c = CYCLES() - c0;                                     \
+            if (c < best) best = c;                                         \
+            Trace_Drain(&htrace, UINT32_MAX);                               \
+        }                                                                   \
+        printf("  %-28s %6.1f " CYCLES_UNIT "\n", label, (double)best / BATCH); \
+    } while (0)
+
+static void cost(void)
+{
+    htrace.ring  = ring_cost;
+    htrace.count = 1;
+    htrace.level = bench_level;
+    htrace.put   = put_nothing;
+    Trace_Init(&htrace);
+    cur_level = 0;
+    nesting   = 0;
+
+    printf("\ncost of one call\n");
+    COST("TRACE, no argument", TRACE(&htrace, "tick"));
+    COST("TRACE, 1 argument", TRACE(&htrace, "tick %u", x));
+    COST("TRACE, 2 arguments", TRACE(&htrace, "tick %u %d", x, x >> 1));
+    COST("TRACE, 3 arguments", TRACE(&htrace, "tick %u %d %x", x, x >> 1, x ^ 7u));
+    COST("TRACE, 4 arguments", TRACE(&htrace, "tick %u %d %x %u", x, x >> 1, x ^ 7u, x + 9u));
+    COST("snprintf, 2 arguments", snprintf(text, sizeof(text), "tick %u %d", x, (int)(x >> 1)));
+    COST("snprintf, 4 arguments",
+         snprintf(text, sizeof(text), "tick %u %d %x %u", x, (int)(x >> 1), x ^ 7u, x + 9u));
+    check(htrace.ring[0].dropped == 0, "cost runs fit the ring");
+}
+
+int main(void)
+{
+    stream = malloc(STREAM_WORDS * sizeof(uint32_t));
+    if (!stream) return 1;
+    srand(1);
+
+    unit_checks();
+    printf("unit checks: %s\n\n", failed ? "FAILED" : "passed");
+
+    nested_run("nested", 4096, 100000, 2);
+    nested_run("overflow", 16, 100000, 16);
+    printf("nested checks: %s\n", failed ? "FAILED" : "passed");
+
+    cost();
+    free(stream);
+    return failed ? 1 : 0;
+}
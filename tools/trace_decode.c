@@ -0,0 +1,305 @@
+/*
+ * trace_decode.c - prints the deferred log (App/Trace) of 005-scale-ADS1220
+ *                  and 006-stroboscope from an ITM / SWO capture
+ *
+ * The firmware sends binary records on ITM stimulus port 1: a header
+ * (format id, level, argument count, sync byte 0xA5), a DWT timestamp and
+ * up to four raw 32-bit arguments. The format strings are not on the
+ * target: they are in the ELF, section trace_fmt, and the id is the
+ * offset of the string in that section. This tool reads them from the
+ * firmware ELF, takes the raw ITM byte stream as a SWO viewer or probe
+ * saves it (STM32CubeProgrammer SWV "save to file", OpenOCD
+ * "itm port ... / tpiu config internal <file> uart off <hz>", J-Link SWO
+ * viewer raw output, ...), and prints one line per record:
+ *
+ *      1234.567 us  L2  tach lock, err 12 deg/10
+ *
+ * time from the first record (in ticks, or microseconds with --hz), the
+ * level (ring) of the record and the formatted text. Port 0 is printed as
+ * text lines ("itm0" prefix), so the Diag dumps of the same capture show
+ * up in place. An ITM overflow packet drops the record being assembled
+ * and the tool resyncs on the next header.
+ *
+ * The firmware ELF must match the capture: the ids are offsets, a
+ * rebuild moves them.
+ *
+ * Usage:
+ *   trace_decode firmware.elf capture.bin [--hz 100000000] [--port 1]
+ *   (capture "-" reads stdin)
+ *
+ * Build from the repository root:
+ *   gcc -O2 -Wall -o trace_decode tools/trace_decode.c
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_SYNC      0xA5u
+#define TRACE_ID_DROP   0xFFFFu
+#define TRACE_MAX_ARGS  4u
+
+static char    *fmt_sec;
+static uint32_t fmt_size;
+
+/* ---- ELF: the trace_fmt section ---- */
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE    *f = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    uint8_t *buf = NULL;
+    size_t   cap = 0, n = 0, r;
+
+    if (!f) return NULL;
+    do {
+        if (n == cap) {
+            cap = cap ? cap * 2 : 65536;
+            buf = realloc(buf, cap);
+            if (!buf) exit(1);
+        }
+        r  = fread(buf + n, 1, cap - n, f);
+        n += r;
+    } while (r > 0);
+    if (f != stdin) fclose(f);
+    *len = n;
+    return buf;
+}
+
+static uint64_t rd(const uint8_t *p, int size)
+{
+    uint64_t v = 0;
+    for (int i = size - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static int load_formats(const char *path)
+{
+    size_t   len;
+    uint8_t *elf = read_file(path, &len);
+    int      is64;
+    uint64_t shoff;
+    uint32_t shentsize, shnum, shstrndx;
+    const uint8_t *sh, *strsh;
+    uint64_t strtab;
+
+    if (!elf || len < 64 || memcmp(elf, "\177ELF", 4) != 0 || elf[5] != 1) {
+        fprintf(stderr, "%s: not a little endian ELF\n", path);
+        return -1;
+    }
+    is64      = (elf[4] == 2);
+    shoff     = is64 ? rd(elf + 0x28, 8) : rd(elf + 0x20, 4);
+    shentsize = (uint32_t)rd(elf + (is64 ? 0x3A : 0x2E), 2);
+    shnum     = (uint32_t)rd(elf + (is64 ? 0x3C : 0x30), 2);
+    shstrndx  = (uint32_t)rd(elf + (is64 ? 0x3E : 0x32), 2);
+    if (shoff + (uint64_t)shentsize * shnum > len || shstrndx >= shnum) {
+        fprintf(stderr, "%s: bad section table\n", path);
+        return -1;
+    }
+    strsh  = elf + shoff + (uint64_t)shentsize * shstrndx;
+    strtab = is64 ? rd(strsh + 0x18, 8) : rd(strsh + 0x10, 4);
+
+    for (uint32_t i = 0; i < shnum; i++) {
+        uint64_t off, size;
+        sh   = elf + shoff + (uint64_t)shentsize * i;
+        if (strtab + rd(sh, 4) >= len ||
+            strcmp((const char *)elf + strtab + rd(sh, 4), "trace_fmt") != 0) continue;
+        off  = is64 ? rd(sh + 0x18, 8) : rd(sh + 0x10, 4);
+        size = is64 ? rd(sh + 0x20, 8) : rd(sh + 0x14, 4);
+        if (off + size > len) break;
+        fmt_sec  = malloc(size + 1);
+        if (!fmt_sec) exit(1);
+        memcpy(fmt_sec, elf + off, size);
+        fmt_sec[size] = '\0';
+        fmt_size = (uint32_t)size;
+        free(elf);
+        return 0;
+    }
+    fprintf(stderr, "%s: no trace_fmt section\n", path);
+    free(elf);
+    return -1;
+}
+
+/* ---- records ---- */
+
+static double   tick_us;            /* 0: print ticks */
+static uint64_t t_abs;
+static uint32_t t_last;
+static int      t_first = 1;
+
+/* printf of one record: each conversion takes the next raw argument */
+static void print_text(const char *f, const uint32_t *a, uint32_t n)
+{
+    uint32_t k = 0;
+
+    while (*f) {
+        char spec[24];
+        int  s = 0;
+
+        if (*f != '%') { putchar(*f++); continue; }
+        if (f[1] == '%') { putchar('%'); f += 2; continue; }
+
+        spec[s++] = *f++;
+        while (*f && strchr("-+ #0", *f) && s < 8)              spec[s++] = *f++;
+        while (*f >= '0' && *f <= '9' && s < 14)                spec[s++] = *f++;
+        if (*f == '.') { spec[s++] = *f++; while (*f >= '0' && *f <= '9' && s < 20) spec[s++] = *f++; }
+        while (*f && strchr("hlzjt", *f)) f++;          /* all arguments are 32-bit */
+        if (!*f) break;
+
+        spec[s++] = *f;
+        spec[s]   = '\0';
+        if (k >= n) { printf("<?>"); f++; continue; }
+        switch (*f++) {
+        case 'd': case 'i':           printf(spec, (int)(int32_t)a[k++]); break;
+        case 'u': case 'x': case 'X':
+        case 'o':                     printf(spec, (unsigned)a[k++]); break;
+        case 'c':                     printf(spec, (int)(a[k++] & 0xFFu)); break;
+        case 'p':                     printf("0x%08x", (unsigned)a[k++]); break;
+        default:                      printf("<%s?>", spec); k++; break;
+        }
+    }
+}
+
+static void print_record(const uint32_t *w, uint32_t n)
+{
+    uint32_t id = w[0] >> 16, lvl = (w[0] >> 12) & 0xFu;
+
+    /* 32-bit ticks, followed into 64 bits from the first record */
+    if (t_first) { t_first = 0; t_last = w[1]; }
+    t_abs += (uint32_t)(w[1] - t_last);
+    t_last = w[1];
+
+    if (tick_us > 0) printf("%12.3f us  L%u  ", (double)t_abs * tick_us, lvl);
+    else             printf("%12llu     L%u  ", (unsigned long long)t_abs, lvl);
+
+    if (id == TRACE_ID_DROP) printf("<%u records dropped>", n ? w[2] : 0u);
+    else                     print_text(fmt_sec + id, w + 2, n);
+    putchar('\n');
+}
+
+static uint32_t rec[2 + TRACE_MAX_ARGS];
+static uint32_t rec_len, rec_need;
+static uint32_t junk_words, overflows;
+
+static void trace_word(uint32_t w)
+{
+    if (rec_len == 0) {
+        uint32_t id = w >> 16, n = (w >> 8) & 0xFu;
+        if ((w & 0xFFu) != TRACE_SYNC || n > TRACE_MAX_ARGS ||
+            (id != TRACE_ID_DROP && id >= fmt_size)) {
+            junk_words++;
+            return;
+        }
+        rec_need = 2u + n;
+    }
+    rec[rec_len++] = w;
+    if (rec_len == rec_need) {
+        print_record(rec, rec_need - 2u);
+        rec_len = 0;
+    }
+}
+
+/* ---- ITM packets ---- */
+
+static char     text[256];
+static uint32_t text_len;
+
+static void text_byte(uint8_t c)
+{
+    if (c == '\r') return;
+    if (c == '\n' || text_len == sizeof(text) - 1u) {
+        printf("itm0  %.*s\n", (int)text_len, text);
+        text_len = 0;
+        if (c == '\n') return;
+    }
+    text[text_len++] = (char)c;
+}
+
+static void decode(const uint8_t *p, size_t len, uint8_t port)
+{
+    uint32_t word = 0, word_bytes = 0;
+    size_t   i = 0;
+
+    while (i < len) {
+        uint8_t b = p[i++];
+
+        if (b == 0x00u || b == 0x80u) continue;           /* sync */
+        if (b == 0x70u) {                                 /* overflow */
+            overflows++;
+            rec_len = 0;
+            word_bytes = 0;
+            continue;
+        }
+        if ((b & 0x03u) == 0u) {
+            /* timestamp, extension, global timestamp: header and
+             * continuation bytes while bit 7 is set */
+            if (b & 0x80u) while (i < len && (p[i++] & 0x80u)) { }
+            continue;
+        }
+
+        {
+            uint32_t size = (b & 0x03u) == 3u ? 4u : (b & 0x03u);
+            uint8_t  src  = (uint8_t)(b >> 3);
+
+            if (i + size > len) break;
+            if (b & 0x04u) { i += size; continue; }       /* hardware source */
+            for (uint32_t k = 0; k < size; k++) {
+                uint8_t c = p[i + k];
+                if (src == 0u && port != 0u) {
+                    text_byte(c);
+                } else if (src == port) {
+                    word |= (uint32_t)c << (8u * word_bytes);
+                    if (++word_bytes == 4u) {
+                        trace_word(word);
+                        word = 0;
+                        word_bytes = 0;
+                    }
+                }
+            }
+            i += size;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *elf = NULL, *cap = NULL;
+    uint8_t     port = 1;
+    uint8_t    *data;
+    size_t      len;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--hz") && i + 1 < argc) {
+            double hz = atof(argv[++i]);
+            if (hz > 0) tick_us = 1e6 / hz;
+        } else if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+            port = (uint8_t)atoi(argv[++i]);
+        } else if (!elf) {
+            elf = argv[i];
+        } else if (!cap) {
+            cap = argv[i];
+        } else {
+            elf = NULL;
+            break;
+        }
+    }
+    if (!elf || !cap || port > 31u) {
+        fprintf(stderr, "usage: %s firmware.elf capture.bin [--hz <cpu Hz>] [--port <n>]\n", argv[0]);
+        return 2;
+    }
+    if (load_formats(elf) != 0) return 1;
+    data = read_file(cap, &len);
+    if (!data) {
+        fprintf(stderr, "%s: cannot read\n", cap);
+        return 1;
+    }
+
+    decode(data, len, port);
+    if (text_len) printf("itm0  %.*s\n", (int)text_len, text);
+    if (junk_words || overflows || rec_len)
+        fprintf(stderr, "%u words out of sync, %u ITM overflows, %s\n", junk_words, overflows,
+                rec_len ? "last record incomplete" : "no record incomplete");
+    free(data);
+    free(fmt_sec);
+    return 0;
+}
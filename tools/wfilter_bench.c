@@ -0,0 +1,202 @@
+/*
+ * wfilter_bench.c - host benchmark of the 005-scale-ADS1220 weight filter
+ *
+ * Synthetic ADS1220 traces at the scale's 20 SPS: a 100 g load is put on
+ * the platform, rings like a damped spring for a moment and stays; a bit
+ * later it is taken off again. Gaussian noise on top, in ADC codes at the
+ * default 1724 codes per gram. Each trace goes through
+ *
+ *   - the former 8-sample moving average of main.c (re-sums the buffer),
+ *   - a plain 32-sample moving average,
+ *   - the firmware's own wfilter.c with the settings of main.c,
+ *
+ * and the bench prints, per filter, the settling time (the output stays
+ * within 0.1 g of the load from then on), the residual noise (rms over
+ * the last 2 s of the load) and, for wfilter.c, when the stable flag came
+ * up for good, or "never" when the noise stays above the limit (0.1 g,
+ * FILTER_NOISE_G_X10). The vibration trace runs twice: with the limit of
+ * main.c, where it never gets stable, and with 0.2 g, where it does.
+ *
+ * Cost: cycles per sample of each filter (rdtsc on x86, else ns), the
+ * minimum over 2500 batches of 4096 samples. These are host cycles: the
+ * per-sample work of the three is what they compare, the target cost is
+ * in the readme.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/Filter tools/wfilter_bench.c \
+ *       005-scale-ADS1220/App/Filter/wfilter.c -lm -o wfilter_bench \
+ *       && ./wfilter_bench
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "wfilter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES()        __rdtsc()
+#define CYCLES_UNIT     "cycles"
+#else
+static uint64_t ns_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#define CYCLES()        ns_now()
+#define CYCLES_UNIT     "ns"
+#endif
+
+#define SPS             20.0
+#define CODES_PER_G     1724.0
+#define LOAD_G          100.0
+#define T_ON            2.0     /* s */
+#define T_OFF           8.0
+#define T_END           14.0
+#define BAND_G          0.1
+
+typedef struct {
+    const char *name;
+    double      noise_g;        /* 1 sigma                             */
+    double      ring_g;         /* first swing of the platform          */
+    double      ring_hz;
+    double      ring_tau;       /* s                                   */
+    double      limit_g;        /* stable noise limit, 0 = main.c      */
+} Trace_t;
+
+typedef struct {
+    int32_t  buf[32];
+    uint8_t  idx, full, size;
+} Ma_t;
+
+/* the filter as it was in Scale_ProcessSample */
+static int32_t ma_process(Ma_t *m, int32_t x)
+{
+    m->buf[m->idx] = x;
+    m->idx = (uint8_t)((m->idx + 1) % m->size);
+    if (m->idx == 0) m->full = 1;
+
+    uint8_t count = m->full ? m->size : m->idx;
+    int32_t sum   = 0;
+    for (uint8_t i = 0; i < count; i++) sum += m->buf[i];
+    return sum / (count ? count : 1);
+}
+
+static void wf_setup(WFilter_t *f, double limit_g)
+{
+    /* same as Scale_FilterSetup() in main.c at 20 SPS */
+    f->len_max      = 32;
+    f->stable_len   = 10;
+    f->step         = (int32_t)(2.0 * CODES_PER_G);
+    f->step_confirm = 2;
+    f->noise        = (int32_t)((limit_g > 0.0 ? limit_g : 0.1) * CODES_PER_G);
+    WFilter_Reset(f);
+}
+
+static double urand(void) { return (rand() + 0.5) / ((double)RAND_MAX + 1.0); }
+static double gauss(void) { return sqrt(-2.0 * log(urand())) * cos(2.0 * M_PI * urand()); }
+
+static double signal_g(const Trace_t *tr, double t)
+{
+    double g = 0.0;
+    if (t >= T_ON && t < T_OFF) {
+        double s = t - T_ON;
+        g = LOAD_G + tr->ring_g * exp(-s / tr->ring_tau) * cos(2.0 * M_PI * tr->ring_hz * s);
+    }
+    return g;
+}
+
+static void run(const Trace_t *tr)
+{
+    int     n = (int)(T_END * SPS);
+    Ma_t    ma8  = { {0}, 0, 0, 8 };
+    Ma_t    ma32 = { {0}, 0, 0, 32 };
+    WFilter_t wf;
+    double  settle[3] = { -1, -1, -1 }, sum2[3] = { 0 }, t_stable = -1.0;
+    int     cnt = 0;
+
+    wf_setup(&wf, tr->limit_g);
+    printf("%s (noise %.2f g, ring %.0f g @ %.0f Hz, stable limit %.1f g)\n", tr->name, tr->noise_g,
+           tr->ring_g, tr->ring_hz, tr->limit_g > 0.0 ? tr->limit_g : 0.1);
+
+    for (int i = 0; i < n; i++) {
+        double  t   = i / SPS;
+        int32_t x   = (int32_t)lround((signal_g(tr, t) + tr->noise_g * gauss()) * CODES_PER_G);
+        int32_t y[3];
+
+        y[0] = ma_process(&ma8, x);
+        y[1] = ma_process(&ma32, x);
+        y[2] = WFilter_Process(&wf, x);
+
+        if (t >= T_ON && t < T_OFF) {
+            for (int k = 0; k < 3; k++) {
+                double e = fabs(y[k] / CODES_PER_G - LOAD_G);
+                if (e > BAND_G) settle[k] = -1.0;
+                else if (settle[k] < 0.0) settle[k] = t - T_ON;
+                if (t >= T_OFF - 2.0) sum2[k] += (y[k] / CODES_PER_G - LOAD_G) * (y[k] / CODES_PER_G - LOAD_G);
+            }
+            if (t >= T_OFF - 2.0) cnt++;
+            if (wf.stable && t_stable < 0.0) t_stable = t - T_ON;
+            if (!wf.stable) t_stable = -1.0;
+        }
+    }
+
+    static const char *names[3] = { "moving average 8 ", "moving average 32", "wfilter          " };
+    for (int k = 0; k < 3; k++) {
+        printf("  %s  settle %5.2f s  residual %6.4f g rms", names[k], settle[k], sqrt(sum2[k] / cnt));
+        if (k == 2 && t_stable >= 0.0) printf("  stable after %5.2f s  steps %lu", t_stable, (unsigned long)wf.restarts);
+        if (k == 2 && t_stable < 0.0)   printf("  stable never         steps %lu", (unsigned long)wf.restarts);
+        printf("\n");
+    }
+}
+
+/* min over batches of the mean per sample: the figure without the
+ * interruptions of the host */
+static double cycles_per_sample(int which)
+{
+    static int32_t in[4096];
+    Ma_t          ma8  = { {0}, 0, 0, 8 };
+    Ma_t          ma32 = { {0}, 0, 0, 32 };
+    WFilter_t     wf;
+    volatile int32_t sink = 0;
+    uint64_t      best = UINT64_MAX;
+
+    for (int i = 0; i < 4096; i++) in[i] = (int32_t)(gauss() * 100.0) + ((i & 1024) ? 172400 : 0);
+    wf_setup(&wf, 0.0);
+
+    for (int b = 0; b < 2500; b++) {
+        uint64_t c0 = CYCLES();
+        for (int i = 0; i < 4096; i++) {
+            int32_t x = in[i];
+            if (which == 0)      sink = ma_process(&ma8, x);
+            else if (which == 1) sink = ma_process(&ma32, x);
+            else                 sink = WFilter_Process(&wf, x);
+        }
+        uint64_t c = CYCLES() - c0;
+        if (c < best) best = c;
+    }
+    (void)sink;
+    return (double)best / 4096;
+}
+
+int main(void)
+{
+    static const Trace_t traces[] = {
+        { "quiet load cell",           0.03,  0.0, 0.0, 1.0,  0.0 },
+        { "quiet, platform rings",     0.03, 15.0, 3.0, 0.25, 0.0 },
+        { "noisy (vibration)",         0.15, 15.0, 3.0, 0.25, 0.0 },
+        { "noisy, limit 0.2 g",        0.15, 15.0, 3.0, 0.25, 0.2 },
+    };
+
+    srand(11);
+    for (unsigned i = 0u; i < sizeof(traces) / sizeof(traces[0]); i++)
+        run(&traces[i]);
+
+    printf("host " CYCLES_UNIT " per sample: moving average 8 %.1f, moving average 32 %.1f, wfilter %.1f\n",
+           cycles_per_sample(0), cycles_per_sample(1), cycles_per_sample(2));
+    return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * ztrack_sim.c - host check of the 005-scale-ADS1220 zero tracking
+ *
+ * Three hours of a synthetic ADS1220 stream at 20 SPS, read through the
+ * firmware's own wfilter.c and ztrack.c with the settings of main.c
+ * (1724 codes per gram, display division d = 0.1 g = 172 codes). The
+ * offset correction is run scanned as in main.c with ADC_SCAN (8 bridge
+ * conversions, temperature, AVDD/4 and the shorted input every 4th
+ * cycle), the other settings with the bridge only, as shipped:
+ *
+ *   - the room warms from 20 to 30 degC and cools to 22 degC,
+ *   - the bridge zero drifts 120 codes/degC (cheap cell, zero TC not
+ *     learned), the ADC offset 130 codes/degC (0.25 uV/degC at gain 128),
+ *   - 500 g is put on for 5 minutes every 20 minutes, with 0.01 % creep
+ *     (time constant 5 min) while loaded and the recovery after it,
+ *   - white noise of 60 codes rms on every conversion.
+ *
+ * The platform is tared once at the start. For the scale without
+ * tracking, with zero tracking without and with the recapture after an
+ * unload, and with zero tracking plus the shorted-input offset
+ * correction, it prints the largest error of the displayed weight
+ * (rounded to d) on the empty platform and under the 500 g load, leaving
+ * out 3 s after each load change. The shipped setting (zero tracking
+ * with recapture, ADC_SCAN 0) is run twice: updated once per sample, and
+ * on every 1 ms main loop pass as main.c does. The sim fails if either
+ * leaves more than 1 d on the empty platform.
+ *
+ * Rate: ZTrack_Update called every 1 ms on a stable reading far from the
+ * zero, for calibrations of 1724, 80 and 20 codes per gram (rate 0.5 d/s
+ * = 86, 4 and 1 codes/s). The zero must move at the set rate, within 1%.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -I005-scale-ADS1220/App/Filter -I005-scale-ADS1220/App/Calib \
+ *       tools/ztrack_sim.c 005-scale-ADS1220/App/Filter/wfilter.c \
+ *       005-scale-ADS1220/App/Calib/ztrack.c -lm -o ztrack_sim \
+ *       && ./ztrack_sim
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "wfilter.h"
+#include "ztrack.h"
+
+#define SPS         20.0
+#define HOURS       3.0
+#define CPG         1724            /* codes per gram                     */
+#define D_CODES     (CPG / 10.0)    /* display division, codes            */
+#define ZERO        150000.0        /* bridge code of the empty platform  */
+#define OFFSET      2000.0          /* ADC offset at 20 degC              */
+#define NOISE       60.0
+#define TC_BRIDGE   120.0           /* codes per degC                     */
+#define TC_OFFSET   130.0
+#define LOAD_G      500.0
+#define CREEP       1e-4            /* of the load                        */
+#define CREEP_TAU   300.0           /* s                                  */
+#define SETTLE_S    3.0
+
+enum { NONE = 0, TRACK_BAND, TRACK, TRACK_1MS, TRACK_OFFSET };
+
+static double urand(void) { return (rand() + 0.5) / ((double)RAND_MAX + 1.0); }
+static double gauss(void) { return sqrt(-2.0 * log(urand())) * cos(2.0 * M_PI * urand()); }
+
+static double temperature(double t)
+{
+    double h = t / 3600.0;
+    return (h < 1.5) ? 20.0 + 10.0 * h / 1.5 : 30.0 - 8.0 * (h - 1.5) / 1.5;
+}
+
+/* 500 g for 5 of every 20 minutes, from minute 10 on */
+static int loaded(double t)
+{
+    double m = fmod(t / 60.0, 20.0);
+    return t >= 600.0 && m >= 10.0 && m < 15.0;
+}
+
+static double since_change(double t)
+{
+    double m = fmod(t / 60.0, 20.0);
+    if (t < 600.0) return t;
+    return 60.0 * (m >= 15.0 ? m - 15.0 : (m >= 10.0 ? m - 10.0 : m + 5.0));
+}
+
+static double run(int mode)
+{
+    WFilter_t f = { 0 };
+    ZTrack_t  z = { 0 };
+    double    creep = 0.0, err_empty = 0.0, err_load = 0.0;
+    int32_t   tare = 0, adc_filtered = 0;
+    long      n = (long)(HOURS * 3600.0 * SPS);
+    int       tared = 0, cycle = 0, pos = 0;
+
+    /* main.c at 20 SPS: Scale_FilterSetup */
+    f.len_max = 32; f.stable_len = 10; f.step = CPG * 2; f.step_confirm = 2; f.noise = CPG / 10;
+    WFilter_Reset(&f);
+    z.band = CPG * 10 / 100; z.rate = CPG * 5 / 100; z.limit = CPG * 20;
+    z.recapture = (mode == TRACK_BAND) ? 0 : CPG * 50 / 100;
+    z.hold_ms = 1000; z.offset_shift = 3;
+
+    srand(19);
+    for (long i = 0; i < n; i++) {
+        double   t      = i / SPS;
+        double   temp   = temperature(t);
+        double   load   = loaded(t) ? LOAD_G : 0.0;
+        double   offset = OFFSET + TC_OFFSET * (temp - 20.0);
+        uint32_t ms     = (uint32_t)(t * 1000.0);
+
+        /* creep follows the load with a first order lag */
+        creep += (CREEP * load * CPG - creep) / (CREEP_TAU * SPS);
+
+        /* scan: 8 x bridge, temperature, AVDD/4, shorted every 4th cycle;
+         * without ADC_SCAN every conversion is the bridge */
+        if (pos < 8 || mode != TRACK_OFFSET) {
+            double  bridge = ZERO + TC_BRIDGE * (temp - 20.0) + load * CPG + creep;
+            int32_t code   = (int32_t)lround(bridge + offset + NOISE * gauss());
+
+            adc_filtered = WFilter_Process(&f, code - (mode == TRACK_OFFSET ? z.offset : 0));
+        } else if (pos == 10) {
+            ZTrack_OffsetSample(&z, (int32_t)lround(offset + NOISE * gauss()));
+        }
+        if (++pos == 10 + ((cycle % 4) == 0)) { pos = 0; cycle++; }
+
+        /* tare once the filter has settled, then track */
+        if (!tared && t >= 5.0) {
+            ZTrack_Set(&z, adc_filtered);
+            tare  = z.zero;
+            tared = 1;
+        }
+        if (!tared) continue;
+        if (mode == TRACK_1MS) {
+            for (uint32_t k = 0; k < (uint32_t)(1000.0 / SPS); k++)
+                tare = ZTrack_Update(&z, adc_filtered, f.stable, ms + k);
+        } else if (mode != NONE) {
+            tare = ZTrack_Update(&z, adc_filtered, f.stable, ms);
+        }
+
+        /* displayed weight in d, against the true one */
+        if (since_change(t) >= SETTLE_S) {
+            double shown = lround((adc_filtered - tare) / D_CODES);
+            double e     = fabs(shown - load * 10.0);
+            if (load == 0.0 && e > err_empty) err_empty = e;
+            if (load != 0.0 && e > err_load)  err_load  = e;
+        }
+    }
+    printf("  %-34s empty %5.0f d   500 g %5.0f d   (%lu corrections, zero moved %+ld codes)\n",
+           mode == NONE ? "no tracking" : mode == TRACK_BAND ? "zero tracking, no recapture" :
+           mode == TRACK ? "zero tracking (shipped)" :
+           mode == TRACK_1MS ? "zero tracking, every 1 ms" : "zero tracking + offset correction",
+           err_empty, err_load, (unsigned long)z.corrections, (long)(z.zero - z.zero_ref));
+    return err_empty;
+}
+
+/* zero movement over 10 s of 1 ms updates, after the hold, against
+ * rate * 10 s; 0 if within 1% */
+static int rate_check(int32_t cpg)
+{
+    ZTrack_t z = { 0 };
+    double   moved, want;
+
+    z.band = z.recapture = z.limit = 1000000;   /* never reached */
+    z.rate = cpg * 5 / 100;
+    z.hold_ms = 1000;
+    ZTrack_Set(&z, 0);
+    for (uint32_t ms = 1; ms <= 11000u; ms++) ZTrack_Update(&z, 100000, 1, ms);
+
+    moved = z.zero_q8 / 256.0;
+    want  = z.rate * 10.0;
+    printf("  %4d codes/g, rate %2d codes/s   moved %7.2f codes in 10 s, want %4.0f\n",
+           (int)cpg, (int)z.rate, moved, want);
+    return fabs(moved - want) > 0.01 * want;
+}
+
+int main(void)
+{
+    double shipped;
+    int    bad = 0;
+
+    printf("largest display error over %.0f h, 20 -> 30 -> 22 degC, d = 0.1 g:\n", HOURS);
+    run(NONE);
+    run(TRACK_BAND);
+    shipped = run(TRACK);
+    shipped = fmax(shipped, run(TRACK_1MS));
+    run(TRACK_OFFSET);
+
+    printf("tracking rate, ZTrack_Update every 1 ms:\n");
+    bad |= rate_check(CPG);
+    bad |= rate_check(80);
+    bad |= rate_check(20);
+
+    if (shipped > 1.0) {
+        printf("FAIL: the shipped setting leaves %.0f d on the empty platform\n", shipped);
+        return 1;
+    }
+    if (bad) {
+        printf("FAIL: the zero does not move at the set rate\n");
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}